@@ -14,6 +14,10 @@
 #include <memory>
 #include <optional>
 #include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <thread>
 
 #include "communication/ICommunication.hpp"
 #include "Logger.hpp"
@@ -34,7 +38,12 @@ typedef std::unordered_map<uint64_t, Reply> SeqNumToReplyMap;
 
 class Client {
  public:
+  // Called with the matched reply or with std::nullopt if the request timed out.
+  using ReplyCallback = std::function<void(std::optional<Reply>&&)>;
+
   Client(std::unique_ptr<bft::communication::ICommunication> comm, const ClientConfig& config);
+  // Fails the outstanding asynchronous requests, as if they timed out.
+  ~Client();
 
   void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator) {
     metrics_.setAggregator(aggregator);
@@ -50,6 +59,21 @@ class Client {
   Reply send(const ReadConfig& config, Msg&& request);
   SeqNumToReplyMap sendBatch(std::deque<WriteRequest>& write_requests, const std::string& cid);
 
+  // Send a message without waiting for the reply. Any number of requests, with distinct sequence numbers, can be
+  // outstanding. A reactor thread, started by the first asynchronous request, matches their replies and retransmits
+  // them. The callbacks are called from the reactor thread and shouldn't block.
+  //
+  // The future throws a TimeoutException if the request timed out. Don't use the blocking send methods while
+  // asynchronous requests are outstanding, as they consume each other's replies.
+  //
+  // Thread safe. Throws a BftClientException on error.
+  std::future<Reply> sendAsync(const WriteConfig& config, Msg&& request);
+  std::future<Reply> sendAsync(const ReadConfig& config, Msg&& request);
+  void sendAsync(const WriteConfig& config, Msg&& request, ReplyCallback&& callback);
+  void sendAsync(const ReadConfig& config, Msg&& request, ReplyCallback&& callback);
+
+  size_t numOutstandingAsyncRequests();
+
   // Return true if the client has at least num_replicas_required active replica connections.
   bool isServing(int num_replicas, int num_replicas_required) const;
 
@@ -65,6 +89,29 @@ class Client {
   // Generic function for sending a read or write message.
   Reply send(const MatchConfig& match_config, const RequestConfig& request_config, Msg&& request, bool read_only);
 
+  // An outstanding asynchronous request
+  struct AsyncRequest {
+    Matcher matcher;
+    Msg msg;
+    bool read_only;
+    RequestConfig config;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point next_retry;
+    ReplyCallback callback;
+  };
+
+  void sendAsync(const MatchConfig& match_config,
+                 const RequestConfig& request_config,
+                 Msg&& request,
+                 bool read_only,
+                 ReplyCallback&& callback);
+
+  // Send the request to the primary if known or to all of its destinations otherwise
+  void transmit(const AsyncRequest& request);
+
+  // Match the replies of the asynchronous requests and retransmit or time them out
+  void runReactor();
+
   // Wait for messages until we get a quorum or a retry timeout.
   //
   // Inserts the Replies to the input queue.
@@ -85,7 +132,8 @@ class Client {
   // data, we construct them here, rather than relying on the type constructors embedded into the
   // bftEngine impl. This allows us to not have to link with the bftengine library, and also allows us
   // to return the messages as vectors with proper RAII based memory management.
-  Msg createClientMsg(const RequestConfig& req_config, Msg&& request, bool read_only, uint16_t client_id);
+  Msg createClientMsg(
+      const RequestConfig& req_config, Msg&& request, bool read_only, uint16_t client_id, bool reply_digest = false);
 
   // This function creates a ClientBatchRequestMsg.
   Msg createClientBatchMsg(const std::deque<Msg>& client_requests,
@@ -149,6 +197,15 @@ class Client {
   uint32_t snapshot_index_ = 0;
   std::unique_ptr<Recorders> histograms_;
   std::mutex lock_;
+
+  // Guards the asynchronous requests as well as the state they share with the reactor thread
+  std::mutex async_lock_;
+  std::map<uint64_t, AsyncRequest> async_requests_;
+  uint32_t async_max_reply_size_ = 0;
+  std::thread reactor_;
+  std::atomic_bool stop_reactor_ = false;
+  // Upper bound on how long the reactor waits for replies before checking the timeouts
+  static constexpr std::chrono::milliseconds kMaxReactorWait{100};
 };
 
 }  // namespace bft::client
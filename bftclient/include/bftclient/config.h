@@ -81,6 +81,9 @@ struct RequestConfig {
   std::string span_context = "";
   bool key_exchange = false;
   bool reconfiguration = false;
+  // Read-only requests only: all replicas but one reply with the digest of their reply instead of the reply itself.
+  // Saves bandwidth and client memory for large replies. Retransmissions ask all replicas for the full reply.
+  bool reply_digest = false;
 };
 
 // The configuration for a single write request.
@@ -157,13 +157,34 @@ inline std::vector<uint8_t> createReply(const MsgFromClient& msg, std::vector<ui
   return reply;
 }
 
+// The reply to a request or the replies to all requests of a batch. The client pool sends batches over the mock
+// communication (enable_mock_comm), and a batch only completes once every one of its requests got a reply.
+inline std::vector<std::vector<uint8_t>> createReplies(const MsgFromClient& msg) {
+  const auto* batch_header = reinterpret_cast<const bftEngine::ClientBatchRequestMsgHeader*>(msg.data.data());
+  if (batch_header->msgType != BATCH_REQUEST_MSG_TYPE) {
+    return {createReply(msg)};
+  }
+  std::vector<std::vector<uint8_t>> replies;
+  const auto* position = msg.data.data() + sizeof(bftEngine::ClientBatchRequestMsgHeader) + batch_header->cidSize;
+  for (uint32_t i = 0; i < batch_header->numOfMessagesInBatch; i++) {
+    const auto* req_header = reinterpret_cast<const bftEngine::ClientRequestMsgHeader*>(position);
+    replies.push_back(createReply(MsgFromClient{msg.destination, Msg(position, position + sizeof(*req_header))}));
+    position += sizeof(*req_header) + req_header->spanContextSize + req_header->requestLength +
+                req_header->cidLength + req_header->reqSignatureLength;
+  }
+  return replies;
+}
+
 inline void immideateBehaviour(const MsgFromClient& msg, IReceiver* client_receiver) {
-  std::vector<uint8_t> reply = createReply(msg);
-  client_receiver->onNewMessage(msg.destination.val, reinterpret_cast<const char*>(reply.data()), reply.size());
+  for (const auto& reply : createReplies(msg)) {
+    client_receiver->onNewMessage(msg.destination.val, reinterpret_cast<const char*>(reply.data()), reply.size());
+  }
 }
 
 inline void delayedBehaviour(const MsgFromClient& msg, IReceiver* client_receiver) {
-  std::vector<uint8_t> reply = createReply(msg);
+  auto replies = createReplies(msg);
   std::this_thread::sleep_for(5ms);
-  client_receiver->onNewMessage(msg.destination.val, reinterpret_cast<const char*>(reply.data()), reply.size());
+  for (const auto& reply : replies) {
+    client_receiver->onNewMessage(msg.destination.val, reinterpret_cast<const char*>(reply.data()), reply.size());
+  }
 }
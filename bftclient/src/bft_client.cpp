@@ -10,8 +10,12 @@
 // subcomponent's license, as noted in the LICENSE file.
 
 #include "bftclient/bft_client.h"
+
+#include <algorithm>
+
 #include "bftengine/ClientMsgs.hpp"
 #include "assertUtils.hpp"
+#include "kvstream.h"
 #include "secrets_manager_enc.h"
 #include "secrets_manager_plain.h"
 #include "communication/StateControl.hpp"
@@ -23,6 +27,13 @@ using namespace bftEngine::impl;
 
 namespace bft::client {
 
+namespace {
+
+// Retransmissions ask all replicas for the full reply, in case the designated full replier doesn't reply
+void disableReplyDigest(Msg& msg) { reinterpret_cast<ClientRequestMsgHeader*>(msg.data())->flags &= ~REPLY_DIGEST_REQ; }
+
+}  // namespace
+
 Client::Client(std::unique_ptr<bft::communication::ICommunication> comm, const ClientConfig& config)
     : communication_(std::move(comm)),
       config_(config),
@@ -67,8 +78,24 @@ Client::Client(std::unique_ptr<bft::communication::ICommunication> comm, const C
   }
 }
 
-Msg Client::createClientMsg(const RequestConfig& config, Msg&& request, bool read_only, uint16_t client_id) {
-  uint8_t flags = read_only ? READ_ONLY_REQ : EMPTY_FLAGS_REQ;
+Client::~Client() {
+  {
+    std::lock_guard<std::mutex> guard(async_lock_);
+    stop_reactor_ = true;
+  }
+  if (reactor_.joinable()) {
+    receiver_.interrupt();
+    reactor_.join();
+  }
+  for (auto& [seq_num, request] : async_requests_) {
+    (void)seq_num;
+    request.callback(std::nullopt);
+  }
+}
+
+Msg Client::createClientMsg(
+    const RequestConfig& config, Msg&& request, bool read_only, uint16_t client_id, bool reply_digest) {
+  uint64_t flags = read_only ? READ_ONLY_REQ : EMPTY_FLAGS_REQ;
   size_t expected_sig_len = 0;
   bool write_req_with_pre_exec = !read_only && config.pre_execute;
 
@@ -82,6 +109,10 @@ Msg Client::createClientMsg(const RequestConfig& config, Msg&& request, bool rea
   if (config.reconfiguration) {
     flags |= RECONFIG_FLAG;
   }
+
+  if (reply_digest) {
+    flags |= REPLY_DIGEST_REQ;
+  }
   auto header_size = sizeof(ClientRequestMsgHeader);
   auto msg_size = header_size + request.size() + config.correlation_id.size() + config.span_context.size();
   if (transaction_signer_) {
@@ -218,7 +249,8 @@ Reply Client::send(const MatchConfig& match_config,
   metrics_.updateAggregator();
   reply_certificates_.insert(std::make_pair(request_config.sequence_number, Matcher(match_config)));
   receiver_.activate(request_config.max_reply_size);
-  auto orig_msg = createClientMsg(request_config, std::move(request), read_only, config_.id.val);
+  auto orig_msg =
+      createClientMsg(request_config, std::move(request), read_only, config_.id.val, match_config.reply_digest);
   auto start = std::chrono::steady_clock::now();
   auto end = start + request_config.timeout;
   while (std::chrono::steady_clock::now() < end) {
@@ -232,6 +264,7 @@ Reply Client::send(const MatchConfig& match_config,
       }
       communication_->send(dests, std::move(msg));
     }
+    disableReplyDigest(orig_msg);
 
     if (auto reply = wait()) {
       expected_commit_time_ms_.add(
@@ -281,6 +314,161 @@ SeqNumToReplyMap Client::sendBatch(std::deque<WriteRequest>& write_requests, con
   throw BatchTimeoutException(cid);
 }
 
+std::future<Reply> Client::sendAsync(const WriteConfig& config, Msg&& request) {
+  auto promise = std::make_shared<std::promise<Reply>>();
+  auto future = promise->get_future();
+  sendAsync(config, std::move(request), [promise, config](std::optional<Reply>&& reply) {
+    if (reply) {
+      promise->set_value(std::move(*reply));
+    } else {
+      promise->set_exception(std::make_exception_ptr(
+          TimeoutException(config.request.sequence_number, config.request.correlation_id)));
+    }
+  });
+  return future;
+}
+
+std::future<Reply> Client::sendAsync(const ReadConfig& config, Msg&& request) {
+  auto promise = std::make_shared<std::promise<Reply>>();
+  auto future = promise->get_future();
+  sendAsync(config, std::move(request), [promise, config](std::optional<Reply>&& reply) {
+    if (reply) {
+      promise->set_value(std::move(*reply));
+    } else {
+      promise->set_exception(std::make_exception_ptr(
+          TimeoutException(config.request.sequence_number, config.request.correlation_id)));
+    }
+  });
+  return future;
+}
+
+void Client::sendAsync(const WriteConfig& config, Msg&& request, ReplyCallback&& callback) {
+  auto match_config = writeConfigToMatchConfig(config);
+  bool read_only = false;
+  sendAsync(match_config, config.request, std::move(request), read_only, std::move(callback));
+}
+
+void Client::sendAsync(const ReadConfig& config, Msg&& request, ReplyCallback&& callback) {
+  auto match_config = readConfigToMatchConfig(config);
+  bool read_only = true;
+  sendAsync(match_config, config.request, std::move(request), read_only, std::move(callback));
+}
+
+void Client::sendAsync(const MatchConfig& match_config,
+                       const RequestConfig& request_config,
+                       Msg&& request,
+                       bool read_only,
+                       ReplyCallback&& callback) {
+  std::lock_guard<std::mutex> guard(async_lock_);
+  if (async_requests_.count(request_config.sequence_number) > 0) {
+    throw BftClientException("Duplicate sequence number of an outstanding request: " +
+                             std::to_string(request_config.sequence_number));
+  }
+  metrics_.retransmissionTimer.Get().Set(expected_commit_time_ms_.upperLimit());
+  metrics_.updateAggregator();
+  if (request_config.max_reply_size > async_max_reply_size_) {
+    async_max_reply_size_ = request_config.max_reply_size;
+    receiver_.activate(async_max_reply_size_);
+  }
+  auto now = std::chrono::steady_clock::now();
+  AsyncRequest async_request{Matcher(match_config),
+                             createClientMsg(request_config,
+                                             std::move(request),
+                                             read_only,
+                                             config_.id.val,
+                                             match_config.reply_digest),
+                             read_only,
+                             request_config,
+                             now,
+                             now + std::chrono::milliseconds(expected_commit_time_ms_.upperLimit()),
+                             std::move(callback)};
+  transmit(async_request);
+  async_requests_.emplace(request_config.sequence_number, std::move(async_request));
+  if (!reactor_.joinable()) {
+    reactor_ = std::thread([this] { runReactor(); });
+  } else {
+    // The reactor might wait for longer than the retry timeout of this request
+    receiver_.interrupt();
+  }
+}
+
+size_t Client::numOutstandingAsyncRequests() {
+  std::lock_guard<std::mutex> guard(async_lock_);
+  return async_requests_.size();
+}
+
+void Client::transmit(const AsyncRequest& request) {
+  bft::client::Msg msg(request.msg);
+  if (primary_ && !request.read_only) {
+    communication_->send(primary_.value().val, std::move(msg));
+  } else {
+    std::set<bft::communication::NodeNum> dests;
+    for (const auto& d : request.matcher.destinations()) {
+      dests.emplace(d.val);
+    }
+    communication_->send(dests, std::move(msg));
+  }
+}
+
+void Client::runReactor() {
+  static const size_t CLEAR_MATCHER_REPLIES_THRESHOLD = 2 * config_.f_val + config_.c_val + 1;
+  auto wait_time = kMaxReactorWait;
+  while (!stop_reactor_) {
+    auto unmatched_replies = receiver_.wait(wait_time);
+    std::vector<std::pair<ReplyCallback, std::optional<Reply>>> completed;
+    {
+      std::lock_guard<std::mutex> guard(async_lock_);
+      if (stop_reactor_) {
+        return;
+      }
+      auto now = std::chrono::steady_clock::now();
+      for (auto&& reply : unmatched_replies) {
+        auto request = async_requests_.find(reply.metadata.seq_num);
+        if (request == async_requests_.end()) continue;
+        if (auto match = request->second.matcher.onReply(std::move(reply))) {
+          primary_ = request->second.matcher.getPrimary();
+          expected_commit_time_ms_.add(
+              std::chrono::duration_cast<std::chrono::milliseconds>(now - request->second.start).count());
+          completed.emplace_back(std::move(request->second.callback), std::move(match->reply));
+          async_requests_.erase(request);
+        }
+      }
+
+      auto next_wakeup = now + kMaxReactorWait;
+      for (auto it = async_requests_.begin(); it != async_requests_.end();) {
+        auto& request = it->second;
+        const auto deadline = request.start + request.config.timeout;
+        if (now >= deadline) {
+          LOG_DEBUG(logger_,
+                    "Request timed out" << KVLOG(request.config.sequence_number, request.config.correlation_id));
+          expected_commit_time_ms_.add(request.config.timeout.count());
+          primary_ = std::nullopt;
+          completed.emplace_back(std::move(request.callback), std::nullopt);
+          it = async_requests_.erase(it);
+          continue;
+        }
+        if (now >= request.next_retry) {
+          if (request.matcher.numDifferentReplies() > CLEAR_MATCHER_REPLIES_THRESHOLD) {
+            request.matcher.clearReplies();
+            metrics_.repliesCleared++;
+          }
+          primary_ = std::nullopt;
+          disableReplyDigest(request.msg);
+          transmit(request);
+          metrics_.retransmissions++;
+          request.next_retry = now + std::chrono::milliseconds(expected_commit_time_ms_.upperLimit());
+        }
+        next_wakeup = std::min({next_wakeup, deadline, request.next_retry});
+        ++it;
+      }
+      wait_time = std::chrono::ceil<std::chrono::milliseconds>(next_wakeup - now);
+    }
+    for (auto& [callback, reply] : completed) {
+      callback(std::move(reply));
+    }
+  }
+}
+
 std::optional<Reply> Client::wait() {
   SeqNumToReplyMap replies;
   wait(replies);
@@ -355,6 +543,12 @@ MatchConfig Client::readConfigToMatchConfig(const ReadConfig& read_config) {
   } else {
     mc.quorum = quorum_converter_.toMofN(std::get<MofN>(read_config.quorum));
   }
+
+  // Digests are only useful if the replica which replies in full is asked
+  if (read_config.request.reply_digest) {
+    const auto full_replier = fullReplierOf(mc.sequence_number, config_.all_replicas.size());
+    mc.reply_digest = mc.quorum.destinations.count(ReplicaId{full_replier}) > 0;
+  }
   return mc;
 }
 
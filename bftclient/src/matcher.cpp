@@ -10,12 +10,19 @@
 // file.
 
 #include "matcher.h"
+#include "sha_hash.hpp"
 
 namespace bft::client {
 
 std::optional<Match> Matcher::onReply(UnmatchedReply&& reply) {
   if (!valid(reply)) return std::nullopt;
   if (!config_.include_primary_) reply.metadata.primary = std::nullopt;
+  if (config_.reply_digest && !reply.digest) {
+    const auto digest = concord::util::SHA2_256{}.digest(reply.data.data(), reply.data.size());
+    Msg digest_data(digest.begin(), digest.end());
+    bodies_.try_emplace(digest_data, std::move(reply.data));
+    reply.data = std::move(digest_data);
+  }
   auto key = MatchKey{reply.metadata, std::move(reply.data)};
   if (matches_[key].count(reply.rsi.from)) {
     if (matches_[key][reply.rsi.from] != reply.rsi.data) {
@@ -31,11 +38,13 @@ std::optional<Match> Matcher::onReply(UnmatchedReply&& reply) {
 
 std::optional<Match> Matcher::match() {
   auto result = std::find_if(matches_.begin(), matches_.end(), [this](const auto& match) {
-    return match.second.size() == config_.quorum.wait_for;
+    return match.second.size() >= config_.quorum.wait_for &&
+           (!config_.reply_digest || bodies_.count(match.first.data) > 0);
   });
   if (result == matches_.end()) return std::nullopt;
   primary_ = result->first.metadata.primary;
-  return Match{Reply{result->first.metadata.result, result->first.data, std::move(result->second)},
+  auto data = config_.reply_digest ? std::move(bodies_[result->first.data]) : result->first.data;
+  return Match{Reply{result->first.metadata.result, std::move(data), std::move(result->second)},
                result->first.metadata.primary};
 }
 
@@ -47,6 +56,11 @@ bool Matcher::valid(const UnmatchedReply& reply) const {
     return false;
   }
 
+  if (reply.digest && !config_.reply_digest) {
+    LOG_WARN(logger_, "Received a digest reply for a request without reply digests from: " << reply.rsi.from.val);
+    return false;
+  }
+
   if (!validSource(reply.rsi.from)) {
     LOG_WARN(logger_, "Received reply from invalid source: " << reply.rsi.from.val);
     return false;
@@ -27,12 +27,14 @@ struct MatchConfig {
   MofN quorum;
   uint64_t sequence_number;
   bool include_primary_ = true;  // by default part of the match is the current primary
+  // Match the digests of the replies, see REPLY_DIGEST_MSG_TYPE. Digest replies are only accepted in this mode.
+  bool reply_digest = false;
 };
 
 // The parts of data that must match in a reply for quorum to be reached
 struct MatchKey {
   ReplyMetadata metadata;
-  Msg data;
+  Msg data;  // The digest of the reply data when matching digests
 
   bool operator==(const MatchKey& other) const { return metadata == other.metadata && data == other.data; }
   bool operator!=(const MatchKey& other) const { return !(*this == other); }
@@ -65,7 +67,12 @@ class Matcher {
   // go on for a long time.
   size_t numDifferentReplies() const { return matches_.size(); }
 
-  void clearReplies() { matches_.clear(); }
+  void clearReplies() {
+    matches_.clear();
+    bodies_.clear();
+  }
+
+  const std::set<ReplicaId>& destinations() const { return config_.quorum.destinations; }
 
   std::optional<ReplicaId> getPrimary() {
     if (!config_.include_primary_) return std::nullopt;
@@ -96,6 +103,10 @@ class Matcher {
   // replica. In the future we can keep track of this across future requests, but for now, we just log it and worry
   // about it for the current match.
   std::map<MatchKey, std::map<ReplicaId, Msg>> matches_;
+
+  // When matching digests: a map from a digest to the first full reply data with this digest. A quorum of matching
+  // digests is only a match once the full reply data is known.
+  std::map<Msg, Msg> bodies_;
 };
 
 }  // namespace bft::client
@@ -13,6 +13,7 @@
 #include "assertUtils.hpp"
 #include "bftengine/ClientMsgs.hpp"
 #include "msg_receiver.h"
+#include "sha_hash.hpp"
 
 namespace bft::client {
 
@@ -27,13 +28,22 @@ void UnmatchedReplyQueue::push(UnmatchedReply&& reply) {
 std::vector<UnmatchedReply> UnmatchedReplyQueue::wait(std::chrono::milliseconds timeout) {
   std::vector<UnmatchedReply> new_msgs;
   std::unique_lock<std::mutex> lock(lock_);
-  cond_var_.wait_for(lock, timeout, [this] { return !msgs_.empty(); });
+  cond_var_.wait_for(lock, timeout, [this] { return !msgs_.empty() || interrupted_; });
+  interrupted_ = false;
   if (!msgs_.empty()) {
     msgs_.swap(new_msgs);
   }
   return new_msgs;
 }
 
+void UnmatchedReplyQueue::interrupt() {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    interrupted_ = true;
+  }
+  cond_var_.notify_one();
+}
+
 void UnmatchedReplyQueue::clear() {
   std::lock_guard<std::mutex> guard(lock_);
   msgs_.clear();
@@ -57,7 +67,7 @@ void MsgReceiver::onNewMessage(bft::communication::NodeNum source, const char* c
   }
 
   auto* header = reinterpret_cast<const bftEngine::ClientReplyMsgHeader*>(message);
-  if (header->msgType != REPLY_MSG_TYPE) {
+  if (header->msgType != REPLY_MSG_TYPE && header->msgType != REPLY_DIGEST_MSG_TYPE) {
     LOG_WARN(logger_, "Invalid message received. Incorrect Header Type. " << KVLOG(header->msgType));
     return;
   }
@@ -68,6 +78,11 @@ void MsgReceiver::onNewMessage(bft::communication::NodeNum source, const char* c
   metadata.result = header->result;
 
   auto data_len = header->replyLength;
+  const bool digest = header->msgType == REPLY_DIGEST_MSG_TYPE;
+  if (digest && data_len - header->replicaSpecificInfoLength != concord::util::SHA2_256::SIZE_IN_BYTES) {
+    LOG_WARN(logger_, "Invalid message received. Digest reply of wrong size. " << KVLOG(data_len));
+    return;
+  }
   const char* start_of_body = message + sizeof(bftEngine::ClientReplyMsgHeader) + header->spanContextSize;
   const char* start_of_rsi = start_of_body + (data_len - header->replicaSpecificInfoLength);
   const char* end_of_rsi = start_of_rsi + header->replicaSpecificInfoLength;
@@ -80,6 +95,7 @@ void MsgReceiver::onNewMessage(bft::communication::NodeNum source, const char* c
   reply.metadata = metadata;
   reply.rsi = std::move(rsi);
   reply.data = Msg(start_of_body, start_of_rsi);
+  reply.digest = digest;
 
   queue_.push(std::move(reply));
 }
@@ -46,6 +46,8 @@ struct UnmatchedReply {
   ReplyMetadata metadata;
   Msg data;
   ReplicaSpecificInfo rsi;
+  // The data is the digest of the reply data, see REPLY_DIGEST_MSG_TYPE
+  bool digest = false;
 };
 
 // A thread-safe queue that allows the ASIO thread to push newly received messages and the client
@@ -62,6 +64,11 @@ class UnmatchedReplyQueue {
   // This function is thread safe.
   std::vector<UnmatchedReply> wait(std::chrono::milliseconds timeout);
 
+  // Make the current or next call to wait return immediately, even if no messages were pushed.
+  //
+  // This function is thread safe.
+  void interrupt();
+
   // Clear the queue.
   //
   // This is only used when the receiver is deactivated.
@@ -71,6 +78,7 @@ class UnmatchedReplyQueue {
 
  private:
   std::vector<UnmatchedReply> msgs_;
+  bool interrupted_ = false;
   std::mutex lock_;
   std::condition_variable cond_var_;
 };
@@ -96,6 +104,9 @@ class MsgReceiver : public bft::communication::IReceiver {
   // This should be called from the thread that calls `Client::send`.
   std::vector<UnmatchedReply> wait(std::chrono::milliseconds timeout);
 
+  // Wake up the waiter, e.g. because it has to wait for a different timeout now.
+  void interrupt() { queue_.interrupt(); }
+
   // We want to drop all replies when there isn't an outstanding request. We also want to know the
   // max size of a reply for an outstanding request so we can drop replies that are too large. This
   // method informs us that a request is in progress. A max_reply_size of 0 means no request is in
@@ -32,6 +32,7 @@
 #include "bftclient/bft_client.h"
 #include "bftclient/fake_comm.h"
 #include "msg_receiver.h"
+#include "sha_hash.hpp"
 
 using namespace std;
 using namespace bft::client;
@@ -522,6 +523,100 @@ TEST_F(ClientApiTestFixture, write_f_plus_one_get_differnt_rsi) {
   client.stop();
 }
 
+TEST_F(ClientApiTestFixture, async_requests_are_pipelined) {
+  // Only reply once all requests were sent, i.e. they have to be outstanding at the same time
+  static constexpr uint64_t kNumRequests = 16;
+  mutex requests_lock;
+  vector<MsgFromClient> requests;
+  auto DelayedWriteBehavior = [&](const MsgFromClient& msg, IReceiver* client_receiver) {
+    lock_guard<mutex> guard(requests_lock);
+    requests.push_back(msg);
+    if (requests.size() < kNumRequests * test_config_.all_replicas.size()) {
+      return;
+    }
+    for (const auto& request : requests) {
+      auto reply = replyFromRequest(request);
+      client_receiver->onNewMessage((NodeNum)request.destination.val, (const char*)reply.data(), reply.size());
+    }
+  };
+
+  unique_ptr<FakeCommunication> comm(new FakeCommunication(DelayedWriteBehavior));
+  Client client(move(comm), test_config_);
+  vector<future<Reply>> futures;
+  for (uint64_t seq_num = 1; seq_num <= kNumRequests; ++seq_num) {
+    WriteConfig config{RequestConfig{false, seq_num}, ByzantineSafeQuorum{}};
+    config.request.timeout = 5s;
+    futures.push_back(client.sendAsync(config, Msg({'h', 'e', 'l', 'l', 'o'})));
+  }
+  Msg expected{'w', 'o', 'r', 'l', 'd'};
+  for (auto& future : futures) {
+    auto reply = future.get();
+    ASSERT_EQ(expected, reply.matched_data);
+    ASSERT_EQ(reply.rsi.size(), 2);
+  }
+  ASSERT_EQ(0, client.numOutstandingAsyncRequests());
+  ASSERT_EQ(client.primary(), ReplicaId_t{0});
+  client.stop();
+}
+
+TEST_F(ClientApiTestFixture, async_request_is_retransmitted) {
+  unique_ptr<FakeCommunication> comm(new FakeCommunication(RetryBehavior{test_config_.all_replicas}));
+  Client client(move(comm), test_config_);
+  ReadConfig read_config{RequestConfig{false, 1}, All{}};
+  read_config.request.timeout = 1s;
+  promise<optional<Reply>> result;
+  client.sendAsync(
+      read_config, Msg({'h', 'e', 'l', 'l', 'o'}), [&](optional<Reply>&& reply) { result.set_value(move(reply)); });
+  auto reply = result.get_future().get();
+  ASSERT_TRUE(reply.has_value());
+  Msg expected{'w', 'o', 'r', 'l', 'd'};
+  ASSERT_EQ(expected, reply->matched_data);
+  client.stop();
+}
+
+TEST_F(ClientApiTestFixture, async_request_times_out) {
+  auto NoReplyBehavior = [&](const MsgFromClient& msg, IReceiver* client_receiver) { return; };
+  unique_ptr<FakeCommunication> comm(new FakeCommunication(NoReplyBehavior));
+  Client client(move(comm), test_config_);
+  WriteConfig config{RequestConfig{false, 1}, LinearizableQuorum{}};
+  config.request.timeout = 200ms;
+  auto future = client.sendAsync(config, Msg({1, 2, 3, 4, 5}));
+  ASSERT_THROW(client.sendAsync(config, Msg({1, 2, 3, 4, 5})), BftClientException);
+  ASSERT_THROW(future.get(), TimeoutException);
+  ASSERT_EQ(0, client.numOutstandingAsyncRequests());
+  client.stop();
+}
+
+TEST_F(ClientApiTestFixture, read_with_reply_digests) {
+  const auto full_replier = fullReplierOf(1, test_config_.all_replicas.size());
+  atomic<size_t> num_digests = 0;
+  auto DigestBehavior = [&](const MsgFromClient& msg, IReceiver* client_receiver) {
+    const auto* req_header = reinterpret_cast<const ClientRequestMsgHeader*>(msg.data.data());
+    auto reply = replyFromRequest(msg);
+    if ((req_header->flags & REPLY_DIGEST_REQ) != 0 && msg.destination.val != full_replier) {
+      auto* reply_header = reinterpret_cast<ClientReplyMsgHeader*>(reply.data());
+      const auto digest = concord::util::SHA2_256{}.digest(reply.data() + sizeof(ClientReplyMsgHeader),
+                                                           reply_header->replyLength);
+      reply_header->msgType = REPLY_DIGEST_MSG_TYPE;
+      reply_header->replyLength = digest.size();
+      reply.resize(sizeof(ClientReplyMsgHeader));
+      reply.insert(reply.end(), digest.begin(), digest.end());
+      num_digests++;
+    }
+    client_receiver->onNewMessage((NodeNum)msg.destination.val, (const char*)reply.data(), reply.size());
+  };
+  unique_ptr<FakeCommunication> comm(new FakeCommunication(DigestBehavior));
+  Client client(move(comm), test_config_);
+  ReadConfig read_config{RequestConfig{false, 1}, All{}};
+  read_config.request.reply_digest = true;
+  auto reply = client.send(read_config, Msg({'h', 'e', 'l', 'l', 'o'}));
+  Msg expected{'w', 'o', 'r', 'l', 'd'};
+  ASSERT_EQ(expected, reply.matched_data);
+  ASSERT_EQ(test_config_.all_replicas.size(), reply.rsi.size());
+  ASSERT_EQ(test_config_.all_replicas.size() - 1, num_digests);
+  client.stop();
+}
+
 int main(int argc, char* argv[]) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
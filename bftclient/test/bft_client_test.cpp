@@ -16,6 +16,7 @@
 #include "bftengine/ClientMsgs.hpp"
 
 #include "msg_receiver.h"
+#include "sha_hash.hpp"
 #include "bftclient/bft_client.h"
 
 using namespace bft::client;
@@ -113,6 +114,28 @@ TEST(msg_receiver_tests, no_replies_bad_msg_type) {
   ASSERT_EQ(0, replies.size());
 }
 
+TEST(msg_receiver_tests, digest_replies) {
+  MsgReceiver receiver;
+  receiver.activate(64 * 1024);
+  auto rsi_len = 5u;
+  for (auto digest_len : {concord::util::SHA2_256::SIZE_IN_BYTES, concord::util::SHA2_256::SIZE_IN_BYTES - 1}) {
+    std::vector<char> reply(sizeof(bftEngine::ClientReplyMsgHeader) + digest_len + rsi_len);
+    auto* header = reinterpret_cast<bftEngine::ClientReplyMsgHeader*>(reply.data());
+    header->msgType = REPLY_DIGEST_MSG_TYPE;
+    header->reqSeqNum = 100;
+    header->replyLength = digest_len + rsi_len;
+    header->replicaSpecificInfoLength = rsi_len;
+    receiver.onNewMessage(1, reply.data(), reply.size());
+  }
+
+  // Only the reply with a digest of the right size is delivered
+  auto replies = receiver.wait(1ms);
+  ASSERT_EQ(1, replies.size());
+  ASSERT_TRUE(replies[0].digest);
+  ASSERT_EQ(Msg(concord::util::SHA2_256::SIZE_IN_BYTES), replies[0].data);
+  ASSERT_EQ(Msg(rsi_len), replies[0].rsi.data);
+}
+
 std::set<ReplicaId> destinations(uint16_t n) {
   std::set<ReplicaId> replicas;
   for (uint16_t i = 0; i < n; i++) {
@@ -268,6 +291,70 @@ TEST(matcher_tests, wait_for_replies_with_ignoring_primary) {
   ASSERT_FALSE(match.value().primary.has_value());
 }
 
+Msg digest_of(const Msg& msg) {
+  auto digest = concord::util::SHA2_256{}.digest(msg.data(), msg.size());
+  return Msg(digest.begin(), digest.end());
+}
+
+TEST(matcher_tests, wait_for_digests_and_full_reply) {
+  uint64_t seq_num = 5;
+  MatchConfig config{MofN{3, destinations(4)}, seq_num};
+  config.reply_digest = true;
+  Matcher matcher(config);
+  ReplicaId primary{1};
+  Msg msg = {'h', 'e', 'l', 'l', 'o'};
+  auto unmatched = unmatched_replies(4, ReplyMetadata{primary, seq_num}, digest_of(msg), create_rsi(4));
+  for (auto& reply : unmatched) {
+    reply.digest = true;
+  }
+  unmatched[3].data = msg;
+  unmatched[3].digest = false;
+
+  // A quorum of digests doesn't match without the full reply
+  ASSERT_EQ(std::nullopt, matcher.onReply(std::move(unmatched[0])));
+  ASSERT_EQ(std::nullopt, matcher.onReply(std::move(unmatched[1])));
+  ASSERT_EQ(std::nullopt, matcher.onReply(std::move(unmatched[2])));
+  ASSERT_EQ(1, matcher.numDifferentReplies());
+
+  auto match = matcher.onReply(std::move(unmatched[3]));
+  ASSERT_TRUE(match.has_value());
+  ASSERT_EQ(msg, match.value().reply.matched_data);
+  ASSERT_EQ(primary, match.value().primary.value());
+  ASSERT_EQ(4, match.value().reply.rsi.size());
+}
+
+TEST(matcher_tests, full_reply_must_match_the_digests) {
+  uint64_t seq_num = 5;
+  MatchConfig config{MofN{2, destinations(4)}, seq_num};
+  config.reply_digest = true;
+  Matcher matcher(config);
+  ReplicaId primary{1};
+  Msg msg = {'h', 'e', 'l', 'l', 'o'};
+  auto rsi = create_rsi(4);
+  auto metadata = ReplyMetadata{primary, seq_num};
+
+  // A full reply which doesn't match the digests doesn't complete their quorum
+  ASSERT_EQ(std::nullopt, matcher.onReply(UnmatchedReply{metadata, digest_of(msg), rsi[0], true}));
+  ASSERT_EQ(std::nullopt, matcher.onReply(UnmatchedReply{metadata, digest_of(msg), rsi[1], true}));
+  ASSERT_EQ(std::nullopt, matcher.onReply(UnmatchedReply{metadata, Msg{'x'}, rsi[2]}));
+  ASSERT_EQ(2, matcher.numDifferentReplies());
+
+  // Any replica can send the full reply
+  auto match = matcher.onReply(UnmatchedReply{metadata, msg, rsi[3]});
+  ASSERT_TRUE(match.has_value());
+  ASSERT_EQ(msg, match.value().reply.matched_data);
+  ASSERT_EQ(3, match.value().reply.rsi.size());
+}
+
+TEST(matcher_tests, digests_are_rejected_without_reply_digest) {
+  uint64_t seq_num = 5;
+  Matcher matcher(MatchConfig{MofN{1, destinations(4)}, seq_num});
+  Msg msg = {'h', 'e', 'l', 'l', 'o'};
+  auto rsi = ReplicaSpecificInfo{ReplicaId{0}, {'r', 's', 'i'}};
+  ASSERT_EQ(std::nullopt, matcher.onReply(UnmatchedReply{ReplyMetadata{ReplicaId{1}, seq_num}, msg, rsi, true}));
+  ASSERT_EQ(0, matcher.numDifferentReplies());
+}
+
 TEST(quorum_tests, valid_quorums_without_destinations) {
   auto all_replicas = destinations(4);
   // Even that we have ro replicas, empty destinations should include only committers. To issue a request to ro replica
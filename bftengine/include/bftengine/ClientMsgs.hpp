@@ -17,6 +17,7 @@
 #define REQUEST_MSG_TYPE (700)
 #define BATCH_REQUEST_MSG_TYPE (750)
 #define REPLY_MSG_TYPE (800)
+#define REPLY_DIGEST_MSG_TYPE (801)
 
 namespace bftEngine {
 
@@ -65,4 +66,11 @@ struct ClientReplyMsgHeader {
 
 #pragma pack(pop)
 
+// A read-only request with the REPLY_DIGEST_FLAG is answered in full by a single replica only. All other replicas reply
+// with a REPLY_DIGEST_MSG_TYPE message: a ClientReplyMsgHeader followed by the SHA-256 digest of the reply data and the
+// replica specific information, i.e. replyLength is the digest size plus replicaSpecificInfoLength.
+inline uint16_t fullReplierOf(uint64_t reqSeqNum, uint16_t numReplicas) {
+  return static_cast<uint16_t>(reqSeqNum % numReplicas);
+}
+
 }  // namespace bftEngine
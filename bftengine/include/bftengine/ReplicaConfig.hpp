@@ -33,7 +33,13 @@ namespace bftEngine {
   CONFIG_PARAM_RO(param, type, default_val, description);   \
   void set##param(const type& val) { param = val; } /* NOLINT(bugprone-macro-parentheses) */
 
-enum BatchingPolicy { BATCH_SELF_ADJUSTED, BATCH_BY_REQ_SIZE, BATCH_BY_REQ_NUM, BATCH_ADAPTIVE };
+enum BatchingPolicy {
+  BATCH_SELF_ADJUSTED,
+  BATCH_BY_REQ_SIZE,
+  BATCH_BY_REQ_NUM,
+  BATCH_ADAPTIVE,
+  BATCH_BY_LATENCY_TARGET
+};
 
 class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConfig> {
  public:
@@ -119,6 +125,14 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
   CONFIG_PARAM(adaptiveBatchingMidIncCond, std::string, "0.9", "The mid increase condition");
   CONFIG_PARAM(adaptiveBatchingMinIncCond, std::string, "0.75", "The min increase condition");
   CONFIG_PARAM(adaptiveBatchingDecCond, std::string, "0.5", "The decrease condition");
+  CONFIG_PARAM(batchingLatencyTargetMillisec,
+               uint32_t,
+               100,
+               "Target p99 consensus latency of the BATCH_BY_LATENCY_TARGET batching policy");
+  CONFIG_PARAM(batchingLatencyMinFlushPeriod,
+               uint32_t,
+               10,
+               "Lower bound of the flush period picked by the BATCH_BY_LATENCY_TARGET batching policy");
 
   // Crypto system
   // RSA public keys of all replicas. map from replica identifier to a public key
@@ -235,6 +249,21 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
   // Post-execution separation feature flag
   CONFIG_PARAM(enablePostExecutionSeparation, bool, true, "Post-execution separation feature flag");
   CONFIG_PARAM(postExecutionQueuesSize, uint16_t, 50, "Post-execution deferred message queues size");
+  CONFIG_PARAM(enableExecutionPipelining,
+               bool,
+               false,
+               "Start executing the next committed PrePrepare before sending the replies, checkpoint messages and "
+               "metrics of the previous one");
+  CONFIG_PARAM(requestTraceSamplesPerMillion,
+               uint32_t,
+               0u,
+               "Number of client requests per million whose critical path stages are traced, 0 disables tracing");
+  CONFIG_PARAM(threadPlacementPolicy,
+               std::string,
+               "",
+               "Placement of the replica threads by role, as 'role=cpus;...' where cpus is a list of CPUs like "
+               "'0-3,8' or a NUMA node like 'node1'. Roles: dispatcher, post_exec, request_pool, pre_processor, comm "
+               "and state_transfer. Empty leaves the threads to the OS scheduler");
 
   // Parameter to enable/disable waiting for transaction data to be persisted.
   CONFIG_PARAM(syncOnUpdateOfMetadata,
@@ -309,6 +338,8 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     serialize(outStream, adaptiveBatchingMidIncCond);
     serialize(outStream, adaptiveBatchingMinIncCond);
     serialize(outStream, adaptiveBatchingDecCond);
+    serialize(outStream, batchingLatencyTargetMillisec);
+    serialize(outStream, batchingLatencyMinFlushPeriod);
 
     serialize(outStream, publicKeysOfReplicas);
     serialize(outStream, publicKeysOfClients);
@@ -360,6 +391,9 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     serialize(outStream, dbCheckpointMonitorIntervalSeconds);
     serialize(outStream, enablePostExecutionSeparation);
     serialize(outStream, postExecutionQueuesSize);
+    serialize(outStream, enableExecutionPipelining);
+    serialize(outStream, requestTraceSamplesPerMillion);
+    serialize(outStream, threadPlacementPolicy);
     serialize(outStream, config_params_);
   }
   void deserializeDataMembers(std::istream& inStream) {
@@ -397,6 +431,8 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     deserialize(inStream, adaptiveBatchingMidIncCond);
     deserialize(inStream, adaptiveBatchingMinIncCond);
     deserialize(inStream, adaptiveBatchingDecCond);
+    deserialize(inStream, batchingLatencyTargetMillisec);
+    deserialize(inStream, batchingLatencyMinFlushPeriod);
 
     deserialize(inStream, publicKeysOfReplicas);
     deserialize(inStream, publicKeysOfClients);
@@ -448,6 +484,9 @@ class ReplicaConfig : public concord::serialize::SerializableFactory<ReplicaConf
     deserialize(inStream, dbCheckpointMonitorIntervalSeconds);
     deserialize(inStream, enablePostExecutionSeparation);
     deserialize(inStream, postExecutionQueuesSize);
+    deserialize(inStream, enableExecutionPipelining);
+    deserialize(inStream, requestTraceSamplesPerMillion);
+    deserialize(inStream, threadPlacementPolicy);
     deserialize(inStream, config_params_);
   }
 
@@ -524,12 +563,17 @@ inline std::ostream& operator<<(std::ostream& os, const ReplicaConfig& rc) {
               rc.threadbagConcurrencyLevel2,
               rc.enablePostExecutionSeparation,
               rc.postExecutionQueuesSize,
+              rc.enableExecutionPipelining,
               rc.dbCheckpointFeatureEnabled,
               rc.maxNumberOfDbCheckpoints,
               rc.dbCheckPointWindowSize,
               rc.dbCheckpointDirPath,
               rc.dbSnapshotIntervalSeconds.count(),
-              rc.dbCheckpointMonitorIntervalSeconds.count());
+              rc.dbCheckpointMonitorIntervalSeconds.count(),
+              rc.batchingLatencyTargetMillisec,
+              rc.batchingLatencyMinFlushPeriod);
+  os << ",";
+  os << KVLOG(rc.requestTraceSamplesPerMillion, rc.threadPlacementPolicy);
 
   for (auto& [param, value] : rc.config_params_) os << param << ": " << value << "\n";
   return os;
@@ -278,7 +278,8 @@ BCStateTran::BCStateTran(const Config &config, IAppState *const stateApi, DataSt
   LOG_INFO(logger_, "Creating BCStateTran object: " << config_);
 
   if (config_.runInSeparateThread) {
-    handoff_.reset(new concord::util::Handoff(config_.myReplicaId));
+    handoff_.reset(
+        new concord::util::Handoff(config_.myReplicaId, concord::util::ThreadPlacement::Role::StateTransfer));
     messageHandler_ = std::bind(&BCStateTran::handoffMsg, this, _1, _2, _3);
     timerHandler_ = std::bind(&BCStateTran::handoffTimer, this);
   } else {
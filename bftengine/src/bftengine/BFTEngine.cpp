@@ -22,6 +22,7 @@
 #include "PreProcessor.hpp"
 #include "MsgReceiver.hpp"
 #include "RequestHandler.h"
+#include "ThreadPlacement.hpp"
 #include "ReservedPagesClient.hpp"
 #include "bftengine/EpochManager.hpp"
 #include "bcstatetransfer/AsyncStateTransferCRE.hpp"
@@ -158,6 +159,8 @@ IReplica::IReplicaPtr IReplica::createNewReplica(const ReplicaConfig &replicaCon
                                                  std::shared_ptr<concord::performance::PerformanceManager> pm,
                                                  const shared_ptr<concord::secretsmanager::ISecretsManagerImpl> &sm,
                                                  const std::function<void(bool)> &viewChangeCallBack) {
+  // Before the replica threads start, also moves the threads the application already started, e.g. state transfer's
+  concord::util::ThreadPlacement::instance().setPolicy(replicaConfig.threadPlacementPolicy);
   shared_ptr<PersistentStorage> persistentStoragePtr;
   if (replicaConfig.debugPersistentStorageEnabled)
     if (metadataStorage == nullptr)
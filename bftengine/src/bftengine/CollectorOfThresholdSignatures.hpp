@@ -15,6 +15,8 @@
 #include <unordered_map>
 #include <set>
 #include <iterator>
+#include <mutex>
+#include <vector>
 
 #include "OpenTracing.hpp"
 #include "PrimitiveTypes.hpp"
@@ -47,7 +49,7 @@ class CollectorOfThresholdSignatures {
     if ((combinedValidSignatureMsg != nullptr) || (replicasInfo.count(repId) > 0)) return false;
 
     // add partialSigMsg to replicasInfo
-    RepInfo info = {partialSigMsg, SigState::Unknown};
+    RepInfo info = {partialSigMsg, SigState::Unknown, false};
     replicasInfo[repId] = info;
 
     numberOfUnknownSignatures++;
@@ -125,6 +127,9 @@ class CollectorOfThresholdSignatures {
 
     processingSignaturesInTheBackground = false;
 
+    // The running accumulation may contain bad shares, so start a new one from the remaining shares
+    resetShareAccumulation();
+
     for (const ReplicaId repId : replicasWithBadSigs) {
       LOG_TRACE(THRESHSIGN_LOG, "replica with bad signature: " << repId);
       RepInfo& repInfo = replicasInfo[repId];
@@ -201,7 +206,7 @@ class CollectorOfThresholdSignatures {
     ConcordAssert(numberOfUnknownSignatures == 0);  // we can use this method to add at most one PART message
 
     // add partialSigMsg to replicasInfo
-    RepInfo info = {partialSigMsg, SigState::Unknown};
+    RepInfo info = {partialSigMsg, SigState::Unknown, false};
     replicasInfo[repId] = info;
 
     // TODO(GG): do we want to verify the partial signature here?
@@ -260,7 +265,11 @@ class CollectorOfThresholdSignatures {
     } else if (numberOfUnknownSignatures >= numOfRequiredSigs) {
       processingSignaturesInTheBackground = true;
 
-      SignaturesProcessingJob* bkJob = new SignaturesProcessingJob(ExternalFunc::thresholdVerifier(expectedSeqNumber),
+      if (!shareAccumulation)
+        shareAccumulation =
+            std::make_shared<ShareAccumulation>(ExternalFunc::thresholdVerifier(expectedSeqNumber), expectedDigest);
+
+      SignaturesProcessingJob* bkJob = new SignaturesProcessingJob(shareAccumulation,
                                                                    &ExternalFunc::incomingMsgsStorage(context),
                                                                    expectedSeqNumber,
                                                                    expectedView,
@@ -268,9 +277,13 @@ class CollectorOfThresholdSignatures {
                                                                    numOfRequiredSigs,
                                                                    context);
 
+      // Prefer the shares that were already folded into the running accumulation, so that the job only has to parse
+      // the ones that completed the quorum
       uint16_t numOfPartSigsInJob = 0;
-      for (std::pair<uint16_t, RepInfo>&& info : replicasInfo) {
-        if (info.second.state != SigState::Invalid) {
+      for (bool folded : {true, false}) {
+        for (auto& info : replicasInfo) {
+          if (numOfPartSigsInJob == numOfRequiredSigs) break;
+          if (info.second.state == SigState::Invalid || info.second.folded != folded) continue;
           auto msg = info.second.partialSigMsg;
           auto sig = msg->signatureBody();
           auto len = msg->signatureLen();
@@ -278,55 +291,138 @@ class CollectorOfThresholdSignatures {
           bkJob->add(info.first, sig, len, span_context);
           numOfPartSigsInJob++;
         }
-
-        if (numOfPartSigsInJob == numOfRequiredSigs) break;
       }
 
       ConcordAssert(numOfPartSigsInJob == numOfRequiredSigs);
 
       ExternalFunc::threadPool(context).add(bkJob);
+    } else {
+      foldNewShares();
     }
   }
 
+  // Sends the shares that are not part of the running accumulation yet to the background threads, so that they are
+  // folded while we keep waiting for the rest of the quorum. At most numOfRequiredSigs shares are folded.
+  void foldNewShares() {
+    ConcordAssert(expectedSeqNumber != 0);
+    if (numOfFoldedSigs >= numOfRequiredSigs) return;
+
+    if (!shareAccumulation)
+      shareAccumulation =
+          std::make_shared<ShareAccumulation>(ExternalFunc::thresholdVerifier(expectedSeqNumber), expectedDigest);
+
+    for (auto& info : replicasInfo) {
+      if (numOfFoldedSigs == numOfRequiredSigs) break;
+      if (info.second.folded || info.second.state == SigState::Invalid) continue;
+
+      auto msg = info.second.partialSigMsg;
+      ExternalFunc::threadPool(context).add(
+          new ShareFoldingJob(shareAccumulation, info.first, msg->signatureBody(), msg->signatureLen()));
+      info.second.folded = true;
+      numOfFoldedSigs++;
+      LOG_TRACE(THRESHSIGN_LOG, KVLOG(expectedSeqNumber, info.first, numOfFoldedSigs));
+    }
+  }
+
+  void resetShareAccumulation() {
+    shareAccumulation.reset();
+    numOfFoldedSigs = 0;
+    for (auto& info : replicasInfo) info.second.folded = false;
+  }
+
+  // Running (optimistic, i.e. without share verification) accumulation of the partial signatures of the expected
+  // seqNum/view/digest. Folding a share parses it (point decompression) and adds it to the accumulator, and the first
+  // one hashes the digest to the curve. This is what the ShareFoldingJobs take off the critical path as the shares
+  // arrive. The Lagrange coefficients and the multi-exponentiation depend on the final set of signers, so they are
+  // still computed by the SignaturesProcessingJob once the quorum is complete, see combine().
+  class ShareAccumulation {
+   public:
+    ShareAccumulation(std::shared_ptr<IThresholdVerifier> thresholdVerifier, const Digest& digest)
+        : verifier{thresholdVerifier}, expectedDigest{digest}, acc{verifier->newAccumulator(false)} {}
+
+    const std::shared_ptr<IThresholdVerifier>& thresholdVerifier() const { return verifier; }
+
+    // Parses the share of srcRepId and adds it to the accumulator; a share that was already folded is ignored
+    void fold(ReplicaId srcRepId, const char* sigBody, uint16_t sigLength) {
+      std::lock_guard<std::mutex> g(lock);
+      if (!folded.insert(srcRepId).second) return;
+      // Hashing the digest to the curve is done once, by the first share that gets here
+      if (folded.size() == 1)
+        acc->setExpectedDigest(reinterpret_cast<unsigned char*>(expectedDigest.content()), DIGEST_SIZE);
+      acc->add(sigBody, sigLength);
+    }
+
+    // Computes the Lagrange coefficients of the folded shares and combines them into the threshold signature
+    void combine(char* outThreshSig, uint16_t threshSigLen) {
+      std::lock_guard<std::mutex> g(lock);
+      acc->getFullSignedData(outThreshSig, threshSigLen);
+    }
+
+   private:
+    const std::shared_ptr<IThresholdVerifier> verifier;
+    const Digest expectedDigest;
+    std::mutex lock;
+    std::unique_ptr<IThresholdAccumulator> acc;
+    std::set<ReplicaId> folded;
+  };
+
+  class ShareFoldingJob : public concord::util::SimpleThreadPool::Job {
+   private:
+    std::shared_ptr<ShareAccumulation> accumulation;
+    const ReplicaId srcRepId;
+    const std::vector<char> sigBody;
+
+    virtual ~ShareFoldingJob() {}
+
+   public:
+    ShareFoldingJob(std::shared_ptr<ShareAccumulation> shareAccumulation,
+                    ReplicaId repId,
+                    const char* sig,
+                    uint16_t sigLength)
+        : accumulation{shareAccumulation}, srcRepId{repId}, sigBody(sig, sig + sigLength) {}
+
+    void release() override { delete this; }
+
+    void execute() override { accumulation->fold(srcRepId, sigBody.data(), (uint16_t)sigBody.size()); }
+  };
+
   class SignaturesProcessingJob : public concord::util::SimpleThreadPool::Job {
    private:
     struct SigData {
       ReplicaId srcRepId;
-      char* sigBody;
-      uint16_t sigLength;
+      std::vector<char> sigBody;
       concordUtils::SpanContext span_context;
     };
 
+    std::shared_ptr<ShareAccumulation> accumulation;
     std::shared_ptr<IThresholdVerifier> verifier;
     IncomingMsgsStorage* const repMsgsStorage;
     const SeqNum expectedSeqNumber;
     const ViewNum expectedView;
     const Digest expectedDigest;
     const uint16_t reqDataItems;
-    SigData* const sigDataItems;
-
-    uint16_t numOfDataItems;
+    std::vector<SigData> sigDataItems;
 
     void* context;
 
     virtual ~SignaturesProcessingJob() {}
 
    public:
-    SignaturesProcessingJob(std::shared_ptr<IThresholdVerifier> thresholdVerifier,
+    SignaturesProcessingJob(std::shared_ptr<ShareAccumulation> shareAccumulation,
                             IncomingMsgsStorage* const replicaMsgsStorage,
                             SeqNum seqNum,
                             ViewNum view,
                             Digest& digest,
                             uint16_t numOfRequired,
                             void* cnt)
-        : verifier{thresholdVerifier},
+        : accumulation{shareAccumulation},
+          verifier{shareAccumulation->thresholdVerifier()},
           repMsgsStorage{replicaMsgsStorage},
           expectedSeqNumber{seqNum},
           expectedView{view},
           expectedDigest{digest},
-          reqDataItems{numOfRequired},
-          sigDataItems{new SigData[numOfRequired]},
-          numOfDataItems(0) {
+          reqDataItems{numOfRequired} {
+      sigDataItems.reserve(reqDataItems);
       this->context = cnt;
       LOG_TRACE(THRESHSIGN_LOG, KVLOG(expectedSeqNumber, expectedView, reqDataItems));
     }
@@ -335,33 +431,16 @@ class CollectorOfThresholdSignatures {
              const char* sigBody,
              uint16_t sigLength,
              const concordUtils::SpanContext& span_context) {
-      ConcordAssert(numOfDataItems < reqDataItems);
-
-      SigData d;
-      d.srcRepId = srcRepId;
-      d.sigLength = sigLength;
-      d.sigBody = (char*)std::malloc(sigLength);
-      d.span_context = span_context;
-      memcpy(d.sigBody, sigBody, sigLength);
-
-      sigDataItems[numOfDataItems] = d;
-      numOfDataItems++;
-      LOG_TRACE(THRESHSIGN_LOG, KVLOG(srcRepId, numOfDataItems));
-    }
+      ConcordAssert(sigDataItems.size() < reqDataItems);
 
-    void release() override {
-      for (uint16_t i = 0; i < numOfDataItems; i++) {
-        SigData& d = sigDataItems[i];
-        std::free(d.sigBody);
-      }
-
-      delete[] sigDataItems;
-
-      delete this;
+      sigDataItems.push_back(SigData{srcRepId, std::vector<char>(sigBody, sigBody + sigLength), span_context});
+      LOG_TRACE(THRESHSIGN_LOG, KVLOG(srcRepId, sigDataItems.size()));
     }
 
+    void release() override { delete this; }
+
     void execute() override {
-      ConcordAssert(numOfDataItems == reqDataItems);
+      ConcordAssert(sigDataItems.size() == reqDataItems);
       MDC_PUT(MDC_REPLICA_ID_KEY, std::to_string(((InternalReplicaApi*)this->context)->getReplicaConfig().replicaId));
       SCOPED_MDC_SEQ_NUM(std::to_string(expectedSeqNumber));
       MDC_PUT(MDC_THREAD_KEY, demangler::demangle<FULL>());
@@ -373,11 +452,12 @@ class CollectorOfThresholdSignatures {
       const auto& span_context_of_last_message =
           (reqDataItems - 1) ? sigDataItems[reqDataItems - 1].span_context : concordUtils::SpanContext{};
       {
-        // optimistically, don't use share verification
-        std::unique_ptr<IThresholdAccumulator> acc{verifier->newAccumulator(false)};
-        for (uint16_t i = 0; i < reqDataItems; i++) acc->add(sigDataItems[i].sigBody, sigDataItems[i].sigLength);
-        acc->setExpectedDigest(reinterpret_cast<unsigned char*>(expectedDigest.content()), DIGEST_SIZE);
-        acc->getFullSignedData(bufferForSigComputations.data(), bufferSize);
+        // optimistically, don't use share verification. Most shares were already parsed into the accumulation by
+        // ShareFoldingJobs while the quorum was being collected; fold the ones whose job did not run yet, then
+        // interpolate.
+        for (const auto& d : sigDataItems)
+          accumulation->fold(d.srcRepId, d.sigBody.data(), (uint16_t)d.sigBody.size());
+        accumulation->combine(bufferForSigComputations.data(), bufferSize);
       }
 
       if (!verifier->verify((char*)&expectedDigest, sizeof(Digest), bufferForSigComputations.data(), bufferSize)) {
@@ -385,7 +465,7 @@ class CollectorOfThresholdSignatures {
         // this still can succeed if there're enough valid shares.
         // at least replica with bad   signatures will be identified.
         std::unique_ptr<IThresholdAccumulator> acc{verifier->newAccumulator(true)};
-        for (uint16_t i = 0; i < reqDataItems; i++) acc->add(sigDataItems[i].sigBody, sigDataItems[i].sigLength);
+        for (const auto& d : sigDataItems) acc->add(d.sigBody.data(), (int)d.sigBody.size());
         acc->setExpectedDigest(reinterpret_cast<unsigned char*>(expectedDigest.content()), DIGEST_SIZE);
         acc->getFullSignedData(bufferForSigComputations.data(), bufferSize);
         if (!verifier->verify((char*)&expectedDigest, sizeof(Digest), bufferForSigComputations.data(), bufferSize)) {
@@ -466,6 +546,9 @@ class CollectorOfThresholdSignatures {
 
     numberOfUnknownSignatures = 0;
 
+    shareAccumulation.reset();
+    numOfFoldedSigs = 0;
+
     for (auto&& m : replicasInfo) {
       RepInfo& repInfo = m.second;
       delete repInfo.partialSigMsg;
@@ -495,6 +578,7 @@ class CollectorOfThresholdSignatures {
   struct RepInfo {
     PART* partialSigMsg;
     SigState state;
+    bool folded;  // whether the share was sent to the running accumulation
   };
 
   bool processingSignaturesInTheBackground = false;
@@ -502,6 +586,9 @@ class CollectorOfThresholdSignatures {
   uint16_t numberOfUnknownSignatures = 0;
   std::unordered_map<ReplicaId, RepInfo> replicasInfo;  // map from replica Id to RepInfo
 
+  std::shared_ptr<ShareAccumulation> shareAccumulation;  // created once the expected digest is known
+  uint16_t numOfFoldedSigs = 0;
+
   FULL* combinedValidSignatureMsg = nullptr;
   FULL* candidateCombinedSignatureMsg = nullptr;  // holds msg when expectedSeqNumber is not known yet
 
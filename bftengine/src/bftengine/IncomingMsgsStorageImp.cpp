@@ -13,7 +13,10 @@
 
 #include "IncomingMsgsStorageImp.hpp"
 #include "messages/InternalMessage.hpp"
+#include "RequestTracer.hpp"
+#include "ClientMsgs.hpp"
 #include "Logger.hpp"
+#include "ThreadPlacement.hpp"
 #include <future>
 
 using std::queue;
@@ -70,6 +73,11 @@ bool IncomingMsgsStorageImp::pushExternalMsg(std::unique_ptr<MessageBase> msg) {
 bool IncomingMsgsStorageImp::pushExternalMsg(std::unique_ptr<MessageBase> msg, Callback onMsgPopped) {
   MsgCode::Type type = static_cast<MsgCode::Type>(msg->type());
   LOG_TRACE(MSGS, type);
+  if (type == MsgCode::ClientRequest && RequestTracer::instance().enabled() &&
+      msg->size() >= sizeof(ClientRequestMsgHeader)) {
+    const auto* header = reinterpret_cast<const ClientRequestMsgHeader*>(msg->body());
+    RequestTracer::instance().trace(header->idOfClientProxy, header->reqSeqNum, RequestTracer::Stage::Received);
+  }
   std::unique_lock<std::mutex> mlock(lock_);
   if (ptrProtectedQueueForExternalMessages_->size() >= maxNumberOfPendingExternalMsgs_) {
     Time now = getMonotonicTime();
@@ -164,6 +172,7 @@ void IncomingMsgsStorageImp::dispatchMessages(std::promise<void>& signalStarted)
   signalStarted.set_value();
   MDC_PUT(MDC_REPLICA_ID_KEY, std::to_string(replicaId_));
   MDC_PUT(MDC_THREAD_KEY, "message-processing");
+  concord::util::ThreadPlacement::instance().place(concord::util::ThreadPlacement::Role::Dispatcher);
   try {
     while (!stopped_) {
       auto msg = getMsgForProcessing();
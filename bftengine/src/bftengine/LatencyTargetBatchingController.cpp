@@ -0,0 +1,57 @@
+// Concord
+//
+// Copyright (c) 2020 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#include "LatencyTargetBatchingController.hpp"
+
+#include <algorithm>
+
+namespace bftEngine::batchingLogic {
+
+using namespace std;
+
+LatencyTargetBatchingController::LatencyTargetBatchingController(const Config &config)
+    : config_(config),
+      inFlightLimit_(max(config.maxInFlight, 1u)),
+      flushPeriodMs_(max(config.minFlushPeriodMs, config.maxFlushPeriodMs)) {
+  samples_.reserve(max(config_.samplesPerAdjustment, 1u));
+}
+
+void LatencyTargetBatchingController::onConsensusLatency(uint64_t latencyMs) {
+  samples_.push_back(latencyMs);
+  if (samples_.size() >= config_.samplesPerAdjustment) adjust();
+}
+
+uint32_t LatencyTargetBatchingController::batchSize(uint64_t requestsInQueue, uint64_t inFlight) const {
+  if (requestsInQueue == 0 || !canStartConsensus(inFlight)) return 0;
+  // Every sequence number in flight slows the others down, so a new one has to carry at least as many requests as there
+  // are in flight to be worth it. Smaller batches wait for the flush timer.
+  if (requestsInQueue < min<uint64_t>(inFlight, config_.maxBatchSize)) return 0;
+  return (uint32_t)min<uint64_t>(requestsInQueue, max(config_.maxBatchSize, 1u));
+}
+
+void LatencyTargetBatchingController::adjust() {
+  auto p99 = samples_.begin() + (samples_.size() * 99) / 100;
+  nth_element(samples_.begin(), p99, samples_.end());
+  lastP99Ms_ = *p99;
+  samples_.clear();
+
+  if (lastP99Ms_ <= config_.targetP99Ms) {
+    if (inFlightLimit_ < config_.maxInFlight) inFlightLimit_++;
+  } else {
+    inFlightLimit_ = max((uint32_t)(inFlightLimit_ * config_.decreaseFactor), 1u);
+  }
+
+  const uint64_t headroom = config_.targetP99Ms > lastP99Ms_ ? config_.targetP99Ms - lastP99Ms_ : 0;
+  flushPeriodMs_ = (uint32_t)min<uint64_t>(max<uint64_t>(headroom, config_.minFlushPeriodMs),
+                                           max(config_.minFlushPeriodMs, config_.maxFlushPeriodMs));
+}
+
+}  // namespace bftEngine::batchingLogic
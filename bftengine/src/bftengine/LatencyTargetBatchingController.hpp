@@ -0,0 +1,62 @@
+// Concord
+//
+// Copyright (c) 2020 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace bftEngine::batchingLogic {
+
+// Decision logic of the BATCH_BY_LATENCY_TARGET policy, kept free of any replica state so that it can be driven by
+// both RequestsBatchingLogic and the batching simulation tests.
+//
+// The controller applies AIMD to the number of sequence numbers the primary keeps in flight: every
+// samplesPerAdjustment consensus latencies it computes their p99, and either grows the limit by one (p99 within the
+// target) or shrinks it by decreaseFactor (p99 above the target). Batches are cut as soon as there is a free slot and
+// hold whatever is queued, so a lower limit translates into fewer, larger batches.
+class LatencyTargetBatchingController {
+ public:
+  struct Config {
+    uint32_t targetP99Ms = 100;
+    uint32_t maxBatchSize = 100;
+    uint32_t maxInFlight = 30;
+    uint32_t minFlushPeriodMs = 10;
+    uint32_t maxFlushPeriodMs = 1000;
+    uint32_t samplesPerAdjustment = 64;
+    double decreaseFactor = 0.7;
+  };
+
+  explicit LatencyTargetBatchingController(const Config &config);
+
+  void onConsensusLatency(uint64_t latencyMs);
+
+  // Returns the number of requests the next PrePrepare should carry, or 0 if the primary should wait.
+  uint32_t batchSize(uint64_t requestsInQueue, uint64_t inFlight) const;
+  bool canStartConsensus(uint64_t inFlight) const { return inFlight < inFlightLimit_; }
+
+  // How long a partially filled batch may wait for more requests: the latency headroom left below the target.
+  uint32_t flushPeriodMs() const { return flushPeriodMs_; }
+  uint32_t inFlightLimit() const { return inFlightLimit_; }
+  uint64_t lastP99Ms() const { return lastP99Ms_; }
+
+ private:
+  void adjust();
+
+ private:
+  const Config config_;
+  uint32_t inFlightLimit_;
+  uint32_t flushPeriodMs_;
+  uint64_t lastP99Ms_ = 0;
+  std::vector<uint64_t> samples_;
+};
+
+}  // namespace bftEngine::batchingLogic
@@ -32,6 +32,9 @@ class MsgsCommunicator {
   uint32_t numOfConnectedReplicas(uint32_t clusterSize);
   bool isReplicaConnected(uint16_t repId);
   bool isUdp();
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator) {
+    communication_->setAggregator(aggregator);
+  }
 
   [[nodiscard]] bool isMsgsProcessingRunning() const { return incomingMsgsStorage_->isRunning(); }
   int sendAsyncMessage(bft::communication::NodeNum destNode, char* message, size_t messageLength);
@@ -61,6 +61,8 @@
 #include "secrets_manager_plain.h"
 #include "bftengine/EpochManager.hpp"
 #include "RequestThreadPool.hpp"
+#include "RequestTracer.hpp"
+#include "ThreadPlacement.hpp"
 #include "DbCheckpointManager.hpp"
 #include "communication/StateControl.hpp"
 
@@ -286,11 +288,18 @@ void ReplicaImp::asyncValidateMessage(MSG *msg) {
   // This function is called in a single thread as the queue by dispatcher will not allow multiple threads together.
   try {
     static auto &threadPool = RequestThreadPool::getThreadPool(RequestThreadPool::PoolLevel::STARTING);
+    // Read on the dispatcher thread, which owns the view. Backups never put requests into a PrePrepare, and if the view
+    // changes meanwhile, finishAddingRequests() computes the missing digests itself.
+    const bool isPrimary = isCurrentPrimary();
 
     threadPool.async(
-        [this](auto *unValidatedMsg, auto *replicaInfo, auto *incomingMessageQueue) {
+        [this, isPrimary](auto *unValidatedMsg, auto *replicaInfo, auto *incomingMessageQueue) {
           try {
             unValidatedMsg->validate(*replicaInfo);
+            if constexpr (std::is_same_v<MSG, ClientRequestMsg>) {
+              // Computed here, off the dispatcher thread, for the PrePrepare the request will get into
+              if (isPrimary && !unValidatedMsg->isReadOnly()) unValidatedMsg->sigOrDigest();
+            }
             CarrierMesssage *validatedCarrierMsg = new ValidatedMessageCarrierInternalMsg<MSG>(unValidatedMsg);
             incomingMessageQueue->pushInternalMsg(validatedCarrierMsg);
           } catch (std::exception &e) {
@@ -395,6 +404,7 @@ void ReplicaImp::onMessage<ClientRequestMsg>(ClientRequestMsg *m) {
   const bool readOnly = m->isReadOnly();
   const ReqId reqSeqNum = m->requestSeqNum();
   const uint64_t flags = m->flags();
+  RequestTracer::instance().trace(clientId, reqSeqNum, RequestTracer::Stage::Dequeued);
 
   SCOPED_MDC_PRIMARY(std::to_string(currentPrimary()));
   SCOPED_MDC_CID(m->getCid());
@@ -483,7 +493,7 @@ void ReplicaImp::onMessage<ClientRequestMsg>(ClientRequestMsg *m) {
       if (clientsManager->canBecomePending(clientId, reqSeqNum)) {
         LOG_DEBUG(CNSUS, "Pushing to primary queue, request " << KVLOG(reqSeqNum, clientId, senderId));
         if (time_to_collect_batch_ == MinTime) time_to_collect_batch_ = getMonotonicTime();
-        requestsQueueOfPrimary.push(m);
+        requestsQueueOfPrimary.push_back(m);
         primaryCombinedReqSize += m->size();
         primary_queue_size_.Get().Set(requestsQueueOfPrimary.size());
         tryToSendPrePrepareMsg(true);
@@ -608,7 +618,7 @@ void ReplicaImp::removeDuplicatedRequestsFromRequestsQueue() {
   ClientRequestMsg *first = (!requestsQueueOfPrimary.empty() ? requestsQueueOfPrimary.front() : nullptr);
   while (first != nullptr && !clientsManager->canBecomePending(first->clientProxyId(), first->requestSeqNum())) {
     primaryCombinedReqSize -= first->size();
-    requestsQueueOfPrimary.pop();
+    requestsQueueOfPrimary.pop_front();
     delete first;
     first = (!requestsQueueOfPrimary.empty() ? requestsQueueOfPrimary.front() : nullptr);
   }
@@ -682,7 +692,22 @@ bool ReplicaImp::tryToSendPrePrepareMsg(bool batchingLogic) {
   return true;
 }
 
-PrePrepareMsg *ReplicaImp::createPrePrepareMessage() {
+// Returns the total size of the requests at the head of the primary queue that the next PrePrepare will carry, so that
+// it can be allocated with its final size: at most maxNumOfRequests of them, until their size reaches
+// minBatchSizeInBytes.
+uint64_t ReplicaImp::sizeOfNextBatchOfRequests(uint32_t maxNumOfRequests, uint32_t minBatchSizeInBytes) const {
+  uint64_t size = 0;
+  uint32_t numOfRequests = 0;
+  for (const auto *req : requestsQueueOfPrimary) {
+    if (numOfRequests >= maxNumOfRequests || size >= minBatchSizeInBytes) break;
+    if (!clientsManager->canBecomePending(req->clientProxyId(), req->requestSeqNum())) continue;
+    size += req->size();
+    numOfRequests++;
+  }
+  return size;
+}
+
+PrePrepareMsg *ReplicaImp::createPrePrepareMessage(uint64_t requestsSize) {
   CommitPath firstPath = controller->getCurrentFirstPath();
   ConcordAssertOR((config_.getcVal() != 0), (firstPath != CommitPath::FAST_WITH_THRESHOLD));
   if (requestsQueueOfPrimary.empty()) {
@@ -702,9 +727,10 @@ PrePrepareMsg *ReplicaImp::createPrePrepareMessage() {
                                 (primaryLastUsedSeqNum + 1),
                                 firstPath,
                                 requestsQueueOfPrimary.front()->spanContext<ClientRequestMsg>(),
-                                primaryCombinedReqSize + timeServiceMsg->size());
+                                requestsSize + timeServiceMsg->size());
     // add time-Service request as first message in pre-prepare message
-    pp->addRequest(timeServiceMsg->body(), timeServiceMsg->size());
+    timeServiceMsg->sigOrDigest();
+    pp->addRequest(*timeServiceMsg);
     return pp;
   }
   return new PrePrepareMsg(config_.getreplicaId(),
@@ -712,7 +738,7 @@ PrePrepareMsg *ReplicaImp::createPrePrepareMessage() {
                            (primaryLastUsedSeqNum + 1),
                            firstPath,
                            requestsQueueOfPrimary.front()->spanContext<ClientRequestMsg>(),
-                           primaryCombinedReqSize);
+                           requestsSize);
 }
 
 ClientRequestMsg *ReplicaImp::addRequestToPrePrepareMessage(ClientRequestMsg *&nextRequest,
@@ -721,17 +747,21 @@ ClientRequestMsg *ReplicaImp::addRequestToPrePrepareMessage(ClientRequestMsg *&n
   if (nextRequest->size() <= prePrepareMsg.remainingSizeForRequests()) {
     SCOPED_MDC_CID(nextRequest->getCid());
     if (clientsManager->canBecomePending(nextRequest->clientProxyId(), nextRequest->requestSeqNum())) {
-      prePrepareMsg.addRequest(nextRequest->body(), nextRequest->size());
+      prePrepareMsg.addRequest(*nextRequest);
       clientsManager->addPendingRequest(
           nextRequest->clientProxyId(), nextRequest->requestSeqNum(), nextRequest->getCid());
     }
-  } else if (nextRequest->size() > maxStorageForRequests) {  // The message is too big
+  } else if (prePrepareMsg.remainingSizeForRequests() == maxStorageForRequests) {  // The message is too big
     LOG_WARN(GL,
              "Request was dropped because it exceeds maximum allowed size" << KVLOG(
                  prePrepareMsg.seqNumber(), nextRequest->senderId(), nextRequest->size(), maxStorageForRequests));
+  } else {
+    // The PrePrepare is allocated with the size of the requests expected to fill it (see sizeOfNextBatchOfRequests),
+    // so a request that does not fit is left for the next one
+    return nullptr;
   }
   primaryCombinedReqSize -= nextRequest->size();
-  requestsQueueOfPrimary.pop();
+  requestsQueueOfPrimary.pop_front();
   delete nextRequest;
   primary_queue_size_.Get().Set(requestsQueueOfPrimary.size());
   return (!requestsQueueOfPrimary.empty() ? requestsQueueOfPrimary.front() : nullptr);
@@ -816,7 +846,8 @@ std::pair<PrePrepareMsg *, bool> ReplicaImp::finishAddingRequestsToPrePrepareMsg
 // So the second value of the pair provides the real indication of success of failure.
 std::pair<PrePrepareMsg *, bool> ReplicaImp::buildPrePrepareMessage() {
   TimeRecorder scoped_timer(*histograms_.buildPrePrepareMessage);
-  PrePrepareMsg *prePrepareMsg = createPrePrepareMessage();
+  PrePrepareMsg *prePrepareMsg = createPrePrepareMessage(sizeOfNextBatchOfRequests(
+      std::numeric_limits<uint32_t>::max(), std::numeric_limits<uint32_t>::max()));
   if (!prePrepareMsg) return std::make_pair(nullptr, false);
 
   if (!getReplicaConfig().prePrepareFinalizeAsyncEnabled) {
@@ -836,7 +867,12 @@ std::pair<PrePrepareMsg *, bool> ReplicaImp::buildPrePrepareMessage() {
 // The preprepare message can be nullptr if the finalisation is happening in a separate thread.
 // So the second value of the pair provides the real indication of success of failure.
 std::pair<PrePrepareMsg *, bool> ReplicaImp::buildPrePrepareMessageByRequestsNum(uint32_t requiredRequestsNum) {
-  PrePrepareMsg *prePrepareMsg = createPrePrepareMessage();
+  // The time service request, if any, is counted in requiredRequestsNum
+  const uint32_t timeServiceRequests = config_.timeServiceEnabled ? 1 : 0;
+  const uint32_t clientRequestsNum =
+      requiredRequestsNum > timeServiceRequests ? requiredRequestsNum - timeServiceRequests : 0;
+  PrePrepareMsg *prePrepareMsg =
+      createPrePrepareMessage(sizeOfNextBatchOfRequests(clientRequestsNum, std::numeric_limits<uint32_t>::max()));
   if (!prePrepareMsg) return std::make_pair(nullptr, false);
   if (!getReplicaConfig().prePrepareFinalizeAsyncEnabled) {
     SCOPED_MDC("pp_msg_cid", prePrepareMsg->getCid());
@@ -853,7 +889,8 @@ std::pair<PrePrepareMsg *, bool> ReplicaImp::buildPrePrepareMessageByRequestsNum
 // The preprepare message can be nullptr if the finalisation is happening in a separate thread.
 // So the second value of the pair provides the real indication of success of failure.
 std::pair<PrePrepareMsg *, bool> ReplicaImp::buildPrePrepareMessageByBatchSize(uint32_t requiredBatchSizeInBytes) {
-  PrePrepareMsg *prePrepareMsg = createPrePrepareMessage();
+  PrePrepareMsg *prePrepareMsg = createPrePrepareMessage(
+      sizeOfNextBatchOfRequests(std::numeric_limits<uint32_t>::max(), requiredBatchSizeInBytes));
   if (!prePrepareMsg) return std::make_pair(nullptr, false);
   if (!getReplicaConfig().prePrepareFinalizeAsyncEnabled) {
     SCOPED_MDC("pp_msg_cid", prePrepareMsg->getCid());
@@ -899,6 +936,7 @@ void ReplicaImp::startConsensusProcess(PrePrepareMsg *pp, bool isCreatedEarlier)
                                         << " correlation ids: " << pp->getBatchCorrelationIdAsString());
 
   consensus_times_.start(primaryLastUsedSeqNum);
+  RequestTracer::instance().trace(pp, RequestTracer::Stage::PrePrepared);
 
   SeqNumInfo &seqNumInfo = mainLog->get(primaryLastUsedSeqNum);
   {
@@ -1107,6 +1145,7 @@ void ReplicaImp::onMessage<PrePrepareMsg>(PrePrepareMsg *msg) {
     // All pre-prepare messages are added in seqNumInfo even if replica detects incorrect time
     if (seqNumInfo.addMsg(msg, false, time_is_ok)) {
       msgAdded = true;
+      RequestTracer::instance().trace(msg, RequestTracer::Stage::PrePrepared);
 
       // Start tracking all client requests with in this pp message
       RequestsIterator reqIter(msg);
@@ -3223,7 +3262,7 @@ void ReplicaImp::onNewView(const std::vector<PrePrepareMsg *> &prePreparesForNew
   while (!requestsQueueOfPrimary.empty()) {
     auto msg = requestsQueueOfPrimary.front();
     primaryCombinedReqSize -= msg->size();
-    requestsQueueOfPrimary.pop();
+    requestsQueueOfPrimary.pop_front();
     delete msg;
   }
 
@@ -3252,6 +3291,8 @@ void ReplicaImp::onNewView(const std::vector<PrePrepareMsg *> &prePreparesForNew
 
 void ReplicaImp::sendCheckpointIfNeeded() {
   if (isCollectingState() || !currentViewIsActive()) return;
+  // Set again below if this call has to be deferred too
+  isSendCheckpointIfNeeded_ = false;
 
   const SeqNum lastCheckpointNumber = (lastExecutedSeqNum / checkpointWindowSize) * checkpointWindowSize;
 
@@ -4508,6 +4549,8 @@ void ReplicaImp::stop() {
   timers_.cancel(infoReqTimer_);
   timers_.cancel(statusReportTimer_);
   timers_.cancel(clientRequestsRetransmissionTimer_);
+  if (config_.requestTraceSamplesPerMillion > 0) timers_.cancel(requestTraceTimer_);
+  if (!config_.threadPlacementPolicy.empty()) timers_.cancel(threadPlacementTimer_);
   if (viewChangeProtocolEnabled) timers_.cancel(viewChangeTimer_);
   ReplicaForStateTransfer::stop();
 }
@@ -4556,12 +4599,26 @@ void ReplicaImp::addTimers() {
   infoReqTimer_ = timers_.add(milliseconds(dynamicUpperLimitOfRounds->upperLimit() / 2),
                               Timers::Timer::RECURRING,
                               [this](Timers::Handle h) { onInfoRequestTimer(h); });
+
+  if (config_.requestTraceSamplesPerMillion > 0) {
+    requestTraceTimer_ = timers_.add(
+        milliseconds(100), Timers::Timer::RECURRING, [](Timers::Handle) { RequestTracer::instance().aggregate(); });
+  }
+  if (!config_.threadPlacementPolicy.empty()) {
+    threadPlacementTimer_ = timers_.add(milliseconds(1000), Timers::Timer::RECURRING, [](Timers::Handle) {
+      concord::util::ThreadPlacement::instance().updateMetrics();
+    });
+  }
 }
 
 void ReplicaImp::start() {
   LOG_INFO(GL, "Running ReplicaImp");
   sigManager_->SetAggregator(aggregator_);
   KeyExchangeManager::instance().setAggregator(aggregator_);
+  RequestTracer::instance().setAggregator(aggregator_);
+  RequestTracer::instance().setSamplesPerMillion(config_.requestTraceSamplesPerMillion);
+  concord::util::ThreadPlacement::instance().setAggregator(aggregator_);
+  msgsCommunicator_->setAggregator(aggregator_);
   ReplicaForStateTransfer::start();
 
   if (config_.timeServiceEnabled) {
@@ -4660,6 +4717,10 @@ void ReplicaImp::executeReadOnlyRequest(concordUtils::SpanWrapper &parent_span,
     if (actualReplyLength > 0) {
       reply.setReplyLength(actualReplyLength);
       reply.setReplicaSpecificInfoLength(actualReplicaSpecificInfoLength);
+      if ((request->flags() & REPLY_DIGEST_FLAG) != 0 &&
+          config_.getreplicaId() != fullReplierOf(request->requestSeqNum(), config_.getnumReplicas())) {
+        reply.replaceWithDigest();
+      }
       send(&reply, clientId);
       return;
     } else {
@@ -4743,6 +4804,41 @@ void ReplicaImp::tryToStartOrFinishExecution(bool requestMissingInfo) {
   startPrePrepareMsgExecution(prePrepareMsg, allowParallel, false);
 }
 
+// Execution pipelining: called by finishExecutePrePrepareMsg once the metadata of lastExecutedSeqNum has been
+// committed, and starts the execution of lastExecutedSeqNum + 1 before the replies, checkpoint messages and metrics of
+// lastExecutedSeqNum are handled, so that the post-execution thread does not wait for them.
+//
+// Ordering guarantees:
+// - At most one PrePrepare is executed at a time (activeExecutions_ <= 1), and sequence numbers execute in order.
+// - Everything that depends on the state at lastExecutedSeqNum is done before the next execution starts: the replies
+//   are recorded in the clients manager (so duplicates in the next PrePrepare are detected), the checkpoint of the
+//   state is created and the application persists its last block id.
+// - The replies of lastExecutedSeqNum may be sent after replies of special requests of the next sequence number.
+// - A checkpoint that can only be marked stable while no execution is active (see sendCheckpointIfNeeded) stops the
+//   pipelining for one sequence number, so that it is handled after that execution instead of after the whole chain.
+//   Messages deferred while executing (checkpoint, view change and state transfer messages) are handled once the
+//   execution stops, which happens at the latest at the end of the work window, as without pipelining.
+//
+// Recovery: the metadata transaction of lastExecutedSeqNum is committed before the descriptor of the next execution is
+// written, exactly as without pipelining. After a crash the persisted descriptor is always of lastExecutedSeqNum + 1,
+// and the recovery re-executes at most that single sequence number. Replies that were not sent before a crash are sent
+// again from the clients manager when the client retries.
+bool ReplicaImp::tryToPipelineNextExecution() {
+  if (!config_.enableExecutionPipelining || !config_.enablePostExecutionSeparation) return false;
+  if (activeExecutions_ > 0 || isCollectingState() || !currentViewIsActive()) return false;
+  if (isSendCheckpointIfNeeded_) return false;
+  if (lastExecutedSeqNum >= lastStableSeqNum + kWorkWindowSize) return false;
+  if (isSeqNumToStopAt(lastExecutedSeqNum + 1)) return false;
+
+  const SeqNumInfo &seqNumInfo = mainLog->get(lastExecutedSeqNum + 1);
+  PrePrepareMsg *prePrepareMsg = seqNumInfo.getPrePrepareMsg();
+  if (prePrepareMsg == nullptr || !seqNumInfo.isCommitted__gg()) return false;
+
+  LOG_DEBUG(CNSUS, "Pipelining execution of " << KVLOG(prePrepareMsg->seqNumber()));
+  startPrePrepareMsgExecution(prePrepareMsg, true, false);
+  return true;
+}
+
 // TODO(GG): this method is also used for recovery
 // TODO(GG): notice that we use Internal messages (and we may use them during recovery)
 // TODO(GG): handle histograms_.executeRequestsInPrePrepareMsg
@@ -5082,8 +5178,9 @@ void ReplicaImp::finishExecutePrePrepareMsg(PrePrepareMsg *ppMsg,
                                             IRequestsHandler::ExecutionRequestsQueue *pAccumulatedRequests) {
   activeExecutions_ = 0;
 
+  RepliesToSend repliesToSend;
   if (pAccumulatedRequests != nullptr) {
-    sendResponses(ppMsg, *pAccumulatedRequests);
+    sendResponses(ppMsg, *pAccumulatedRequests, config_.enableExecutionPipelining ? &repliesToSend : nullptr);
     delete pAccumulatedRequests;
   }
   LOG_INFO(CNSUS, "Finished execution of request seqNum:" << ppMsg->seqNumber());
@@ -5102,6 +5199,10 @@ void ReplicaImp::finishExecutePrePrepareMsg(PrePrepareMsg *ppMsg,
 
   if (ps_) ps_->endWriteTran(config_.getsyncOnUpdateOfMetadata());
 
+  // The rest of the work for this sequence number overlaps with the execution of the next one
+  tryToPipelineNextExecution();
+  for (auto &[clientId, replyMsg] : repliesToSend) send(replyMsg.get(), clientId);
+
   sendCheckpointIfNeeded();
 
   bool firstCommitPathChanged = controller->onNewSeqNumberExecution(lastExecutedSeqNum);
@@ -5197,6 +5298,7 @@ void ReplicaImp::updateLimitsAndMetrics(PrePrepareMsg *ppMsg) {
     auto numOfRequests = ppMsg->numberOfRequests();
     if (numOfRequests > 0) {
       consensus_time_.add(seqNumInfo.getCommitDurationMs());
+      reqBatchingLogic_.onConsensusLatency(seqNumInfo.getCommitDurationMs());
       consensus_avg_time_.Get().Set((uint64_t)consensus_time_.avg());
       if (consensus_time_.numOfElements() == 1000) consensus_time_.reset();  // We reset the average every 1000 samples
       metric_last_executed_seq_num_.Get().Set(lastExecutedSeqNum);
@@ -5618,8 +5720,16 @@ void ReplicaImp::executeRequestsAndSendResponses(PrePrepareMsg *ppMsg,
   sendResponses(ppMsg, accumulatedRequests);
 }
 
-void ReplicaImp::sendResponses(PrePrepareMsg *ppMsg, IRequestsHandler::ExecutionRequestsQueue &accumulatedRequests) {
+void ReplicaImp::sendResponses(PrePrepareMsg *ppMsg,
+                               IRequestsHandler::ExecutionRequestsQueue &accumulatedRequests,
+                               RepliesToSend *repliesToSend) {
   TimeRecorder scoped_timer(*histograms_.prepareAndSendResponses);
+  auto &tracer = RequestTracer::instance();
+  if (tracer.enabled()) {
+    for (const auto &req : accumulatedRequests) {
+      tracer.trace(req.clientId, req.requestSequenceNum, RequestTracer::Stage::Executed);
+    }
+  }
   for (auto &req : accumulatedRequests) {
     auto executionResult = req.outExecutionStatus;
     std::unique_ptr<ClientReplyMsg> replyMsg;
@@ -5636,10 +5746,14 @@ void ReplicaImp::sendResponses(PrePrepareMsg *ppMsg, IRequestsHandler::Execution
                                                                         req.outActualReplySize,
                                                                         req.outReplicaSpecificInfoSize,
                                                                         executionResult);
-        send(replyMsg.get(), req.clientId);
+        if (repliesToSend != nullptr)
+          repliesToSend->emplace_back(req.clientId, std::move(replyMsg));
+        else
+          send(replyMsg.get(), req.clientId);
         free(req.outReply);
         req.outReply = nullptr;
         clientsManager->removePendingForExecutionRequest(req.clientId, req.requestSequenceNum);
+        tracer.trace(req.clientId, req.requestSequenceNum, RequestTracer::Stage::Replied);
         continue;
       } else {
         LOG_WARN(CNSUS, "Received zero size response." << KVLOG(req.clientId, req.requestSequenceNum, ppMsg->getCid()));
@@ -5656,10 +5770,14 @@ void ReplicaImp::sendResponses(PrePrepareMsg *ppMsg, IRequestsHandler::Execution
                                                                     req.outActualReplySize,
                                                                     0,
                                                                     executionResult);
-    send(replyMsg.get(), req.clientId);
+    if (repliesToSend != nullptr)
+      repliesToSend->emplace_back(req.clientId, std::move(replyMsg));
+    else
+      send(replyMsg.get(), req.clientId);
     free(req.outReply);
     req.outReply = nullptr;
     clientsManager->removePendingForExecutionRequest(req.clientId, req.requestSequenceNum);
+    tracer.trace(req.clientId, req.requestSequenceNum, RequestTracer::Stage::Replied);
   }
 }
 
@@ -5712,8 +5830,10 @@ void ReplicaImp::executeNextCommittedRequests(concordUtils::SpanWrapper &parent_
     ConcordAssertEQ(prePrepareMsg->viewNumber(), getCurrentView());  // TODO(GG): TBD
     const uint16_t numOfRequests = prePrepareMsg->numberOfRequests();
 
+    RequestTracer::instance().trace(prePrepareMsg, RequestTracer::Stage::Committed);
     executeRequestsInPrePrepareMsg(span, prePrepareMsg);
     consensus_time_.add(seqNumInfo.getCommitDurationMs());
+    reqBatchingLogic_.onConsensusLatency(seqNumInfo.getCommitDurationMs());
     consensus_avg_time_.Get().Set((uint64_t)consensus_time_.avg());
     if (consensus_time_.numOfElements() == 1000) consensus_time_.reset();  // We reset the average every 1000 samples
     metric_last_executed_seq_num_.Get().Set(lastExecutedSeqNum);
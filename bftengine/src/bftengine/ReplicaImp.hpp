@@ -11,8 +11,10 @@
 
 #pragma once
 
+#include <deque>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "ReplicaForStateTransfer.hpp"
 #include "CollectorOfThresholdSignatures.hpp"
@@ -112,7 +114,7 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
   SeqNum maxSeqNumTransferredFromPrevViews = 0;
 
   // requests queue (used by the primary)
-  std::queue<ClientRequestMsg*> requestsQueueOfPrimary;  // only used by the primary
+  std::deque<ClientRequestMsg*> requestsQueueOfPrimary;  // only used by the primary
   size_t primaryCombinedReqSize = 0;                     // only used by the primary
 
   std::map<uint64_t, std::pair<Time, ClientRequestMsg*>>
@@ -159,7 +161,7 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
   bool isSendCheckpointIfNeeded_ = false;
   bool isStartCollectingState_ = false;
   bool startedExecution = false;
-  concord::util::SimpleThreadPool postExecThread_;
+  concord::util::SimpleThreadPool postExecThread_{concord::util::ThreadPlacement::Role::PostExec};
 
   // bounded log used to store information about SeqNums in the range (lastStableSeqNum,lastStableSeqNum +
   // kWorkWindowSize]
@@ -212,6 +214,8 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
   concordUtil::Timers::Handle statusReportTimer_;
   concordUtil::Timers::Handle viewChangeTimer_;
   concordUtil::Timers::Handle clientRequestsRetransmissionTimer_;
+  concordUtil::Timers::Handle requestTraceTimer_;
+  concordUtil::Timers::Handle threadPlacementTimer_;
 
   int viewChangeTimerMilli = 0;
   int autoPrimaryRotationTimerMilli = 0;
@@ -398,6 +402,7 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
                                    bool allowParallelExecution,
                                    bool recoverFromErrorInRequestsExecution);
   void tryToStartOrFinishExecution(bool requestMissingInfo = false);
+  bool tryToPipelineNextExecution();
   void startExecution(SeqNum seqNumber, concordUtils::SpanWrapper& parent_span, bool requestMissingInfo);
   void pushDeferredMessage(MessageBase*);
 
@@ -475,7 +480,9 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
                                                   PrePrepareMsg& prePrepareMsg,
                                                   uint32_t maxStorageForRequests);
 
-  PrePrepareMsg* createPrePrepareMessage();
+  PrePrepareMsg* createPrePrepareMessage(uint64_t requestsSize);
+
+  uint64_t sizeOfNextBatchOfRequests(uint32_t maxNumOfRequests, uint32_t minBatchSizeInBytes) const;
 
   std::pair<PrePrepareMsg*, bool> buildPrePrepareMessageByRequestsNum(uint32_t requiredRequestsNum);
 
@@ -507,7 +514,12 @@ class ReplicaImp : public InternalReplicaApi, public ReplicaForStateTransfer {
                                       bool recoverFromErrorInRequestsExecution = false);
 
   void executeRequestsAndSendResponses(PrePrepareMsg* pp, Bitmap& requestSet, concordUtils::SpanWrapper& span);
-  void sendResponses(PrePrepareMsg* ppMsg, IRequestsHandler::ExecutionRequestsQueue& accumulatedRequests);
+  // Replies recorded in the clients manager but not sent yet, with the ids of the clients they go to
+  using RepliesToSend = std::vector<std::pair<NodeIdType, std::unique_ptr<ClientReplyMsg>>>;
+  // Records the replies of the executed requests and sends them, or moves them to 'repliesToSend' if it isn't null
+  void sendResponses(PrePrepareMsg* ppMsg,
+                     IRequestsHandler::ExecutionRequestsQueue& accumulatedRequests,
+                     RepliesToSend* repliesToSend = nullptr);
 
   void onSeqNumIsStable(
       SeqNum newStableSeqNum,
@@ -32,7 +32,10 @@ class RequestThreadPool final {
   static auto& getThreadPool(uint16_t level) {
     // Currently we need 2 level thread pools.
     static std::array<concord::util::ThreadPool, PoolLevel::MAXLEVEL> threadBag = {
-        ReplicaConfig::instance().threadbagConcurrencyLevel1, ReplicaConfig::instance().threadbagConcurrencyLevel2};
+        concord::util::ThreadPool{ReplicaConfig::instance().threadbagConcurrencyLevel1,
+                                  concord::util::ThreadPlacement::Role::RequestPool},
+        concord::util::ThreadPool{ReplicaConfig::instance().threadbagConcurrencyLevel2,
+                                  concord::util::ThreadPlacement::Role::RequestPool}};
     return threadBag.at(level);
   }
 
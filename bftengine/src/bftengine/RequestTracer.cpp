@@ -0,0 +1,172 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#include "RequestTracer.hpp"
+
+#include <algorithm>
+#include <string>
+
+#include "assertUtils.hpp"
+#include "ClientMsgs.hpp"
+#include "messages/PrePrepareMsg.hpp"
+
+using namespace std::chrono;
+
+namespace bftEngine::impl {
+
+namespace {
+
+constexpr const char* kSpanNames[] = {"queueing", "batching", "consensus", "execution", "reply", "total"};
+constexpr double kPercentiles[] = {50.0, 99.0, 99.9};
+constexpr const char* kPercentileNames[] = {"p50", "p99", "p999"};
+
+int64_t nowNs() { return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count(); }
+
+}  // namespace
+
+RequestTracer::RequestTracer()
+    : windowStart_(steady_clock::now()),
+      metrics_{"request_tracer", std::make_shared<concordMetrics::Aggregator>()},
+      traced_requests_(metrics_.RegisterCounter("traced_requests")),
+      stale_requests_(metrics_.RegisterCounter("stale_requests")),
+      dropped_events_(metrics_.RegisterShardedCounter("dropped_events")) {
+  for (size_t span = 0; span < NumOfSpans; ++span) {
+    for (const auto* percentile : kPercentileNames) {
+      percentiles_.push_back(metrics_.RegisterGauge(std::string(kSpanNames[span]) + "_" + percentile + "_us", 0));
+    }
+  }
+  metrics_.Register();
+}
+
+RequestTracer::~RequestTracer() {
+  for (auto* histogram : window_) {
+    if (histogram) hdr_close(histogram);
+  }
+}
+
+void RequestTracer::setSamplesPerMillion(uint32_t samplesPerMillion) {
+  if (samplesPerMillion != 0) {
+    std::lock_guard<std::mutex> lock(aggregateLock_);
+    if (!events_) allocate();
+  }
+  samplesPerMillion_.store(samplesPerMillion, std::memory_order_release);
+}
+
+void RequestTracer::allocate() {
+  events_ = std::make_unique<concord::util::MpmcBoundedQueue<Event>>(kBufferSize);
+  histograms_ = std::make_unique<Recorders>();
+  recorders_ = {histograms_->queueing,
+                histograms_->batching,
+                histograms_->consensus,
+                histograms_->execution,
+                histograms_->reply,
+                histograms_->total};
+  for (auto& histogram : window_) {
+    auto rv = hdr_init(1, MAX_VALUE_MICROSECONDS, 3, &histogram);
+    ConcordAssertEQ(0, rv);
+  }
+  windowStart_ = steady_clock::now();
+}
+
+bool RequestTracer::isSampled(NodeIdType clientId, ReqId reqSeqNum, uint32_t samplesPerMillion) {
+  // The splitmix64 finalizer, as consecutive sequence numbers of a client differ in their low bits only
+  uint64_t hash = reqSeqNum ^ (static_cast<uint64_t>(clientId) << 48);
+  hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  hash = (hash ^ (hash >> 27)) * 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return hash % 1000000 < samplesPerMillion;
+}
+
+void RequestTracer::traceRequests(PrePrepareMsg* pp, Stage stage) {
+  RequestsIterator reqIter(pp);
+  char* requestBody = nullptr;
+  while (reqIter.getAndGoToNext(requestBody)) {
+    const auto* header = reinterpret_cast<const ClientRequestMsgHeader*>(requestBody);
+    trace(header->idOfClientProxy, header->reqSeqNum, stage);
+  }
+}
+
+void RequestTracer::push(NodeIdType clientId, ReqId reqSeqNum, Stage stage) {
+  if (!events_->tryPush(Event{clientId, stage, reqSeqNum, nowNs()})) dropped_events_++;
+}
+
+void RequestTracer::aggregate() {
+  std::unique_lock<std::mutex> lock(aggregateLock_, std::try_to_lock);
+  // Nothing to aggregate before the sampling rate is first set above 0
+  if (!lock.owns_lock() || !events_) return;
+
+  Event event;
+  while (events_->tryPop(event)) {
+    const auto key = std::make_pair(event.clientId, event.reqSeqNum);
+    auto& times = requests_[key];
+    // A stage is reached more than once by retransmitted requests and view changes, only the first time counts
+    auto& time = times[static_cast<size_t>(event.stage)];
+    if (time == 0) time = event.timeNs;
+    if (event.stage == Stage::Replied) {
+      onReplied(times);
+      requests_.erase(key);
+    }
+  }
+
+  const auto now = steady_clock::now();
+  if (now - windowStart_ < metricsWindow_) return;
+  // Requests that weren't replied in time, e.g. duplicates of replied requests and requests of a failed primary
+  const auto staleBeforeNs = nowNs() - duration_cast<nanoseconds>(kStaleAfter).count();
+  for (auto it = requests_.begin(); it != requests_.end();) {
+    const auto& times = it->second;
+    const auto lastNs = *std::max_element(times.begin(), times.end());
+    if (lastNs < staleBeforeNs) {
+      stale_requests_++;
+      it = requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  publish();
+  windowStart_ = now;
+}
+
+void RequestTracer::onReplied(const std::array<int64_t, static_cast<size_t>(Stage::Count)>& times) {
+  auto at = [&times](Stage stage) { return times[static_cast<size_t>(stage)]; };
+  record(Queueing, at(Stage::Received), at(Stage::Dequeued));
+  record(Batching, at(Stage::Dequeued), at(Stage::PrePrepared));
+  record(Consensus, at(Stage::PrePrepared), at(Stage::Committed));
+  record(Execution, at(Stage::Committed), at(Stage::Executed));
+  record(Reply, at(Stage::Executed), at(Stage::Replied));
+  int64_t firstNs = 0;
+  for (const auto timeNs : times) {
+    if (timeNs != 0 && (firstNs == 0 || timeNs < firstNs)) firstNs = timeNs;
+  }
+  record(Total, firstNs, at(Stage::Replied));
+  traced_requests_++;
+}
+
+void RequestTracer::record(Span span, int64_t fromNs, int64_t toNs) {
+  if (fromNs == 0 || toNs == 0) return;
+  const auto micros = std::clamp<int64_t>((toNs - fromNs) / 1000, 0, MAX_VALUE_MICROSECONDS);
+  recorders_[span]->record(micros);
+  hdr_record_value(window_[span], micros);
+}
+
+void RequestTracer::publish() {
+  for (size_t span = 0; span < NumOfSpans; ++span) {
+    for (size_t i = 0; i < std::size(kPercentiles); ++i) {
+      auto& gauge = percentiles_[span * std::size(kPercentiles) + i];
+      gauge.Get().Set(hdr_value_at_percentile(window_[span], kPercentiles[i]));
+    }
+    hdr_reset(window_[span]);
+  }
+  metrics_.UpdateAggregator();
+}
+
+}  // namespace bftEngine::impl
@@ -0,0 +1,167 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <hdr/hdr_histogram.h>
+
+#include "Metrics.hpp"
+#include "MpmcBoundedQueue.hpp"
+#include "PrimitiveTypes.hpp"
+#include "diagnostics.h"
+#include "performance_handler.h"
+
+namespace bftEngine::impl {
+
+class PrePrepareMsg;
+
+// Sampled tracing of the critical path of client requests, keyed by (clientId, reqSeqNum).
+//
+// A request is sampled by hashing its key, so that all the replicas trace the same requests. The threads handling a
+// sampled request push the time it reaches every stage to a bounded lock-free buffer, and drop the event if the buffer
+// is full. The dispatcher thread periodically drains the buffer and, once a request is replied, records the time it
+// spent between the stages it went through in per span histograms. They are exposed by the "request_tracer" component
+// of both the diagnostics server and the metrics, the latter as percentile gauges over a window of 5 seconds by
+// default.
+//
+// The buffer and the histograms are allocated the first time the sampling rate is set above 0. Until then, and with a
+// sampling rate of 0, tracing a stage costs an atomic load.
+class RequestTracer {
+ public:
+  enum class Stage : uint8_t {
+    Received,     // Pushed to the incoming messages queue
+    Dequeued,     // Handled by the dispatcher thread
+    PrePrepared,  // Batched in a PrePrepare sent or accepted by the replica
+    Committed,    // Committed and handed to execution
+    Executed,     // Executed, before its reply is built
+    Replied,      // Reply sent, or queued to be sent by the execution pipeline
+    Count
+  };
+
+  static constexpr size_t kBufferSize = 1 << 16;
+  static constexpr std::chrono::seconds kStaleAfter{10};
+  static constexpr std::chrono::seconds kDefaultMetricsWindow{5};
+
+  static RequestTracer& instance() {
+    static RequestTracer instance_;
+    return instance_;
+  }
+
+  void setSamplesPerMillion(uint32_t samplesPerMillion);
+  bool enabled() const { return samplesPerMillion_.load(std::memory_order_relaxed) != 0; }
+
+  // Can be called by any thread
+  void trace(NodeIdType clientId, ReqId reqSeqNum, Stage stage) {
+    // Acquire, to see the buffer allocated before the rate was set
+    const auto samplesPerMillion = samplesPerMillion_.load(std::memory_order_acquire);
+    if (samplesPerMillion != 0 && isSampled(clientId, reqSeqNum, samplesPerMillion)) push(clientId, reqSeqNum, stage);
+  }
+
+  // Traces all the client requests of the PrePrepare. Can be called by any thread
+  void trace(PrePrepareMsg* pp, Stage stage) {
+    if (enabled()) traceRequests(pp, stage);
+  }
+
+  // Drains the buffer into the histograms and publishes the metrics once per window. Should be called periodically,
+  // calls made while another thread aggregates return immediately.
+  void aggregate();
+
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator) {
+    metrics_.SetAggregator(aggregator);
+  }
+
+  void setMetricsWindow(std::chrono::milliseconds window) {
+    std::lock_guard<std::mutex> lock(aggregateLock_);
+    metricsWindow_ = window;
+  }
+
+  static bool isSampled(NodeIdType clientId, ReqId reqSeqNum, uint32_t samplesPerMillion);
+
+  ~RequestTracer();
+
+ private:
+  // The intervals between stages recorded for every replied request. A span is skipped if the request didn't go
+  // through both its stages on this replica, e.g. backups don't receive the requests batched by the primary.
+  enum Span { Queueing, Batching, Consensus, Execution, Reply, Total, NumOfSpans };
+
+  struct Event {
+    NodeIdType clientId;
+    Stage stage;
+    ReqId reqSeqNum;
+    int64_t timeNs;
+  };
+
+  RequestTracer();
+  RequestTracer(const RequestTracer&) = delete;
+  RequestTracer& operator=(const RequestTracer&) = delete;
+
+  void allocate();
+  void push(NodeIdType clientId, ReqId reqSeqNum, Stage stage);
+  void traceRequests(PrePrepareMsg* pp, Stage stage);
+  void onReplied(const std::array<int64_t, static_cast<size_t>(Stage::Count)>& times);
+  void record(Span span, int64_t fromNs, int64_t toNs);
+  void publish();
+
+ private:
+  std::atomic_uint32_t samplesPerMillion_{0};
+  // Allocated once, before the sampling rate is first set above 0
+  std::unique_ptr<concord::util::MpmcBoundedQueue<Event>> events_;
+
+  // Guards the state below, which is only accessed when aggregating, and the allocation
+  std::mutex aggregateLock_;
+  // The times of the stages every traced request went through, 0 for the stages it didn't go through yet
+  std::map<std::pair<NodeIdType, ReqId>, std::array<int64_t, static_cast<size_t>(Stage::Count)>> requests_;
+  std::array<hdr_histogram*, NumOfSpans> window_{};
+  std::chrono::steady_clock::time_point windowStart_;
+  std::chrono::milliseconds metricsWindow_{kDefaultMetricsWindow};
+
+  // 60 seconds
+  static constexpr int64_t MAX_VALUE_MICROSECONDS = 1000 * 1000 * 60l;
+  using Recorder = concord::diagnostics::Recorder;
+  struct Recorders {
+    Recorders() {
+      auto& registrar = concord::diagnostics::RegistrarSingleton::getInstance();
+      const auto component = "request_tracer";
+      if (!registrar.perf.isRegisteredComponent(component)) {
+        registrar.perf.registerComponent(component, {queueing, batching, consensus, execution, reply, total});
+      }
+    }
+    DEFINE_SHARED_RECORDER(queueing, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(batching, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(consensus, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(execution, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(reply, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+    DEFINE_SHARED_RECORDER(total, 1, MAX_VALUE_MICROSECONDS, 3, concord::diagnostics::Unit::MICROSECONDS);
+  };
+  std::unique_ptr<Recorders> histograms_;
+  std::array<std::shared_ptr<Recorder>, NumOfSpans> recorders_;
+
+  concordMetrics::Component metrics_;
+  concordMetrics::CounterHandle traced_requests_;
+  concordMetrics::CounterHandle stale_requests_;
+  concordMetrics::ShardedCounterHandle dropped_events_;
+  // p50, p99 and p99.9 of every span, in microseconds
+  std::vector<concordMetrics::GaugeHandle> percentiles_;
+};
+
+}  // namespace bftEngine::impl
@@ -17,12 +17,29 @@ using namespace concordUtil;
 using namespace std;
 using namespace std::chrono;
 
+namespace {
+
+LatencyTargetBatchingController::Config latencyTargetConfig(const ReplicaConfig &config) {
+  LatencyTargetBatchingController::Config c;
+  c.targetP99Ms = config.batchingLatencyTargetMillisec;
+  c.maxBatchSize = config.maxNumOfRequestsInBatch;
+  c.maxInFlight = config.concurrencyLevel;
+  c.minFlushPeriodMs = config.batchingLatencyMinFlushPeriod;
+  c.maxFlushPeriodMs = config.batchFlushPeriod;
+  return c;
+}
+
+}  // namespace
+
 RequestsBatchingLogic::RequestsBatchingLogic(InternalReplicaApi &replica,
                                              const ReplicaConfig &config,
                                              concordMetrics::Component &metrics,
                                              concordUtil::Timers &timers)
     : replica_(replica),
       metric_not_enough_client_requests_event_{metrics.RegisterCounter("notEnoughClientRequestsEvent")},
+      metric_batching_in_flight_limit_{metrics.RegisterGauge("batchingInFlightLimit", config.concurrencyLevel)},
+      metric_batching_p99_latency_{metrics.RegisterGauge("batchingP99ConsensusLatency", 0)},
+      metric_batching_flush_period_{metrics.RegisterGauge("batchingFlushPeriod", config.batchFlushPeriod)},
       batchingPolicy_((BatchingPolicy)config.batchingPolicy),
       batchingFactorCoefficient_(config.batchingFactorCoefficient),
       maxInitialBatchSize_(config.maxInitialBatchSize),
@@ -35,6 +52,7 @@ RequestsBatchingLogic::RequestsBatchingLogic(InternalReplicaApi &replica,
       minIncreaseCondition_(stod(config.adaptiveBatchingMinIncCond)),
       initialBatchSize_(config.maxNumOfRequestsInBatch),
       maxBatchSizeInBytes_(config.maxBatchSizeInBytes),
+      latencyTargetController_(latencyTargetConfig(config)),
       timers_(timers) {
   if (batchingPolicy_ != BATCH_SELF_ADJUSTED)
     batchFlushTimer_ = timers_.add(milliseconds(batchFlushPeriodMs_),
@@ -46,17 +64,45 @@ RequestsBatchingLogic::~RequestsBatchingLogic() {
   if (batchingPolicy_ != BATCH_SELF_ADJUSTED) timers_.cancel(batchFlushTimer_);
 }
 
+uint32_t RequestsBatchingLogic::flushPeriodMs() const {
+  return batchingPolicy_ == BATCH_BY_LATENCY_TARGET ? latencyTargetController_.flushPeriodMs() : batchFlushPeriodMs_;
+}
+
+uint64_t RequestsBatchingLogic::numOfSeqNumsInFlight() const {
+  const SeqNum primaryLastUsedSeqNum = replica_.getPrimaryLastUsedSeqNum();
+  const SeqNum lastExecutedSeqNum = replica_.getLastExecutedSeqNum();
+  return primaryLastUsedSeqNum > lastExecutedSeqNum ? primaryLastUsedSeqNum - lastExecutedSeqNum : 0;
+}
+
 void RequestsBatchingLogic::onBatchFlushTimer(Timers::Handle) {
   if (replica_.isCurrentPrimary()) {
     lock_guard<mutex> lock(batchProcessingLock_);
+    // The latency target policy flushes only into a free in-flight slot; otherwise the next execution triggers it
+    if (batchingPolicy_ == BATCH_BY_LATENCY_TARGET &&
+        !latencyTargetController_.canStartConsensus(numOfSeqNumsInFlight()))
+      return;
     if (replica_.tryToSendPrePrepareMsg(false)) {
-      LOG_INFO(GL, "Batching flush period expired" << KVLOG(batchFlushPeriodMs_));
+      const auto period = flushPeriodMs();
+      LOG_INFO(GL, "Batching flush period expired" << KVLOG(period));
       closedOnFlush_ += 1;
-      timers_.reset(batchFlushTimer_, milliseconds(batchFlushPeriodMs_));
+      timers_.reset(batchFlushTimer_, milliseconds(period));
     }
   }
 }
 
+void RequestsBatchingLogic::onConsensusLatency(uint64_t latencyMs) {
+  if (batchingPolicy_ != BATCH_BY_LATENCY_TARGET) return;
+  lock_guard<mutex> lock(batchProcessingLock_);
+  const auto prevLimit = latencyTargetController_.inFlightLimit();
+  latencyTargetController_.onConsensusLatency(latencyMs);
+  const auto limit = latencyTargetController_.inFlightLimit();
+  const auto p99 = latencyTargetController_.lastP99Ms();
+  if (limit != prevLimit) LOG_DEBUG(GL, "In-flight limit updated" << KVLOG(prevLimit, limit, p99));
+  metric_batching_in_flight_limit_.Get().Set(limit);
+  metric_batching_p99_latency_.Get().Set(p99);
+  metric_batching_flush_period_.Get().Set(latencyTargetController_.flushPeriodMs());
+}
+
 std::pair<PrePrepareMsg *, bool> RequestsBatchingLogic::batchRequestsSelfAdjustedPolicy(SeqNum primaryLastUsedSeqNum,
                                                                                         uint64_t requestsInQueue,
                                                                                         SeqNum lastExecutedSeqNum) {
@@ -143,6 +189,14 @@ std::pair<PrePrepareMsg *, bool> RequestsBatchingLogic::batchRequests() {
         if (period > batchFlushPeriodMs_ * 20) adjustPreprepareSize();
       }
     } break;
+    case BATCH_BY_LATENCY_TARGET: {
+      lock_guard<mutex> lock(batchProcessingLock_);
+      const auto batchSize = latencyTargetController_.batchSize(requestsInQueue, numOfSeqNumsInFlight());
+      if (batchSize == 0) break;
+      prePrepareMsgWithResult = replica_.buildPrePrepareMsgBatchByRequestsNum(batchSize);
+      if (prePrepareMsgWithResult.second)
+        timers_.reset(batchFlushTimer_, milliseconds(latencyTargetController_.flushPeriodMs()));
+    } break;
   }
   return prePrepareMsgWithResult;
 }
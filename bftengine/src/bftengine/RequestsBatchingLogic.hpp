@@ -19,6 +19,7 @@
 #include "messages/PrePrepareMsg.hpp"
 #include "Timers.hpp"
 #include "performance_handler.h"
+#include "LatencyTargetBatchingController.hpp"
 
 namespace bftEngine::batchingLogic {
 
@@ -35,8 +36,13 @@ class RequestsBatchingLogic {
 
   std::pair<PrePrepareMsg *, bool> batchRequests();
 
+  // Feeds the commit latency of an executed sequence number to the BATCH_BY_LATENCY_TARGET policy
+  void onConsensusLatency(uint64_t latencyMs);
+
  private:
   void onBatchFlushTimer(concordUtil::Timers::Handle timer);
+  uint32_t flushPeriodMs() const;
+  uint64_t numOfSeqNumsInFlight() const;
   std::pair<PrePrepareMsg *, bool> batchRequestsSelfAdjustedPolicy(SeqNum primaryLastUsedSeqNum,
                                                                    uint64_t requestsInQueue,
                                                                    SeqNum lastExecutedSeqNum);
@@ -45,6 +51,9 @@ class RequestsBatchingLogic {
  private:
   InternalReplicaApi &replica_;
   concordMetrics::CounterHandle metric_not_enough_client_requests_event_;
+  concordMetrics::GaugeHandle metric_batching_in_flight_limit_;
+  concordMetrics::GaugeHandle metric_batching_p99_latency_;
+  concordMetrics::GaugeHandle metric_batching_flush_period_;
   BatchingPolicy batchingPolicy_;
   // Variables used to heuristically compute the 'optimal' batch size
   uint32_t maxNumberOfPendingRequestsInRecentHistory_ = 0;
@@ -63,6 +72,7 @@ class RequestsBatchingLogic {
   const double minIncreaseCondition_;
   const uint32_t initialBatchSize_;
   const uint32_t maxBatchSizeInBytes_;
+  LatencyTargetBatchingController latencyTargetController_;
   concordUtil::Timers &timers_;
   concordUtil::Timers::Handle batchFlushTimer_;
   std::mutex batchProcessingLock_;
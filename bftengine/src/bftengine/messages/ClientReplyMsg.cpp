@@ -13,6 +13,7 @@
 #include "ClientReplyMsg.hpp"
 #include "assertUtils.hpp"
 #include "ReplicaConfig.hpp"
+#include "sha_hash.hpp"
 
 namespace bftEngine {
 namespace impl {
@@ -62,6 +63,16 @@ void ClientReplyMsg::setReplicaSpecificInfoLength(uint32_t length) {
 
 void ClientReplyMsg::setPrimaryId(ReplicaId primaryId) { b()->currentPrimaryId = primaryId; }
 
+void ClientReplyMsg::replaceWithDigest() {
+  const uint32_t rsiLength = b()->replicaSpecificInfoLength;
+  const uint32_t dataLength = replyLength() - rsiLength;
+  const auto digest = concord::util::SHA2_256{}.digest(replyBuf(), dataLength);
+  memmove(replyBuf() + digest.size(), replyBuf() + dataLength, rsiLength);
+  memcpy(replyBuf(), digest.data(), digest.size());
+  setReplyLength(digest.size() + rsiLength);
+  b()->msgType = REPLY_DIGEST_MSG_TYPE;
+}
+
 void ClientReplyMsg::validate(const ReplicasInfo&) const {
   if (size() < ((int)sizeof(ClientReplyMsgHeader) + replyLength())) throw std::runtime_error(__PRETTY_FUNCTION__);
 
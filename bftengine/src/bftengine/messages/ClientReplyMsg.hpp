@@ -52,6 +52,10 @@ class ClientReplyMsg : public MessageBase {
 
   void setPrimaryId(ReplicaId primaryId);
 
+  // Replace the reply data (but not the replica specific information) with its digest and turn this message into a
+  // REPLY_DIGEST_MSG_TYPE reply, see REPLY_DIGEST_FLAG.
+  void replaceWithDigest();
+
   uint64_t debugHash() const;
 
   void validate(const ReplicasInfo&) const override;
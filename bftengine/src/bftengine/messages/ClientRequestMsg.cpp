@@ -232,4 +232,14 @@ char* ClientRequestMsg::requestSignature() const {
   return nullptr;
 }
 
+std::pair<const char*, uint32_t> ClientRequestMsg::sigOrDigest() const {
+  const char* sig = requestSignature();
+  if (sig != nullptr) return std::make_pair(sig, requestSignatureLength());
+  if (!digest_) {
+    digest_.emplace();
+    DigestUtil::compute(body(), size(), digest_->content(), sizeof(Digest));
+  }
+  return std::make_pair(digest_->content(), (uint32_t)sizeof(Digest));
+}
+
 }  // namespace bftEngine::impl
@@ -11,7 +11,10 @@
 
 #pragma once
 
+#include <optional>
+
 #include "MessageBase.hpp"
+#include "Digest.hpp"
 #include "ReplicasInfo.hpp"
 #include "ClientMsgs.hpp"
 #include "diagnostics.h"
@@ -72,6 +75,12 @@ class ClientRequestMsg : public MessageBase {
 
   std::string getCid() const;
 
+  // The request signature if the request is signed, otherwise the digest of the whole message - this is what the
+  // digest of a PrePrepare is computed over. The digest is computed once and cached, so that the primary can compute
+  // it while validating the request, ahead of building the PrePrepare.
+  std::pair<const char*, uint32_t> sigOrDigest() const;
+  bool isSigOrDigestReady() const { return requestSignatureLength() > 0 || digest_.has_value(); }
+
   void validate(const ReplicasInfo& repInfo) const override { validateImp(repInfo); }
 
   bool shouldValidateAsync() const override;
@@ -96,6 +105,8 @@ class ClientRequestMsg : public MessageBase {
                  const std::string& cid,
                  uint32_t requestSignatureLen,
                  uint32_t extraBufSize);
+
+  mutable std::optional<Digest> digest_;
 };
 
 template <>
@@ -199,6 +199,15 @@ void PrePrepareMsg::addRequest(const char* pRequest, uint32_t requestSize) {
   b()->numberOfRequests++;
 }
 
+void PrePrepareMsg::addRequest(const ClientRequestMsg& request) {
+  addRequest(request.body(), request.size());
+  // Otherwise, finishAddingRequests() computes the digests of all the requests in parallel
+  if (numOfRequestsWithSigOrDigest_ + 1 != b()->numberOfRequests || !request.isSigOrDigestReady()) return;
+  const auto [sigOrDigest, len] = request.sigOrDigest();
+  sigOrDigestOfRequests_.append(sigOrDigest, len);
+  numOfRequestsWithSigOrDigest_++;
+}
+
 void PrePrepareMsg::finishAddingRequests() {
   ConcordAssert(!isNull());
   ConcordAssert(!isReady());
@@ -214,10 +223,18 @@ void PrePrepareMsg::finishAddingRequests() {
   ConcordAssert(isReady());
 
   try {
-    calculateDigestOfRequests(b()->digestOfRequests);
+    if (numOfRequestsWithSigOrDigest_ == b()->numberOfRequests) {
+      DigestUtil::compute(sigOrDigestOfRequests_.data(),
+                          sigOrDigestOfRequests_.size(),
+                          (char*)&(b()->digestOfRequests),
+                          sizeof(Digest));
+    } else {
+      calculateDigestOfRequests(b()->digestOfRequests);
+    }
   } catch (std::runtime_error& ex) {
     ConcordAssert(false);
   }
+  std::string().swap(sigOrDigestOfRequests_);
 
   // size
   setMsgSize(b()->endLocationOfLastRequest);
@@ -12,6 +12,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 #include "PrimitiveTypes.hpp"
 #include "assertUtils.hpp"
@@ -22,6 +23,7 @@
 namespace bftEngine {
 namespace impl {
 class RequestsIterator;
+class ClientRequestMsg;
 
 class PrePrepareMsg : public MessageBase {
  protected:
@@ -88,6 +90,10 @@ class PrePrepareMsg : public MessageBase {
 
   void addRequest(const char* pRequest, uint32_t requestSize);
 
+  // Also records the signature or digest of the request if it is already at hand (see ClientRequestMsg::sigOrDigest()).
+  // When all the requests have one, finishAddingRequests() does not have to go over them again.
+  void addRequest(const ClientRequestMsg& request);
+
   void finishAddingRequests();
 
   // getter methods
@@ -127,6 +133,11 @@ class PrePrepareMsg : public MessageBase {
 
   uint32_t payloadShift() const;
   friend class RequestsIterator;
+
+ private:
+  // Only used by the primary, while adding requests
+  std::string sigOrDigestOfRequests_;
+  uint16_t numOfRequestsWithSigOrDigest_ = 0;
 };
 
 class RequestsIterator {
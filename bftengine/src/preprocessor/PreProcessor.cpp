@@ -308,7 +308,7 @@ PreProcessor::PreProcessor(shared_ptr<MsgsCommunicator> &msgsCommunicator,
       numOfReplicas_(myReplica.getReplicaConfig().numReplicas + myReplica.getReplicaConfig().numRoReplicas),
       numOfInternalClients_(myReplica.getReplicaConfig().numOfClientProxies),
       clientBatchingEnabled_(myReplica.getReplicaConfig().clientBatchingEnabled),
-      memoryPool_(myReplica.getReplicaConfig().maxExternalMessageSize, timers),
+      memoryPool_("memoryPoolMetrics", myReplica.getReplicaConfig().maxExternalMessageSize),
       metricsComponent_{concordMetrics::Component("preProcessor", std::make_shared<concordMetrics::Aggregator>())},
       metricsLastDumpTime_(0),
       metricsDumpIntervalInSec_{myReplica_.getReplicaConfig().metricsDumpIntervalSeconds},
@@ -343,7 +343,7 @@ PreProcessor::PreProcessor(shared_ptr<MsgsCommunicator> &msgsCommunicator,
     preProcessResultBuffers_.emplace_back(make_shared<SafeResultBuffer>());
   }
   // Initially, allocate a memory for all batches of one client (clientMaxBatchSize_)
-  memoryPool_.allocatePool(clientMaxBatchSize_, numOfReqEntries);
+  memoryPool_.reserve(myReplica.getReplicaConfig().maxExternalMessageSize, clientMaxBatchSize_);
   const uint16_t firstClientId = numOfReplicas_ + numOfInternalClients_;
   for (uint16_t i = 0; i < numOfExternalClients; i++) {
     // Placeholders for all client batches
@@ -1529,22 +1529,71 @@ const char *PreProcessor::getPreProcessResultBuffer(uint16_t clientId, ReqId req
   // First buffer offset = numOfReplicas_ * batchSize_
   // The number of buffers per client comes from the configuration parameter clientBatchingMaxMsgsNbr.
   const auto bufferOffset = getBufferOffset(clientId, reqSeqNum, reqOffsetInBatch);
-  std::unique_lock lock(preProcessResultBuffers_[bufferOffset]->mutex);
-  if (!preProcessResultBuffers_[bufferOffset]->buffer) {
-    preProcessResultBuffers_[bufferOffset]->buffer = memoryPool_.getChunk();
+  auto &resultBuffer = *preProcessResultBuffers_[bufferOffset];
+  std::unique_lock lock(resultBuffer.mutex);
+  if (!resultBuffer.buffer) {
+    // The size of the result is only known once the request is pre-executed
+    resultBuffer.buffer = memoryPool_.allocate(memoryPool_.maxChunkSize());
+    resultBuffer.size = memoryPool_.maxChunkSize();
     LOG_TRACE(logger(), "Allocate memory from the pool" << KVLOG(clientId, reqSeqNum, reqOffsetInBatch, bufferOffset));
   }
-  return preProcessResultBuffers_[bufferOffset]->buffer;
+  return resultBuffer.buffer;
+}
+
+// Every pre-execution gets a max-size buffer of its own: the result of a previous pre-execution of the request (e.g.
+// before a primary retry) may have been shrunk, and the request state keeps pointing to it until it's handed the new
+// result. Hence, the previous buffer is retired rather than released.
+char *PreProcessor::getPreExecutionResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch) {
+  const auto bufferOffset = getBufferOffset(clientId, reqSeqNum, reqOffsetInBatch);
+  auto &resultBuffer = *preProcessResultBuffers_[bufferOffset];
+  std::unique_lock lock(resultBuffer.mutex);
+  if (resultBuffer.buffer) resultBuffer.retired.push_back(resultBuffer.buffer);
+  resultBuffer.buffer = memoryPool_.allocate(memoryPool_.maxChunkSize());
+  resultBuffer.size = memoryPool_.maxChunkSize();
+  return resultBuffer.buffer;
 }
 
 void PreProcessor::releasePreProcessResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch) {
   const auto bufferOffset = getBufferOffset(clientId, reqSeqNum, reqOffsetInBatch);
-  std::unique_lock lock(preProcessResultBuffers_[bufferOffset]->mutex);
-  if (preProcessResultBuffers_[bufferOffset]->buffer) {
-    memoryPool_.returnChunk(preProcessResultBuffers_[bufferOffset]->buffer);
-    preProcessResultBuffers_[bufferOffset]->buffer = nullptr;
+  auto &resultBuffer = *preProcessResultBuffers_[bufferOffset];
+  std::unique_lock lock(resultBuffer.mutex);
+  if (resultBuffer.buffer) {
+    memoryPool_.deallocate(resultBuffer.buffer);
+    resultBuffer.buffer = nullptr;
+    resultBuffer.size = 0;
     LOG_TRACE(logger(), "Returned memory to the pool" << KVLOG(clientId, reqSeqNum, reqOffsetInBatch, bufferOffset));
   }
+  for (auto *retired : resultBuffer.retired) memoryPool_.deallocate(retired);
+  resultBuffer.retired.clear();
+}
+
+// Called once the request state points to the current buffer
+void PreProcessor::releaseRetiredPreProcessResultBuffers(uint16_t clientId,
+                                                         ReqId reqSeqNum,
+                                                         uint16_t reqOffsetInBatch) {
+  const auto bufferOffset = getBufferOffset(clientId, reqSeqNum, reqOffsetInBatch);
+  auto &resultBuffer = *preProcessResultBuffers_[bufferOffset];
+  std::unique_lock lock(resultBuffer.mutex);
+  for (auto *retired : resultBuffer.retired) memoryPool_.deallocate(retired);
+  resultBuffer.retired.clear();
+}
+
+// The result buffer is held until the pre-processing consensus completes, so move a result smaller than the maximum to
+// a chunk of its size. The buffer was allocated for this pre-execution (see getPreExecutionResultBuffer), nothing else
+// points to it yet.
+void PreProcessor::shrinkPreProcessResultBuffer(uint16_t clientId,
+                                                ReqId reqSeqNum,
+                                                uint16_t reqOffsetInBatch,
+                                                uint32_t resultLen) {
+  const auto bufferOffset = getBufferOffset(clientId, reqSeqNum, reqOffsetInBatch);
+  auto &resultBuffer = *preProcessResultBuffers_[bufferOffset];
+  std::unique_lock lock(resultBuffer.mutex);
+  if (!resultBuffer.buffer || memoryPool_.chunkSize(resultLen) >= resultBuffer.size) return;
+  auto *shrunkBuffer = memoryPool_.allocate(resultLen);
+  memcpy(shrunkBuffer, resultBuffer.buffer, resultLen);
+  memoryPool_.deallocate(resultBuffer.buffer);
+  resultBuffer.buffer = shrunkBuffer;
+  resultBuffer.size = memoryPool_.chunkSize(resultLen);
 }
 
 // Primary replica: ask all replicas to pre-process the request
@@ -1607,7 +1656,7 @@ OperationResult PreProcessor::launchReqPreProcessing(const PreProcessRequestMsgS
                                << GlobalData::current_block_id << "] delta [" << GlobalData::block_delta << "]");
     GlobalData::increment_step = true;
   }
-  auto preProcessResultBuffer = (char *)getPreProcessResultBuffer(clientId, reqSeqNum, reqOffsetInBatch);
+  auto preProcessResultBuffer = getPreExecutionResultBuffer(clientId, reqSeqNum, reqOffsetInBatch);
   IRequestsHandler::ExecutionRequest request = bftEngine::IRequestsHandler::ExecutionRequest{
       clientId,
       reqSeqNum,
@@ -1641,6 +1690,7 @@ OperationResult PreProcessor::launchReqPreProcessing(const PreProcessRequestMsgS
   // Append the conflict detection block id and add its size to the resulting length.
   memcpy(preProcessResultBuffer + resultLen, reinterpret_cast<char *>(&blockId), sizeof(uint64_t));
   resultLen += sizeof(uint64_t);
+  shrinkPreProcessResultBuffer(clientId, reqSeqNum, reqOffsetInBatch, resultLen);
   LOG_DEBUG(
       logger(),
       "Pre-execution operation successfully completed" << KVLOG(cid, reqSeqNum, clientId, reqOffsetInBatch, blockId));
@@ -1655,15 +1705,22 @@ ReqId PreProcessor::getOngoingReqIdForClient(uint16_t clientId, uint16_t reqOffs
   return 0;
 }
 
+// For test purposes
+uint32_t PreProcessor::getPreProcessResultBufferSize(uint16_t clientId, uint16_t reqOffsetInBatch) {
+  auto &resultBuffer = *preProcessResultBuffers_[getBufferOffset(clientId, 0, reqOffsetInBatch)];
+  std::unique_lock lock(resultBuffer.mutex);
+  return resultBuffer.size;
+}
+
 PreProcessingResult PreProcessor::handlePreProcessedReqByPrimaryAndGetConsensusResult(
     uint16_t clientId, uint16_t reqOffsetInBatch, uint32_t resultBufLen, OperationResult preProcessResult) {
   const auto &reqEntry = ongoingReqBatches_[clientId]->getRequestState(reqOffsetInBatch);
   lock_guard<mutex> lock(reqEntry->mutex);
   if (reqEntry->reqProcessingStatePtr) {
+    const auto reqSeqNum = reqEntry->reqProcessingStatePtr->getReqSeqNum();
     reqEntry->reqProcessingStatePtr->handlePrimaryPreProcessed(
-        getPreProcessResultBuffer(clientId, reqEntry->reqProcessingStatePtr->getReqSeqNum(), reqOffsetInBatch),
-        resultBufLen,
-        preProcessResult);
+        getPreProcessResultBuffer(clientId, reqSeqNum, reqOffsetInBatch), resultBufLen, preProcessResult);
+    releaseRetiredPreProcessResultBuffers(clientId, reqSeqNum, reqOffsetInBatch);
     return reqEntry->reqProcessingStatePtr->definePreProcessingConsensusResult();
   }
   return NONE;
@@ -31,7 +31,7 @@
 #include "PerformanceManager.hpp"
 #include "RollingAvgAndVar.hpp"
 #include "SharedTypes.hpp"
-#include "RawMemoryPool.hpp"
+#include "SlabAllocator.hpp"
 #include "GlobalData.hpp"
 
 // TODO[TK] till boost upgrade
@@ -43,6 +43,7 @@
 #include <mutex>
 #include <condition_variable>
 #include <functional>
+#include <vector>
 
 namespace preprocessor {
 
@@ -59,6 +60,10 @@ struct RequestState {
 struct SafeResultBuffer {
   std::mutex mutex;
   char *buffer = nullptr;
+  // The chunk size of buffer, smaller than the maximum once the result was shrunk
+  uint32_t size = 0;
+  // Buffers of previous pre-executions of the request, the request state may still point to them
+  std::vector<char *> retired;
 };
 
 using SafeResultBufferSharedPtr = std::shared_ptr<SafeResultBuffer>;
@@ -143,6 +148,7 @@ class PreProcessor {
   static void setAggregator(std::shared_ptr<concordMetrics::Aggregator> aggregator);
 
   ReqId getOngoingReqIdForClient(uint16_t clientId, uint16_t reqOffsetInBatch);
+  uint32_t getPreProcessResultBufferSize(uint16_t clientId, uint16_t reqOffsetInBatch);
 
  private:
   friend class AsyncPreProcessJob;
@@ -225,6 +231,9 @@ class PreProcessor {
   uint32_t getBufferOffset(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch) const;
   const char *getPreProcessResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch);
   void releasePreProcessResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch);
+  char *getPreExecutionResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch);
+  void shrinkPreProcessResultBuffer(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch, uint32_t resultLen);
+  void releaseRetiredPreProcessResultBuffers(uint16_t clientId, ReqId reqSeqNum, uint16_t reqOffsetInBatch);
   void launchAsyncReqPreProcessingJob(const PreProcessRequestMsgSharedPtr &preProcessReqMsg,
                                       const std::string &batchCid,
                                       bool isPrimary,
@@ -326,11 +335,11 @@ class PreProcessor {
   const uint16_t numOfInternalClients_;
   const bool clientBatchingEnabled_;
   inline static uint16_t clientMaxBatchSize_ = 0;
-  concord::util::SimpleThreadPool threadPool_;
+  concord::util::SimpleThreadPool threadPool_{concord::util::ThreadPlacement::Role::PreProcessor};
   // One-time allocated buffers (one per client) for the pre-execution results storage
   PreProcessResultBuffers preProcessResultBuffers_;
   OngoingReqBatchesMap ongoingReqBatches_;  // clientId -> RequestsBatch
-  concordUtil::RawMemoryPool memoryPool_;
+  concordUtil::SlabAllocator memoryPool_;
 
   concordMetrics::Component metricsComponent_;
   std::chrono::seconds metricsLastDumpTime_;
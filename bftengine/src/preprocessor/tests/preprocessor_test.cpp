@@ -83,6 +83,30 @@ class DummyRequestsHandler : public IRequestsHandler {
   }
 };
 
+// Writes as much as the pre-execution may write and returns a small result, records the result buffer size of every
+// pre-execution
+class SmallResultRequestsHandler : public IRequestsHandler {
+ public:
+  void execute(ExecutionRequestsQueue& requests,
+               std::optional<Timestamp> timestamp,
+               const std::string& batchCid,
+               concordUtils::SpanWrapper& parent_span) override {}
+  void preExecute(IRequestsHandler::ExecutionRequest& req,
+                  std::optional<Timestamp> timestamp,
+                  const std::string& batchCid,
+                  concordUtils::SpanWrapper& parent_span) override {
+    memset(req.outReply, 'r', req.maxReplySize);
+    req.outActualReplySize = 16;
+    req.outExecutionStatus = static_cast<uint32_t>(OperationResult::SUCCESS);
+    lock_guard<mutex> lock(mutex_);
+    bufferSizes_.push_back(bufferSize_());
+  }
+
+  function<uint32_t()> bufferSize_;
+  mutex mutex_;
+  vector<uint32_t> bufferSizes_;
+};
+
 class DummyReceiver : public IReceiver {
  public:
   virtual ~DummyReceiver() = default;
@@ -941,6 +965,45 @@ TEST(requestPreprocessingState_test, handlePreProcessBatchRequestMsg) {
   clearDiagnosticsHandlers();
 }
 
+// The primary pre-executes the request again when its result differs from the one the other replicas agreed on. The
+// result of the first pre-execution was moved to a small buffer, the retry needs a max-size one.
+TEST(requestPreprocessingState_test, primaryRetryAfterSmallResult) {
+  setUpConfiguration_7();
+  replicaConfig.replicaId = replica_0;
+  SigManager::instance(sigManager[replica_0].get());
+
+  bftEngine::impl::ReplicasInfo repInfo(replicaConfig, false, false);
+  DummyReplica replica(repInfo);
+  replica.setPrimary(true);
+  concordUtil::Timers timers;
+  SmallResultRequestsHandler smallResultHandler;
+  PreProcessor preProcessor(msgsCommunicator, msgsStorage, msgHandlersRegPtr, smallResultHandler, replica, timers, sdm);
+  smallResultHandler.bufferSize_ = [&] { return preProcessor.getPreProcessResultBufferSize(clientId, 0); };
+
+  auto msgHandlerCallback = msgHandlersRegPtr->getCallback(bftEngine::impl::MsgCode::ClientPreProcessRequest);
+  msgHandlerCallback(new ClientPreProcessRequestMsg(clientId, reqSeqNum, bufLen, buf, reqTimeoutMilli, cid));
+  usleep(waitForExecTimerMillisec * 1000);
+  ConcordAssertEQ(preProcessor.getOngoingReqIdForClient(clientId, 0), reqSeqNum);
+  ASSERT_LT(preProcessor.getPreProcessResultBufferSize(clientId, 0), replicaConfig.maxExternalMessageSize);
+
+  // Enough replicas agree on a result that differs from the primary's
+  msgHandlerCallback = msgHandlersRegPtr->getCallback(bftEngine::impl::MsgCode::PreProcessReply);
+  memset(buf, '4', bufLen);
+  for (NodeIdType senderId = replica_1; senderId <= fVal_7 + 1; senderId++) {
+    SigManager::instance(sigManager[senderId].get());
+    auto* replyMsg = new PreProcessReplyMsg(
+        senderId, clientId, 0, reqSeqNum, reqRetryId, buf, bufLen, "", STATUS_GOOD, OperationResult::SUCCESS);
+    SigManager::instance(sigManager[replica_0].get());
+    msgHandlerCallback(replyMsg);
+  }
+  usleep(waitForExecTimerMillisec * 1000);
+
+  lock_guard<mutex> lock(smallResultHandler.mutex_);
+  ASSERT_EQ(smallResultHandler.bufferSizes_.size(), 2);
+  for (const auto size : smallResultHandler.bufferSizes_) ASSERT_GE(size, replicaConfig.maxExternalMessageSize);
+  clearDiagnosticsHandlers();
+}
+
 }  // end namespace
 
 int main(int argc, char** argv) {
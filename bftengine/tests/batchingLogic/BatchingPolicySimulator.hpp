@@ -0,0 +1,219 @@
+// Concord
+//
+// Copyright (c) 2020 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms.
+// Your use of these subcomponents is subject to the terms and conditions of the sub-component's license,
+// as noted in the LICENSE file.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "LatencyTargetBatchingController.hpp"
+
+// Discrete-event simulation of the primary's batching decisions, used to compare batching policies on recorded (or
+// synthetic) client request arrival traces without running a cluster.
+//
+// Consensus is modeled as a pipeline: a PrePrepare carrying b requests that starts while k other sequence numbers are
+// in flight commits after base + b * perRequest + k * perInFlight microseconds, and sequence numbers execute in order.
+namespace bftEngine::batchingLogic::sim {
+
+// Arrival timestamps in microseconds, one per line.
+inline std::vector<uint64_t> loadTrace(const std::string &path) {
+  std::vector<uint64_t> trace;
+  std::ifstream in(path);
+  uint64_t ts;
+  while (in >> ts) trace.push_back(ts);
+  std::sort(trace.begin(), trace.end());
+  return trace;
+}
+
+// Poisson arrivals at the given rate
+inline std::vector<uint64_t> poissonTrace(double requestsPerSec, uint64_t durationUs, uint32_t seed = 1) {
+  std::mt19937_64 gen(seed);
+  std::exponential_distribution<double> gap(requestsPerSec / 1e6);
+  std::vector<uint64_t> trace;
+  for (double t = gap(gen); t < durationUs; t += gap(gen)) trace.push_back((uint64_t)t);
+  return trace;
+}
+
+struct ConsensusModel {
+  uint64_t baseUs = 5000;
+  uint64_t perRequestUs = 50;
+  uint64_t perInFlightUs = 500;
+  uint32_t concurrencyLevel = 30;
+};
+
+class Policy {
+ public:
+  virtual ~Policy() = default;
+  virtual std::string name() const = 0;
+  // Number of requests to cut a batch of right now, or 0 to wait
+  virtual uint32_t batchSize(uint64_t requestsInQueue, uint64_t inFlight) = 0;
+  // Flush timer period; a flush sends whatever is queued (up to maxBatchSize) into a free slot
+  virtual uint64_t flushPeriodUs() const = 0;
+  virtual uint32_t maxBatchSize() const = 0;
+  virtual bool canFlush(uint64_t inFlight) const {
+    (void)inFlight;
+    return true;
+  }
+  virtual void onConsensusLatency(uint64_t latencyUs) { (void)latencyUs; }
+};
+
+// Models BATCH_BY_REQ_NUM: wait for a full batch, or for the flush timer
+class ByRequestsNumPolicy : public Policy {
+ public:
+  ByRequestsNumPolicy(uint32_t batchSize, uint32_t flushPeriodMs) : batchSize_(batchSize), flushMs_(flushPeriodMs) {}
+  std::string name() const override { return "BATCH_BY_REQ_NUM(" + std::to_string(batchSize_) + ")"; }
+  uint32_t batchSize(uint64_t requestsInQueue, uint64_t) override {
+    return requestsInQueue >= batchSize_ ? batchSize_ : 0;
+  }
+  uint64_t flushPeriodUs() const override { return flushMs_ * 1000ul; }
+  uint32_t maxBatchSize() const override { return batchSize_; }
+
+ private:
+  const uint32_t batchSize_;
+  const uint32_t flushMs_;
+};
+
+// Models BATCH_SELF_ADJUSTED: the minimal batch grows with the number of sequence numbers in flight
+class SelfAdjustedPolicy : public Policy {
+ public:
+  SelfAdjustedPolicy(uint32_t maxBatchSize, uint32_t maxInitialBatchSize, uint32_t batchingFactor)
+      : maxBatchSize_(maxBatchSize), maxInitialBatchSize_(maxInitialBatchSize), batchingFactor_(batchingFactor) {}
+  std::string name() const override { return "BATCH_SELF_ADJUSTED"; }
+  uint32_t batchSize(uint64_t requestsInQueue, uint64_t inFlight) override {
+    uint64_t minBatchSize = 1;
+    if (inFlight + 1 >= 2) minBatchSize = std::min<uint64_t>((inFlight + 1) * batchingFactor_, maxInitialBatchSize_);
+    if (requestsInQueue < minBatchSize) return 0;
+    return (uint32_t)std::min<uint64_t>(requestsInQueue, maxBatchSize_);
+  }
+  // The self adjusted policy has no flush timer
+  uint64_t flushPeriodUs() const override { return UINT64_MAX; }
+  uint32_t maxBatchSize() const override { return maxBatchSize_; }
+
+ private:
+  const uint32_t maxBatchSize_;
+  const uint32_t maxInitialBatchSize_;
+  const uint32_t batchingFactor_;
+};
+
+// The actual BATCH_BY_LATENCY_TARGET decision logic
+class LatencyTargetPolicy : public Policy {
+ public:
+  explicit LatencyTargetPolicy(const LatencyTargetBatchingController::Config &config)
+      : config_(config), controller_(config) {}
+  std::string name() const override { return "BATCH_BY_LATENCY_TARGET"; }
+  uint32_t batchSize(uint64_t requestsInQueue, uint64_t inFlight) override {
+    return controller_.batchSize(requestsInQueue, inFlight);
+  }
+  uint64_t flushPeriodUs() const override { return controller_.flushPeriodMs() * 1000ul; }
+  uint32_t maxBatchSize() const override { return config_.maxBatchSize; }
+  bool canFlush(uint64_t inFlight) const override { return controller_.canStartConsensus(inFlight); }
+  void onConsensusLatency(uint64_t latencyUs) override { controller_.onConsensusLatency(latencyUs / 1000); }
+  const LatencyTargetBatchingController &controller() const { return controller_; }
+
+ private:
+  const LatencyTargetBatchingController::Config config_;
+  LatencyTargetBatchingController controller_;
+};
+
+struct Result {
+  uint64_t completedRequests = 0;
+  uint64_t numOfBatches = 0;
+  double throughputPerSec = 0;
+  double avgBatchSize = 0;
+  uint64_t p50LatencyUs = 0;
+  uint64_t p99LatencyUs = 0;
+  // Commit duration of a single sequence number, which is what the replica measures as consensus time
+  uint64_t p99ConsensusUs = 0;
+};
+
+// Replays 'trace' against 'policy' and reports end-to-end request latency (arrival to execution)
+inline Result simulate(const std::vector<uint64_t> &trace, Policy &policy, const ConsensusModel &model) {
+  struct Batch {
+    uint64_t start;
+    uint64_t commit;
+    std::vector<uint64_t> arrivals;
+  };
+  std::deque<uint64_t> queue;
+  std::deque<Batch> inFlight;
+  std::vector<uint64_t> latencies;
+  std::vector<uint64_t> consensusLatencies;
+  latencies.reserve(trace.size());
+  Result result;
+  size_t next = 0;
+  uint64_t now = 0;
+  uint64_t lastSend = 0;
+  uint64_t lastCommit = 0;
+
+  auto send = [&](uint32_t size) {
+    Batch b;
+    b.start = now;
+    for (uint32_t i = 0; i < size; i++) {
+      b.arrivals.push_back(queue.front());
+      queue.pop_front();
+    }
+    b.commit = std::max(now + model.baseUs + size * model.perRequestUs + inFlight.size() * model.perInFlightUs,
+                        lastCommit);
+    lastCommit = b.commit;
+    inFlight.push_back(std::move(b));
+    lastSend = now;
+    result.numOfBatches++;
+  };
+  auto trySend = [&]() {
+    while (!queue.empty() && inFlight.size() < model.concurrencyLevel) {
+      const auto size = policy.batchSize(queue.size(), inFlight.size());
+      if (size == 0) break;
+      send(size);
+    }
+  };
+
+  while (next < trace.size() || !queue.empty() || !inFlight.empty()) {
+    const uint64_t nextArrival = next < trace.size() ? trace[next] : UINT64_MAX;
+    const uint64_t nextCommit = inFlight.empty() ? UINT64_MAX : inFlight.front().commit;
+    const uint64_t period = policy.flushPeriodUs();
+    const bool flushArmed = !queue.empty() && period != UINT64_MAX && inFlight.size() < model.concurrencyLevel &&
+                            policy.canFlush(inFlight.size());
+    const uint64_t nextFlush = flushArmed ? std::max(lastSend + period, now) : UINT64_MAX;
+    now = std::min({nextArrival, nextCommit, nextFlush});
+    if (now == UINT64_MAX) break;
+
+    if (now == nextCommit) {
+      const auto &b = inFlight.front();
+      for (auto arrival : b.arrivals) latencies.push_back(now - arrival);
+      consensusLatencies.push_back(now - b.start);
+      policy.onConsensusLatency(now - b.start);
+      inFlight.pop_front();
+    } else if (now == nextArrival) {
+      queue.push_back(trace[next++]);
+    } else {
+      send((uint32_t)std::min<uint64_t>(queue.size(), policy.maxBatchSize()));
+    }
+    trySend();
+  }
+
+  result.completedRequests = latencies.size();
+  if (latencies.empty()) return result;
+  const uint64_t duration = now > trace.front() ? now - trace.front() : 1;
+  result.throughputPerSec = latencies.size() * 1e6 / duration;
+  result.avgBatchSize = (double)latencies.size() / result.numOfBatches;
+  std::sort(latencies.begin(), latencies.end());
+  result.p50LatencyUs = latencies[latencies.size() / 2];
+  result.p99LatencyUs = latencies[(latencies.size() * 99) / 100];
+  std::sort(consensusLatencies.begin(), consensusLatencies.end());
+  result.p99ConsensusUs = consensusLatencies[(consensusLatencies.size() * 99) / 100];
+  return result;
+}
+
+}  // namespace bftEngine::batchingLogic::sim
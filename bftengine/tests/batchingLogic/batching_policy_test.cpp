@@ -0,0 +1,142 @@
+// Concord
+//
+// Copyright (c) 2020 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#include <iostream>
+
+#include "gtest/gtest.h"
+
+#include "BatchingPolicySimulator.hpp"
+
+namespace {
+using namespace bftEngine::batchingLogic;
+using namespace bftEngine::batchingLogic::sim;
+
+LatencyTargetBatchingController::Config testConfig() {
+  LatencyTargetBatchingController::Config config;
+  config.targetP99Ms = 25;
+  config.maxBatchSize = 400;
+  config.maxInFlight = 30;
+  config.minFlushPeriodMs = 2;
+  config.maxFlushPeriodMs = 100;
+  config.samplesPerAdjustment = 16;
+  return config;
+}
+
+void print(const Policy &policy, const Result &r) {
+  std::cout << policy.name() << ": tps=" << r.throughputPerSec << " avgBatch=" << r.avgBatchSize
+            << " p50=" << r.p50LatencyUs << "us p99=" << r.p99LatencyUs << "us consensus p99=" << r.p99ConsensusUs
+            << "us" << std::endl;
+}
+
+TEST(LatencyTargetBatchingController, decreases_in_flight_limit_above_target) {
+  auto config = testConfig();
+  LatencyTargetBatchingController controller(config);
+  ASSERT_EQ(controller.inFlightLimit(), config.maxInFlight);
+  for (uint32_t i = 0; i < config.samplesPerAdjustment; i++) controller.onConsensusLatency(config.targetP99Ms * 2);
+  ASSERT_EQ(controller.lastP99Ms(), config.targetP99Ms * 2);
+  ASSERT_EQ(controller.inFlightLimit(), (uint32_t)(config.maxInFlight * config.decreaseFactor));
+  // No headroom left - partial batches should not wait
+  ASSERT_EQ(controller.flushPeriodMs(), config.minFlushPeriodMs);
+
+  // Keep decreasing down to a single sequence number in flight
+  for (int i = 0; i < 100; i++) controller.onConsensusLatency(config.targetP99Ms * 2);
+  ASSERT_EQ(controller.inFlightLimit(), 1u);
+  ASSERT_EQ(controller.batchSize(10, 1), 0u);
+  ASSERT_EQ(controller.batchSize(10, 0), 10u);
+}
+
+TEST(LatencyTargetBatchingController, increases_in_flight_limit_within_target) {
+  auto config = testConfig();
+  LatencyTargetBatchingController controller(config);
+  for (uint32_t i = 0; i < config.samplesPerAdjustment; i++) controller.onConsensusLatency(config.targetP99Ms * 2);
+  const auto decreased = controller.inFlightLimit();
+  for (uint32_t i = 0; i < config.samplesPerAdjustment; i++) controller.onConsensusLatency(config.targetP99Ms / 5);
+  ASSERT_EQ(controller.inFlightLimit(), decreased + 1);
+  ASSERT_EQ(controller.flushPeriodMs(), config.targetP99Ms - config.targetP99Ms / 5);
+
+  // The limit never exceeds the configured maximum
+  for (int i = 0; i < 1000; i++) controller.onConsensusLatency(1);
+  ASSERT_EQ(controller.inFlightLimit(), config.maxInFlight);
+  ASSERT_EQ(controller.batchSize(1000, 0), config.maxBatchSize);
+  ASSERT_EQ(controller.batchSize(0, 0), 0u);
+}
+
+TEST(LatencyTargetBatchingController, p99_ignores_rare_outliers) {
+  auto config = testConfig();
+  config.samplesPerAdjustment = 200;
+  LatencyTargetBatchingController controller(config);
+  for (int i = 0; i < 199; i++) controller.onConsensusLatency(config.targetP99Ms / 2);
+  controller.onConsensusLatency(config.targetP99Ms * 100);
+  ASSERT_EQ(controller.lastP99Ms(), config.targetP99Ms / 2);
+  ASSERT_EQ(controller.inFlightLimit(), config.maxInFlight);
+}
+
+// Under a load the pipeline cannot absorb at full concurrency, the latency target policy backs off to fewer, larger
+// batches: it keeps up with the arrival rate while the consensus latency stays around the target.
+TEST(BatchingPolicySimulation, latency_target_meets_p99_under_heavy_load) {
+  ConsensusModel model;
+  // At full concurrency a sequence number takes 5ms + 30 * 1.5ms to commit, well above the 25ms target
+  model.perInFlightUs = 1500;
+  const auto trace = poissonTrace(5000, 10 * 1000 * 1000);
+  auto config = testConfig();
+
+  LatencyTargetPolicy latencyTarget(config);
+  const auto r = simulate(trace, latencyTarget, model);
+  print(latencyTarget, r);
+  ASSERT_EQ(r.completedRequests, trace.size());
+  ASSERT_GT(r.throughputPerSec, 4500);
+  ASSERT_LE(r.p99ConsensusUs, config.targetP99Ms * 1000 * 11 / 10);
+  ASSERT_LE(r.p99LatencyUs, config.targetP99Ms * 1000 * 2);
+}
+
+// Small fixed batches saturate the pipeline and fall behind the arrival rate, while the latency target policy grows
+// its batches with the queue.
+TEST(BatchingPolicySimulation, latency_target_keeps_up_with_overload) {
+  ConsensusModel model;
+  model.perInFlightUs = 1500;
+  const auto trace = poissonTrace(20000, 5 * 1000 * 1000);
+  auto config = testConfig();
+
+  LatencyTargetPolicy latencyTarget(config);
+  const auto r = simulate(trace, latencyTarget, model);
+  print(latencyTarget, r);
+
+  ByRequestsNumPolicy byReqNum(10, 100);
+  const auto n = simulate(trace, byReqNum, model);
+  print(byReqNum, n);
+
+  ASSERT_GT(r.throughputPerSec, 18000);
+  ASSERT_GT(r.throughputPerSec, n.throughputPerSec * 2);
+  ASSERT_LT(r.p99LatencyUs, n.p99LatencyUs);
+}
+
+// Under a light load, waiting for a fixed batch size costs a flush period per request, while the latency target
+// policy sends requests as they come.
+TEST(BatchingPolicySimulation, latency_target_does_not_wait_under_light_load) {
+  ConsensusModel model;
+  const auto trace = poissonTrace(200, 10 * 1000 * 1000);
+  auto config = testConfig();
+
+  LatencyTargetPolicy latencyTarget(config);
+  const auto r = simulate(trace, latencyTarget, model);
+  print(latencyTarget, r);
+
+  ByRequestsNumPolicy byReqNum(100, 50);
+  const auto n = simulate(trace, byReqNum, model);
+  print(byReqNum, n);
+
+  ASSERT_EQ(r.completedRequests, trace.size());
+  ASSERT_EQ(n.completedRequests, trace.size());
+  ASSERT_LT(r.p50LatencyUs, n.p50LatencyUs);
+  ASSERT_LE(r.p99LatencyUs, config.targetP99Ms * 1000);
+}
+
+}  // namespace
@@ -0,0 +1,58 @@
+// Concord
+//
+// Copyright (c) 2020 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+// Replays a recorded client request arrival trace (microsecond timestamps, one per line) against every batching policy
+// and prints throughput, batch size and latency percentiles for each.
+//
+// Usage: batching_trace_replay <trace file> [target p99 ms] [max batch size] [concurrency level]
+
+#include <iostream>
+#include <memory>
+
+#include "BatchingPolicySimulator.hpp"
+
+using namespace bftEngine::batchingLogic;
+using namespace bftEngine::batchingLogic::sim;
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <trace file> [target p99 ms] [max batch size] [concurrency level]"
+              << std::endl;
+    return 1;
+  }
+  const auto trace = loadTrace(argv[1]);
+  if (trace.empty()) {
+    std::cerr << "Empty or unreadable trace: " << argv[1] << std::endl;
+    return 1;
+  }
+
+  LatencyTargetBatchingController::Config config;
+  if (argc > 2) config.targetP99Ms = (uint32_t)std::stoul(argv[2]);
+  if (argc > 3) config.maxBatchSize = (uint32_t)std::stoul(argv[3]);
+  ConsensusModel model;
+  if (argc > 4) model.concurrencyLevel = (uint32_t)std::stoul(argv[4]);
+  config.maxInFlight = model.concurrencyLevel;
+
+  std::vector<std::unique_ptr<Policy>> policies;
+  policies.emplace_back(new SelfAdjustedPolicy(config.maxBatchSize, 350, 1));
+  policies.emplace_back(new ByRequestsNumPolicy(config.maxBatchSize, config.maxFlushPeriodMs));
+  policies.emplace_back(new ByRequestsNumPolicy(config.maxBatchSize / 10 + 1, config.targetP99Ms));
+  policies.emplace_back(new LatencyTargetPolicy(config));
+
+  std::cout << "Replaying " << trace.size() << " requests" << std::endl;
+  for (auto &policy : policies) {
+    const auto r = simulate(trace, *policy, model);
+    std::cout << policy->name() << ": tps=" << r.throughputPerSec << " batches=" << r.numOfBatches
+              << " avgBatch=" << r.avgBatchSize << " p50=" << r.p50LatencyUs << "us p99=" << r.p99LatencyUs << "us"
+              << std::endl;
+  }
+  return 0;
+}
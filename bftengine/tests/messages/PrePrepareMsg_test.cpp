@@ -152,6 +152,59 @@ TEST_F(PrePrepareMsgTestFixture, finalize_and_validate) {
   EXPECT_NO_THROW(msg.validate(replicaInfo));  // validate the same digest
 }
 
+TEST_F(PrePrepareMsgTestFixture, finalize_with_precomputed_digests) {
+  bftEngine::ReservedPagesClientBase::setReservedPages(&res_pages_mock_);
+  ReplicasInfo replicaInfo(createReplicaConfig(), false, false);
+
+  ReplicaId senderId = 1u;
+  ViewNum viewNum = 2u;
+  SeqNum seqNum = 3u;
+  CommitPath commitPath = CommitPath::OPTIMISTIC_FAST;
+  std::vector<std::shared_ptr<ClientRequestMsg>> crmv;
+  create_random_client_requests(crmv, 50u);
+  size_t req_size = 0;
+  for (const auto& crm : crmv) {
+    req_size += crm->size();
+  }
+
+  PrePrepareMsg expected(senderId, viewNum, seqNum, commitPath, req_size);
+  for (const auto& crm : crmv) {
+    expected.addRequest(crm->body(), crm->size());
+  }
+  expected.finishAddingRequests();
+
+  // All the digests were computed ahead of time (as done while validating the requests)
+  PrePrepareMsg precomputed(senderId, viewNum, seqNum, commitPath, req_size);
+  for (const auto& crm : crmv) {
+    EXPECT_FALSE(crm->isSigOrDigestReady());
+    crm->sigOrDigest();
+    EXPECT_TRUE(crm->isSigOrDigestReady());
+    precomputed.addRequest(*crm);
+  }
+  precomputed.finishAddingRequests();
+  EXPECT_EQ(expected.digestOfRequests(), precomputed.digestOfRequests());
+  EXPECT_NO_THROW(precomputed.validate(replicaInfo));
+
+  // Only some of the digests are at hand - all are computed when finishing
+  std::vector<std::shared_ptr<ClientRequestMsg>> crmv2;
+  create_random_client_requests(crmv2, 50u);
+  req_size = 0;
+  for (const auto& crm : crmv2) {
+    req_size += crm->size();
+  }
+  PrePrepareMsg expected2(senderId, viewNum, seqNum, commitPath, req_size);
+  PrePrepareMsg partial(senderId, viewNum, seqNum, commitPath, req_size);
+  for (size_t i = 0; i < crmv2.size(); i++) {
+    if (i % 2 == 1) crmv2[i]->sigOrDigest();
+    expected2.addRequest(crmv2[i]->body(), crmv2[i]->size());
+    partial.addRequest(*crmv2[i]);
+  }
+  expected2.finishAddingRequests();
+  partial.finishAddingRequests();
+  EXPECT_EQ(expected2.digestOfRequests(), partial.digestOfRequests());
+  EXPECT_NO_THROW(partial.validate(replicaInfo));
+}
+
 TEST_F(PrePrepareMsgTestFixture, create_and_compare) {
   ReplicasInfo replicaInfo(createReplicaConfig(), false, false);
   bftEngine::ReservedPagesClientBase::setReservedPages(&res_pages_mock_);
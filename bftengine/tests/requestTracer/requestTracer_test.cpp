@@ -0,0 +1,149 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "gtest/gtest.h"
+
+#include "RequestTracer.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace bftEngine::impl;
+using namespace std::chrono_literals;
+using Stage = RequestTracer::Stage;
+
+class request_tracer_test : public ::testing::Test {
+  void SetUp() override {
+    tracer_.setAggregator(aggregator_);
+    tracer_.setMetricsWindow(0ms);
+    tracer_.setSamplesPerMillion(1000000);
+    // Drain what previous tests left behind
+    tracer_.aggregate();
+  }
+
+  void TearDown() override {
+    tracer_.setSamplesPerMillion(0);
+    tracer_.setMetricsWindow(RequestTracer::kDefaultMetricsWindow);
+  }
+
+ protected:
+  uint64_t counter(const std::string& name) { return aggregator_->GetCounter("request_tracer", name).Get(); }
+  uint64_t gauge(const std::string& name) { return aggregator_->GetGauge("request_tracer", name).Get(); }
+
+  void traceStages(NodeIdType clientId, ReqId reqSeqNum, const std::vector<Stage>& stages) {
+    for (auto stage : stages) {
+      tracer_.trace(clientId, reqSeqNum, stage);
+    }
+  }
+
+  RequestTracer& tracer_ = RequestTracer::instance();
+  const std::shared_ptr<concordMetrics::Aggregator> aggregator_ = std::make_shared<concordMetrics::Aggregator>();
+  const std::vector<Stage> allStages_{
+      Stage::Received, Stage::Dequeued, Stage::PrePrepared, Stage::Committed, Stage::Executed, Stage::Replied};
+};
+
+TEST(request_tracer, sampling_is_deterministic_and_follows_the_rate) {
+  const uint64_t numOfRequests = 1000000;
+  uint64_t sampled = 0;
+  for (ReqId reqSeqNum = 0; reqSeqNum < numOfRequests; ++reqSeqNum) {
+    const bool isSampled = RequestTracer::isSampled(7, reqSeqNum, 10000);
+    ASSERT_EQ(isSampled, RequestTracer::isSampled(7, reqSeqNum, 10000));
+    if (isSampled) ++sampled;
+    ASSERT_FALSE(RequestTracer::isSampled(7, reqSeqNum, 0));
+    ASSERT_TRUE(RequestTracer::isSampled(7, reqSeqNum, 1000000));
+  }
+  // 1% of the requests
+  ASSERT_GT(sampled, numOfRequests / 100 * 9 / 10);
+  ASSERT_LT(sampled, numOfRequests / 100 * 11 / 10);
+}
+
+TEST_F(request_tracer_test, replied_requests_are_recorded) {
+  const auto traced = counter("traced_requests");
+  for (ReqId reqSeqNum = 1; reqSeqNum <= 10; ++reqSeqNum) {
+    tracer_.trace(1, reqSeqNum, Stage::Received);
+    std::this_thread::sleep_for(1ms);
+    traceStages(1, reqSeqNum, {Stage::Dequeued, Stage::PrePrepared, Stage::Committed, Stage::Executed});
+    tracer_.trace(1, reqSeqNum, Stage::Replied);
+  }
+  // Not replied yet
+  traceStages(1, 11, {Stage::Received, Stage::Dequeued});
+  tracer_.aggregate();
+
+  ASSERT_EQ(traced + 10, counter("traced_requests"));
+  ASSERT_GE(gauge("queueing_p50_us"), 1000);
+  ASSERT_GE(gauge("total_p99_us"), gauge("queueing_p99_us"));
+
+  tracer_.trace(1, 11, Stage::Replied);
+  tracer_.aggregate();
+  ASSERT_EQ(traced + 11, counter("traced_requests"));
+}
+
+TEST_F(request_tracer_test, backups_record_the_stages_they_go_through) {
+  const auto traced = counter("traced_requests");
+  traceStages(2, 1, {Stage::PrePrepared, Stage::Committed, Stage::Executed, Stage::Replied});
+  tracer_.aggregate();
+  ASSERT_EQ(traced + 1, counter("traced_requests"));
+  ASSERT_EQ(0, gauge("queueing_p50_us"));
+}
+
+TEST_F(request_tracer_test, nothing_is_traced_when_disabled) {
+  const auto traced = counter("traced_requests");
+  tracer_.setSamplesPerMillion(0);
+  ASSERT_FALSE(tracer_.enabled());
+  traceStages(3, 1, allStages_);
+  tracer_.aggregate();
+  ASSERT_EQ(traced, counter("traced_requests"));
+}
+
+TEST_F(request_tracer_test, events_are_dropped_when_the_buffer_is_full) {
+  const auto traced = counter("traced_requests");
+  const auto dropped = counter("dropped_events");
+  for (ReqId reqSeqNum = 0; reqSeqNum < RequestTracer::kBufferSize + 10; ++reqSeqNum) {
+    tracer_.trace(4, reqSeqNum, Stage::Received);
+  }
+  traceStages(4, RequestTracer::kBufferSize + 11, allStages_);
+  ASSERT_EQ(dropped + 10 + allStages_.size(), counter("dropped_events"));
+
+  // The buffer is usable again once drained
+  tracer_.aggregate();
+  traceStages(4, RequestTracer::kBufferSize + 12, allStages_);
+  tracer_.aggregate();
+  ASSERT_EQ(traced + 1, counter("traced_requests"));
+}
+
+TEST_F(request_tracer_test, concurrent_producers) {
+  const auto traced = counter("traced_requests");
+  const auto dropped = counter("dropped_events");
+  const ReqId requestsPerThread = 2000;
+  std::vector<std::thread> producers;
+  for (NodeIdType clientId = 10; clientId < 14; ++clientId) {
+    producers.emplace_back([this, clientId, requestsPerThread]() {
+      for (ReqId reqSeqNum = 0; reqSeqNum < requestsPerThread; ++reqSeqNum) {
+        traceStages(clientId, reqSeqNum, allStages_);
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  tracer_.aggregate();
+  ASSERT_EQ(dropped, counter("dropped_events"));
+  ASSERT_EQ(traced + 4 * requestsPerThread, counter("traced_requests"));
+}
+
+}  // namespace
@@ -0,0 +1,336 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "CollectorOfThresholdSignatures.hpp"
+#include "ReplicaConfig.hpp"
+#include "ReplicasInfo.hpp"
+
+using namespace bftEngine;
+using namespace bftEngine::impl;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr uint16_t kNumOfReplicas = 4;
+constexpr uint16_t kNumOfRequired = 3;
+constexpr SeqNum kSeqNum = 7;
+constexpr ViewNum kView = 1;
+
+// A threshold scheme that only keeps track of what was signed: a share is the id of its signer followed by the digest
+// it signed, and a valid threshold signature is 'V' followed by the digest. Combining without share verification, like
+// the optimistic accumulation does, yields a signature which doesn't verify as soon as one of the shares is bad.
+std::vector<char> signShare(ReplicaId signer, const Digest& digest) {
+  std::vector<char> share(sizeof(ShareID) + DIGEST_SIZE);
+  const ShareID id = signer + 1;  // signer ids start with 1
+  memcpy(share.data(), &id, sizeof(id));
+  memcpy(share.data() + sizeof(id), digest.content(), DIGEST_SIZE);
+  return share;
+}
+
+class FakeKey : public IShareVerificationKey {
+ public:
+  std::string toString() const override { return "FakeKey"; }
+};
+
+class FakeAccumulator : public IThresholdAccumulator {
+ public:
+  FakeAccumulator(bool withShareVerification, std::atomic_int& addedShares)
+      : withShareVerification_{withShareVerification}, addedShares_{addedShares} {}
+
+  int add(const char* sigShareWithId, int len) override {
+    ShareID id;
+    memcpy(&id, sigShareWithId, sizeof(id));
+    shares_.emplace_back(id, std::string(sigShareWithId + sizeof(id), len - sizeof(id)));
+    addedShares_++;
+    return shares_.size();
+  }
+  void setExpectedDigest(const unsigned char* msg, int len) override {
+    expectedDigest_ = std::string(reinterpret_cast<const char*>(msg), len);
+  }
+  bool hasShareVerificationEnabled() const override { return withShareVerification_; }
+  int getNumValidShares() const override { return shares_.size() - getInvalidShareIds().size(); }
+  std::set<ShareID> getInvalidShareIds() const override {
+    std::set<ShareID> invalid;
+    if (!withShareVerification_) return invalid;
+    for (const auto& [id, signedDigest] : shares_) {
+      if (signedDigest != expectedDigest_) invalid.insert(id);
+    }
+    return invalid;
+  }
+  void getFullSignedData(char* outThreshSig, int threshSigLen) override {
+    ASSERT_EQ(1 + DIGEST_SIZE, threshSigLen);
+    ASSERT_FALSE(expectedDigest_.empty());
+    size_t numOfShares = 0;
+    bool allValid = true;
+    for (const auto& share : shares_) {
+      if (share.second == expectedDigest_) {
+        numOfShares++;
+      } else if (!withShareVerification_) {
+        numOfShares++;
+        allValid = false;
+      }
+    }
+    const bool valid = allValid && numOfShares >= kNumOfRequired;
+    outThreshSig[0] = valid ? 'V' : 'X';
+    memcpy(outThreshSig + 1, expectedDigest_.data(), DIGEST_SIZE);
+  }
+
+ private:
+  const bool withShareVerification_;
+  std::atomic_int& addedShares_;
+  std::string expectedDigest_;
+  std::vector<std::pair<ShareID, std::string>> shares_;
+};
+
+class FakeVerifier : public IThresholdVerifier {
+ public:
+  IThresholdAccumulator* newAccumulator(bool withShareVerification) const override {
+    return new FakeAccumulator(withShareVerification, withShareVerification ? verifiedShares : foldedShares);
+  }
+  bool verify(const char* msg, int msgLen, const char* sig, int sigLen) const override {
+    return sigLen == 1 + DIGEST_SIZE && sig[0] == 'V' && memcmp(sig + 1, msg, msgLen) == 0;
+  }
+  int requiredLengthForSignedData() const override { return 1 + DIGEST_SIZE; }
+  const IPublicKey& getPublicKey() const override { return key_; }
+  const IShareVerificationKey& getShareVerificationKey(ShareID) const override { return key_; }
+
+  // Number of shares added to the accumulators without/with share verification
+  mutable std::atomic_int foldedShares{0};
+  mutable std::atomic_int verifiedShares{0};
+
+ private:
+  FakeKey key_;
+};
+
+// Collects the internal messages the background jobs send to the replica
+class TestMsgsStorage : public IncomingMsgsStorage {
+ public:
+  void start() override {}
+  void stop() override {}
+  bool isRunning() const override { return true; }
+  bool pushExternalMsg(std::unique_ptr<MessageBase>) override { return false; }
+  bool pushExternalMsg(std::unique_ptr<MessageBase>, Callback) override { return false; }
+  bool pushExternalMsgRaw(char*, size_t) override { return false; }
+  bool pushExternalMsgRaw(char*, size_t, Callback) override { return false; }
+  void pushInternalMsg(InternalMessage&& msg) override {
+    std::lock_guard<std::mutex> lock(lock_);
+    msgs_.push_back(std::move(msg));
+    cond_.notify_all();
+  }
+
+  std::optional<InternalMessage> pop() {
+    std::unique_lock<std::mutex> lock(lock_);
+    if (!cond_.wait_for(lock, 5s, [this] { return !msgs_.empty(); })) return std::nullopt;
+    auto msg = std::move(msgs_.front());
+    msgs_.pop_front();
+    return msg;
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cond_;
+  std::deque<InternalMessage> msgs_;
+};
+
+class TestReplica : public InternalReplicaApi {
+ public:
+  TestReplica() { pool_.start(4); }
+  ~TestReplica() { pool_.stop(); }
+
+  const ReplicasInfo& getReplicasInfo() const override { return replicasInfo_; }
+  bool isValidClient(NodeIdType) const override { return true; }
+  bool isIdOfReplica(NodeIdType) const override { return true; }
+  const std::set<ReplicaId>& getIdsOfPeerReplicas() const override { return peers_; }
+  ViewNum getCurrentView() const override { return kView; }
+  ReplicaId currentPrimary() const override { return 0; }
+  bool isCurrentPrimary() const override { return true; }
+  bool currentViewIsActive() const override { return true; }
+  bool isReplyAlreadySentToClient(NodeIdType, ReqId) const override { return false; }
+  bool isClientRequestInProcess(NodeIdType, ReqId) const override { return false; }
+  SeqNum getPrimaryLastUsedSeqNum() const override { return 0; }
+  uint64_t getRequestsInQueue() const override { return 0; }
+  SeqNum getLastExecutedSeqNum() const override { return 0; }
+  IncomingMsgsStorage& getIncomingMsgsStorage() override { return msgsStorage_; }
+  concord::util::SimpleThreadPool& getInternalThreadPool() override { return pool_; }
+  bool isCollectingState() const override { return false; }
+  const ReplicaConfig& getReplicaConfig() const override { return ReplicaConfig::instance(); }
+
+  TestMsgsStorage msgsStorage_;
+  std::shared_ptr<FakeVerifier> verifier_ = std::make_shared<FakeVerifier>();
+
+ private:
+  concord::util::SimpleThreadPool pool_;
+  ReplicasInfo replicasInfo_;
+  std::set<ReplicaId> peers_;
+};
+
+TestReplica* replica = nullptr;
+
+class ShareMsg {
+ public:
+  ShareMsg(std::vector<char> share) : share_{std::move(share)} {}
+  SeqNum seqNumber() const { return kSeqNum; }
+  ViewNum viewNumber() const { return kView; }
+  const char* signatureBody() const { return share_.data(); }
+  uint16_t signatureLen() const { return share_.size(); }
+  template <typename MessageT>
+  concordUtils::SpanContext spanContext() const {
+    return concordUtils::SpanContext{};
+  }
+
+ private:
+  std::vector<char> share_;
+};
+
+class CombinedMsg {
+ public:
+  CombinedMsg(const char* sig, uint16_t sigLen) : sig_(sig, sig + sigLen) {}
+  SeqNum seqNumber() const { return kSeqNum; }
+  ViewNum viewNumber() const { return kView; }
+  const char* signatureBody() const { return sig_.data(); }
+  uint16_t signatureLen() const { return sig_.size(); }
+
+ private:
+  std::vector<char> sig_;
+};
+
+class ExFuncForTestCollector {
+ public:
+  static CombinedMsg* createCombinedSignatureMsg(void*,
+                                                 SeqNum,
+                                                 ViewNum,
+                                                 const char* const combinedSig,
+                                                 uint16_t combinedSigLen,
+                                                 const concordUtils::SpanContext&) {
+    return new CombinedMsg(combinedSig, combinedSigLen);
+  }
+  static InternalMessage createInterCombinedSigFailed(SeqNum seqNumber,
+                                                      ViewNum viewNumber,
+                                                      const std::set<uint16_t>& replicasWithBadSigs) {
+    return CombinedSigFailedInternalMsg(seqNumber, viewNumber, replicasWithBadSigs);
+  }
+  static InternalMessage createInterCombinedSigSucceeded(SeqNum seqNumber,
+                                                         ViewNum viewNumber,
+                                                         const char* combinedSig,
+                                                         uint16_t combinedSigLen,
+                                                         const concordUtils::SpanContext& span_context) {
+    return CombinedSigSucceededInternalMsg(seqNumber, viewNumber, combinedSig, combinedSigLen, span_context);
+  }
+  static InternalMessage createInterVerifyCombinedSigResult(SeqNum seqNumber, ViewNum viewNumber, bool isValid) {
+    return VerifyCombinedSigResultInternalMsg(seqNumber, viewNumber, isValid);
+  }
+  static uint16_t numberOfRequiredSignatures(void*) { return kNumOfRequired; }
+  static std::shared_ptr<IThresholdVerifier> thresholdVerifier(SeqNum) { return replica->verifier_; }
+  static concord::util::SimpleThreadPool& threadPool(void*) { return replica->getInternalThreadPool(); }
+  static IncomingMsgsStorage& incomingMsgsStorage(void*) { return replica->getIncomingMsgsStorage(); }
+};
+
+using Collector = CollectorOfThresholdSignatures<ShareMsg, CombinedMsg, ExFuncForTestCollector>;
+
+class collector_of_threshold_signatures_test : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ReplicaConfig::instance().numReplicas = kNumOfReplicas;
+    ReplicaConfig::instance().fVal = 1;
+    replica = &replica_;
+  }
+  void TearDown() override { replica = nullptr; }
+
+  void addShare(ReplicaId signer, const Digest& signedDigest) {
+    ASSERT_TRUE(collector_.addMsgWithPartialSignature(new ShareMsg(signShare(signer, signedDigest)), signer));
+  }
+
+  // Hands the result of the background processing to the collector, the way the replica does
+  template <typename ResultMsg>
+  ResultMsg waitForResult() {
+    auto msg = replica_.msgsStorage_.pop();
+    if (!msg) throw std::runtime_error("no result of the signatures processing");
+    auto* result = std::get_if<ResultMsg>(&*msg);
+    if (!result) throw std::runtime_error("unexpected result of the signatures processing");
+    if constexpr (std::is_same_v<ResultMsg, CombinedSigSucceededInternalMsg>) {
+      collector_.onCompletionOfSignaturesProcessing(result->seqNumber,
+                                                    result->view,
+                                                    result->combinedSig.data(),
+                                                    result->combinedSig.size(),
+                                                    result->span_context_);
+    } else {
+      collector_.onCompletionOfSignaturesProcessing(result->seqNumber, result->view, result->replicasWithBadSigs);
+    }
+    return *result;
+  }
+
+  bool isValid(const CombinedMsg& msg) {
+    return replica_.verifier_->verify(digest_.content(), DIGEST_SIZE, msg.signatureBody(), msg.signatureLen());
+  }
+
+  TestReplica replica_;
+  Digest digest_{'d'};
+  Collector collector_{&replica_};
+};
+
+TEST_F(collector_of_threshold_signatures_test, folds_valid_shares_into_a_verified_combined_signature) {
+  collector_.setExpected(kSeqNum, kView, digest_);
+  for (ReplicaId signer = 0; signer < kNumOfRequired; ++signer) addShare(signer, digest_);
+
+  const auto result = waitForResult<CombinedSigSucceededInternalMsg>();
+  ASSERT_TRUE(
+      replica_.verifier_->verify(digest_.content(), DIGEST_SIZE, result.combinedSig.data(), result.combinedSig.size()));
+  ASSERT_TRUE(collector_.isComplete());
+  ASSERT_TRUE(isValid(*collector_.getMsgWithValidCombinedSignature()));
+  // Each share is folded once, whether by its folding job or by the job that completes the quorum
+  ASSERT_EQ(kNumOfRequired, replica_.verifier_->foldedShares.load());
+  ASSERT_EQ(0, replica_.verifier_->verifiedShares.load());
+}
+
+TEST_F(collector_of_threshold_signatures_test, shares_that_arrive_before_the_digest_are_folded_once_it_is_known) {
+  for (ReplicaId signer = 0; signer < kNumOfRequired; ++signer) addShare(signer, digest_);
+  collector_.setExpected(kSeqNum, kView, digest_);
+
+  waitForResult<CombinedSigSucceededInternalMsg>();
+  ASSERT_TRUE(collector_.isComplete());
+  ASSERT_TRUE(isValid(*collector_.getMsgWithValidCombinedSignature()));
+  ASSERT_EQ(kNumOfRequired, replica_.verifier_->foldedShares.load());
+}
+
+TEST_F(collector_of_threshold_signatures_test, bad_share_is_found_and_its_replica_reported) {
+  constexpr ReplicaId kBadReplica = 1;
+  collector_.setExpected(kSeqNum, kView, digest_);
+  for (ReplicaId signer = 0; signer < kNumOfRequired; ++signer) {
+    addShare(signer, signer == kBadReplica ? Digest{'x'} : digest_);
+  }
+
+  // The optimistic combination doesn't verify, the share-verifying accumulator finds the bad share
+  const auto failure = waitForResult<CombinedSigFailedInternalMsg>();
+  ASSERT_EQ(std::set<uint16_t>{kBadReplica}, failure.replicasWithBadSigs);
+  ASSERT_EQ(kNumOfRequired, replica_.verifier_->verifiedShares.load());
+  ASSERT_FALSE(collector_.isComplete());
+
+  // The accumulation is rebuilt from the remaining shares once another replica completes the quorum
+  addShare(kNumOfRequired, digest_);
+  waitForResult<CombinedSigSucceededInternalMsg>();
+  ASSERT_TRUE(collector_.isComplete());
+  ASSERT_TRUE(isValid(*collector_.getMsgWithValidCombinedSignature()));
+}
+
+}  // namespace
@@ -0,0 +1,100 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace concord::concord_client_pool {
+
+// Decides when the pool-level batch is sent. A batch is sent once it reaches its count target or its byte target
+// (0 - no byte target), or once its first request waited for the latency budget.
+//
+// The policy adapts to the arrival rate: if, at the average rate, the next request isn't expected before the latency
+// budget runs out, the batch is sent right away - waiting for it would only add latency.
+class AdaptiveBatchPolicy {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  AdaptiveBatchPolicy(size_t max_requests, size_t max_bytes, std::chrono::milliseconds max_delay)
+      : max_requests_{std::max<size_t>(max_requests, 1)}, max_bytes_{max_bytes}, max_delay_{max_delay} {}
+
+  // Account for a request added to the batch
+  void add(size_t bytes, Clock::time_point now) {
+    if (requests_ == 0) {
+      opened_ = now;
+    }
+    if (last_arrival_) {
+      // Exponentially weighted moving average with a weight of 1/8 for the new interval
+      avg_interval_ += (now - *last_arrival_ - avg_interval_) / 8;
+    }
+    last_arrival_ = now;
+    ++requests_;
+    bytes_ += bytes;
+  }
+
+  bool empty() const { return requests_ == 0; }
+
+  // The batch reached its count or byte target
+  bool full() const { return requests_ >= max_requests_ || (max_bytes_ > 0 && bytes_ >= max_bytes_); }
+
+  // The latest time the batch is sent at
+  Clock::time_point deadline() const { return opened_ + max_delay_; }
+
+  // Whether the batch should be sent now
+  bool shouldSend(Clock::time_point now) const {
+    if (empty()) {
+      return false;
+    }
+    if (full() || now >= deadline()) {
+      return true;
+    }
+    return std::max(now, *last_arrival_ + avg_interval_) >= deadline();
+  }
+
+  // How long the batch has been open
+  std::chrono::milliseconds age(Clock::time_point now) const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now - opened_);
+  }
+
+  // How full the batch is relative to its targets, in percent
+  uint64_t fillPercent() const {
+    auto fill = requests_ * 100 / max_requests_;
+    if (max_bytes_ > 0) {
+      fill = std::max(fill, bytes_ * 100 / max_bytes_);
+    }
+    return std::min<uint64_t>(fill, 100);
+  }
+
+  // Start a new batch, the arrival rate is kept
+  void reset() {
+    requests_ = 0;
+    bytes_ = 0;
+  }
+
+ private:
+  const size_t max_requests_;
+  const size_t max_bytes_;
+  const std::chrono::milliseconds max_delay_;
+  size_t requests_{0};
+  size_t bytes_{0};
+  Clock::time_point opened_;
+  std::optional<Clock::time_point> last_arrival_;
+  Clock::duration avg_interval_{0};
+};
+
+}  // namespace concord::concord_client_pool
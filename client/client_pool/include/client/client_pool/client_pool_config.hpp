@@ -68,6 +68,12 @@ typedef struct ConcordClientPoolConfig {
   bool client_batching_enabled = false;
   size_t client_batching_max_messages_nbr = 20;
   std::uint64_t client_batching_flush_timeout_ms = 100;
+  // Batch the requests of all clients in a single pool-level batch instead of a batch per client. The batch is sent
+  // once it reaches client_batching_max_messages_nbr requests or client_batching_max_bytes bytes, or once its first
+  // request waited for client_batching_flush_timeout_ms - earlier if the arrival rate is too low to fill it further.
+  bool client_batching_adaptive = false;
+  // 0 - no byte target
+  size_t client_batching_max_bytes = 0;
   bool encrypted_config_enabled = false;
   bool transaction_signing_enabled = false;
   bool with_cre = false;
@@ -118,6 +124,8 @@ class ClientPoolConfig {
   const std::string CLIENT_BATCHING_ENABLED = "client_batching_enabled";
   const std::string CLIENT_BATCHING_MAX_MSG_NUM = "client_batching_max_messages_nbr";
   const std::string CLIENT_BATCHING_TIMEOUT_MILLI = "client_batching_flush_timeout_ms";
+  const std::string CLIENT_BATCHING_ADAPTIVE = "client_batching_adaptive";
+  const std::string CLIENT_BATCHING_MAX_BYTES = "client_batching_max_bytes";
   const std::string TRACE_SAMPLING_RATE = "trace_sampling_rate";
   ClientPoolConfig();
 
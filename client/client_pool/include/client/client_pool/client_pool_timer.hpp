@@ -45,13 +45,16 @@ class Timer {
     timer_thread_future_.wait();
   }
 
-  void set(const ClientT& client) {
+  void set(const ClientT& client) { set(client, timeout_); }
+
+  // Set with a different timeout than the one given at construction. Resetting a set timer cancels it.
+  void set(const ClientT& client, std::chrono::milliseconds custom_timeout) {
     if (timeout_.count() == 0) {
       return;
     }
     client_ = client;
     start_timer_ = std::chrono::steady_clock::now();
-    boost::posix_time::milliseconds timeout(timeout_.count());
+    boost::posix_time::milliseconds timeout(custom_timeout.count());
     timer_.expires_from_now(timeout);
     auto handler = [this](const boost::system::error_code& error) {
       if (error != boost::asio::error::operation_aborted) {
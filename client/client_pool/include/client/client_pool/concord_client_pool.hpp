@@ -24,6 +24,7 @@
 #include "bftclient/base_types.h"
 #include "bftclient/config.h"
 #include "bftclient/quorums.h"
+#include "batch_policy.hpp"
 #include "client_pool_timer.hpp"
 #include "external_client.hpp"
 
@@ -72,6 +73,7 @@ struct externalRequest {
   std::chrono::steady_clock::time_point arrival_time;
   char* reply_buffer = nullptr;
   std::uint32_t reply_size;
+  bftEngine::RequestCallBack callback = {};
 };
 
 // Represents a Concord BFT client pool. The purpose of this class is to be
@@ -169,6 +171,18 @@ class ConcordClientPool {
   void CreatePool(concord::config_pool::ConcordClientPoolConfig&);
 
   void OnBatchingTimeout(ClientPtr client);
+
+  // Pool-level batching, see ConcordClientPoolConfig::client_batching_adaptive. Called with clients_queue_lock_ held.
+  // Add a request to the pool batch and send the batch if it's due
+  void AddToPoolBatch(externalRequest&& request);
+  // Add a request to the pool batch without sending it
+  void AppendToPoolBatch(externalRequest&& request);
+  // Send the pool batch with the given client or, if none given, with an available one.
+  // Return false if there is no available client.
+  bool SendPoolBatch(ClientPtr client = nullptr);
+  // Give a client which completed its job the due pool batch or the next request of the wait queue
+  void OnClientAvailableForPoolBatch(ClientPtr& client);
+  void OnPoolBatchingTimeout(uint64_t batch_generation);
   bool clusterHasKeys(ClientPtr& cl);
   std::atomic_bool hasKeys_{false};
   std::atomic_bool stop_{false};
@@ -191,6 +205,8 @@ class ConcordClientPool {
     concordMetrics::CounterHandle rejected_counter;
     concordMetrics::CounterHandle full_batch_counter;
     concordMetrics::CounterHandle partial_batch_counter;
+    // Pool batches sent before reaching a target or the latency budget because of a low arrival rate
+    concordMetrics::CounterHandle early_batch_counter;
     concordMetrics::CounterHandle first_leg_counter;
     concordMetrics::CounterHandle second_leg_counter;
     concordMetrics::GaugeHandle size_of_batch_gauge;
@@ -198,6 +214,8 @@ class ConcordClientPool {
     concordMetrics::GaugeHandle last_request_time_gauge;
     concordMetrics::GaugeHandle average_req_dur_gauge;
     concordMetrics::GaugeHandle average_batch_agg_dur_gauge;
+    // How full the pool batches are relative to their count or byte target, in percent
+    concordMetrics::GaugeHandle average_batch_fill_gauge;
   } ClientPoolMetrics_;
 
   // Logger
@@ -209,6 +227,16 @@ class ConcordClientPool {
   std::unique_ptr<Timer_t> batch_timer_;
   bftEngine::impl::RollingAvgAndVar average_req_dur_;
   bftEngine::impl::RollingAvgAndVar batch_agg_dur_;
+
+  // Pool-level batching
+  bool pool_batching_enabled_{false};
+  std::chrono::milliseconds batch_timeout_{0};
+  std::unique_ptr<AdaptiveBatchPolicy> batch_policy_;
+  std::deque<externalRequest> pool_batch_;
+  // Incremented whenever the pool batch is sent, to ignore the timeouts of already sent batches
+  uint64_t pool_batch_generation_{0};
+  std::unique_ptr<::concord_client_pool::Timer<uint64_t>> pool_batch_timer_;
+  bftEngine::impl::RollingAvgAndVar batch_fill_;
 };
 
 class BatchRequestProcessingJob : public concord::util::SimpleThreadPool::Job {
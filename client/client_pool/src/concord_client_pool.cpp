@@ -14,6 +14,7 @@
 #include "client/client_pool/concord_client_pool.hpp"
 
 #include <sparse_merkle/base_types.h>
+#include <algorithm>
 #include <mutex>
 #include <thread>
 #include <utility>
@@ -53,7 +54,27 @@ SubmitResult ConcordClientPool::SendRequest(std::vector<uint8_t> &&request,
   auto serving_candidates = clients_.size();
   int client_id = 0;
 
-  while (!clients_.empty() && serving_candidates != 0) {
+  const bool pool_batch = pool_batching_enabled_ && IsGoodForBatching(flags, client_batching_enabled_);
+  if (pool_batch) {
+    // A full batch waits for a client, further requests wait in the queue. A request without a sequence number gets
+    // one from the client that sends the batch.
+    if (!batch_policy_->full()) {
+      LOG_DEBUG(logger_, "Request Acknowledged (pool batch)" << KVLOG(correlation_id, seq_num, pool_batch_.size()));
+      AddToPoolBatch(externalRequest{std::move(request),
+                                     flags,
+                                     timeout_ms,
+                                     seq_num,
+                                     std::move(correlation_id),
+                                     std::move(span_context),
+                                     std::chrono::steady_clock::now(),
+                                     reply_buffer,
+                                     max_reply_size,
+                                     callback});
+      return SubmitResult::Acknowledged;
+    }
+  }
+
+  while (!pool_batch && !clients_.empty() && serving_candidates != 0) {
     auto client = clients_.front();
     client_id = client->getClientId();
     if (is_overloaded_) {
@@ -145,7 +166,8 @@ SubmitResult ConcordClientPool::SendRequest(std::vector<uint8_t> &&request,
                                                           std::move(span_context),
                                                           std::chrono::steady_clock::now(),
                                                           reply_buffer,
-                                                          max_reply_size});
+                                                          max_reply_size,
+                                                          callback});
     LOG_DEBUG(logger_, "Request Acknowledged (external)" << KVLOG(client_id, correlation_id, seq_num, flags));
     return SubmitResult::Acknowledged;
   } else {
@@ -246,13 +268,15 @@ ConcordClientPool::ConcordClientPool(config_pool::ConcordClientPoolConfig &confi
                          metricsComponent_.RegisterCounter("rejected_counter"),
                          metricsComponent_.RegisterCounter("full_batch_counter"),
                          metricsComponent_.RegisterCounter("partial_batch_counter"),
+                         metricsComponent_.RegisterCounter("early_batch_counter"),
                          metricsComponent_.RegisterCounter("first_leg_counter"),
                          metricsComponent_.RegisterCounter("second_leg_counter"),
                          metricsComponent_.RegisterGauge("size_of_batch_gauge", 0),
                          metricsComponent_.RegisterGauge("clients_gauge", 0),
                          metricsComponent_.RegisterGauge("last_request_time_gauge", 0),
                          metricsComponent_.RegisterGauge("average_req_dur_gauge", 0),
-                         metricsComponent_.RegisterGauge("average_batch_agg_dur_gauge", 0)},
+                         metricsComponent_.RegisterGauge("average_batch_agg_dur_gauge", 0),
+                         metricsComponent_.RegisterGauge("average_batch_fill_gauge", 0)},
       logger_(logging::getLogger("com.vmware.external_client_pool")) {
   concord::external_client::ConcordClient::setDelayFlagForTest(delay_behavior);
   try {
@@ -274,13 +298,15 @@ ConcordClientPool::ConcordClientPool(config_pool::ConcordClientPoolConfig &confi
                          metricsComponent_.RegisterCounter("rejected_counter"),
                          metricsComponent_.RegisterCounter("full_batch_counter"),
                          metricsComponent_.RegisterCounter("partial_batch_counter"),
+                         metricsComponent_.RegisterCounter("early_batch_counter"),
                          metricsComponent_.RegisterCounter("first_leg_counter"),
                          metricsComponent_.RegisterCounter("second_leg_counter"),
                          metricsComponent_.RegisterGauge("size_of_batch_gauge", 0),
                          metricsComponent_.RegisterGauge("clients_gauge", 0),
                          metricsComponent_.RegisterGauge("last_request_time_gauge", 0),
                          metricsComponent_.RegisterGauge("average_req_dur_gauge", 0),
-                         metricsComponent_.RegisterGauge("average_batch_agg_dur_gauge", 0)},
+                         metricsComponent_.RegisterGauge("average_batch_agg_dur_gauge", 0),
+                         metricsComponent_.RegisterGauge("average_batch_fill_gauge", 0)},
       logger_(logging::getLogger("com.vmware.external_client_pool")) {
   try {
     metricsComponent_.SetAggregator(aggregator);
@@ -350,6 +376,16 @@ void ConcordClientPool::CreatePool(concord::config_pool::ConcordClientPoolConfig
   }
   batch_timer_ =
       std::make_unique<Timer_t>(timeout, [this](ClientPtr client) -> void { OnBatchingTimeout(std::move(client)); });
+  if (config.client_batching_enabled && config.client_batching_adaptive) {
+    pool_batching_enabled_ = true;
+    batch_timeout_ = timeout;
+    batch_policy_ = std::make_unique<AdaptiveBatchPolicy>(batch_size_, config.client_batching_max_bytes, timeout);
+    pool_batch_timer_ = std::make_unique<::concord_client_pool::Timer<uint64_t>>(
+        timeout, [this](uint64_t batch_generation) { OnPoolBatchingTimeout(batch_generation); });
+    LOG_INFO(logger_,
+             "The requests of all clients are batched together"
+                 << KVLOG(batch_size_, config.client_batching_max_bytes, timeout.count()));
+  }
   external_client::ConcordClient::setStatics(required_num_of_replicas, num_replicas, max_buf_size, batch_size_);
   bftEngine::SimpleClientParams clientParams;
   setUpClientParams(clientParams, config);
@@ -377,8 +413,130 @@ void ConcordClientPool::OnBatchingTimeout(std::shared_ptr<concord::external_clie
   assignJobToClient(client);
 }
 
+void ConcordClientPool::AddToPoolBatch(externalRequest &&request) {
+  AppendToPoolBatch(std::move(request));
+  if (batch_policy_->shouldSend(std::chrono::steady_clock::now())) {
+    SendPoolBatch();
+  }
+}
+
+void ConcordClientPool::AppendToPoolBatch(externalRequest &&request) {
+  if (pool_batch_.empty()) {
+    LOG_TRACE(logger_, "Set pool batching timer" << KVLOG(pool_batch_generation_));
+    pool_batch_timer_->set(pool_batch_generation_, batch_timeout_);
+  }
+  batch_policy_->add(request.request.size(), std::chrono::steady_clock::now());
+  if (request.correlation_id.find('-') != std::string::npos) {
+    ClientPoolMetrics_.first_leg_counter++;
+  } else {
+    ClientPoolMetrics_.second_leg_counter++;
+  }
+  pool_batch_.push_back(std::move(request));
+}
+
+bool ConcordClientPool::SendPoolBatch(ClientPtr client) {
+  if (!client) {
+    auto it = std::find_if(clients_.begin(), clients_.end(), [](const auto &c) { return c->isServing(); });
+    if (it == clients_.end()) {
+      LOG_DEBUG(logger_, "No client is available for the pool batch" << KVLOG(pool_batch_.size()));
+      return false;
+    }
+    client = *it;
+    clients_.erase(it);
+  }
+  const auto now = std::chrono::steady_clock::now();
+  if (batch_policy_->full()) {
+    ClientPoolMetrics_.full_batch_counter++;
+  } else if (now >= batch_policy_->deadline()) {
+    ClientPoolMetrics_.partial_batch_counter++;
+  } else {
+    ClientPoolMetrics_.early_batch_counter++;
+  }
+  batch_agg_dur_.add(batch_policy_->age(now).count());
+  ClientPoolMetrics_.average_batch_agg_dur_gauge.Get().Set((uint64_t)batch_agg_dur_.avg());
+  if (batch_agg_dur_.numOfElements() == 1000) batch_agg_dur_.reset();  // reset the average every 1000 samples
+  batch_fill_.add(batch_policy_->fillPercent());
+  ClientPoolMetrics_.average_batch_fill_gauge.Get().Set((uint64_t)batch_fill_.avg());
+  if (batch_fill_.numOfElements() == 1000) batch_fill_.reset();  // reset the average every 1000 samples
+
+  const auto client_id = client->getClientId();
+  LOG_DEBUG(logger_, "Sending the pool batch" << KVLOG(client_id, pool_batch_.size(), pool_batch_generation_));
+  for (auto &req : pool_batch_) {
+    // Taken from the sending client, like for any other request it sends, so that its sequence numbers keep growing
+    if (0 == req.seq_num) {
+      req.seq_num = client->generateClientSeqNum();
+    }
+    client->AddPendingRequest(std::move(req.request),
+                              req.flags,
+                              req.reply_buffer,
+                              req.timeout_ms,
+                              req.reply_size,
+                              req.seq_num,
+                              req.correlation_id,
+                              req.span_context,
+                              std::move(req.callback));
+  }
+  pool_batch_.clear();
+  batch_policy_->reset();
+  ++pool_batch_generation_;
+  assignJobToClient(client);
+  return true;
+}
+
+void ConcordClientPool::OnClientAvailableForPoolBatch(ClientPtr &client) {
+  const auto client_id = client->getClientId();
+  // Refill the pool batch from the wait queue
+  while (!external_requests_queue_.empty() && !batch_policy_->full() &&
+         IsGoodForBatching(external_requests_queue_.front().flags, client_batching_enabled_)) {
+    auto &req = external_requests_queue_.front();
+    auto waiting_time =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - req.arrival_time);
+    if (waiting_time > req.timeout_ms) {
+      LOG_INFO(logger_,
+               "Dropping request due to timeout"
+                   << KVLOG(client_id, req.seq_num, req.correlation_id, req.timeout_ms.count()));
+    } else {
+      AppendToPoolBatch(std::move(req));
+    }
+    external_requests_queue_.pop_front();
+  }
+  if (batch_policy_->shouldSend(std::chrono::steady_clock::now())) {
+    SendPoolBatch(client);
+    return;
+  }
+  if (!external_requests_queue_.empty() &&
+      !IsGoodForBatching(external_requests_queue_.front().flags, client_batching_enabled_)) {
+    auto req = std::move(external_requests_queue_.front());
+    external_requests_queue_.pop_front();
+    assignJobToClient(client,
+                      std::move(req.request),
+                      req.flags,
+                      req.timeout_ms,
+                      req.reply_buffer,
+                      req.reply_size,
+                      req.seq_num,
+                      req.correlation_id,
+                      req.span_context,
+                      req.callback);
+    return;
+  }
+  clients_.push_back(client);
+}
+
+void ConcordClientPool::OnPoolBatchingTimeout(uint64_t batch_generation) {
+  std::unique_lock<std::mutex> lock(clients_queue_lock_);
+  if (batch_generation != pool_batch_generation_ || pool_batch_.empty()) {
+    return;
+  }
+  LOG_DEBUG(logger_, "Pool batch reached batching timeout" << KVLOG(batch_generation, pool_batch_.size()));
+  SendPoolBatch();
+}
+
 ConcordClientPool::~ConcordClientPool() {
   batch_timer_->stop();
+  if (pool_batch_timer_) {
+    pool_batch_timer_->stop();
+  }
   jobs_thread_pool_.stop(true);
   std::unique_lock<std::mutex> clients_lock(clients_queue_lock_);
   for (auto &client : clients_) {
@@ -452,75 +610,80 @@ void ConcordClientPool::InsertClientToQueue(
   {
     std::unique_lock<std::mutex> lock(clients_queue_lock_);
     metricsComponent_.UpdateAggregator();
-    while (!external_requests_queue_.empty() && client->PendingRequestsCount() < batch_size_) {
-      auto &req = external_requests_queue_.front();
-      auto remaining_time =
-          std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - req.arrival_time);
-
-      if (remaining_time > req.timeout_ms) {
-        LOG_INFO(logger_,
-                 "Dropping request due to timeout"
-                     << KVLOG(client_id, req.seq_num, req.correlation_id, req.timeout_ms.count()));
-        external_requests_queue_.pop_front();
-        continue;
-      }
+    if (pool_batching_enabled_) {
+      OnClientAvailableForPoolBatch(client);
+    } else {
+      while (!external_requests_queue_.empty() && client->PendingRequestsCount() < batch_size_) {
+        auto &req = external_requests_queue_.front();
+        auto remaining_time =
+            std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - req.arrival_time);
+
+        if (remaining_time > req.timeout_ms) {
+          LOG_INFO(logger_,
+                   "Dropping request due to timeout"
+                       << KVLOG(client_id, req.seq_num, req.correlation_id, req.timeout_ms.count()));
+          external_requests_queue_.pop_front();
+          continue;
+        }
 
-      if (IsGoodForBatching(req.flags, client_batching_enabled_)) {
-        if (0 == client->PendingRequestsCount()) {
-          LOG_TRACE(logger_, "Set batching timer for client" << KVLOG(client_id));
-          batch_timer_->set(client);
+        if (IsGoodForBatching(req.flags, client_batching_enabled_)) {
+          if (0 == client->PendingRequestsCount()) {
+            LOG_TRACE(logger_, "Set batching timer for client" << KVLOG(client_id));
+            batch_timer_->set(client);
+          }
+          client->AddPendingRequest(std::move(req.request),
+                                    req.flags,
+                                    req.reply_buffer,
+                                    req.timeout_ms,
+                                    req.reply_size,
+                                    req.seq_num,
+                                    req.correlation_id,
+                                    req.span_context,
+                                    std::move(req.callback));
+
+          LOG_DEBUG(logger_,
+                    "Added request to the client" << KVLOG(
+                        client_id, req.seq_num, req.correlation_id, client->PendingRequestsCount(), batch_size_));
+          external_requests_queue_.pop_front();
+        } else {
+          // No need to loop anymore
+          break;
         }
-        client->AddPendingRequest(std::move(req.request),
-                                  req.flags,
-                                  req.reply_buffer,
-                                  req.timeout_ms,
-                                  req.reply_size,
-                                  req.seq_num,
-                                  req.correlation_id,
-                                  req.span_context);
-
-        LOG_DEBUG(logger_,
-                  "Added request to the client" << KVLOG(
-                      client_id, req.seq_num, req.correlation_id, client->PendingRequestsCount(), batch_size_));
-        external_requests_queue_.pop_front();
-      } else {
-        // No need to loop anymore
-        break;
       }
-    }
-    if (client->PendingRequestsCount() > 0) {
-      if (client->PendingRequestsCount() >= batch_size_) {
-        LOG_TRACE(logger_, "Cancel batching timer for client_id=" << client->getClientId());
-        auto batch_wait_time = batch_timer_->cancel();
-        batch_agg_dur_.add(batch_wait_time.count());
-        ClientPoolMetrics_.average_batch_agg_dur_gauge.Get().Set((uint64_t)batch_agg_dur_.avg());
-        if (batch_agg_dur_.numOfElements() == 1000) batch_agg_dur_.reset();  // reset the average every 1000 samples
-        ClientPoolMetrics_.full_batch_counter++;
-        assignJobToClient(client);
-      } else {
-        if (is_overloaded_) {
-          client->setStartWaitingTime();
+      if (client->PendingRequestsCount() > 0) {
+        if (client->PendingRequestsCount() >= batch_size_) {
+          LOG_TRACE(logger_, "Cancel batching timer for client_id=" << client->getClientId());
+          auto batch_wait_time = batch_timer_->cancel();
+          batch_agg_dur_.add(batch_wait_time.count());
+          ClientPoolMetrics_.average_batch_agg_dur_gauge.Get().Set((uint64_t)batch_agg_dur_.avg());
+          if (batch_agg_dur_.numOfElements() == 1000) batch_agg_dur_.reset();  // reset the average every 1000 samples
+          ClientPoolMetrics_.full_batch_counter++;
+          assignJobToClient(client);
+        } else {
+          if (is_overloaded_) {
+            client->setStartWaitingTime();
+          }
+          LOG_TRACE(logger_, "Return client with pending jobs to the queue" << KVLOG(client_id));
+          clients_.push_back(client);
         }
-        LOG_TRACE(logger_, "Return client with pending jobs to the queue" << KVLOG(client_id));
-        clients_.push_back(client);
-      }
-    } else {
-      if (!external_requests_queue_.empty()) {
-        auto req = std::move(external_requests_queue_.front());
-        external_requests_queue_.pop_front();
-
-        assignJobToClient(client,
-                          std::move(req.request),
-                          req.flags,
-                          req.timeout_ms,
-                          req.reply_buffer,
-                          req.reply_size,
-                          req.seq_num,
-                          req.correlation_id,
-                          req.span_context,
-                          nullptr);
       } else {
-        clients_.push_back(client);
+        if (!external_requests_queue_.empty()) {
+          auto req = std::move(external_requests_queue_.front());
+          external_requests_queue_.pop_front();
+
+          assignJobToClient(client,
+                            std::move(req.request),
+                            req.flags,
+                            req.timeout_ms,
+                            req.reply_buffer,
+                            req.reply_size,
+                            req.seq_num,
+                            req.correlation_id,
+                            req.span_context,
+                            req.callback);
+        } else {
+          clients_.push_back(client);
+        }
       }
     }
   }
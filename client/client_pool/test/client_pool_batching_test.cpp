@@ -0,0 +1,227 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "client/client_pool/batch_policy.hpp"
+#include "client/client_pool/concord_client_pool.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+using concord::concord_client_pool::AdaptiveBatchPolicy;
+using concord::concord_client_pool::ConcordClientPool;
+using concord::concord_client_pool::SubmitResult;
+
+constexpr auto kMaxDelay = 100ms;
+
+TEST(adaptive_batch_policy, full_on_count) {
+  AdaptiveBatchPolicy policy(4, 0, kMaxDelay);
+  const auto now = AdaptiveBatchPolicy::Clock::now();
+  ASSERT_TRUE(policy.empty());
+  ASSERT_FALSE(policy.shouldSend(now));
+  for (int i = 0; i < 3; ++i) {
+    policy.add(100, now + i * 1ms);
+    ASSERT_FALSE(policy.full());
+    ASSERT_FALSE(policy.shouldSend(now + i * 1ms));
+  }
+  policy.add(100, now + 3ms);
+  ASSERT_TRUE(policy.full());
+  ASSERT_TRUE(policy.shouldSend(now + 3ms));
+  ASSERT_EQ(100, policy.fillPercent());
+}
+
+TEST(adaptive_batch_policy, full_on_bytes) {
+  AdaptiveBatchPolicy policy(100, 1000, kMaxDelay);
+  const auto now = AdaptiveBatchPolicy::Clock::now();
+  policy.add(600, now);
+  ASSERT_FALSE(policy.full());
+  ASSERT_EQ(60, policy.fillPercent());
+  policy.add(600, now + 1ms);
+  ASSERT_TRUE(policy.full());
+  ASSERT_TRUE(policy.shouldSend(now + 1ms));
+}
+
+TEST(adaptive_batch_policy, sent_at_the_deadline) {
+  AdaptiveBatchPolicy policy(100, 0, kMaxDelay);
+  const auto now = AdaptiveBatchPolicy::Clock::now();
+  policy.add(100, now);
+  ASSERT_EQ(now + kMaxDelay, policy.deadline());
+  ASSERT_FALSE(policy.shouldSend(now + kMaxDelay - 1ms));
+  ASSERT_TRUE(policy.shouldSend(now + kMaxDelay));
+  ASSERT_EQ(kMaxDelay, policy.age(now + kMaxDelay));
+}
+
+// Under a high arrival rate the batch grows until it's full
+TEST(adaptive_batch_policy, waits_for_frequent_requests) {
+  AdaptiveBatchPolicy policy(32, 0, kMaxDelay);
+  auto now = AdaptiveBatchPolicy::Clock::now();
+  for (int i = 0; i < 31; ++i, now += 1ms) {
+    policy.add(100, now);
+    ASSERT_FALSE(policy.shouldSend(now)) << i;
+  }
+  policy.add(100, now);
+  ASSERT_TRUE(policy.shouldSend(now));
+}
+
+// Once requests arrive further apart than the latency budget, the batch is sent without waiting for the next one
+TEST(adaptive_batch_policy, sends_early_when_requests_are_rare) {
+  AdaptiveBatchPolicy policy(32, 0, kMaxDelay);
+  auto now = AdaptiveBatchPolicy::Clock::now();
+  int sent_alone = 0;
+  for (int i = 0; i < 40; ++i, now += 10 * kMaxDelay) {
+    policy.add(100, now);
+    if (policy.shouldSend(now)) {
+      ASSERT_FALSE(policy.full());
+      ++sent_alone;
+      policy.reset();
+    }
+  }
+  // The average interval takes a few samples to cross the budget, from then on every request goes alone
+  ASSERT_GT(sent_alone, 30);
+  policy.add(100, now);
+  ASSERT_TRUE(policy.shouldSend(now));
+}
+
+// The batch grows again when the arrival rate goes back up, the rate is kept across batches
+TEST(adaptive_batch_policy, grows_again_when_requests_are_frequent) {
+  AdaptiveBatchPolicy policy(32, 0, kMaxDelay);
+  auto now = AdaptiveBatchPolicy::Clock::now();
+  for (int i = 0; i < 40; ++i, now += 10 * kMaxDelay) {
+    policy.add(100, now);
+    policy.reset();
+  }
+  policy.add(100, now);
+  ASSERT_TRUE(policy.shouldSend(now));
+  policy.reset();
+
+  bool waited = false;
+  for (int i = 0; i < 100 && !waited; ++i) {
+    now += 1ms;
+    policy.add(100, now);
+    if (policy.shouldSend(now)) {
+      policy.reset();
+    } else {
+      waited = true;
+    }
+  }
+  ASSERT_TRUE(waited);
+  for (int i = 0; i < 30; ++i) {
+    now += 1ms;
+    policy.add(100, now);
+  }
+  ASSERT_FALSE(policy.full());
+  ASSERT_FALSE(policy.shouldSend(now));
+}
+
+// A pool with one client and mock communication, which replies to every request right away
+class pool_batch_test : public ::testing::Test {
+ protected:
+  static constexpr auto kNumReplicas = 4;
+
+  void createPool(size_t max_messages, size_t max_bytes, std::chrono::milliseconds flush_timeout) {
+    concord::config_pool::ConcordClientPoolConfig config;
+    config.f_val = 1;
+    config.c_val = 0;
+    config.num_replicas = kNumReplicas;
+    config.clients_per_participant_node = 1;
+    config.enable_mock_comm = true;
+    config.client_batching_enabled = true;
+    config.client_batching_adaptive = true;
+    config.client_batching_max_messages_nbr = max_messages;
+    config.client_batching_max_bytes = max_bytes;
+    config.client_batching_flush_timeout_ms = flush_timeout.count();
+    for (auto i = 0; i < kNumReplicas; ++i) {
+      config.node[i] = concord::config_pool::Replica{static_cast<bft::communication::NodeNum>(i), "127.0.0.1", 3501};
+    }
+    concord::config_pool::ParticipantNode node;
+    node.participant_node_host = "127.0.0.1";
+    node.externalClients[0] = concord::config_pool::ExternalClient{0, static_cast<uint16_t>(kNumReplicas)};
+    config.participant_nodes.push_back(node);
+    pool_ = std::make_unique<ConcordClientPool>(config, aggregator_);
+  }
+
+  void send(size_t size) {
+    bft::client::WriteConfig config;
+    config.request.pre_execute = true;
+    config.request.timeout = 10s;
+    config.request.correlation_id = "batch-test-" + std::to_string(sent_++);
+    ASSERT_EQ(SubmitResult::Acknowledged,
+              pool_->SendRequest(config, bft::client::Msg(size, 'r'), [this](bftEngine::SendResult&& result) {
+                std::lock_guard<std::mutex> lock(lock_);
+                if (std::holds_alternative<bft::client::Reply>(result)) ++replied_;
+                cond_.notify_all();
+              }));
+  }
+
+  bool waitForReplies(size_t replies, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(lock_);
+    return cond_.wait_for(lock, timeout, [&] { return replied_ >= replies; });
+  }
+
+  // The pool publishes its metrics once the client that sent the batch is back in the queue
+  uint64_t counter(const std::string& name) {
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    auto value = aggregator_->GetCounter("ClientPool", name).Get();
+    while (value == 0 && std::chrono::steady_clock::now() < deadline) {
+      std::this_thread::sleep_for(10ms);
+      value = aggregator_->GetCounter("ClientPool", name).Get();
+    }
+    return value;
+  }
+
+  std::shared_ptr<concordMetrics::Aggregator> aggregator_ = std::make_shared<concordMetrics::Aggregator>();
+  std::unique_ptr<ConcordClientPool> pool_;
+  std::mutex lock_;
+  std::condition_variable cond_;
+  size_t sent_ = 0;
+  size_t replied_ = 0;
+};
+
+TEST_F(pool_batch_test, flushed_once_the_count_target_is_reached) {
+  createPool(4, 0, 10s);
+  for (int i = 0; i < 4; ++i) send(100);
+  ASSERT_TRUE(waitForReplies(4, 5s));
+  ASSERT_EQ(1, counter("full_batch_counter"));
+  ASSERT_EQ(0, aggregator_->GetCounter("ClientPool", "partial_batch_counter").Get());
+}
+
+TEST_F(pool_batch_test, flushed_once_the_byte_target_is_reached) {
+  createPool(32, 1000, 10s);
+  send(600);
+  send(600);
+  ASSERT_TRUE(waitForReplies(2, 5s));
+  ASSERT_EQ(1, counter("full_batch_counter"));
+  ASSERT_EQ(0, aggregator_->GetCounter("ClientPool", "partial_batch_counter").Get());
+}
+
+TEST_F(pool_batch_test, flushed_on_timeout) {
+  constexpr auto kFlushTimeout = 300ms;
+  createPool(32, 0, kFlushTimeout);
+  const auto start = std::chrono::steady_clock::now();
+  send(100);
+  send(100);
+  ASSERT_FALSE(waitForReplies(1, kFlushTimeout / 2));
+  ASSERT_TRUE(waitForReplies(2, 5s));
+  ASSERT_GE(std::chrono::steady_clock::now() - start, kFlushTimeout);
+  ASSERT_EQ(1, counter("partial_batch_counter"));
+  ASSERT_EQ(0, aggregator_->GetCounter("ClientPool", "full_batch_counter").Get());
+}
+
+}  // namespace
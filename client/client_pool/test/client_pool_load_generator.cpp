@@ -0,0 +1,147 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the sub-component's license, as noted in the LICENSE
+// file.
+
+// Load generator for the batching of the client pool. Sends pre-execution requests at a fixed rate to a pool with mock
+// communication (every replica replies after 5ms) and reports the request latency and how the requests were batched.
+//
+// Usage: client_pool_load_generator <fixed|adaptive> [requests/s] [seconds] [request size] [clients]
+//  fixed    - the clients batch independently, a batch is sent once full or after the flush timeout
+//  adaptive - the requests of all clients are batched together, see client_batching_adaptive
+// Exits with a failure if not all requests completed successfully.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/client_pool/concord_client_pool.hpp"
+
+namespace {
+
+using namespace std::chrono_literals;
+using concord::concord_client_pool::ConcordClientPool;
+using concord::concord_client_pool::SubmitResult;
+
+constexpr auto kNumReplicas = 4;
+constexpr auto kRequestTimeout = 10s;
+
+concord::config_pool::ConcordClientPoolConfig createConfig(bool adaptive, int num_clients) {
+  concord::config_pool::ConcordClientPoolConfig config;
+  config.f_val = 1;
+  config.c_val = 0;
+  config.num_replicas = kNumReplicas;
+  config.clients_per_participant_node = num_clients;
+  config.enable_mock_comm = true;
+  config.client_batching_enabled = true;
+  config.client_batching_max_messages_nbr = 32;
+  config.client_batching_flush_timeout_ms = 20;
+  config.client_batching_adaptive = adaptive;
+  config.client_batching_max_bytes = 64 * 1024;
+  config.external_requests_queue_size = 100000;
+  for (auto i = 0; i < kNumReplicas; ++i) {
+    config.node[i] = concord::config_pool::Replica{static_cast<bft::communication::NodeNum>(i), "127.0.0.1", 3501};
+  }
+  concord::config_pool::ParticipantNode node;
+  node.participant_node_host = "127.0.0.1";
+  for (auto i = 0; i < num_clients; ++i) {
+    node.externalClients[i] = concord::config_pool::ExternalClient{0, static_cast<uint16_t>(kNumReplicas + i)};
+  }
+  config.participant_nodes.push_back(node);
+  return config;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2 || (std::string{argv[1]} != "fixed" && std::string{argv[1]} != "adaptive")) {
+    std::cerr << "Usage: " << argv[0] << " <fixed|adaptive> [requests/s] [seconds] [request size] [clients]"
+              << std::endl;
+    return 1;
+  }
+  const bool adaptive = std::string{argv[1]} == "adaptive";
+  const uint64_t rate = argc > 2 ? std::stoull(argv[2]) : 2000;
+  const uint64_t seconds = argc > 3 ? std::stoull(argv[3]) : 5;
+  const size_t request_size = argc > 4 ? std::stoul(argv[4]) : 512;
+  const int num_clients = argc > 5 ? std::stoi(argv[5]) : 8;
+  const uint64_t num_requests = rate * seconds;
+
+  auto config = createConfig(adaptive, num_clients);
+  auto aggregator = std::make_shared<concordMetrics::Aggregator>();
+  constexpr bool kDelayedReplies = true;
+  ConcordClientPool pool(config, aggregator, kDelayedReplies);
+
+  std::mutex mutex;
+  std::condition_variable done_cv;
+  std::vector<int64_t> latencies_us;
+  latencies_us.reserve(num_requests);
+  uint64_t num_done = 0;
+  uint64_t num_failed = 0;
+  uint64_t num_rejected = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto interval = std::chrono::nanoseconds(std::chrono::seconds(1)) / rate;
+  for (uint64_t i = 0; i < num_requests; ++i) {
+    std::this_thread::sleep_until(start + i * interval);
+    bft::client::WriteConfig write_config;
+    write_config.request.pre_execute = true;
+    write_config.request.timeout = kRequestTimeout;
+    write_config.request.correlation_id = "load-" + std::to_string(i);
+    const auto sent = std::chrono::steady_clock::now();
+    auto result = pool.SendRequest(
+        write_config, bft::client::Msg(request_size, 'r'), [&, sent](bftEngine::SendResult&& send_result) {
+          const auto latency = std::chrono::steady_clock::now() - sent;
+          std::lock_guard<std::mutex> lock(mutex);
+          if (std::holds_alternative<bft::client::Reply>(send_result)) {
+            latencies_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+          } else {
+            ++num_failed;
+          }
+          if (++num_done == num_requests) {
+            done_cv.notify_one();
+          }
+        });
+    if (result != SubmitResult::Acknowledged) {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++num_rejected;
+      ++num_done;
+    }
+  }
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    done_cv.wait_for(lock, kRequestTimeout, [&] { return num_done == num_requests; });
+  }
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::sort(latencies_us.begin(), latencies_us.end());
+  auto percentile_us = [&](double p) {
+    return latencies_us.empty() ? 0 : latencies_us[static_cast<size_t>(p * (latencies_us.size() - 1))];
+  };
+  auto counter = [&](const std::string& name) { return aggregator->GetCounter("ClientPool", name).Get(); };
+  const auto batches =
+      counter("full_batch_counter") + counter("partial_batch_counter") + counter("early_batch_counter");
+  std::cout << argv[1] << ": requests=" << num_requests << " completed=" << latencies_us.size()
+            << " failed=" << num_failed << " rejected=" << num_rejected
+            << " requests/s=" << static_cast<uint64_t>(latencies_us.size() / elapsed) << " p50=" << percentile_us(0.5)
+            << "us p99=" << percentile_us(0.99) << "us batches=" << batches
+            << " full=" << counter("full_batch_counter") << " partial=" << counter("partial_batch_counter")
+            << " early=" << counter("early_batch_counter")
+            << " requests/batch=" << (batches ? counter("requests_counter") / batches : 0)
+            << " fill%=" << aggregator->GetGauge("ClientPool", "average_batch_fill_gauge").Get() << std::endl;
+  return latencies_us.size() == num_requests ? 0 : 1;
+}
@@ -31,4 +31,9 @@ class EventServiceImpl final : public vmware::concord::client::event::v1::EventS
   std::shared_ptr<concord::client::concordclient::ConcordClient> client_;
 };
 
+// Convert an update from the update queue into a subscription response. The events are moved into the response
+// rather than copied, the update is left without events. Returns false for an unknown update type.
+bool toSubscribeResponse(concord::client::concordclient::EventVariant&& update,
+                         vmware::concord::client::event::v1::SubscribeResponse& response);
+
 }  // namespace concord::client::clientservice
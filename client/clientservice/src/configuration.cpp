@@ -78,6 +78,8 @@ void parseConfigFile(ConcordClientConfig& config, const YAML::Node& yaml) {
   readYamlField(yaml, "client_batching_enabled", config.topology.client_batching_enabled);
   readYamlField(yaml, "client_batching_max_messages_nbr", config.topology.client_batching_max_messages_nbr);
   readYamlField(yaml, "client_batching_flush_timeout_ms", config.topology.client_batching_flush_timeout_ms);
+  readYamlField(yaml, "client_batching_adaptive", config.topology.client_batching_adaptive, false);
+  readYamlField(yaml, "client_batching_max_bytes", config.topology.client_batching_max_bytes, false);
   readYamlField(yaml, "replicas_master_key_path", config.topology.path_to_replicas_master_key, false);
 
   ConcordAssert(yaml["node"].IsSequence());
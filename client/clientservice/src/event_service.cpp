@@ -23,9 +23,6 @@ using grpc::ServerWriter;
 
 using vmware::concord::client::event::v1::SubscribeRequest;
 using vmware::concord::client::event::v1::SubscribeResponse;
-using vmware::concord::client::event::v1::Event;
-using vmware::concord::client::event::v1::EventGroup;
-using vmware::concord::client::event::v1::Events;
 using concord::client::concordclient::EventVariant;
 using concord::client::concordclient::UpdateNotFound;
 using concord::client::concordclient::OutOfRangeSubscriptionRequest;
@@ -65,7 +62,6 @@ Status EventServiceImpl::Subscribe(ServerContext* context,
   // TODO: Return UNAVAILABLE as documented in event.proto if ConcordClient is unhealthy
   auto status = grpc::Status::OK;
   while (!context->IsCancelled()) {
-    SubscribeResponse response;
     std::unique_ptr<EventVariant> update;
     try {
       update = update_queue->tryPop();
@@ -93,36 +89,14 @@ Status EventServiceImpl::Subscribe(ServerContext* context,
       continue;
     }
 
-    if (std::holds_alternative<cc::EventGroup>(*update)) {
-      auto& event_group_in = std::get<cc::EventGroup>(*update);
-      EventGroup proto_event_group;
-      proto_event_group.set_id(event_group_in.id);
-      for (const auto& event : event_group_in.events) {
-        *proto_event_group.add_events() = std::string(event.begin(), event.end());
-      }
-      *proto_event_group.mutable_record_time() = event_group_in.record_time;
-      *proto_event_group.mutable_trace_context() = {event_group_in.trace_context.begin(),
-                                                    event_group_in.trace_context.end()};
-
-      *response.mutable_event_group() = proto_event_group;
-      stream->Write(response);
-
-    } else if (std::holds_alternative<cc::Update>(*update)) {
-      auto& legacy_event_in = std::get<cc::Update>(*update);
-      Events proto_events;
-      proto_events.set_block_id(legacy_event_in.block_id);
-      for (auto& [key, value] : legacy_event_in.kv_pairs) {
-        Event proto_event;
-        *proto_event.mutable_event_key() = std::move(key);
-        *proto_event.mutable_event_value() = std::move(value);
-        *proto_events.add_events() = proto_event;
+    SubscribeResponse response;
+    if (toSubscribeResponse(std::move(*update), response)) {
+      // Let gRPC coalesce the writes while more updates are queued
+      auto options = grpc::WriteOptions();
+      if (update_queue->size() > 0) {
+        options.set_buffer_hint();
       }
-      proto_events.set_correlation_id(legacy_event_in.correlation_id_);
-      // TODO: Set trace context
-
-      *response.mutable_events() = proto_events;
-      stream->Write(response);
-
+      stream->Write(response, options);
     } else {
       LOG_ERROR(logger_, "Got unexpected update type from TRC. This should never happen!");
     }
@@ -132,4 +106,37 @@ Status EventServiceImpl::Subscribe(ServerContext* context,
   return status;
 }
 
+bool toSubscribeResponse(EventVariant&& update, SubscribeResponse& response) {
+  if (std::holds_alternative<cc::EventGroup>(update)) {
+    auto& event_group_in = std::get<cc::EventGroup>(update);
+    auto proto_event_group = response.mutable_event_group();
+    proto_event_group->set_id(event_group_in.id);
+    proto_event_group->mutable_events()->Reserve(event_group_in.events.size());
+    for (auto& event : event_group_in.events) {
+      proto_event_group->add_events(std::move(event));
+    }
+    *proto_event_group->mutable_record_time() = event_group_in.record_time;
+    proto_event_group->mutable_trace_context()->insert(event_group_in.trace_context.begin(),
+                                                       event_group_in.trace_context.end());
+    return true;
+  }
+
+  if (std::holds_alternative<cc::Update>(update)) {
+    auto& legacy_event_in = std::get<cc::Update>(update);
+    auto proto_events = response.mutable_events();
+    proto_events->set_block_id(legacy_event_in.block_id);
+    proto_events->mutable_events()->Reserve(legacy_event_in.kv_pairs.size());
+    for (auto& [key, value] : legacy_event_in.kv_pairs) {
+      auto proto_event = proto_events->add_events();
+      proto_event->set_event_key(std::move(key));
+      proto_event->set_event_value(std::move(value));
+    }
+    proto_events->set_correlation_id(std::move(legacy_event_in.correlation_id_));
+    // TODO: Set trace context
+    return true;
+  }
+
+  return false;
+}
+
 }  // namespace concord::client::clientservice
@@ -0,0 +1,81 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Throughput benchmark of the event delivery through clientservice. Every subscriber has a producer thread pushing
+// event groups to an update queue, as the thin replica client does, and a consumer thread converting them into
+// subscription responses and serializing them, as the event service and gRPC do.
+//
+// Usage: event_delivery_benchmark [updates per subscriber] [events per update] [event size] [subscribers]
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "client/clientservice/event_service.hpp"
+#include "client/concordclient/event_update_queue.hpp"
+
+namespace cc = concord::client::concordclient;
+
+using concord::client::clientservice::toSubscribeResponse;
+using vmware::concord::client::event::v1::SubscribeResponse;
+
+int main(int argc, char** argv) {
+  const uint64_t num_updates = argc > 1 ? std::stoull(argv[1]) : 100000;
+  const size_t events_per_update = argc > 2 ? std::stoul(argv[2]) : 8;
+  const size_t event_size = argc > 3 ? std::stoul(argv[3]) : 1024;
+  const size_t num_subscribers = argc > 4 ? std::stoul(argv[4]) : 1;
+
+  std::vector<std::thread> threads;
+  std::vector<uint64_t> bytes_out(num_subscribers, 0);
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t s = 0; s < num_subscribers; ++s) {
+    auto queue = std::make_shared<cc::BasicUpdateQueue>();
+    threads.emplace_back([=]() {
+      for (uint64_t id = 1; id <= num_updates; ++id) {
+        cc::EventGroup event_group;
+        event_group.id = id;
+        event_group.events.reserve(events_per_update);
+        for (size_t e = 0; e < events_per_update; ++e) {
+          event_group.events.emplace_back(event_size, 'e');
+        }
+        queue->push(std::make_unique<cc::EventVariant>(std::move(event_group)));
+      }
+    });
+    threads.emplace_back([=, &bytes_out]() {
+      std::string serialized;
+      for (uint64_t i = 0; i < num_updates; ++i) {
+        auto update = queue->pop();
+        SubscribeResponse response;
+        toSubscribeResponse(std::move(*update), response);
+        response.SerializeToString(&serialized);
+        bytes_out[s] += serialized.size();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  uint64_t total_bytes = 0;
+  for (auto bytes : bytes_out) {
+    total_bytes += bytes;
+  }
+  const auto total_updates = num_updates * num_subscribers;
+  std::cout << "subscribers=" << num_subscribers << " updates=" << total_updates
+            << " events/update=" << events_per_update << " event size=" << event_size
+            << ": updates/s=" << static_cast<uint64_t>(total_updates / elapsed)
+            << " events/s=" << static_cast<uint64_t>(total_updates * events_per_update / elapsed)
+            << " MB/s=" << static_cast<uint64_t>(total_bytes / elapsed / (1024 * 1024)) << std::endl;
+  return 0;
+}
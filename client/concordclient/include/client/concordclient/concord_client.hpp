@@ -63,6 +63,9 @@ struct BftTopology {
   bool client_batching_enabled;
   size_t client_batching_max_messages_nbr;
   std::uint64_t client_batching_flush_timeout_ms;
+  // Batch the requests of all clients together, see ConcordClientPoolConfig
+  bool client_batching_adaptive = false;
+  size_t client_batching_max_bytes = 0;
   std::string path_to_replicas_master_key = std::string();
 };
 
@@ -89,6 +89,8 @@ ConcordClientPoolConfig ConcordClient::createClientPoolStruct(const ConcordClien
   client_pool_config.client_batching_enabled = config.topology.client_batching_enabled;
   client_pool_config.client_batching_max_messages_nbr = config.topology.client_batching_max_messages_nbr;
   client_pool_config.client_batching_flush_timeout_ms = config.topology.client_batching_flush_timeout_ms;
+  client_pool_config.client_batching_adaptive = config.topology.client_batching_adaptive;
+  client_pool_config.client_batching_max_bytes = config.topology.client_batching_max_bytes;
 
   client_pool_config.comm_to_use = config.transport.comm_type == TransportConfig::Invalid
                                        ? "Invalid"
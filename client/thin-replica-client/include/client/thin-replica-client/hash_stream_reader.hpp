@@ -0,0 +1,96 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+//
+// Concurrent reading of hash subscription streams for internal use by the Thin
+// Replica Client
+
+#ifndef THIN_REPLICA_CLIENT_HASH_STREAM_READER_HPP_
+#define THIN_REPLICA_CLIENT_HASH_STREAM_READER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "Logger.hpp"
+#include "client/thin-replica-client/trs_connection.hpp"
+
+namespace client::thin_replica_client {
+
+// Reads the hash streams of the Thin Replica Servers concurrently, one thread
+// per server. Every thread reads up to read_ahead hashes ahead into the queue of
+// its server, so a slow stream doesn't hold up the others and the hashes of the
+// following updates are available as soon as the ThinReplicaClient needs them.
+//
+// While a server is read from, its hash stream must not be used otherwise; stop
+// reading from the server before cancelling or reopening its hash stream.
+class HashStreamReader {
+ public:
+  struct Result {
+    size_t server_index;
+    TrsConnection::Result status;
+    com::vmware::concord::thin_replica::Hash hash;
+  };
+
+  HashStreamReader(std::vector<std::unique_ptr<TrsConnection>>& trs_conns, size_t read_ahead);
+  ~HashStreamReader();
+
+  HashStreamReader(const HashStreamReader&) = delete;
+  HashStreamReader& operator=(const HashStreamReader&) = delete;
+
+  // Start reading from the open hash stream of the given server.
+  void start(size_t server_index);
+
+  // Stop reading from the given server and drop its unconsumed results. A read
+  // in progress is interrupted, the hash stream has to be cancelled afterwards.
+  void stop(size_t server_index);
+  void stopAll();
+
+  // Whether the server is read from or has unconsumed results.
+  bool isReading(size_t server_index);
+
+  // Wait up to timeout for the next result of any of the given servers. A
+  // server stops reading after its first unsuccessful read.
+  std::optional<Result> next(const std::vector<bool>& servers, std::chrono::milliseconds timeout);
+
+ private:
+  struct ServerReader {
+    std::thread thread;
+    bool running = false;
+    bool stopping = false;
+    std::deque<Result> results;
+  };
+
+  void read(size_t server_index);
+
+  logging::Logger logger_;
+  std::vector<std::unique_ptr<TrsConnection>>& trs_conns_;
+  const size_t read_ahead_;
+
+  std::mutex mutex_;
+  // Notified when a result is queued
+  std::condition_variable result_queued_;
+  // Notified when a result is consumed or a reader is stopped
+  std::condition_variable result_consumed_;
+  std::vector<ServerReader> readers_;
+  // Where next() starts looking for results, so that no server is starved
+  size_t next_server_ = 0;
+};
+
+}  // namespace client::thin_replica_client
+
+#endif  // THIN_REPLICA_CLIENT_HASH_STREAM_READER_HPP_
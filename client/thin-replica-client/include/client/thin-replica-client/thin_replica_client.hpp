@@ -40,6 +40,7 @@
 #define THIN_REPLICA_CLIENT_HPP_
 
 #include "thin_replica.pb.h"
+#include "hash_stream_reader.hpp"
 #include "trs_connection.hpp"
 #include "assertUtils.hpp"
 #include "Metrics.hpp"
@@ -105,20 +106,32 @@ struct ThinReplicaClientConfig {
   // the time duration the TRC waits before printing warning logs when
   // responsive agreeing servers are less than config_->max_faulty + 1
   std::chrono::seconds no_agreement_warn_duration;
+  // hash_read_ahead is the number of hashes the TRC reads ahead from every
+  // open hash stream; the hash streams are read concurrently.
+  std::size_t hash_read_ahead;
+  // hash_read_hedge_delay is the time the TRC waits for the hashes of the
+  // servers it asked before it additionally asks another server.
+  std::chrono::milliseconds hash_read_hedge_delay;
 
   ThinReplicaClientConfig(std::string client_id_,
                           std::shared_ptr<concord::client::concordclient::UpdateQueue> update_queue_,
                           std::size_t max_faulty_,
                           std::vector<std::unique_ptr<TrsConnection>> trs_conns_,
-                          std::chrono::seconds no_agreement_warn_duration_ = kNoAgreementWarnDuration)
+                          std::chrono::seconds no_agreement_warn_duration_ = kNoAgreementWarnDuration,
+                          std::size_t hash_read_ahead_ = kHashReadAhead,
+                          std::chrono::milliseconds hash_read_hedge_delay_ = kHashReadHedgeDelay)
       : client_id(std::move(client_id_)),
         update_queue(update_queue_),
         max_faulty(max_faulty_),
         trs_conns(std::move(trs_conns_)),
-        no_agreement_warn_duration(no_agreement_warn_duration_) {}
+        no_agreement_warn_duration(no_agreement_warn_duration_),
+        hash_read_ahead(hash_read_ahead_),
+        hash_read_hedge_delay(hash_read_hedge_delay_) {}
 
  private:
   static constexpr std::chrono::seconds kNoAgreementWarnDuration = 60s;
+  static constexpr std::size_t kHashReadAhead = 4;
+  static constexpr std::chrono::milliseconds kHashReadHedgeDelay = 100ms;
 };
 
 // TRC metrics
@@ -186,6 +199,8 @@ class ThinReplicaClient final {
  private:
   logging::Logger logger_;
   std::unique_ptr<ThinReplicaClientConfig> config_;
+  // Declared after config_ so that it stops reading before the connections are destroyed
+  std::unique_ptr<HashStreamReader> hash_reader_;
   size_t data_conn_index_;
 
   bool is_event_group_request_;
@@ -250,12 +265,14 @@ class ThinReplicaClient final {
                                                       HashRecord& most_agreed_block,
                                                       std::unique_ptr<LogCid>& cid);
 
-  // Opens hash streams to all the replicas and tries to read hash updates
-  // from opened streams to check for maximal agreement.
-  // If none of the replicas return a hash update i.e., the connections to
-  // all the replicas either time out or fail while waiting for an update,
-  // findBlockHashAgreement returns false, otherwise returns true.
+  // Collects the hashes of the update from the hash streams, which are read
+  // concurrently, until max_faulty + 1 servers agree or no server is left to
+  // ask. Hash streams are opened as needed: while the servers being waited for
+  // can't reach agreement, or when none of them answered within the hedge
+  // delay. hash_pending marks the servers that were waited for but didn't
+  // answer yet; they keep streaming and their late hashes are skipped.
   void findBlockHashAgreement(std::vector<bool>& servers_tried,
+                              std::vector<bool>& hash_pending,
                               HashRecordMap& agreeing_subset_members,
                               size_t& most_agreeing,
                               HashRecord& most_agreed_block,
@@ -271,6 +288,9 @@ class ThinReplicaClient final {
 
   TrsConnection::Result resetDataStreamTo(size_t server_idx);
   TrsConnection::Result startHashStreamWith(size_t server_idx);
+  // Returns true if the hash stream of the server is read from
+  bool startHashReaderWith(size_t server_index, size_t& servers_out_of_range, size_t& servers_pruned);
+  void cancelHashStream(size_t server_index);
   void closeAllHashStreams();
 
   // Helper functions to receiveUpdates.
@@ -283,13 +303,14 @@ class ThinReplicaClient final {
                            size_t& maximal_agreeing_subset_size,
                            HashRecord& maximally_agreed_on_update);
 
-  // Returns true if a hash update is received from a hash stream, returns false otherwise
-  bool readUpdateHashFromStream(size_t server_index,
-                                HashRecordMap& server_indexes_by_reported_update,
-                                size_t& maximal_agreeing_subset_size,
-                                HashRecord& maximally_agreed_on_update,
-                                size_t& servers_out_of_range,
-                                size_t& servers_pruned);
+  // Returns false if the hash is for an update that was verified already and
+  // the next hash of the server has to be awaited, returns true otherwise
+  bool recordHashFromStream(const HashStreamReader::Result& read_result,
+                            HashRecordMap& server_indexes_by_reported_update,
+                            size_t& maximal_agreeing_subset_size,
+                            HashRecord& maximally_agreed_on_update,
+                            size_t& servers_out_of_range,
+                            size_t& servers_pruned);
 
  public:
   // Constructor for ThinReplicaClient. Note that, as the ThinReplicaClient
@@ -322,6 +343,7 @@ class ThinReplicaClient final {
                                   std::to_string(config_->max_faulty) +
                                   "). The number of servers must be at least (3 * max_faulty + 1).");
     }
+    hash_reader_ = std::make_unique<HashStreamReader>(config_->trs_conns, config_->hash_read_ahead);
 
     // TODO (Alex): Enforce that, as far as this constructor can see (likely the
     //              virtual memory for the process it is running in), only one
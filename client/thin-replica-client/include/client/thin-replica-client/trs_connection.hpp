@@ -18,6 +18,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 
 #include <grpcpp/grpcpp.h>
@@ -118,6 +119,11 @@ class TrsConnection {
   // out the read.
   virtual Result readHash(com::vmware::concord::thin_replica::Hash* hash);
 
+  // Make a readHash in progress on another thread return early. Unlike the
+  // other functions, interruptHashStream may be called concurrently with
+  // readHash; the stream has to be cancelled afterwards.
+  virtual void interruptHashStream();
+
   // Open a state subscription stream (connection has to be established before).
   // A state data stream will be open after openStateStream returns if and only
   // if openDataStream returns Result::kSuccess; a stream will not be open in
@@ -185,6 +191,8 @@ class TrsConnection {
   std::unique_ptr<grpc::ClientReaderInterface<com::vmware::concord::thin_replica::Data>> data_stream_;
   std::unique_ptr<grpc::ClientContext> state_context_;
   std::unique_ptr<grpc::ClientReaderInterface<com::vmware::concord::thin_replica::Data>> state_stream_;
+  // Guards the hash context against interruptHashStream
+  std::mutex hash_context_mutex_;
   std::unique_ptr<grpc::ClientContext> hash_context_;
   std::unique_ptr<grpc::ClientReaderInterface<com::vmware::concord::thin_replica::Hash>> hash_stream_;
 
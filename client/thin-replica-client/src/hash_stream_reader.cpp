@@ -0,0 +1,137 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "client/thin-replica-client/hash_stream_reader.hpp"
+
+#include <algorithm>
+
+#include "assertUtils.hpp"
+
+namespace client::thin_replica_client {
+
+HashStreamReader::HashStreamReader(std::vector<std::unique_ptr<TrsConnection>>& trs_conns, size_t read_ahead)
+    : logger_(logging::getLogger("concord.client.thin_replica.hash_reader")),
+      trs_conns_(trs_conns),
+      read_ahead_(std::max<size_t>(read_ahead, 1)),
+      readers_(trs_conns.size()) {}
+
+HashStreamReader::~HashStreamReader() { stopAll(); }
+
+void HashStreamReader::start(size_t server_index) {
+  ConcordAssertLT(server_index, readers_.size());
+  auto& reader = readers_[server_index];
+  // The previous thread of this server ended after an unsuccessful read
+  if (reader.thread.joinable()) {
+    reader.thread.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  ConcordAssert(!reader.running);
+  reader.results.clear();
+  reader.stopping = false;
+  reader.running = true;
+  reader.thread = std::thread(&HashStreamReader::read, this, server_index);
+}
+
+void HashStreamReader::stop(size_t server_index) {
+  ConcordAssertLT(server_index, readers_.size());
+  auto& reader = readers_[server_index];
+  bool running = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reader.stopping = true;
+    running = reader.running;
+  }
+  result_consumed_.notify_all();
+  if (running) {
+    trs_conns_[server_index]->interruptHashStream();
+  }
+  if (reader.thread.joinable()) {
+    reader.thread.join();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  reader.results.clear();
+  reader.stopping = false;
+}
+
+void HashStreamReader::stopAll() {
+  for (size_t i = 0; i < readers_.size(); ++i) {
+    stop(i);
+  }
+}
+
+bool HashStreamReader::isReading(size_t server_index) {
+  ConcordAssertLT(server_index, readers_.size());
+  std::lock_guard<std::mutex> lock(mutex_);
+  return readers_[server_index].running || !readers_[server_index].results.empty();
+}
+
+std::optional<HashStreamReader::Result> HashStreamReader::next(const std::vector<bool>& servers,
+                                                               std::chrono::milliseconds timeout) {
+  ConcordAssertEQ(servers.size(), readers_.size());
+  std::optional<size_t> ready;
+  auto find_ready = [&]() {
+    for (size_t i = 0; i < readers_.size(); ++i) {
+      const auto server_index = (next_server_ + i) % readers_.size();
+      if (servers[server_index] && !readers_[server_index].results.empty()) {
+        ready = server_index;
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!result_queued_.wait_for(lock, timeout, find_ready)) {
+    return std::nullopt;
+  }
+  auto& results = readers_[*ready].results;
+  auto result = std::move(results.front());
+  results.pop_front();
+  next_server_ = (*ready + 1) % readers_.size();
+  lock.unlock();
+  result_consumed_.notify_all();
+  return result;
+}
+
+void HashStreamReader::read(size_t server_index) {
+  auto& reader = readers_[server_index];
+  LOG_DEBUG(logger_, "Start reading hash stream " << server_index);
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      result_consumed_.wait(lock, [&]() { return reader.stopping || reader.results.size() < read_ahead_; });
+      if (reader.stopping) {
+        break;
+      }
+    }
+
+    Result result{server_index, TrsConnection::Result::kUnknown, {}};
+    result.status = trs_conns_[server_index]->readHash(&result.hash);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (reader.stopping) {
+      break;
+    }
+    const bool stream_ended = result.status != TrsConnection::Result::kSuccess;
+    reader.results.push_back(std::move(result));
+    result_queued_.notify_all();
+    if (stream_ended) {
+      break;
+    }
+  }
+  LOG_DEBUG(logger_, "Stop reading hash stream " << server_index);
+  std::lock_guard<std::mutex> lock(mutex_);
+  reader.running = false;
+}
+
+}  // namespace client::thin_replica_client
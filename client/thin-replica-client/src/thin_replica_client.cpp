@@ -17,7 +17,7 @@
 #include <opentracing/span.h>
 #include <opentracing/tracer.h>
 #include <memory>
-#include <numeric>
+#include <algorithm>
 #include <sstream>
 
 #include "client/thin-replica-client/trace_contexts.hpp"
@@ -27,7 +27,6 @@
 using com::vmware::concord::thin_replica::BlockId;
 using com::vmware::concord::thin_replica::Data;
 using com::vmware::concord::thin_replica::Hash;
-using com::vmware::concord::thin_replica::KVPair;
 using com::vmware::concord::thin_replica::ReadStateHashRequest;
 using com::vmware::concord::thin_replica::ReadStateRequest;
 using com::vmware::concord::thin_replica::SubscriptionRequest;
@@ -100,37 +99,38 @@ void ThinReplicaClient::recordCollectedHash(size_t update_source,
   }
 }
 
-bool ThinReplicaClient::readUpdateHashFromStream(size_t server_index,
-                                                 HashRecordMap& server_indexes_by_reported_update,
-                                                 size_t& maximal_agreeing_subset_size,
-                                                 HashRecord& maximally_agreed_on_update,
-                                                 size_t& servers_out_of_range,
-                                                 size_t& servers_pruned) {
-  Hash hash;
+bool ThinReplicaClient::recordHashFromStream(const HashStreamReader::Result& hash_read,
+                                             HashRecordMap& server_indexes_by_reported_update,
+                                             size_t& maximal_agreeing_subset_size,
+                                             HashRecord& maximally_agreed_on_update,
+                                             size_t& servers_out_of_range,
+                                             size_t& servers_pruned) {
+  const size_t server_index = hash_read.server_index;
+  const Hash& hash = hash_read.hash;
   LOG_DEBUG(logger_, "Read hash from " << server_index);
 
-  TrsConnection::Result read_result = config_->trs_conns[server_index]->readHash(&hash);
+  TrsConnection::Result read_result = hash_read.status;
   if (read_result == TrsConnection::Result::kTimeout) {
     LOG_DEBUG(logger_, "Hash stream " << server_index << " timed out.");
     metrics_.read_timeouts_per_update++;
-    return false;
+    return true;
   }
   if (read_result == TrsConnection::Result::kFailure) {
     LOG_DEBUG(logger_, "Hash stream " << server_index << " read failed.");
     metrics_.read_failures_per_update++;
-    return false;
+    return true;
   }
   if (read_result == TrsConnection::Result::kOutOfRange) {
     LOG_DEBUG(logger_, "Hash stream " << server_index << " read failed, request out of range.");
     metrics_.read_failures_per_update++;
     if (!is_subscription_successful_) servers_out_of_range++;
-    return false;
+    return true;
   }
   if (read_result == TrsConnection::Result::kNotFound) {
     LOG_DEBUG(logger_, "Hash stream " << server_index << " read failed, requested update pruned.");
     metrics_.read_failures_per_update++;
     servers_pruned++;
-    return false;
+    return true;
   }
   ConcordAssert(read_result == TrsConnection::Result::kSuccess);
 
@@ -140,11 +140,16 @@ bool ThinReplicaClient::readUpdateHashFromStream(size_t server_index,
     hash_id = hash.event_group().event_group_id();
     ConcordAssert(latest_verified_event_group_id_ <
                   std::numeric_limits<decltype(latest_verified_event_group_id_)>::max());
+    if (is_subscription_successful_ && hash_id <= latest_verified_event_group_id_) {
+      // Read ahead while the event group was verified without this server
+      LOG_DEBUG(logger_, "Skip hash of verified event group " << hash_id << " from " << server_index);
+      return false;
+    }
     if (hash_id < latest_verified_event_group_id_) {
       LOG_WARN(logger_,
                "Hash stream " << server_index << " gave an update with decreasing event group number: " << hash_id);
       metrics_.read_ignored_per_update++;
-      return true;
+      return false;
     }
     hash_string = hash.event_group().hash();
 
@@ -158,10 +163,15 @@ bool ThinReplicaClient::readUpdateHashFromStream(size_t server_index,
   } else {
     ConcordAssert(hash.has_events());
     hash_id = hash.events().block_id();
+    if (is_subscription_successful_ && hash_id <= latest_verified_block_id_) {
+      // Read ahead while the block was verified without this server
+      LOG_DEBUG(logger_, "Skip hash of verified block " << hash_id << " from " << server_index);
+      return false;
+    }
     if (hash_id < latest_verified_block_id_) {
       LOG_WARN(logger_, "Hash stream " << server_index << " gave an update with decreasing update number: " << hash_id);
       metrics_.read_ignored_per_update++;
-      return true;
+      return false;
     }
     hash_string = hash.events().hash();
 
@@ -269,7 +279,7 @@ std::pair<TrsConnection::Result, ThinReplicaClient::SpanPtr> ThinReplicaClient::
 
 TrsConnection::Result ThinReplicaClient::startHashStreamWith(size_t server_index) {
   ConcordAssert(server_index != data_conn_index_);
-  config_->trs_conns[server_index]->cancelHashStream();
+  cancelHashStream(server_index);
 
   SubscriptionRequest request;
   if (is_event_group_request_) {
@@ -280,7 +290,55 @@ TrsConnection::Result ThinReplicaClient::startHashStreamWith(size_t server_index
   return config_->trs_conns[server_index]->openHashStream(request);
 }
 
+bool ThinReplicaClient::startHashReaderWith(size_t server_index,
+                                            size_t& servers_out_of_range,
+                                            size_t& servers_pruned) {
+  ConcordAssertNE(config_->trs_conns[server_index], nullptr);
+  if (!config_->trs_conns[server_index]->hasHashStream()) {
+    LOG_DEBUG(logger_, "Additionally asking " << server_index);
+    TrsConnection::Result stream_open_status = startHashStreamWith(server_index);
+
+    // Assert the possible TrsConnection::Result values have not changed
+    // without updating the following code.
+    ConcordAssert(stream_open_status == TrsConnection::Result::kSuccess ||
+                  stream_open_status == TrsConnection::Result::kTimeout ||
+                  stream_open_status == TrsConnection::Result::kFailure ||
+                  stream_open_status == TrsConnection::Result::kOutOfRange ||
+                  stream_open_status == TrsConnection::Result::kNotFound);
+
+    if (stream_open_status == TrsConnection::Result::kTimeout) {
+      LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " timed out.");
+      metrics_.read_timeouts_per_update++;
+    }
+    if (stream_open_status == TrsConnection::Result::kFailure) {
+      LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " failed.");
+      metrics_.read_failures_per_update++;
+    }
+    if (stream_open_status == TrsConnection::Result::kOutOfRange) {
+      LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " failed, request out of range.");
+      metrics_.read_failures_per_update++;
+      if (!is_subscription_successful_) servers_out_of_range++;
+    }
+    if (stream_open_status == TrsConnection::Result::kNotFound) {
+      LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " failed, requested update pruned.");
+      metrics_.read_failures_per_update++;
+      servers_pruned++;
+    }
+    if (stream_open_status != TrsConnection::Result::kSuccess) {
+      return false;
+    }
+  }
+  hash_reader_->start(server_index);
+  return true;
+}
+
+void ThinReplicaClient::cancelHashStream(size_t server_index) {
+  hash_reader_->stop(server_index);
+  config_->trs_conns[server_index]->cancelHashStream();
+}
+
 void ThinReplicaClient::findBlockHashAgreement(std::vector<bool>& servers_tried,
+                                               std::vector<bool>& hash_pending,
                                                HashRecordMap& agreeing_subset_members,
                                                size_t& most_agreeing,
                                                HashRecord& most_agreed_block,
@@ -292,80 +350,84 @@ void ThinReplicaClient::findBlockHashAgreement(std::vector<bool>& servers_tried,
     span = opentracing::Tracer::Global()->StartSpan("trclient_verify_hash_against_additional_servers",
                                                     {opentracing::ChildOf(&parent_span->context())});
   }
+  // How often the wait for hashes is interrupted to check whether to stop or to ask another server
+  constexpr auto kHashPollInterval = std::chrono::milliseconds(10);
+  const size_t quorum = config_->max_faulty + 1;
+
+  // The hashes of all servers that are read from already are collected, they
+  // arrive concurrently and cost nothing extra.
+  size_t num_pending = 0;
+  for (size_t server_index = 0; server_index < config_->trs_conns.size(); ++server_index) {
+    if (!servers_tried[server_index] && hash_reader_->isReading(server_index)) {
+      servers_tried[server_index] = true;
+      hash_pending[server_index] = true;
+      ++num_pending;
+    }
+  }
 
-  // Create a list of server indexes so that we start iterating over the ones
-  // that have an open stream already. If we cannot find agreement amongst them
-  // then we keep going and try the other servers too.
-  std::vector<size_t> sorted_servers(config_->trs_conns.size());
-  std::iota(sorted_servers.begin(), sorted_servers.end(), 0);
-  std::stable_sort(sorted_servers.begin(), sorted_servers.end(), [this](auto a, auto b) {
+  // The other servers are asked in order, starting with the ones that have an
+  // open stream already.
+  std::vector<size_t> other_servers;
+  for (size_t server_index = 0; server_index < config_->trs_conns.size(); ++server_index) {
+    if (!servers_tried[server_index]) {
+      other_servers.push_back(server_index);
+    }
+  }
+  std::stable_sort(other_servers.begin(), other_servers.end(), [this](auto a, auto b) {
     return config_->trs_conns[a]->hasHashStream() > config_->trs_conns[b]->hasHashStream();
   });
 
-  size_t unsuccessful_hash_stream_subset_size = 0;
-  for (auto server_index : sorted_servers) {
-    ConcordAssertNE(config_->trs_conns[server_index], nullptr);
-    if (servers_tried[server_index]) {
-      continue;
-    }
+  auto next_server = other_servers.begin();
+  auto last_asked = std::chrono::steady_clock::now();
+  while (most_agreeing < quorum) {
     if (stop_subscription_thread_) {
       return;
     }
 
-    if (!config_->trs_conns[server_index]->hasHashStream()) {
-      LOG_DEBUG(logger_, "Additionally asking " << server_index);
-      TrsConnection::Result stream_open_status = startHashStreamWith(server_index);
-
-      // Assert the possible TrsConnection::Result values have not changed
-      // without updating the following code.
-      ConcordAssert(stream_open_status == TrsConnection::Result::kSuccess ||
-                    stream_open_status == TrsConnection::Result::kTimeout ||
-                    stream_open_status == TrsConnection::Result::kFailure ||
-                    stream_open_status == TrsConnection::Result::kOutOfRange ||
-                    stream_open_status == TrsConnection::Result::kNotFound);
-
-      if (stream_open_status == TrsConnection::Result::kTimeout) {
-        LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " timed out.");
-        metrics_.read_timeouts_per_update++;
-      }
-      if (stream_open_status == TrsConnection::Result::kFailure) {
-        LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " failed.");
-        metrics_.read_failures_per_update++;
+    // Ask another server if the pending ones can't reach agreement or if
+    // none of them answered within the hedge delay.
+    auto now = std::chrono::steady_clock::now();
+    bool hedge = num_pending > 0 && now - last_asked >= config_->hash_read_hedge_delay;
+    while (next_server != other_servers.end() && (most_agreeing + num_pending < quorum || hedge)) {
+      const auto server_index = *next_server++;
+      servers_tried[server_index] = true;
+      if (stop_subscription_thread_) {
+        return;
       }
-      if (stream_open_status == TrsConnection::Result::kOutOfRange) {
-        LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " failed, request out of range.");
-        metrics_.read_failures_per_update++;
-        if (!is_subscription_successful_) servers_out_of_range++;
-      }
-      if (stream_open_status == TrsConnection::Result::kNotFound) {
-        LOG_DEBUG(logger_, "Opening a hash stream to server " << server_index << " failed, requested update pruned.");
-        metrics_.read_failures_per_update++;
-        servers_pruned++;
-      }
-      if (stream_open_status != TrsConnection::Result::kSuccess) {
-        servers_tried[server_index] = true;
+      if (!startHashReaderWith(server_index, servers_out_of_range, servers_pruned)) {
         continue;
       }
+      if (hedge) {
+        LOG_DEBUG(logger_, "No hash within the hedge delay, additionally asking " << server_index);
+      }
+      hash_pending[server_index] = true;
+      ++num_pending;
+      last_asked = now;
+      hedge = false;
     }
-
-    bool has_hash = readUpdateHashFromStream(
-        server_index, agreeing_subset_members, most_agreeing, most_agreed_block, servers_out_of_range, servers_pruned);
-    if (!has_hash) unsuccessful_hash_stream_subset_size++;
-    servers_tried[server_index] = true;
-
-    if (most_agreeing >= (config_->max_faulty + 1)) {
+    if (num_pending == 0) {
       return;
     }
+
+    auto hash_read = hash_reader_->next(hash_pending, kHashPollInterval);
+    if (!hash_read) {
+      continue;
+    }
+    const bool answered = recordHashFromStream(
+        *hash_read, agreeing_subset_members, most_agreeing, most_agreed_block, servers_out_of_range, servers_pruned);
+    if (answered) {
+      hash_pending[hash_read->server_index] = false;
+      --num_pending;
+    }
   }
-  return;
 }
 
 TrsConnection::Result ThinReplicaClient::resetDataStreamTo(size_t server_index) {
   ConcordAssertNE(config_->trs_conns[server_index], nullptr);
   config_->trs_conns[server_index]->cancelDataStream();
-  config_->trs_conns[server_index]->cancelHashStream();
+  cancelHashStream(server_index);
   config_->trs_conns[data_conn_index_]->cancelDataStream();
-  config_->trs_conns[data_conn_index_]->cancelHashStream();
+  cancelHashStream(data_conn_index_);
 
   SubscriptionRequest request;
 
@@ -384,7 +446,7 @@ TrsConnection::Result ThinReplicaClient::resetDataStreamTo(size_t server_index)
 void ThinReplicaClient::closeAllHashStreams() {
   for (size_t i = 0; i < config_->trs_conns.size(); ++i) {
     if (i != data_conn_index_) {
-      config_->trs_conns[i]->cancelHashStream();
+      cancelHashStream(i);
     }
   }
 }
@@ -521,6 +583,7 @@ void ThinReplicaClient::receiveUpdates() {
     unique_ptr<LogCid> update_cid;
     SpanPtr span = nullptr;
     vector<bool> servers_tried(config_->trs_conns.size(), false);
+    vector<bool> hash_pending(config_->trs_conns.size(), false);
     // indicates the number of servers in one iteration of the while loop have returned OUT_OF_RANGE error
     size_t servers_out_of_range = 0;
     // indicates the number of servers in one iteration of the while loop have returned NOT_FOUND error
@@ -555,6 +618,7 @@ void ThinReplicaClient::receiveUpdates() {
     LOG_DEBUG(logger_,
               "Find hash agreement amongst all servers for update " << (has_data ? to_string(update_id) : "n/a"));
     findBlockHashAgreement(servers_tried,
+                           hash_pending,
                            agreeing_subset_members,
                            most_agreeing,
                            most_agreed_block,
@@ -657,25 +721,30 @@ void ThinReplicaClient::receiveUpdates() {
 
     ConcordAssertNE(config_->update_queue, nullptr);
 
+    // update_in isn't used past this point, its payload is moved into the update rather than copied
     auto update = std::make_unique<EventVariant>();
     if (update_in.has_event_group()) {
+      auto event_group_in = update_in.mutable_event_group();
       EventGroup event_group;
-      event_group.id = update_in.event_group().id();
-      for (auto& event : update_in.event_group().events()) {
-        event_group.events.push_back(event);
+      event_group.id = event_group_in->id();
+      event_group.events.reserve(event_group_in->events_size());
+      for (auto& event : *event_group_in->mutable_events()) {
+        event_group.events.push_back(std::move(event));
       }
-      event_group.record_time = update_in.event_group().record_time();
+      event_group.record_time = event_group_in->record_time();
       latest_verified_event_group_id_ = event_group.id;
       update->emplace<EventGroup>(std::move(event_group));
       // If we started with a legacy request then the transition has happened now
       is_event_group_request_ = true;
     } else {
       ConcordAssert(update_in.has_events());
+      auto events_in = update_in.mutable_events();
       Update legacy_event;
-      legacy_event.block_id = update_in.events().block_id();
-      legacy_event.correlation_id_ = update_in.events().correlation_id();
-      for (const auto& kvp_in : update_in.events().data()) {
-        legacy_event.kv_pairs.push_back(make_pair(kvp_in.key(), kvp_in.value()));
+      legacy_event.block_id = events_in->block_id();
+      legacy_event.correlation_id_ = std::move(*events_in->mutable_correlation_id());
+      legacy_event.kv_pairs.reserve(events_in->data_size());
+      for (auto& kvp_in : *events_in->mutable_data()) {
+        legacy_event.kv_pairs.emplace_back(std::move(*kvp_in.mutable_key()), std::move(*kvp_in.mutable_value()));
       }
       latest_verified_block_id_ = legacy_event.block_id;
       update->emplace<Update>(std::move(legacy_event));
@@ -695,14 +764,17 @@ void ThinReplicaClient::receiveUpdates() {
 
     // Cleanup before the next update
 
-    // The main subscription loop should not be leaving any more than
-    // (max_faulty_ + 1) subscription streams open before ending each iteration;
-    // the fact it shouldn't may or not be used as a simplifying assumption in
-    // the loop's implementation.
+    // Close the hash streams of the servers that answered but didn't agree.
+    // The streams of the agreeing servers and of the servers we didn't get an
+    // answer from yet are kept open and read ahead for the next updates.
     for (size_t trsc = 0; trsc < config_->trs_conns.size(); ++trsc) {
-      if (agreeing_subset_members[most_agreed_block].count(trsc) < 1 && config_->trs_conns[trsc]->hasHashStream()) {
+      if (trsc == data_conn_index_ || hash_pending[trsc] ||
+          agreeing_subset_members[most_agreed_block].count(trsc) > 0) {
+        continue;
+      }
+      if (hash_reader_->isReading(trsc) || config_->trs_conns[trsc]->hasHashStream()) {
         LOG_DEBUG(logger_, "Close hash stream " << trsc << " after update " << update_id);
-        config_->trs_conns[trsc]->cancelHashStream();
+        cancelHashStream(trsc);
       }
     }
   }
@@ -829,10 +901,12 @@ void ThinReplicaClient::Subscribe() {
         auto update = std::make_unique<EventVariant>();
         auto& legacy_event = std::get<Update>(*update);
         legacy_event.block_id = block_id;
-        legacy_event.correlation_id_ = response.events().correlation_id();
-        for (int i = 0; i < response.events().data_size(); ++i) {
-          const KVPair& kvp = response.events().data(i);
-          legacy_event.kv_pairs.push_back(make_pair(kvp.key(), kvp.value()));
+        // The response is overwritten by the next read, move its payload instead of copying it
+        auto events_in = response.mutable_events();
+        legacy_event.correlation_id_ = std::move(*events_in->mutable_correlation_id());
+        legacy_event.kv_pairs.reserve(events_in->data_size());
+        for (auto& kvp : *events_in->mutable_data()) {
+          legacy_event.kv_pairs.emplace_back(std::move(*kvp.mutable_key()), std::move(*kvp.mutable_value()));
         }
         update_hashes.push_back(hashUpdate(*update));
         state.push_back(move(update));
@@ -1067,6 +1141,8 @@ void ThinReplicaClient::receiveUpdatesWrapper() {
     config_->update_queue->setException(std::current_exception());
     stop_subscription_thread_ = true;
   }
+  // Don't read hashes without a subscription
+  hash_reader_->stopAll();
 }
 
 }  // namespace client::thin_replica_client
@@ -327,7 +327,10 @@ void TrsConnection::cancelHashStream() {
   }
   ConcordAssertNE(hash_context_, nullptr);
   hash_context_->TryCancel();
-  hash_context_.reset();
+  {
+    std::lock_guard<std::mutex> lock(hash_context_mutex_);
+    hash_context_.reset();
+  }
   hash_stream_.reset();
 }
 
@@ -342,7 +345,10 @@ TrsConnection::Result TrsConnection::readHash(Hash* hash) {
   if (status == future_status::timeout || status == future_status::deferred) {
     hash_context_->TryCancel();
     result.wait();
-    hash_context_.reset();
+    {
+      std::lock_guard<std::mutex> lock(hash_context_mutex_);
+      hash_context_.reset();
+    }
     hash_stream_.reset();
     return Result::kTimeout;
   }
@@ -356,6 +362,13 @@ TrsConnection::Result TrsConnection::readHash(Hash* hash) {
   return Result::kFailure;
 }
 
+void TrsConnection::interruptHashStream() {
+  std::lock_guard<std::mutex> lock(hash_context_mutex_);
+  if (hash_context_) {
+    hash_context_->TryCancel();
+  }
+}
+
 TrsConnection::Result TrsConnection::openStateSnapshotStream(
     const vmware::concord::replicastatesnapshot::StreamSnapshotRequest& request) {
   // TODO: Add implementation
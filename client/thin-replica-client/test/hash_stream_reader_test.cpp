@@ -0,0 +1,151 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "client/thin-replica-client/hash_stream_reader.hpp"
+
+using com::vmware::concord::thin_replica::Hash;
+using client::thin_replica_client::HashStreamReader;
+using client::thin_replica_client::TrsConnection;
+using std::chrono::milliseconds;
+
+namespace {
+
+constexpr milliseconds kReadDelay{50};
+constexpr milliseconds kWaitTimeout{5000};
+
+// Streams hashes for the blocks 1..num_hashes, then ends. Every read takes the given delay unless interrupted.
+class FakeHashConnection : public TrsConnection {
+ public:
+  FakeHashConnection(uint64_t num_hashes, milliseconds delay)
+      : TrsConnection("fake_address", "fake_client_id", 1, 1), num_hashes_(num_hashes), delay_(delay) {}
+  ~FakeHashConnection() override {}
+
+  Result readHash(Hash* hash) override {
+    ++reads;
+    const auto deadline = std::chrono::steady_clock::now() + delay_;
+    while (std::chrono::steady_clock::now() < deadline) {
+      if (interrupted) {
+        return Result::kFailure;
+      }
+      std::this_thread::sleep_for(milliseconds(1));
+    }
+    if (next_block_ > num_hashes_) {
+      return Result::kFailure;
+    }
+    hash->mutable_events()->set_block_id(next_block_++);
+    return Result::kSuccess;
+  }
+  void interruptHashStream() override { interrupted = true; }
+
+  std::atomic_uint64_t reads{0};
+  std::atomic_bool interrupted{false};
+
+ private:
+  const uint64_t num_hashes_;
+  const milliseconds delay_;
+  uint64_t next_block_ = 1;
+};
+
+std::vector<std::unique_ptr<TrsConnection>> createConnections(std::vector<milliseconds> delays,
+                                                               uint64_t num_hashes = 10) {
+  std::vector<std::unique_ptr<TrsConnection>> conns;
+  for (auto delay : delays) {
+    conns.push_back(std::make_unique<FakeHashConnection>(num_hashes, delay));
+  }
+  return conns;
+}
+
+FakeHashConnection& fake(std::vector<std::unique_ptr<TrsConnection>>& conns, size_t i) {
+  return dynamic_cast<FakeHashConnection&>(*conns[i]);
+}
+
+TEST(hash_stream_reader_test, slow_stream_does_not_delay_the_others) {
+  auto conns = createConnections({milliseconds{0}, kWaitTimeout * 2, milliseconds{0}});
+  HashStreamReader reader(conns, 4);
+  for (size_t i = 0; i < conns.size(); ++i) {
+    reader.start(i);
+  }
+
+  // The hashes of both fast servers arrive while the slow server is still reading
+  std::vector<bool> pending(conns.size(), true);
+  for (int i = 0; i < 2; ++i) {
+    auto result = reader.next(pending, kWaitTimeout);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(TrsConnection::Result::kSuccess, result->status);
+    ASSERT_EQ(1, result->hash.events().block_id());
+    pending[result->server_index] = false;
+  }
+  ASSERT_EQ((std::vector<bool>{false, true, false}), pending);
+
+  // The slow read is interrupted when the reader stops
+  reader.stop(1);
+  ASSERT_TRUE(fake(conns, 1).interrupted);
+  ASSERT_FALSE(reader.isReading(1));
+}
+
+TEST(hash_stream_reader_test, reads_ahead_in_order) {
+  auto conns = createConnections({milliseconds{0}});
+  HashStreamReader reader(conns, 3);
+  reader.start(0);
+
+  const std::vector<bool> servers{true};
+  // Wait until the reader filled its queue, it doesn't read further
+  auto deadline = std::chrono::steady_clock::now() + kWaitTimeout;
+  while (fake(conns, 0).reads < 3 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  std::this_thread::sleep_for(kReadDelay);
+  ASSERT_EQ(3, fake(conns, 0).reads.load());
+
+  for (uint64_t block_id = 1; block_id <= 10; ++block_id) {
+    auto result = reader.next(servers, kWaitTimeout);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(TrsConnection::Result::kSuccess, result->status);
+    ASSERT_EQ(block_id, result->hash.events().block_id());
+  }
+
+  // The end of the stream is reported once and the reader stops reading
+  auto result = reader.next(servers, kWaitTimeout);
+  ASSERT_TRUE(result.has_value());
+  ASSERT_EQ(TrsConnection::Result::kFailure, result->status);
+  ASSERT_FALSE(reader.next(servers, kReadDelay).has_value());
+  ASSERT_FALSE(reader.isReading(0));
+}
+
+TEST(hash_stream_reader_test, only_the_given_servers_are_waited_for) {
+  auto conns = createConnections({milliseconds{0}, milliseconds{0}});
+  HashStreamReader reader(conns, 1);
+  reader.start(0);
+  reader.start(1);
+
+  const std::vector<bool> second{false, true};
+  for (uint64_t block_id = 1; block_id <= 3; ++block_id) {
+    auto result = reader.next(second, kWaitTimeout);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(1, result->server_index);
+    ASSERT_EQ(block_id, result->hash.events().block_id());
+  }
+
+  // Unconsumed results are dropped on stop
+  reader.stop(0);
+  ASSERT_FALSE(reader.isReading(0));
+  ASSERT_FALSE(reader.next({true, false}, kReadDelay).has_value());
+}
+
+}  // namespace
@@ -0,0 +1,153 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Benchmark of the hash verification of the Thin Replica Client against a mock
+// cluster of 3F + 1 servers, F of which stream their hashes slowly. Reports the
+// updates/s and the distribution of the time between consecutive updates.
+//
+// Usage: trc_hash_stream_benchmark [updates] [F] [slow read ms] [read ahead]
+// Exits with a failure if not all updates were received.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "client/thin-replica-client/thin_replica_client.hpp"
+#include "thin_replica_client_mocks.hpp"
+
+using com::vmware::concord::thin_replica::Data;
+using com::vmware::concord::thin_replica::Hash;
+using com::vmware::concord::thin_replica::KVPair;
+using com::vmware::concord::thin_replica::SubscriptionRequest;
+using concord::client::concordclient::BasicUpdateQueue;
+using client::thin_replica_client::ThinReplicaClient;
+using client::thin_replica_client::ThinReplicaClientConfig;
+using grpc::ClientContext;
+using grpc::ClientReaderInterface;
+using grpc::Status;
+using std::chrono::milliseconds;
+using testing::Invoke;
+
+namespace {
+
+const std::string kClientId = "trc_benchmark_client";
+constexpr auto kPopTimeout = std::chrono::seconds(10);
+
+// Makes up to max_slow servers stream every hash with the given delay.
+class SlowHashStreams : public ByzantineMockThinReplicaServerPreparer::ByzantineServerBehavior {
+ private:
+  class SlowStreamState : public MockThinReplicaStream<Hash>::State {
+   public:
+    SlowStreamState(ClientReaderInterface<Hash>* hashes, milliseconds delay) : hashes_(hashes), delay_(delay) {}
+    Status Finish() { return hashes_->Finish(); }
+    bool Read(Hash* hash) {
+      std::this_thread::sleep_for(delay_);
+      return hashes_->Read(hash);
+    }
+
+   private:
+    std::unique_ptr<ClientReaderInterface<Hash>> hashes_;
+    const milliseconds delay_;
+  };
+
+  const size_t max_slow_;
+  const milliseconds delay_;
+
+ public:
+  SlowHashStreams(size_t max_slow, milliseconds delay) : max_slow_(max_slow), delay_(delay) {}
+
+  ClientReaderInterface<Hash>* SubscribeToUpdateHashesRaw(size_t server_index,
+                                                          ClientContext* context,
+                                                          const SubscriptionRequest& request,
+                                                          ClientReaderInterface<Hash>* correct_hashes) override {
+    if (delay_.count() == 0 || !MakeByzantineFaulty(server_index, max_slow_)) {
+      return correct_hashes;
+    }
+    auto hash_stream = new MockThinReplicaStream<Hash>();
+    auto stream_state = new SlowStreamState(correct_hashes, delay_);
+    hash_stream->state.reset(stream_state);
+    ON_CALL(*hash_stream, Finish).WillByDefault(Invoke(stream_state, &SlowStreamState::Finish));
+    ON_CALL(*hash_stream, Read).WillByDefault(Invoke(stream_state, &SlowStreamState::Read));
+    return hash_stream;
+  }
+};
+
+Data sampleUpdate() {
+  Data update;
+  update.mutable_events()->set_block_id(1);
+  KVPair* kvp = update.mutable_events()->add_data();
+  kvp->set_key("key");
+  kvp->set_value(std::string(256, 'v'));
+  return update;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_updates = argc > 1 ? std::stoul(argv[1]) : 2000;
+  const size_t max_faulty = argc > 2 ? std::stoul(argv[2]) : 1;
+  const milliseconds slow_delay(argc > 3 ? std::stoul(argv[3]) : 5);
+  const size_t read_ahead = argc > 4 ? std::stoul(argv[4]) : 4;
+  const size_t num_servers = 3 * max_faulty + 1;
+
+  std::shared_ptr<MockDataStreamPreparer> data_preparer =
+      std::make_shared<RepeatedMockDataStreamPreparer>(sampleUpdate());
+  auto hasher = std::make_shared<MockOrderedDataStreamHasher>(data_preparer);
+  auto behavior = std::make_shared<SlowHashStreams>(max_faulty, slow_delay);
+  ByzantineMockThinReplicaServerPreparer server_preparer(data_preparer, hasher, behavior);
+  auto mock_servers = CreateByzantineMockServers(num_servers, server_preparer);
+
+  auto update_queue = std::make_shared<BasicUpdateQueue>();
+  auto config = std::make_unique<ThinReplicaClientConfig>(
+      kClientId,
+      update_queue,
+      max_faulty,
+      CreateTrsConnections<ByzantineMockThinReplicaServerPreparer::ByzantineMockServer>(mock_servers),
+      std::chrono::seconds(60),
+      read_ahead);
+  auto trc = std::make_unique<ThinReplicaClient>(std::move(config), std::make_shared<concordMetrics::Aggregator>());
+  trc->Subscribe();
+
+  std::vector<int64_t> gaps_us;
+  gaps_us.reserve(num_updates);
+  const auto start = std::chrono::steady_clock::now();
+  auto last = start;
+  while (gaps_us.size() < num_updates) {
+    auto update = update_queue->tryPop();
+    const auto now = std::chrono::steady_clock::now();
+    if (!update) {
+      if (now - last > kPopTimeout) {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+    gaps_us.push_back(std::chrono::duration_cast<std::chrono::microseconds>(now - last).count());
+    last = now;
+  }
+  const auto elapsed = std::chrono::duration<double>(last - start).count();
+  trc->Unsubscribe();
+
+  std::sort(gaps_us.begin(), gaps_us.end());
+  auto percentile_us = [&](double p) {
+    return gaps_us.empty() ? 0 : gaps_us[static_cast<size_t>(p * (gaps_us.size() - 1))];
+  };
+  std::cout << "servers=" << num_servers << " slow=" << max_faulty << " slow_read=" << slow_delay.count()
+            << "ms read_ahead=" << read_ahead << ": updates=" << gaps_us.size()
+            << " updates/s=" << static_cast<uint64_t>(elapsed > 0 ? gaps_us.size() / elapsed : 0)
+            << " p50=" << percentile_us(0.5) << "us p99=" << percentile_us(0.99)
+            << "us max=" << (gaps_us.empty() ? 0 : gaps_us.back()) << "us" << std::endl;
+  return gaps_us.size() == num_updates ? 0 : 1;
+}
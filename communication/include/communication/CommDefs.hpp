@@ -195,6 +195,7 @@ class TlsTCPCommunication : public ICommunication {
   void setReceiver(NodeNum receiverNum, IReceiver *receiver) override;
 
   void restartCommunication(NodeNum i) override;
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator> &aggregator) override;
   ~TlsTCPCommunication() override;
 
  private:
@@ -13,9 +13,14 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include <set>
 #include <vector>
 
+namespace concordMetrics {
+class Aggregator;
+}
+
 namespace bft::communication {
 
 typedef uint64_t NodeNum;
@@ -68,6 +73,10 @@ class ICommunication {
   virtual void setReceiver(NodeNum receiverNum, IReceiver* receiver) = 0;
 
   virtual void restartCommunication(NodeNum i) = 0;
+
+  // Registers the metrics of the communication, if it has any, with the given aggregator.
+  virtual void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator) {}
+
   virtual ~ICommunication() = default;
 };
 }  // namespace bft::communication
@@ -0,0 +1,67 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "communication/ICommunication.hpp"
+
+// Communication over memory shared by the threads of a process, or by processes forked from it, with no network.
+//
+// A SharedMemoryNetwork maps one single producer single consumer ring per ordered pair of connected nodes. Replicas are
+// connected to each other and to all clients, clients only to the replicas. The network has to be created before
+// forking, so that the forked processes share its memory, and outlive the communications of its nodes.
+//
+// Messages are delivered in the order they were sent by a node, and without copying: the receiver gets a pointer into
+// the ring. A send waits while the ring to a running node is full, and fails if the node isn't running.
+
+namespace bft::communication {
+
+class SharedMemoryNetwork {
+ public:
+  static constexpr size_t kDefaultRingBytes = 1024 * 1024;
+
+  // ringBytes: The bytes of every ring, a power of two. Messages larger than a quarter of it can't be sent.
+  SharedMemoryNetwork(const std::vector<NodeNum>& replicas,
+                      const std::vector<NodeNum>& clients,
+                      size_t ringBytes = kDefaultRingBytes);
+  ~SharedMemoryNetwork();
+
+  SharedMemoryNetwork(const SharedMemoryNetwork&) = delete;
+  SharedMemoryNetwork& operator=(const SharedMemoryNetwork&) = delete;
+
+  // The communication of the given node. Every node has a single one, at any time, across all processes.
+  std::unique_ptr<ICommunication> communicationOf(NodeNum node);
+
+  size_t maxMessageSize() const { return ringBytes_ / 4; }
+
+ private:
+  class Communication;
+  struct NodeHeader;
+  struct RingHeader;
+
+  RingHeader* ring(size_t from, size_t to) const;
+  NodeHeader* node(size_t index) const;
+
+  const size_t ringBytes_;
+  std::vector<NodeNum> nodes_;
+  std::unordered_map<NodeNum, size_t> indexes_;
+  // The offset of the ring of every ordered pair of node indexes, 0 if the nodes aren't connected
+  std::vector<size_t> ringOffsets_;
+  char* memory_ = nullptr;
+  size_t memoryBytes_ = 0;
+};
+
+}  // namespace bft::communication
@@ -96,18 +96,21 @@ void AsyncTlsConnection::readMsgSizeHeader() { readMsgSizeHeader(std::nullopt);
 
 void AsyncTlsConnection::readMsg() {
   auto msg_size = getReadMsgSize();
-  LOG_DEBUG(logger_, KVLOG(peer_id_.value(), msg_size, (void*)read_msg_.data()));
+  read_msg_ = receive_buffers_->allocate(msg_size);
+  LOG_DEBUG(logger_, KVLOG(peer_id_.value(), msg_size, (void*)read_msg_));
   auto self = shared_from_this();
   status_.msg_reads++;
   auto start = std::chrono::steady_clock::now();
   async_read(
       *socket_,
-      asio::buffer(read_msg_.data(), msg_size),
+      asio::buffer(read_msg_, msg_size),
       asio::bind_executor(strand_, [this, self, start](const asio::error_code& error_code, auto bytes_transferred) {
         if (disposed_) {
+          releaseReadMsg();
           return;
         }
         if (error_code) {
+          releaseReadMsg();
           if (error_code == asio::error::operation_aborted) {
             LOG_DEBUG(logger_, "Operation aborted: " << KVLOG(peer_id_.value(), disposed_));
             // The socket has already been cleaned up and any references are invalid. Just return.
@@ -123,13 +126,14 @@ void AsyncTlsConnection::readMsg() {
 
         // The Read succeeded.
         histograms_.async_read_msg->recordAtomic(durationInMicros(start));
-        LOG_DEBUG(logger_, "Cancelling read timer: " << KVLOG(peer_id_.value(), (void*)read_msg_.data()));
+        LOG_DEBUG(logger_, "Cancelling read timer: " << KVLOG(peer_id_.value(), (void*)read_msg_));
         read_timer_.cancel();
         histograms_.received_msg_size->recordAtomic(bytes_transferred);
         {
           concord::diagnostics::TimeRecorder<true> scoped_timer(*histograms_.read_enqueue_time);
-          receiver_->onNewMessage(peer_id_.value(), read_msg_.data(), bytes_transferred);
+          receiver_->onNewMessage(peer_id_.value(), read_msg_, bytes_transferred);
         }
+        releaseReadMsg();
         readMsgSizeHeader();
       }));
 }
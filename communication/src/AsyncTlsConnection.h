@@ -83,7 +83,7 @@ class AsyncTlsConnection : public std::enable_shared_from_this<AsyncTlsConnectio
         connection_manager_(conn_mgr),
         read_timer_(io_context_),
         write_timer_(io_context_),
-        read_msg_(config.bufferLength_),
+        receive_buffers_(conn_mgr.receive_buffers_),
         config_(config),
         status_(status),
         histograms_(histograms),
@@ -106,7 +106,7 @@ class AsyncTlsConnection : public std::enable_shared_from_this<AsyncTlsConnectio
         connection_manager_(conn_mgr),
         read_timer_(io_context_),
         write_timer_(io_context_),
-        read_msg_(config.bufferLength_),
+        receive_buffers_(conn_mgr.receive_buffers_),
         config_(config),
         status_(status),
         histograms_(histograms),
@@ -114,6 +114,8 @@ class AsyncTlsConnection : public std::enable_shared_from_this<AsyncTlsConnectio
     write_queue_.setDestination(peer_id);
   }
 
+  ~AsyncTlsConnection() { releaseReadMsg(); }
+
   void setPeerId(NodeNum peer_id) {
     peer_id_ = peer_id;
     write_queue_.setDestination(peer_id);
@@ -149,6 +151,10 @@ class AsyncTlsConnection : public std::enable_shared_from_this<AsyncTlsConnectio
   // ensure we read all remaining bytes within a given timeout. If we read the full message we
   // inform the `receiver_`, otherwise we `dispose` of the connection.
   void readMsg();
+  void releaseReadMsg() {
+    receive_buffers_->deallocate(read_msg_);
+    read_msg_ = nullptr;
+  }
 
   // Return the recently read size header as an integer. Assume network byte order.
   uint32_t getReadMsgSize();
@@ -206,8 +212,9 @@ class AsyncTlsConnection : public std::enable_shared_from_this<AsyncTlsConnectio
   // On every read, we must read the size of the incoming message first. This buffer stores that size.
   std::array<char, MSG_HEADER_SIZE> read_size_buf_;
 
-  // Last read message
-  std::vector<char> read_msg_;
+  // The message being read, allocated once its size is known and released once it is handed to the receiver
+  std::shared_ptr<concordUtil::SlabAllocator> receive_buffers_;
+  char* read_msg_ = nullptr;
 
   // Message being currently written.
   std::atomic_bool write_msg_used_{false};
@@ -38,6 +38,7 @@
 #include <boost/date_time/posix_time/posix_time_duration.hpp>
 
 #include "assertUtils.hpp"
+#include "ThreadPlacement.hpp"
 
 using namespace std;
 using namespace boost::asio;
@@ -732,8 +733,10 @@ class PlainTCPCommunication::PlainTcpImpl {
   int Start() {
     if (_pIoThread) return 0;  // running
 
-    _pIoThread = new std::thread(std::bind(
-        static_cast<size_t (boost::asio::io_service::*)()>(&boost::asio::io_service::run), std::ref(_service)));
+    _pIoThread = new std::thread([this]() {
+      concord::util::ThreadPlacement::instance().place(concord::util::ThreadPlacement::Role::Comm);
+      _service.run();
+    });
     return 0;
   }
 
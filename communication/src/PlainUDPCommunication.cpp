@@ -15,6 +15,7 @@
 #include "communication/CommDefs.hpp"
 
 #include "errnoString.hpp"
+#include "ThreadPlacement.hpp"
 
 #include <iostream>
 #include <cstddef>
@@ -201,6 +202,7 @@ class PlainUDPCommunication::PlainUdpImpl {
   void recvThreadRoutine() {
     ConcordAssert((udpSockFd_ != 0) && "Unable to start receiving: socket not define!");
     ConcordAssert((receiverRef_ != 0) && "Unable to start receiving: receiver not defined!");
+    concord::util::ThreadPlacement::instance().place(concord::util::ThreadPlacement::Role::Comm);
 
     // The main receive loop.
     Addr fromAddress;
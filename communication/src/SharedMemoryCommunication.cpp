@@ -0,0 +1,296 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "communication/SharedMemoryCommunication.hpp"
+
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "Logger.hpp"
+#include "SpscByteRing.hpp"
+#include "kvstream.h"
+
+namespace bft::communication {
+
+namespace {
+
+constexpr size_t kCacheLine = 64;
+// How long an idle receiver sleeps before checking whether it was stopped
+constexpr auto kIdleWait = std::chrono::milliseconds(10);
+// How long a sender sleeps while the ring is full
+constexpr auto kFullRingWait = std::chrono::microseconds(50);
+
+// The futex isn't private, to wake up threads of other processes
+void futexWait(std::atomic_uint32_t* word, uint32_t expected) {
+  const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(kIdleWait).count();
+  timespec timeout{static_cast<time_t>(nanos / 1000000000), static_cast<long>(nanos % 1000000000)};
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futexWake(std::atomic_uint32_t* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+}
+
+}  // namespace
+
+// The state of a node shared by all processes
+struct alignas(kCacheLine) SharedMemoryNetwork::NodeHeader {
+  // Bumped on every message sent to the node, the receiver waits on it
+  std::atomic_uint32_t seq{0};
+  // Whether the receiver waits, so that senders only make a system call when needed
+  std::atomic_uint32_t waiting{0};
+  std::atomic_bool running{false};
+};
+
+// The positions of the ring from a node to another, followed by its buffer
+struct SharedMemoryNetwork::RingHeader {
+  concord::util::SpscByteRing::Positions positions;
+
+  char* buffer() { return reinterpret_cast<char*>(this + 1); }
+};
+
+static_assert(std::atomic_uint32_t::is_always_lock_free, "atomics in shared memory must be lock free");
+
+/******************************** Class Communication ********************************/
+
+class SharedMemoryNetwork::Communication final : public ICommunication {
+ public:
+  Communication(SharedMemoryNetwork& network, size_t self)
+      : logger_(logging::getLogger("concord-bft.shared-memory")), network_(network), self_(self) {
+    for (size_t other = 0; other < network_.nodes_.size(); ++other) {
+      if (auto ring = network_.ring(self_, other)) {
+        outgoing_.emplace(network_.nodes_[other], std::make_unique<Outgoing>(ringOf(ring), network_.node(other)));
+      }
+      if (auto ring = network_.ring(other, self_)) {
+        incoming_.emplace_back(network_.nodes_[other], ringOf(ring));
+      }
+    }
+  }
+
+  ~Communication() override {
+    if (running_) {
+      stop();
+    }
+  }
+
+  int getMaxMessageSize() override { return static_cast<int>(network_.maxMessageSize()); }
+
+  int start() override {
+    if (running_) {
+      return -1;
+    }
+    running_ = true;
+    network_.node(self_)->running = true;
+    receiver_thread_ = std::thread(&Communication::receive, this);
+    return 0;
+  }
+
+  int stop() override {
+    if (!running_) {
+      return -1;
+    }
+    running_ = false;
+    auto self = network_.node(self_);
+    self->running = false;
+    self->seq++;
+    futexWake(&self->seq);
+    receiver_thread_.join();
+    return 0;
+  }
+
+  bool isRunning() const override { return running_; }
+
+  ConnectionStatus getCurrentConnectionStatus(NodeNum node) override {
+    auto iter = outgoing_.find(node);
+    if (iter == outgoing_.end()) {
+      return ConnectionStatus::Unknown;
+    }
+    return iter->second->node->running ? ConnectionStatus::Connected : ConnectionStatus::Disconnected;
+  }
+
+  int send(NodeNum destNode, std::vector<uint8_t>&& msg) override {
+    auto iter = outgoing_.find(destNode);
+    if (iter == outgoing_.end()) {
+      LOG_ERROR(logger_, "Not connected to the destination" << KVLOG(network_.nodes_[self_], destNode));
+      return -1;
+    }
+    if (msg.size() > network_.maxMessageSize()) {
+      LOG_ERROR(logger_, "Message too large" << KVLOG(destNode, msg.size(), network_.maxMessageSize()));
+      return -1;
+    }
+    auto& out = *iter->second;
+    {
+      std::lock_guard<std::mutex> lock(out.lock);
+      while (!out.ring.tryWrite(msg.data(), msg.size())) {
+        // A node that doesn't run drops the messages once its ring is full, like a network would
+        if (!out.node->running.load(std::memory_order_acquire)) {
+          return -1;
+        }
+        std::this_thread::sleep_for(kFullRingWait);
+      }
+    }
+    out.node->seq.fetch_add(1);
+    if (out.node->waiting.load()) {
+      futexWake(&out.node->seq);
+    }
+    return 0;
+  }
+
+  std::set<NodeNum> send(std::set<NodeNum> dests, std::vector<uint8_t>&& msg) override {
+    std::set<NodeNum> failed;
+    for (auto dest : dests) {
+      if (send(dest, std::vector<uint8_t>(msg)) != 0) {
+        failed.insert(dest);
+      }
+    }
+    return failed;
+  }
+
+  void setReceiver(NodeNum, IReceiver* receiver) override { receiver_ = receiver; }
+
+  void restartCommunication(NodeNum) override {}
+
+ private:
+  // A ring to another node, shared by the sending threads of this node
+  struct Outgoing {
+    Outgoing(const concord::util::SpscByteRing& ring, NodeHeader* node) : ring(ring), node(node) {}
+    std::mutex lock;
+    concord::util::SpscByteRing ring;
+    NodeHeader* const node;
+  };
+
+  concord::util::SpscByteRing ringOf(RingHeader* header) const {
+    return concord::util::SpscByteRing(header->positions, header->buffer(), network_.ringBytes_);
+  }
+
+  // Delivers the messages in the incoming rings straight from the rings, returns how many
+  size_t deliverAll() {
+    size_t delivered = 0;
+    for (auto& [source, ring] : incoming_) {
+      const auto node = source;
+      delivered += ring.read([this, node](const char* message, size_t size) { deliver(node, message, size); });
+    }
+    return delivered;
+  }
+
+  void deliver(NodeNum source, const char* message, size_t size) {
+    if (!receiver_) {
+      return;
+    }
+    try {
+      receiver_->onNewMessage(source, message, size);
+    } catch (std::exception& e) {
+      LOG_ERROR(logger_, "Failed to handle a message" << KVLOG(source, size, e.what()));
+    }
+  }
+
+  void receive() {
+    auto self = network_.node(self_);
+    while (running_) {
+      if (deliverAll() > 0) {
+        continue;
+      }
+      // Senders check the flag after bumping seq: either they see it and wake us up, or we see their message
+      self->waiting.store(1);
+      const auto seq = self->seq.load();
+      if (deliverAll() == 0 && running_) {
+        futexWait(&self->seq, seq);
+      }
+      self->waiting.store(0);
+    }
+  }
+
+  logging::Logger logger_;
+  SharedMemoryNetwork& network_;
+  const size_t self_;
+  std::unordered_map<NodeNum, std::unique_ptr<Outgoing>> outgoing_;
+  std::vector<std::pair<NodeNum, concord::util::SpscByteRing>> incoming_;
+  IReceiver* receiver_ = nullptr;
+  std::atomic_bool running_{false};
+  std::thread receiver_thread_;
+};
+
+/******************************** Class SharedMemoryNetwork ********************************/
+
+SharedMemoryNetwork::SharedMemoryNetwork(const std::vector<NodeNum>& replicas,
+                                         const std::vector<NodeNum>& clients,
+                                         size_t ringBytes)
+    : ringBytes_(ringBytes) {
+  if (ringBytes_ < kCacheLine || (ringBytes_ & (ringBytes_ - 1)) != 0) {
+    throw std::invalid_argument("the bytes of a ring must be a power of two");
+  }
+  nodes_ = replicas;
+  nodes_.insert(nodes_.end(), clients.begin(), clients.end());
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (!indexes_.emplace(nodes_[i], i).second) {
+      throw std::invalid_argument("duplicate node " + std::to_string(nodes_[i]));
+    }
+  }
+
+  // The node headers, then the rings
+  memoryBytes_ = nodes_.size() * sizeof(NodeHeader);
+  ringOffsets_.resize(nodes_.size() * nodes_.size(), 0);
+  for (size_t from = 0; from < nodes_.size(); ++from) {
+    for (size_t to = 0; to < nodes_.size(); ++to) {
+      const bool connected = from != to && (from < replicas.size() || to < replicas.size());
+      if (connected) {
+        ringOffsets_[from * nodes_.size() + to] = memoryBytes_;
+        memoryBytes_ += sizeof(RingHeader) + ringBytes_;
+      }
+    }
+  }
+
+  auto memory = mmap(nullptr, memoryBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("failed to map " + std::to_string(memoryBytes_) + " bytes: " + std::strerror(errno));
+  }
+  memory_ = static_cast<char*>(memory);
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    new (node(i)) NodeHeader;
+  }
+  for (auto offset : ringOffsets_) {
+    if (offset != 0) {
+      new (memory_ + offset) RingHeader;
+    }
+  }
+}
+
+SharedMemoryNetwork::~SharedMemoryNetwork() { munmap(memory_, memoryBytes_); }
+
+std::unique_ptr<ICommunication> SharedMemoryNetwork::communicationOf(NodeNum node) {
+  auto iter = indexes_.find(node);
+  if (iter == indexes_.end()) {
+    throw std::invalid_argument("unknown node " + std::to_string(node));
+  }
+  return std::make_unique<Communication>(*this, iter->second);
+}
+
+SharedMemoryNetwork::RingHeader* SharedMemoryNetwork::ring(size_t from, size_t to) const {
+  const auto offset = ringOffsets_[from * nodes_.size() + to];
+  return offset == 0 ? nullptr : reinterpret_cast<RingHeader*>(memory_ + offset);
+}
+
+SharedMemoryNetwork::NodeHeader* SharedMemoryNetwork::node(size_t index) const {
+  return reinterpret_cast<NodeHeader*>(memory_) + index;
+}
+
+}  // namespace bft::communication
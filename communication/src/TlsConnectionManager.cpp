@@ -32,6 +32,8 @@ ConnectionManager::ConnectionManager(const TlsTcpConfig& config, asio::io_contex
       acceptor_(io_context_),
       resolver_(io_context_),
       connect_timer_(io_context_),
+      receive_buffers_(std::make_shared<concordUtil::SlabAllocator>(
+          "tls_receive_buffers" + std::to_string(config.selfId_), config.bufferLength_, std::chrono::seconds(0))),
       status_(std::make_shared<TlsStatus>()),
       histograms_(Recorders(std::to_string(config.selfId_), config.bufferLength_, MAX_QUEUE_SIZE_IN_BYTES)) {
   auto& registrar = concord::diagnostics::RegistrarSingleton::getInstance();
@@ -106,6 +108,7 @@ void ConnectionManager::startConnectTimer() {
       return;
     }
     connect();
+    receive_buffers_->trim();
     startConnectTimer();
   }));
 }  // namespace bft::communication::tls
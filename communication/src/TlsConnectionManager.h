@@ -15,6 +15,7 @@
 
 #include "communication/CommDefs.hpp"
 #include "Logger.hpp"
+#include "SlabAllocator.hpp"
 #include "TlsWriteQueue.h"
 
 #pragma once
@@ -45,6 +46,9 @@ class ConnectionManager {
   void send(const NodeNum destination, const std::shared_ptr<OutgoingMsg> &msg);
   void send(const std::set<NodeNum> &destinations, const std::shared_ptr<OutgoingMsg> &msg);
   int getMaxMessageSize() const;
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator> &aggregator) {
+    receive_buffers_->setAggregator(aggregator);
+  }
 
  private:
   void start();
@@ -150,6 +154,10 @@ class ConnectionManager {
   // Active, secured connections.
   std::unordered_map<NodeNum, std::shared_ptr<AsyncTlsConnection>> connections_;
 
+  // Buffers of the messages being read, sized to each message. Shared with the connections, that may outlive this
+  // object while their handlers are pending. Trimmed on the connect timer rather than by a thread of its own.
+  std::shared_ptr<concordUtil::SlabAllocator> receive_buffers_;
+
   // Diagnostics
   std::shared_ptr<TlsStatus> status_;
   Recorders histograms_;
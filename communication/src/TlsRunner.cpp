@@ -10,6 +10,7 @@
 // subcomponent's license, as noted in the LICENSE file.
 
 #include "assertUtils.hpp"
+#include "ThreadPlacement.hpp"
 #include "TlsRunner.h"
 
 namespace bft::communication::tls {
@@ -35,7 +36,10 @@ void Runner::start() {
 
   // Run the io_context in the thread pool
   for (std::size_t i = 0; i < num_threads_; i++) {
-    io_threads_.emplace_back([this]() { io_context_.run(); });
+    io_threads_.emplace_back([this]() {
+      concord::util::ThreadPlacement::instance().place(concord::util::ThreadPlacement::Role::Comm);
+      io_context_.run();
+    });
   }
 }
 
@@ -34,6 +34,9 @@ class Runner {
   void setReceiver(NodeNum id, IReceiver* receiver) { connectionManager_.setReceiver(id, receiver); }
   void send(NodeNum destNode, std::shared_ptr<tls::OutgoingMsg> msg) { connectionManager_.send(destNode, msg); }
   void send(std::set<NodeNum> dests, std::shared_ptr<tls::OutgoingMsg> msg) { connectionManager_.send(dests, msg); }
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator) {
+    connectionManager_.setAggregator(aggregator);
+  }
 
  private:
   logging::Logger logger_;
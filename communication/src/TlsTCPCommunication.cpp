@@ -72,4 +72,8 @@ void TlsTCPCommunication::restartCommunication(NodeNum i) {
     runner_->start();
   }
 }
+
+void TlsTCPCommunication::setAggregator(const std::shared_ptr<concordMetrics::Aggregator> &aggregator) {
+  runner_->setAggregator(aggregator);
+}
 }  // namespace bft::communication
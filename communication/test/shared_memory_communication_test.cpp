@@ -0,0 +1,183 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "communication/SharedMemoryCommunication.hpp"
+
+using namespace bft::communication;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr NodeNum kReplica = 0;
+constexpr NodeNum kOtherReplica = 1;
+constexpr NodeNum kClient = 2;
+constexpr NodeNum kOtherClient = 3;
+
+class RecordingReceiver : public IReceiver {
+ public:
+  void onNewMessage(NodeNum sourceNode, const char* const message, size_t messageLength) override {
+    std::lock_guard<std::mutex> lock(mutex);
+    received.emplace_back(sourceNode, std::string(message, messageLength));
+    cond.notify_all();
+  }
+  void onConnectionStatusChanged(NodeNum, ConnectionStatus) override {}
+
+  std::vector<std::pair<NodeNum, std::string>> waitFor(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait_for(lock, 10s, [this, count]() { return received.size() >= count; });
+    return received;
+  }
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::vector<std::pair<NodeNum, std::string>> received;
+};
+
+std::vector<uint8_t> message(const std::string& s) { return std::vector<uint8_t>(s.begin(), s.end()); }
+
+TEST(shared_memory_communication, messages_of_a_node_are_delivered_in_order) {
+  SharedMemoryNetwork network{{kReplica, kOtherReplica}, {kClient}, 4096};
+  auto replica = network.communicationOf(kReplica);
+  RecordingReceiver receiver;
+  replica->setReceiver(kReplica, &receiver);
+  ASSERT_EQ(0, replica->start());
+
+  // Many more bytes than the ring, from two senders
+  const size_t num_messages = 10000;
+  std::vector<std::thread> senders;
+  for (auto node : {kOtherReplica, kClient}) {
+    senders.emplace_back([&network, node]() {
+      auto comm = network.communicationOf(node);
+      comm->start();
+      for (size_t i = 0; i < num_messages; ++i) {
+        ASSERT_EQ(0, comm->send(kReplica, message(std::string(i % 100, 'x') + std::to_string(i))));
+      }
+      comm->stop();
+    });
+  }
+  for (auto& sender : senders) {
+    sender.join();
+  }
+  auto received = receiver.waitFor(2 * num_messages);
+  replica->stop();
+
+  ASSERT_EQ(2 * num_messages, received.size());
+  std::map<NodeNum, size_t> next;
+  for (const auto& [source, msg] : received) {
+    const auto i = next[source]++;
+    ASSERT_EQ(std::string(i % 100, 'x') + std::to_string(i), msg);
+  }
+}
+
+TEST(shared_memory_communication, connections) {
+  SharedMemoryNetwork network{{kReplica, kOtherReplica}, {kClient, kOtherClient}, 4096};
+  auto replica = network.communicationOf(kReplica);
+  auto other_replica = network.communicationOf(kOtherReplica);
+  auto client = network.communicationOf(kClient);
+
+  ASSERT_EQ(ConnectionStatus::Disconnected, client->getCurrentConnectionStatus(kReplica));
+  replica->start();
+  ASSERT_EQ(ConnectionStatus::Connected, client->getCurrentConnectionStatus(kReplica));
+  ASSERT_EQ(ConnectionStatus::Connected, other_replica->getCurrentConnectionStatus(kReplica));
+  // Clients aren't connected to each other
+  ASSERT_EQ(ConnectionStatus::Unknown, client->getCurrentConnectionStatus(kOtherClient));
+  ASSERT_NE(0, client->send(kOtherClient, message("hello")));
+  ASSERT_EQ((std::set<NodeNum>{kOtherClient}), client->send({kReplica, kOtherClient}, message("hello")));
+
+  ASSERT_NE(0, client->send(kReplica, std::vector<uint8_t>(network.maxMessageSize() + 1)));
+  ASSERT_EQ(0, client->send(kReplica, std::vector<uint8_t>(network.maxMessageSize())));
+  replica->stop();
+  ASSERT_EQ(ConnectionStatus::Disconnected, client->getCurrentConnectionStatus(kReplica));
+
+  // Sends to a stopped node fail once its ring is full
+  int result = 0;
+  for (size_t i = 0; i < 1000 && result == 0; ++i) {
+    result = client->send(kReplica, message("hello"));
+  }
+  ASSERT_NE(0, result);
+}
+
+TEST(shared_memory_communication, forked_processes) {
+  SharedMemoryNetwork network{{kReplica, kOtherReplica}, {}};
+  const size_t num_messages = 1000;
+  const auto child = fork();
+  ASSERT_NE(-1, child);
+  if (child == 0) {
+    // Echoes the messages of the parent
+    class Echo : public IReceiver {
+     public:
+      void onNewMessage(NodeNum sourceNode, const char* const message, size_t messageLength) override {
+        comm->send(sourceNode, std::vector<uint8_t>(message, message + messageLength));
+        if (++received == num_messages) done = true;
+      }
+      void onConnectionStatusChanged(NodeNum, ConnectionStatus) override {}
+      ICommunication* comm = nullptr;
+      size_t received = 0;
+      std::atomic_bool done{false};
+    } echo;
+    auto comm = network.communicationOf(kOtherReplica);
+    echo.comm = comm.get();
+    comm->setReceiver(kOtherReplica, &echo);
+    comm->start();
+    while (!echo.done) std::this_thread::sleep_for(1ms);
+    comm->stop();
+    _exit(0);
+  }
+
+  auto comm = network.communicationOf(kReplica);
+  RecordingReceiver receiver;
+  comm->setReceiver(kReplica, &receiver);
+  comm->start();
+  while (comm->getCurrentConnectionStatus(kOtherReplica) != ConnectionStatus::Connected) {
+    std::this_thread::sleep_for(1ms);
+  }
+  for (size_t i = 0; i < num_messages; ++i) {
+    ASSERT_EQ(0, comm->send(kOtherReplica, message(std::to_string(i))));
+  }
+  const auto received = receiver.waitFor(num_messages);
+  comm->stop();
+  int status = 0;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  ASSERT_EQ(num_messages, received.size());
+  for (size_t i = 0; i < num_messages; ++i) {
+    ASSERT_EQ(std::make_pair(kOtherReplica, std::to_string(i)), received[i]);
+  }
+}
+
+TEST(shared_memory_communication, invalid_networks) {
+  ASSERT_THROW(SharedMemoryNetwork({kReplica, kOtherReplica}, {}, 1000), std::invalid_argument);
+  ASSERT_THROW(SharedMemoryNetwork({kReplica, kReplica}, {}), std::invalid_argument);
+  SharedMemoryNetwork network{{kReplica}, {kClient}};
+  ASSERT_THROW(network.communicationOf(kOtherClient), std::invalid_argument);
+}
+
+}  // namespace
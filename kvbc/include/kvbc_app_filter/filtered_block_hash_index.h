@@ -0,0 +1,99 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+//
+// Index of the filtered update hashes of consecutive blocks, for a single
+// client id.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "kv_types.hpp"
+#include "sha_hash.hpp"
+
+namespace concord {
+namespace kvbc {
+
+// Keeps the filtered update hash (see KvbAppFilter::hashUpdate) of every block
+// in [firstBlockId(), lastBlockId()] so that the hash of a block range doesn't
+// require reading and filtering the blocks again. The range hash is the
+// SHA-256 of the concatenated block hashes; for ranges starting at the origin
+// (the first block added) it is resumed from a running digest checkpointed
+// every kCheckpointInterval blocks, hence costs a map lookup plus at most
+// kCheckpointInterval block hashes.
+//
+// The hashes are stored in segments of kCheckpointInterval blocks, which end
+// at a checkpoint. Pruning drops whole segments but keeps the digests, hence
+// range hashes from the origin can still be served afterwards.
+//
+// Blocks have to be added in order and without gaps. Thread safe.
+class FilteredBlockHashIndex {
+ public:
+  static constexpr BlockId kCheckpointInterval = 1024;
+
+  FilteredBlockHashIndex() = default;
+  FilteredBlockHashIndex(const FilteredBlockHashIndex&) = delete;
+  FilteredBlockHashIndex& operator=(const FilteredBlockHashIndex&) = delete;
+
+  // Add the hash of the next block. The first block added can be any block.
+  // Return false (and ignore the hash) if block_id isn't the next block.
+  bool append(BlockId block_id, const std::string& hash);
+
+  // Drop the hashes of the segments which end before the given block id, e.g.
+  // after the blockchain was pruned. Costs O(1) per dropped segment.
+  void prune(BlockId until);
+
+  std::optional<std::string> blockHash(BlockId block_id) const;
+
+  // SHA-256 of the concatenated hashes of the blocks in [start, end] or
+  // std::nullopt if some of these blocks aren't indexed. The blocks before
+  // firstBlockId() only need to be indexed if start is the origin.
+  std::optional<std::string> rangeHash(BlockId start, BlockId end) const;
+
+  bool empty() const;
+  // Only valid if the index isn't empty
+  BlockId originBlockId() const;
+  BlockId firstBlockId() const;
+  BlockId lastBlockId() const;
+
+ private:
+  bool isIndexed(BlockId block_id) const { return block_id >= first_ && block_id < end_; }
+  const char* hashAt(BlockId block_id) const;
+  // Update the digest with the hashes of [start, end], which are indexed
+  void hashRange(concord::util::SHA2_256& digest, BlockId start, BlockId end) const;
+
+  static constexpr size_t kHashSize = 32;
+  static constexpr size_t kSegmentSize = kCheckpointInterval * kHashSize;
+
+  mutable std::mutex mutex_;
+  BlockId origin_{0};
+  BlockId first_{0};
+  // One past the last block
+  BlockId end_{0};
+  // The hashes of [first_, end_ - 1], kHashSize bytes each and kSegmentSize
+  // bytes per segment. The first block of a segment is kCheckpointInterval
+  // aligned to the origin.
+  std::deque<std::string> segments_;
+  // Digest of the hashes of [origin_, end_ - 1]
+  std::optional<concord::util::SHA2_256> running_digest_;
+  // Block id -> digest of the hashes of [origin_, block id], from first_ - 1 on
+  std::map<BlockId, concord::util::SHA2_256> checkpoints_;
+};
+
+}  // namespace kvbc
+}  // namespace concord
@@ -29,6 +29,7 @@
 #include "categorization/db_categories.h"
 #include "kv_types.hpp"
 #include "event_group_msgs.cmf.hpp"
+#include "kvbc_app_filter/filtered_block_hash_index.h"
 #include "endianness.hpp"
 
 namespace concord {
@@ -171,6 +172,13 @@ class KvbAppFilter {
     }
   }
 
+  // The client id the key-value pairs and events are filtered for
+  const std::string &getClientId() const { return client_id_; }
+
+  // Use and extend the given index of filtered block hashes when reading block
+  // hashes. The index has to belong to the same client id.
+  void setBlockHashIndex(std::shared_ptr<FilteredBlockHashIndex> index) { block_hash_index_ = std::move(index); }
+
   // Filter legacy events
   KvbFilteredUpdate filterUpdate(const KvbUpdate &update);
 
@@ -183,6 +191,10 @@ class KvbAppFilter {
   std::string hashUpdate(const KvbFilteredUpdate &update);
   std::string hashEventGroupUpdate(const KvbFilteredEventGroupUpdate &update);
 
+  // Read the given block's events and filter them. Thread safe, hence blocks
+  // can be read concurrently.
+  KvbFilteredUpdate readFilteredBlock(kvbc::BlockId block_id);
+
   // Return all key-value pairs from the KVB in the block range [earliest block
   // available, given block_id] with the following conditions:
   //   * The key-value pair is part of a block
@@ -240,9 +252,13 @@ class KvbAppFilter {
   std::optional<BlockId> getOldestEventGroupBlockId();
 
  private:
+  std::string computeBlockHash(kvbc::BlockId block_id);
+  std::optional<std::string> readIndexedBlockRangeHash(kvbc::BlockId start, kvbc::BlockId end);
+
   logging::Logger logger_;
   const concord::kvbc::IReader *rostorage_;
   const std::string client_id_;
+  std::shared_ptr<FilteredBlockHashIndex> block_hash_index_;
   static inline const std::string kGlobalEgIdKeyOldest{"_global_eg_id_oldest"};
   static inline const std::string kPublicEgIdKeyOldest{"_public_eg_id_oldest"};
   static inline const std::string kPublicEgIdKeyNewest{"_public_eg_id_newest"};
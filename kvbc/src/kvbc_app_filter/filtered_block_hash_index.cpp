@@ -0,0 +1,145 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "kvbc_app_filter/filtered_block_hash_index.h"
+
+#include <algorithm>
+
+#include "assertUtils.hpp"
+
+using concord::util::SHA2_256;
+using std::optional;
+using std::string;
+
+namespace concord {
+namespace kvbc {
+
+namespace {
+string toString(const SHA2_256::Digest& digest) {
+  return string(reinterpret_cast<const char*>(digest.data()), digest.size());
+}
+}  // namespace
+
+bool FilteredBlockHashIndex::append(BlockId block_id, const string& hash) {
+  ConcordAssertEQ(hash.size(), kHashSize);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_digest_) {
+    origin_ = block_id;
+    first_ = block_id;
+    end_ = block_id;
+    running_digest_.emplace();
+    running_digest_->init();
+  } else if (block_id != end_) {
+    return false;
+  }
+  if (segments_.empty() || segments_.back().size() == kSegmentSize) {
+    segments_.emplace_back();
+    segments_.back().reserve(kSegmentSize);
+  }
+  segments_.back().append(hash);
+  running_digest_->update(hash.data(), kHashSize);
+  if ((++end_ - origin_) % kCheckpointInterval == 0) {
+    checkpoints_.emplace(block_id, running_digest_->clone());
+  }
+  return true;
+}
+
+// The digests are relative to the origin and hence, stay valid. Only the
+// checkpoint before the first kept block is needed to resume from.
+void FilteredBlockHashIndex::prune(BlockId until) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const auto first = first_;
+  while (!segments_.empty() && segments_.front().size() == kSegmentSize && first_ + kCheckpointInterval <= until) {
+    segments_.pop_front();
+    first_ += kCheckpointInterval;
+  }
+  if (first_ != first) {
+    checkpoints_.erase(checkpoints_.begin(), checkpoints_.find(first_ - 1));
+  }
+}
+
+const char* FilteredBlockHashIndex::hashAt(BlockId block_id) const {
+  const auto offset = block_id - first_;
+  return segments_[offset / kCheckpointInterval].data() + (offset % kCheckpointInterval) * kHashSize;
+}
+
+void FilteredBlockHashIndex::hashRange(SHA2_256& digest, BlockId start, BlockId end) const {
+  while (start <= end) {
+    // Up to the end of the segment
+    const auto segment_end = std::min(end, start + kCheckpointInterval - 1 - (start - first_) % kCheckpointInterval);
+    digest.update(hashAt(start), (segment_end + 1 - start) * kHashSize);
+    start = segment_end + 1;
+  }
+}
+
+optional<string> FilteredBlockHashIndex::blockHash(BlockId block_id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!isIndexed(block_id)) {
+    return std::nullopt;
+  }
+  return string(hashAt(block_id), kHashSize);
+}
+
+optional<string> FilteredBlockHashIndex::rangeHash(BlockId start, BlockId end) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_digest_ || start > end) {
+    return std::nullopt;
+  }
+  if (start == origin_ && end == end_ - 1) {
+    return toString(running_digest_->clone().finish());
+  }
+  if (!isIndexed(end) || (start != origin_ && !isIndexed(start))) {
+    return std::nullopt;
+  }
+
+  // Resume from the closest checkpoint if the range starts at the origin
+  auto from = start;
+  optional<SHA2_256> digest;
+  if (start == origin_) {
+    auto checkpoint = checkpoints_.upper_bound(end);
+    if (checkpoint != checkpoints_.begin()) {
+      --checkpoint;
+      digest.emplace(checkpoint->second.clone());
+      from = checkpoint->first + 1;
+    }
+  }
+  if (!digest) {
+    digest.emplace();
+    digest->init();
+  }
+  hashRange(*digest, from, end);
+  return toString(digest->finish());
+}
+
+bool FilteredBlockHashIndex::empty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return !running_digest_;
+}
+
+BlockId FilteredBlockHashIndex::originBlockId() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return origin_;
+}
+
+BlockId FilteredBlockHashIndex::firstBlockId() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return first_;
+}
+
+BlockId FilteredBlockHashIndex::lastBlockId() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return end_ - 1;
+}
+
+}  // namespace kvbc
+}  // namespace concord
@@ -241,6 +241,17 @@ string KvbAppFilter::hashEventGroupUpdate(const KvbFilteredEventGroupUpdate &upd
   return computeSHA256Hash(concatenated_entry_hashes);
 }
 
+KvbFilteredUpdate KvbAppFilter::readFilteredBlock(BlockId block_id) {
+  std::string cid;
+  auto events = getBlockEvents(block_id, cid);
+  if (!events) {
+    std::stringstream msg;
+    msg << "Couldn't retrieve block events for block id " << block_id;
+    throw KvbReadError(msg.str());
+  }
+  return KvbFilteredUpdate{block_id, cid, filterKeyValuePairs(*events)};
+}
+
 void KvbAppFilter::readBlockRange(BlockId block_id_start,
                                   BlockId block_id_end,
                                   spsc_queue<KvbFilteredUpdate> &queue_out,
@@ -254,14 +265,7 @@ void KvbAppFilter::readBlockRange(BlockId block_id_start,
   LOG_DEBUG(logger_, "readBlockRange block " << block_id << " to " << block_id_end);
 
   for (; block_id <= block_id_end; ++block_id) {
-    std::string cid;
-    auto events = getBlockEvents(block_id, cid);
-    if (!events) {
-      std::stringstream msg;
-      msg << "Couldn't retrieve block events for block id " << block_id;
-      throw KvbReadError(msg.str());
-    }
-    KvbFilteredUpdate update{block_id, cid, filterKeyValuePairs(*events)};
+    auto update = readFilteredBlock(block_id);
     while (!stop_execution) {
       if (queue_out.push(update)) {
         break;
@@ -570,18 +574,24 @@ string KvbAppFilter::readBlockHash(BlockId block_id) {
   if (block_id > rostorage_->getLastBlockId()) {
     throw InvalidBlockRange(block_id, block_id);
   }
+  if (!block_hash_index_) {
+    return computeBlockHash(block_id);
+  }
 
-  std::string cid;
-  auto events = getBlockEvents(block_id, cid);
-  if (!events) {
-    std::stringstream msg;
-    msg << "Couldn't retrieve block events for block id " << block_id;
-    throw KvbReadError(msg.str());
+  if (auto hash = block_hash_index_->blockHash(block_id)) {
+    return *hash;
+  }
+  auto hash = computeBlockHash(block_id);
+  // The index is seeded by readBlockRangeHash() only, from the start of the
+  // blockchain. Here, it is just extended if this is the next block.
+  if (!block_hash_index_->empty()) {
+    block_hash_index_->append(block_id, hash);
   }
-  KvbFilteredUpdate filtered_update{block_id, cid, filterKeyValuePairs(*events)};
-  return hashUpdate(filtered_update);
+  return hash;
 }
 
+string KvbAppFilter::computeBlockHash(BlockId block_id) { return hashUpdate(readFilteredBlock(block_id)); }
+
 string KvbAppFilter::readEventGroupHash(EventGroupId requested_event_group_id) {
   if (requested_event_group_id == 0) {
     throw InvalidEventGroupId(requested_event_group_id);
@@ -648,6 +658,11 @@ string KvbAppFilter::readBlockRangeHash(BlockId block_id_start, BlockId block_id
   if (block_id_start > block_id_end || block_id_end > rostorage_->getLastBlockId()) {
     throw InvalidBlockRange(block_id_start, block_id_end);
   }
+  if (block_hash_index_) {
+    if (auto hash = readIndexedBlockRangeHash(block_id_start, block_id_end)) {
+      return *hash;
+    }
+  }
   BlockId block_id(block_id_start);
 
   LOG_DEBUG(logger_, "readBlockRangeHash block " << block_id << " to " << block_id_end);
@@ -668,6 +683,24 @@ string KvbAppFilter::readBlockRangeHash(BlockId block_id_start, BlockId block_id
   return computeSHA256Hash(concatenated_update_hashes);
 }
 
+// Only the blocks that aren't indexed yet are read and filtered. Return
+// std::nullopt if the index cannot serve the range, i.e. the range starts
+// before the first indexed block and not at the origin of the index.
+optional<string> KvbAppFilter::readIndexedBlockRangeHash(BlockId block_id_start, BlockId block_id_end) {
+  block_hash_index_->prune(rostorage_->getGenesisBlockId());
+  if (!block_hash_index_->empty() && block_hash_index_->firstBlockId() > block_id_start &&
+      block_hash_index_->originBlockId() != block_id_start) {
+    return std::nullopt;
+  }
+
+  auto block_id = block_hash_index_->empty() ? block_id_start : block_hash_index_->lastBlockId() + 1;
+  LOG_DEBUG(logger_, "readBlockRangeHash indexing block " << block_id << " to " << block_id_end);
+  for (; block_id <= block_id_end; ++block_id) {
+    block_hash_index_->append(block_id, computeBlockHash(block_id));
+  }
+  return block_hash_index_->rangeHash(block_id_start, block_id_end);
+}
+
 string KvbAppFilter::readEventGroupRangeHash(EventGroupId event_group_id_start) {
   uint64_t public_start = getValueFromLatestTable(kPublicEgIdKeyOldest);
   uint64_t public_end = getValueFromLatestTable(kPublicEgIdKeyNewest);
@@ -44,6 +44,7 @@ using concord::kvbc::BlockId;
 using concord::kvbc::EgUpdate;
 using concord::kvbc::EventGroupId;
 using concord::kvbc::EventGroupClientState;
+using concord::kvbc::FilteredBlockHashIndex;
 using concord::kvbc::InvalidBlockRange;
 using concord::kvbc::InvalidEventGroupRange;
 using concord::kvbc::KvbAppFilter;
@@ -723,6 +724,107 @@ TEST(kvbc_filter_test, kvbfilter_success_hash_of_block) {
   EXPECT_EQ(hash_value, computeSHA256Hash(concatenated_entry_hashes));
 }
 
+TEST(kvbc_filter_test, filtered_block_hash_index) {
+  FilteredBlockHashIndex index;
+  ASSERT_TRUE(index.empty());
+  const BlockId last_block_id = 2 * FilteredBlockHashIndex::kCheckpointInterval + 500;
+  std::vector<std::string> hashes;
+  for (BlockId i = 0; i <= last_block_id; ++i) {
+    hashes.push_back(computeSHA256Hash(std::to_string(i)));
+    ASSERT_TRUE(index.append(i, hashes.back()));
+  }
+  ASSERT_FALSE(index.append(last_block_id, hashes.back()));
+  ASSERT_FALSE(index.append(last_block_id + 2, hashes.back()));
+  ASSERT_EQ(index.firstBlockId(), BlockId{0});
+  ASSERT_EQ(index.lastBlockId(), last_block_id);
+
+  auto expected_range_hash = [&](BlockId start, BlockId end) {
+    std::string concatenated_update_hashes;
+    for (auto i = start; i <= end; ++i) {
+      concatenated_update_hashes += hashes.at(i);
+    }
+    return computeSHA256Hash(concatenated_update_hashes);
+  };
+  const auto interval = FilteredBlockHashIndex::kCheckpointInterval;
+  for (auto end : {BlockId{0}, interval - 2, interval - 1, interval, 2 * interval + 17, last_block_id}) {
+    ASSERT_EQ(index.rangeHash(0, end), expected_range_hash(0, end));
+  }
+  ASSERT_EQ(index.rangeHash(5, 2 * interval), expected_range_hash(5, 2 * interval));
+  ASSERT_EQ(index.blockHash(42), hashes.at(42));
+  ASSERT_FALSE(index.rangeHash(0, last_block_id + 1).has_value());
+  ASSERT_FALSE(index.rangeHash(10, 5).has_value());
+
+  // Pruning drops whole segments and range hashes from the origin are still served
+  const BlockId pruned_until = interval + 100;
+  index.prune(pruned_until);
+  ASSERT_EQ(index.originBlockId(), BlockId{0});
+  ASSERT_EQ(index.firstBlockId(), interval);
+  ASSERT_FALSE(index.blockHash(interval - 1).has_value());
+  ASSERT_EQ(index.blockHash(interval), hashes.at(interval));
+  ASSERT_FALSE(index.rangeHash(0, interval - 2).has_value());
+  ASSERT_FALSE(index.rangeHash(5, last_block_id).has_value());
+  for (auto end : {interval, pruned_until, 2 * interval - 1, 2 * interval + 17, last_block_id}) {
+    ASSERT_EQ(index.rangeHash(0, end), expected_range_hash(0, end));
+    ASSERT_EQ(index.rangeHash(interval, end), expected_range_hash(interval, end));
+  }
+  // Across a segment boundary
+  ASSERT_EQ(index.rangeHash(pruned_until, 2 * interval + 17), expected_range_hash(pruned_until, 2 * interval + 17));
+
+  // The segment being filled is kept
+  index.prune(last_block_id + 1);
+  ASSERT_EQ(index.firstBlockId(), 2 * interval);
+  ASSERT_EQ(index.lastBlockId(), last_block_id);
+
+  // Once it's full, it can be dropped too
+  for (auto i = last_block_id + 1; i < 3 * interval; ++i) {
+    hashes.push_back(computeSHA256Hash(std::to_string(i)));
+    ASSERT_TRUE(index.append(i, hashes.back()));
+  }
+  index.prune(3 * interval);
+  ASSERT_FALSE(index.empty());
+  ASSERT_EQ(index.firstBlockId(), 3 * interval);
+  ASSERT_FALSE(index.blockHash(3 * interval - 1).has_value());
+  ASSERT_EQ(index.rangeHash(0, 3 * interval - 1), expected_range_hash(0, 3 * interval - 1));
+  hashes.push_back(computeSHA256Hash(std::to_string(3 * interval)));
+  ASSERT_TRUE(index.append(3 * interval, hashes.back()));
+  ASSERT_EQ(index.rangeHash(0, 3 * interval), expected_range_hash(0, 3 * interval));
+  ASSERT_EQ(index.rangeHash(3 * interval, 3 * interval), expected_range_hash(3 * interval, 3 * interval));
+}
+
+TEST(kvbc_filter_test, kvbfilter_hash_of_blocks_in_range_with_index) {
+  class PrunableStorage : public FakeStorage {
+   public:
+    BlockId getGenesisBlockId() const override { return genesis_block_id_; }
+    BlockId genesis_block_id_{0};
+  };
+  PrunableStorage storage;
+  storage.fillWithData(kLastBlockId);
+  const std::string client_id{"1"};
+  auto reference_filter = KvbAppFilter(&storage, client_id);
+  auto index = std::make_shared<FilteredBlockHashIndex>();
+  auto kvb_filter = KvbAppFilter(&storage, client_id);
+  kvb_filter.setBlockHashIndex(index);
+
+  for (auto block_id_end : {BlockId{10}, BlockId{5}, kLastBlockId}) {
+    EXPECT_EQ(kvb_filter.readBlockRangeHash(0, block_id_end), reference_filter.readBlockRangeHash(0, block_id_end));
+    EXPECT_EQ(kvb_filter.readBlockRangeHash(3, block_id_end), reference_filter.readBlockRangeHash(3, block_id_end));
+  }
+  EXPECT_EQ(index->firstBlockId(), BlockId{0});
+  EXPECT_EQ(index->lastBlockId(), kLastBlockId);
+
+  // Another filter for the same client reuses the index
+  auto other_filter = KvbAppFilter(&storage, client_id);
+  other_filter.setBlockHashIndex(index);
+  EXPECT_EQ(other_filter.readBlockHash(7), reference_filter.readBlockHash(7));
+  EXPECT_EQ(other_filter.readBlockRangeHash(0, 100), reference_filter.readBlockRangeHash(0, 100));
+
+  // The index is pruned together with the blockchain, the first segment isn't complete yet
+  storage.genesis_block_id_ = 20;
+  EXPECT_EQ(kvb_filter.readBlockRangeHash(20, 100), reference_filter.readBlockRangeHash(20, 100));
+  EXPECT_EQ(kvb_filter.readBlockRangeHash(0, 100), reference_filter.readBlockRangeHash(0, 100));
+  EXPECT_EQ(index->firstBlockId(), BlockId{0});
+}
+
 TEST(kvbc_filter_test, kvbfilter_success_hash_of_event_group) {
   FakeStorage storage;
   std::string client_id("trid_1");
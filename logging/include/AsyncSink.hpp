@@ -0,0 +1,203 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace logging {
+
+/**
+ * What a thread logging into a full ring does
+ */
+enum class OverflowPolicy {
+  drop,  // the record is dropped and counted
+  block  // the thread waits until the sink has drained the ring
+};
+
+struct AsyncSinkConfig {
+  // The bytes of the ring of every logging thread, a power of two. Records larger than a quarter of it are dropped.
+  size_t ring_bytes = 256 * 1024;
+  OverflowPolicy overflow_policy = OverflowPolicy::drop;
+  // How long the sink sleeps when the rings are empty
+  std::chrono::milliseconds drain_interval{10};
+};
+
+struct AsyncSinkStats {
+  uint64_t written = 0;
+  uint64_t dropped = 0;
+  // The rings of the threads that logged, kept until their thread exits and they are drained
+  uint64_t rings = 0;
+};
+
+/**
+ * A sink of preformatted records, written asynchronously by a background thread.
+ *
+ * Every thread pushes its records into a ring of its own, so pushing takes no lock and doesn't wait for the writer
+ * unless the ring is full and the policy is to block. The background thread drains the rings of all threads, in the
+ * order of each thread, calls the writer for every record, and the flusher after every batch.
+ */
+class AsyncSink {
+ public:
+  using Writer = std::function<void(const char* data, size_t size)>;
+  using Flusher = std::function<void()>;
+
+  // Starts the sink right away
+  AsyncSink(const AsyncSinkConfig& config, Writer writer, Flusher flusher = nullptr);
+  // Stops the sink
+  ~AsyncSink();
+
+  AsyncSink(const AsyncSink&) = delete;
+  AsyncSink& operator=(const AsyncSink&) = delete;
+
+  /**
+   * push a record from the calling thread
+   * @return whether the record will be written, false if it's dropped
+   */
+  bool push(const char* data, size_t size);
+  /**
+   * wait until the records pushed before the call are written and flushed
+   */
+  void flush();
+  /**
+   * restarts a stopped sink
+   */
+  void start();
+  /**
+   * writes the remaining records and stops the background thread. Records pushed afterwards are dropped.
+   */
+  void stop();
+  AsyncSinkStats getStats() const;
+  const AsyncSinkConfig& getConfig() const { return config_; }
+
+ private:
+  class Ring;
+
+  Ring& threadRing();
+  bool waitForRoom(Ring& ring, const char* data, size_t size);
+  void loop();
+  size_t drainAll();
+  void drop();
+
+  const AsyncSinkConfig config_;
+  const Writer writer_;
+  const Flusher flusher_;
+  // Tells apart the sinks in the rings cached by a thread
+  const uint64_t id_;
+
+  std::mutex lock_;
+  std::condition_variable wakeup_;
+  std::condition_variable flushed_cond_;
+  std::vector<std::shared_ptr<Ring>> rings_;
+  uint64_t rings_version_ = 0;
+  uint64_t flush_requests_ = 0;
+  uint64_t flushed_ = 0;
+  std::atomic_bool running_{false};
+  // The copy of rings_ drained by the background thread
+  std::vector<std::shared_ptr<Ring>> drained_rings_;
+  uint64_t drained_rings_version_ = UINT64_MAX;
+
+  std::atomic_uint64_t written_{0};
+  std::atomic_uint64_t dropped_{0};
+  std::atomic_uint64_t num_rings_{0};
+  std::thread thread_;
+};
+
+/**
+ * An output stream into a growing buffer. Cleared and reused, it formats records without allocating memory.
+ */
+class RecordStream : public std::ostream {
+ public:
+  RecordStream() : std::ostream(&buffer_) {}
+  // Clears the buffer and resets the formatting flags left by the previous record
+  void clear();
+  const char* data() const { return buffer_.data(); }
+  size_t size() const { return buffer_.size(); }
+
+ private:
+  class Buffer : public std::streambuf {
+   public:
+    Buffer() { grow(kInitialCapacity); }
+    const char* data() const { return pbase(); }
+    size_t size() const { return pptr() - pbase(); }
+    void clear() { setp(storage_.data(), storage_.data() + storage_.size()); }
+
+   protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+   private:
+    static constexpr size_t kInitialCapacity = 512;
+    void grow(size_t capacity);
+    std::vector<char> storage_;
+  };
+
+  Buffer buffer_;
+};
+
+namespace detail {
+extern std::atomic_bool async_logging;
+// Implemented by the native logging backend, called from the thread of the sink
+void writeAsyncRecord(const char* data, size_t size);
+void flushAsyncRecords();
+}  // namespace detail
+
+/**
+ * Routes the records of the LOG_* macros through an AsyncSink writing to the configured appenders. The stats are of
+ * the sink of the current configuration.
+ */
+void startAsyncLogging(const AsyncSinkConfig& config = AsyncSinkConfig{});
+/**
+ * Writes the remaining records and returns the LOG_* macros to synchronous logging. Records logged concurrently with
+ * the call may be dropped.
+ */
+void stopAsyncLogging();
+void flushAsyncLogging();
+AsyncSinkStats getAsyncLoggingStats();
+
+inline bool isAsyncLogging() { return detail::async_logging.load(std::memory_order_relaxed); }
+
+/**
+ * A record formatted into a stream of the calling thread. The streams are reused, one per nesting level, so a record
+ * logged while formatting another one, e.g. by a function called in the streamed expression, gets a stream of its own.
+ */
+class AsyncRecord {
+ public:
+  AsyncRecord();
+  ~AsyncRecord();
+
+  AsyncRecord(const AsyncRecord&) = delete;
+  AsyncRecord& operator=(const AsyncRecord&) = delete;
+
+  RecordStream& stream() { return stream_; }
+  /**
+   * Pushes the record to the sink
+   * @param flush - whether to wait until the record is written, e.g. before a crash
+   */
+  void commit(bool flush);
+
+ private:
+  RecordStream& stream_;
+};
+
+}  // namespace logging
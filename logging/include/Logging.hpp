@@ -14,10 +14,13 @@
 
 #include <string>
 #include <sys/time.h>
+#include <ctime>
 #include <iomanip>
 #include <iostream>
 #include <map>
 #include <array>
+#include <string_view>
+#include "AsyncSink.hpp"
 namespace logging {
 
 /**
@@ -32,11 +35,17 @@ class MDC {
  public:
   void put(const std::string& key, const std::string& val) { mdc_map_.insert_or_assign(key, val); }
   std::string get(const std::string& key) { return mdc_map_[key]; }
+  // The value of the key without copying it, empty if missing
+  const std::string& find(std::string_view key) const {
+    static const std::string empty;
+    auto it = mdc_map_.find(key);
+    return it == mdc_map_.end() ? empty : it->second;
+  }
   void remove(const std::string& key) { mdc_map_.erase(key); }
   void clear() { mdc_map_.clear(); }
 
  private:
-  std::map<std::string, std::string> mdc_map_;
+  std::map<std::string, std::string, std::less<>> mdc_map_;
 };
 
 /**
@@ -61,22 +70,34 @@ class LoggerImpl {
   LoggerImpl& operator=(const LoggerImpl&) = delete;
   ~LoggerImpl() = default;
 
-  std::ostream& print(logging::LogLevel l, const char* func) const {
+  std::ostream& print(logging::LogLevel l, const char* func) const { return print(std::cout, l, func); }
+
+  std::ostream& print(std::ostream& os, logging::LogLevel l, const char* func) const {
     struct timeval cur_time;
     gettimeofday(&cur_time, NULL);
 
+    // Formatting the local time is costly, the thread formats a second once
+    static thread_local time_t formatted_sec = -1;
+    static thread_local char formatted_time[32];
+    if (cur_time.tv_sec != formatted_sec) {
+      struct tm local_time;
+      localtime_r(&cur_time.tv_sec, &local_time);
+      strftime(formatted_time, sizeof(formatted_time), "%FT%T.", &local_time);
+      formatted_sec = cur_time.tv_sec;
+    }
+
     // clang-format off
-    std::cout << std::put_time(std::localtime(&cur_time.tv_sec), "%FT%T.") << (int)cur_time.tv_usec / 1000
+    os << formatted_time << (int)cur_time.tv_usec / 1000
        << "|" << LoggerImpl::LEVELS_STRINGS[l]
-       << "|" << getThreadContext().getMDC().get(MDC_REPLICA_ID_KEY)
+       << "|" << getThreadContext().getMDC().find(MDC_REPLICA_ID_KEY)
        << "|" << name_
-       << "|" << getThreadContext().getMDC().get(MDC_THREAD_KEY)
-       << "|" << getThreadContext().getMDC().get(MDC_CID_KEY)
-       << "|" << getThreadContext().getMDC().get(MDC_SEQ_NUM_KEY)
+       << "|" << getThreadContext().getMDC().find(MDC_THREAD_KEY)
+       << "|" << getThreadContext().getMDC().find(MDC_CID_KEY)
+       << "|" << getThreadContext().getMDC().find(MDC_SEQ_NUM_KEY)
        << "|" << func
        << "|";
     // clang-format on
-    return std::cout;
+    return os;
   }
 
  private:
@@ -100,6 +121,9 @@ class Logger {
  public:
   Logger(LoggerImpl& logger) : logger_{&logger} {}
   std::ostream& print(logging::LogLevel l, const char* func) const { return logger_->print(l, func); }
+  std::ostream& print(std::ostream& os, logging::LogLevel l, const char* func) const {
+    return logger_->print(os, l, func);
+  }
   LogLevel getLogLevel() const { return logger_->level_; }
   void setLogLevel(LogLevel l) { logger_->level_ = l; }
   static ThreadContext& getThreadContext() { return LoggerImpl::getThreadContext(); }
@@ -111,10 +135,19 @@ class Logger {
 
 }  // namespace logging
 
-#define LOG_COMMON(logger, level, s)                              \
-  if ((logger).getLogLevel() <= level) {                          \
-    (logger).print(level, __PRETTY_FUNCTION__) << s << std::endl; \
-  }
+// With async logging, the record is formatted into a buffer of the thread and written by the sink
+#define LOG_COMMON(logger, level, s)                                                      \
+  do {                                                                                    \
+    if ((logger).getLogLevel() <= level) {                                                \
+      if (logging::isAsyncLogging()) {                                                    \
+        logging::AsyncRecord logging_record;                                              \
+        (logger).print(logging_record.stream(), level, __PRETTY_FUNCTION__) << s << '\n'; \
+        logging_record.commit(level == logging::LogLevel::fatal);                         \
+      } else {                                                                            \
+        (logger).print(level, __PRETTY_FUNCTION__) << s << std::endl;                     \
+      }                                                                                   \
+    }                                                                                     \
+  } while (0)
 
 #define LOG_TRACE(l, s) LOG_COMMON(l, logging::LogLevel::trace, s)
 #define LOG_DEBUG(l, s) LOG_COMMON(l, logging::LogLevel::debug, s)
@@ -0,0 +1,319 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license,
+// as noted in the LICENSE file.
+
+#include "AsyncSink.hpp"
+#include "SpscByteRing.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+namespace logging {
+
+namespace {
+
+std::atomic_uint64_t next_sink_id{1};
+
+// The rings cached by a thread, one per sink it logged to
+struct ThreadRings {
+  uint64_t last_id = 0;
+  void* last = nullptr;
+  std::vector<std::pair<uint64_t, std::shared_ptr<void>>> rings;
+};
+
+thread_local ThreadRings thread_rings;
+
+}  // namespace
+
+/******************************** Class Ring ********************************/
+
+// The ring of a logging thread, drained by the thread of the sink
+class AsyncSink::Ring {
+ public:
+  explicit Ring(size_t capacity) : buffer_(new char[capacity]), ring_(positions_, buffer_.get(), capacity) {}
+
+  size_t maxRecordSize() const { return ring_.maxRecordSize(); }
+  bool tryWrite(const char* data, size_t size) { return ring_.tryWrite(data, size); }
+  template <typename Reader>
+  size_t read(Reader&& reader) {
+    return ring_.read(std::forward<Reader>(reader));
+  }
+  bool empty() const { return ring_.empty(); }
+
+ private:
+  std::unique_ptr<char[]> buffer_;
+  concord::util::SpscByteRing::Positions positions_;
+  concord::util::SpscByteRing ring_;
+};
+
+/******************************** Class AsyncSink ********************************/
+
+AsyncSink::AsyncSink(const AsyncSinkConfig& config, Writer writer, Flusher flusher)
+    : config_(config), writer_(std::move(writer)), flusher_(std::move(flusher)), id_(next_sink_id++) {
+  // Fail early on an invalid size
+  Ring{config_.ring_bytes};
+  start();
+}
+
+AsyncSink::~AsyncSink() { stop(); }
+
+bool AsyncSink::push(const char* data, size_t size) {
+  if (!running_.load(std::memory_order_relaxed)) {
+    drop();
+    return false;
+  }
+  auto& ring = threadRing();
+  if (size > ring.maxRecordSize()) {
+    drop();
+    return false;
+  }
+  if (ring.tryWrite(data, size)) return true;
+  if (config_.overflow_policy == OverflowPolicy::drop) {
+    drop();
+    return false;
+  }
+  return waitForRoom(ring, data, size);
+}
+
+bool AsyncSink::waitForRoom(Ring& ring, const char* data, size_t size) {
+  while (!ring.tryWrite(data, size)) {
+    if (!running_.load(std::memory_order_acquire)) {
+      drop();
+      return false;
+    }
+    wakeup_.notify_one();
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+  }
+  return true;
+}
+
+void AsyncSink::drop() { dropped_.fetch_add(1, std::memory_order_relaxed); }
+
+AsyncSink::Ring& AsyncSink::threadRing() {
+  if (thread_rings.last_id == id_) {
+    return *static_cast<Ring*>(thread_rings.last);
+  }
+  auto iter = std::find_if(thread_rings.rings.begin(), thread_rings.rings.end(), [this](const auto& ring) {
+    return ring.first == id_;
+  });
+  if (iter == thread_rings.rings.end()) {
+    auto ring = std::make_shared<Ring>(config_.ring_bytes);
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      rings_.push_back(ring);
+      ++rings_version_;
+      num_rings_.store(rings_.size(), std::memory_order_relaxed);
+    }
+    thread_rings.rings.emplace_back(id_, ring);
+    iter = std::prev(thread_rings.rings.end());
+  }
+  thread_rings.last_id = id_;
+  thread_rings.last = iter->second.get();
+  return *static_cast<Ring*>(thread_rings.last);
+}
+
+void AsyncSink::flush() {
+  std::unique_lock<std::mutex> lock(lock_);
+  const auto request = ++flush_requests_;
+  wakeup_.notify_one();
+  flushed_cond_.wait(lock, [this, request]() { return flushed_ >= request || !running_; });
+}
+
+void AsyncSink::start() {
+  std::lock_guard<std::mutex> lock(lock_);
+  if (running_) return;
+  running_ = true;
+  thread_ = std::thread(&AsyncSink::loop, this);
+}
+
+void AsyncSink::stop() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!running_) return;
+    running_ = false;
+  }
+  wakeup_.notify_one();
+  thread_.join();
+  std::lock_guard<std::mutex> lock(lock_);
+  flushed_cond_.notify_all();
+}
+
+AsyncSinkStats AsyncSink::getStats() const {
+  return AsyncSinkStats{written_.load(std::memory_order_relaxed),
+                        dropped_.load(std::memory_order_relaxed),
+                        num_rings_.load(std::memory_order_relaxed)};
+}
+
+void AsyncSink::loop() {
+  std::unique_lock<std::mutex> lock(lock_);
+  while (true) {
+    const auto request = flush_requests_;
+    const bool stopping = !running_;
+    lock.unlock();
+    const auto drained = drainAll();
+    lock.lock();
+    flushed_ = request;
+    flushed_cond_.notify_all();
+    if (stopping) break;
+    if (drained == 0 && flush_requests_ == request && running_) {
+      wakeup_.wait_for(lock, config_.drain_interval);
+    }
+  }
+}
+
+size_t AsyncSink::drainAll() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    // A stale copy is replaced below anyway. A current one holds every ring of rings_ once more.
+    if (drained_rings_version_ != rings_version_) drained_rings_.clear();
+    const long owners = drained_rings_version_ == rings_version_ ? 2 : 1;
+    // Forget the rings of exited threads once drained, the thread held the only other owner
+    const auto size = rings_.size();
+    rings_.erase(std::remove_if(rings_.begin(),
+                                rings_.end(),
+                                [owners](const auto& ring) { return ring.use_count() == owners && ring->empty(); }),
+                 rings_.end());
+    if (rings_.size() != size) {
+      ++rings_version_;
+      num_rings_.store(rings_.size(), std::memory_order_relaxed);
+    }
+    // The rings are copied to let threads register while the records are written
+    if (drained_rings_version_ != rings_version_) {
+      drained_rings_ = rings_;
+      drained_rings_version_ = rings_version_;
+    }
+  }
+  size_t records = 0;
+  for (auto& ring : drained_rings_) {
+    records += ring->read([this](const char* data, size_t size) {
+      try {
+        writer_(data, size);
+      } catch (std::exception& e) {
+        std::cerr << __PRETTY_FUNCTION__ << ": failed to write a record: " << e.what() << std::endl;
+      }
+    });
+  }
+  if (records > 0) {
+    written_.fetch_add(records, std::memory_order_relaxed);
+    if (flusher_) flusher_();
+  }
+  return records;
+}
+
+/******************************** Class RecordStream ********************************/
+
+void RecordStream::clear() {
+  buffer_.clear();
+  std::ostream::clear();
+  flags(std::ios_base::dec | std::ios_base::skipws);
+  fill(' ');
+  precision(6);
+  width(0);
+}
+
+RecordStream::Buffer::int_type RecordStream::Buffer::overflow(int_type c) {
+  if (traits_type::eq_int_type(c, traits_type::eof())) return traits_type::not_eof(c);
+  grow(storage_.size() * 2);
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+std::streamsize RecordStream::Buffer::xsputn(const char* s, std::streamsize n) {
+  if (epptr() - pptr() < n) {
+    grow(std::max(storage_.size() * 2, size() + static_cast<size_t>(n)));
+  }
+  std::memcpy(pptr(), s, n);
+  pbump(static_cast<int>(n));
+  return n;
+}
+
+void RecordStream::Buffer::grow(size_t capacity) {
+  const auto used = size();
+  storage_.resize(capacity);
+  setp(storage_.data(), storage_.data() + storage_.size());
+  pbump(static_cast<int>(used));
+}
+
+/******************************** Async logging ********************************/
+
+namespace detail {
+std::atomic_bool async_logging{false};
+}  // namespace detail
+
+namespace {
+
+std::mutex async_logging_lock;
+// Sinks are never destroyed, since threads that saw async logging enabled may still push to a stopped one
+std::atomic<AsyncSink*> async_sink{nullptr};
+// The streams of the records being formatted by the thread, indexed by their nesting level
+thread_local std::vector<std::unique_ptr<RecordStream>> record_streams;
+thread_local size_t record_depth = 0;
+
+RecordStream& acquireRecordStream() {
+  if (record_depth == record_streams.size()) {
+    record_streams.push_back(std::make_unique<RecordStream>());
+  }
+  auto& stream = *record_streams[record_depth++];
+  stream.clear();
+  return stream;
+}
+
+bool sameConfig(const AsyncSinkConfig& lhs, const AsyncSinkConfig& rhs) {
+  return lhs.ring_bytes == rhs.ring_bytes && lhs.overflow_policy == rhs.overflow_policy &&
+         lhs.drain_interval == rhs.drain_interval;
+}
+
+}  // namespace
+
+void startAsyncLogging(const AsyncSinkConfig& config) {
+  std::lock_guard<std::mutex> lock(async_logging_lock);
+  if (detail::async_logging) return;
+  auto sink = async_sink.load();
+  if (sink && sameConfig(sink->getConfig(), config)) {
+    sink->start();
+  } else {
+    async_sink = new AsyncSink(config, detail::writeAsyncRecord, detail::flushAsyncRecords);
+  }
+  detail::async_logging = true;
+}
+
+void stopAsyncLogging() {
+  std::lock_guard<std::mutex> lock(async_logging_lock);
+  if (!detail::async_logging) return;
+  detail::async_logging = false;
+  async_sink.load()->stop();
+}
+
+void flushAsyncLogging() {
+  std::lock_guard<std::mutex> lock(async_logging_lock);
+  if (detail::async_logging) async_sink.load()->flush();
+}
+
+AsyncSinkStats getAsyncLoggingStats() {
+  std::lock_guard<std::mutex> lock(async_logging_lock);
+  auto sink = async_sink.load();
+  return sink ? sink->getStats() : AsyncSinkStats{};
+}
+
+AsyncRecord::AsyncRecord() : stream_(acquireRecordStream()) {}
+
+AsyncRecord::~AsyncRecord() { --record_depth; }
+
+void AsyncRecord::commit(bool flush) {
+  auto sink = async_sink.load(std::memory_order_acquire);
+  sink->push(stream_.data(), stream_.size());
+  if (flush) sink->flush();
+}
+
+}  // namespace logging
@@ -81,4 +81,12 @@ bool Logger::config(const std::string& configFileName) {
   return true;
 }
 
+namespace detail {
+
+void writeAsyncRecord(const char* data, size_t size) { std::cout.write(data, size); }
+
+void flushAsyncRecords() { std::cout.flush(); }
+
+}  // namespace detail
+
 }  // namespace logging
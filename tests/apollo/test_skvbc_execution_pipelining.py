@@ -0,0 +1,132 @@
+# Concord
+#
+# Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+#
+# This product is licensed to you under the Apache 2.0 license (the "License").
+# You may not use this product except in compliance with the Apache 2.0 License.
+#
+# This product may include a number of subcomponents with separate copyright
+# notices and license terms. Your use of these subcomponents is subject to the
+# terms and conditions of the subcomponent's license, as noted in the LICENSE
+# file.
+
+import os.path
+import random
+import unittest
+
+import trio
+
+from util.bft import with_trio, with_bft_network, KEY_FILE_PREFIX
+from util.skvbc_history_tracker import verify_linearizability
+from util import skvbc as kvbc
+
+NUM_OF_WRITES = 200
+MAX_CONCURRENCY = 30
+CHECKPOINT_WINDOW_SIZE = 150
+WORK_WINDOW_SIZE = 300
+
+
+def start_replica_cmd(builddir, replica_id):
+    """
+    Return a command that starts an skvbc replica with execution pipelining
+    enabled when passed to subprocess.Popen.
+
+    Note each arguments is an element in a list.
+    """
+    statusTimerMilli = "500"
+    viewChangeTimeoutMilli = "10000"
+    path = os.path.join(builddir, "tests", "simpleKVBC", "TesterReplica", "skvbc_replica")
+    return [path,
+            "-k", KEY_FILE_PREFIX,
+            "-i", str(replica_id),
+            "-s", statusTimerMilli,
+            "-v", viewChangeTimeoutMilli,
+            "--execution-pipelining"
+            ]
+
+
+class SkvbcExecutionPipeliningTest(unittest.TestCase):
+
+    __test__ = False  # so that PyTest ignores this test scenario
+
+    @with_trio
+    @with_bft_network(start_replica_cmd, selected_configs=lambda n, f, c: n == 7)
+    @verify_linearizability(pre_exec_enabled=True, no_conflicts=True)
+    async def test_concurrent_writes_across_checkpoints(self, bft_network, tracker):
+        """
+        Execute concurrent writes with execution pipelining and fill enough
+        sequence numbers to take checkpoints while the next PrePrepares are
+        pipelined. All replicas are then restarted to verify the checkpoints
+        were persisted, and a written value can be read back.
+        """
+        bft_network.start_all_replicas()
+        skvbc = kvbc.SimpleKVBCProtocol(bft_network, tracker)
+        rw = await skvbc.send_concurrent_ops(NUM_OF_WRITES, max_concurrency=MAX_CONCURRENCY, max_size=10,
+                                             write_weight=0.9)
+        self.assertTrue(rw[0] + rw[1] >= NUM_OF_WRITES)
+
+        await skvbc.fill_and_wait_for_checkpoint(initial_nodes=bft_network.all_replicas(),
+                                                 num_of_checkpoints_to_add=1,
+                                                 verify_checkpoint_persistency=True)
+        await skvbc.read_your_writes()
+
+    @with_trio
+    @with_bft_network(start_replica_cmd, selected_configs=lambda n, f, c: n == 7)
+    @verify_linearizability(pre_exec_enabled=True, no_conflicts=True)
+    async def test_checkpoint_becomes_stable_while_executions_are_pipelined(self, bft_network, tracker):
+        """
+        Keep writing so that PrePrepares are executed back to back, and
+        verify that the first checkpoint becomes stable on all replicas
+        while the writes go on, i.e. before execution reaches the end of
+        the work window and stops.
+        """
+        bft_network.start_all_replicas()
+        skvbc = kvbc.SimpleKVBCProtocol(bft_network, tracker)
+
+        async def checkpoint_is_stable():
+            for replica_id in bft_network.all_replicas():
+                last_stable = await bft_network.get_metric(replica_id, bft_network, "Gauges", "lastStableSeqNum")
+                if last_stable < CHECKPOINT_WINDOW_SIZE:
+                    return False
+            return True
+
+        with trio.fail_after(seconds=60):
+            async with trio.open_nursery() as nursery:
+                nursery.start_soon(skvbc.send_indefinite_ops, 1)
+                while not await checkpoint_is_stable():
+                    await trio.sleep(seconds=0.1)
+                primary_last_executed = await bft_network.get_metric(0, bft_network, "Gauges", "lastExecutedSeqNum")
+                nursery.cancel_scope.cancel()
+
+        self.assertLess(primary_last_executed, WORK_WINDOW_SIZE)
+
+    @with_trio
+    @with_bft_network(start_replica_cmd, selected_configs=lambda n, f, c: n == 7)
+    @verify_linearizability(pre_exec_enabled=True, no_conflicts=True)
+    async def test_replica_killed_during_pipelined_execution_recovers(self, bft_network, tracker):
+        """
+        Kill a backup replica while it executes a stream of PrePrepares
+        back to back, then restart it. On restart the replica re-executes at
+        most the single sequence number recorded in its descriptor of last
+        execution, catches up with the primary and the cluster keeps
+        serving writes.
+        """
+        bft_network.start_all_replicas()
+        skvbc = kvbc.SimpleKVBCProtocol(bft_network, tracker)
+        victim = random.choice(bft_network.all_replicas(without={0}))
+
+        async def kill_and_restart():
+            await trio.sleep(2)
+            bft_network.stop_replica(victim, force_kill=True)
+            bft_network.start_replica(victim)
+
+        async with trio.open_nursery() as nursery:
+            nursery.start_soon(kill_and_restart)
+            rw = await skvbc.send_concurrent_ops(NUM_OF_WRITES, max_concurrency=MAX_CONCURRENCY, max_size=10,
+                                                 write_weight=0.9)
+        self.assertTrue(rw[0] + rw[1] >= NUM_OF_WRITES)
+
+        primary_last_executed = await bft_network.get_metric(0, bft_network, "Gauges", "lastExecutedSeqNum")
+        await bft_network.wait_for_last_executed_seq_num(replica_id=victim, expected=primary_last_executed)
+        await skvbc.assert_successful_put_get()
+
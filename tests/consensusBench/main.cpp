@@ -0,0 +1,467 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+// The end to end throughput and latency of consensus, with no network.
+//
+// A single binary runs a cluster of replicas and clients connected through a SharedMemoryNetwork. The replicas rely on
+// process-wide singletons (ReplicaConfig, CryptoManager, SigManager...), so each of them runs in a process forked
+// before any thread is started. The clients are threads of the parent process, each sending its requests one after
+// the other. The parent reports:
+//   * the throughput of the requests and the percentiles of their latency
+//   * the share of the commits on the fast path, as counted by the replicas
+//
+// The replicas execute the requests of one of the workloads:
+//   noop           - nothing is executed
+//   kv-write       - every request writes a key of an in-memory map
+//   pre-execution  - the key value write is pre-executed and its result written on execution
+//
+// The keys of the replicas are generated by GenerateConcordKeys, see the generate_consensus_bench_keys target.
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "communication/SharedMemoryCommunication.hpp"
+#include "IRequestHandler.hpp"
+#include "kvstream.h"
+#include "Logger.hpp"
+#include "Metrics.hpp"
+#include "PerformanceManager.hpp"
+#include "Replica.hpp"
+#include "ReplicaConfig.hpp"
+#include "SimpleClient.hpp"
+#include "SimpleStateTransfer.hpp"
+#include "test_comm_config.hpp"
+
+namespace po = boost::program_options;
+
+using namespace std::chrono_literals;
+using bft::communication::NodeNum;
+using bft::communication::SharedMemoryNetwork;
+
+namespace bftEngine::bench {
+
+logging::Logger logger = logging::getLogger("concord.bench.consensus");
+
+enum class Workload { noop, kv_write, pre_execution };
+
+constexpr uint16_t kMaxReplicas = 64;
+
+struct Options {
+  uint16_t replicas = 4;
+  uint16_t clients = 4;
+  size_t requests = 1000;
+  size_t warmup = 100;
+  Workload workload = Workload::noop;
+  size_t value_size = 64;
+  uint64_t timeout_ms = 10000;
+  uint64_t seed = 1;
+  std::string keys_prefix;
+};
+
+Options parseArgs(int argc, char** argv) {
+  auto desc = po::options_description("Allowed options");
+  // clang-format off
+  desc.add_options()
+    ("help", "show usage")
+
+    ("replicas",
+     po::value<uint16_t>()->default_value(4),
+     "The number of replicas, 3f + 1")
+
+    ("clients",
+     po::value<uint16_t>()->default_value(4),
+     "The number of clients, each sending one request at a time")
+
+    ("requests",
+     po::value<size_t>()->default_value(1000),
+     "The number of measured requests of every client")
+
+    ("warmup",
+     po::value<size_t>()->default_value(100),
+     "The number of requests of every client before measuring")
+
+    ("workload",
+     po::value<std::string>()->default_value("noop"),
+     "What the replicas execute: noop, kv-write or pre-execution")
+
+    ("value-size",
+     po::value<size_t>()->default_value(64),
+     "The bytes of the value written by a request")
+
+    ("timeout-ms",
+     po::value<uint64_t>()->default_value(10000),
+     "The timeout of a request")
+
+    ("seed",
+     po::value<uint64_t>()->default_value(1),
+     "The seed of the keys written by the clients")
+
+    ("keys-prefix",
+     po::value<std::string>(),
+     "The prefix of the key files of the replicas, consensus_bench_<replicas>_ by default");
+  // clang-format on
+
+  auto config = po::variables_map{};
+  po::store(po::parse_command_line(argc, argv, desc), config);
+  po::notify(config);
+  if (config.count("help")) {
+    std::cout << desc << std::endl;
+    exit(0);
+  }
+
+  Options options;
+  options.replicas = config["replicas"].as<uint16_t>();
+  options.clients = config["clients"].as<uint16_t>();
+  options.requests = config["requests"].as<size_t>();
+  options.warmup = config["warmup"].as<size_t>();
+  options.value_size = config["value-size"].as<size_t>();
+  options.timeout_ms = config["timeout-ms"].as<uint64_t>();
+  options.seed = config["seed"].as<uint64_t>();
+  const auto workload = config["workload"].as<std::string>();
+  if (workload == "noop") {
+    options.workload = Workload::noop;
+  } else if (workload == "kv-write") {
+    options.workload = Workload::kv_write;
+  } else if (workload == "pre-execution") {
+    options.workload = Workload::pre_execution;
+  } else {
+    throw po::validation_error{po::validation_error::invalid_option_value, "workload", workload};
+  }
+  if (options.replicas < 4 || (options.replicas - 1) % 3 != 0 || options.replicas > kMaxReplicas) {
+    throw po::validation_error{
+        po::validation_error::invalid_option_value, "replicas", std::to_string(options.replicas)};
+  }
+  if (options.clients == 0) {
+    throw po::validation_error{po::validation_error::invalid_option_value, "clients", "0"};
+  }
+  options.keys_prefix = config.count("keys-prefix") ? config["keys-prefix"].as<std::string>()
+                                                   : "consensus_bench_" + std::to_string(options.replicas) + "_";
+  return options;
+}
+
+// A request is the key followed by the value to write
+class BenchRequestsHandler : public IRequestsHandler {
+ public:
+  explicit BenchRequestsHandler(Workload workload) : workload_(workload) {}
+
+  void execute(ExecutionRequestsQueue& requests,
+               std::optional<Timestamp>,
+               const std::string&,
+               concordUtils::SpanWrapper&) override {
+    for (auto& req : requests) {
+      req.outReplicaSpecificInfoSize = 0;
+      if (workload_ == Workload::kv_write) {
+        write(req.request, req.requestSize);
+      } else if (workload_ == Workload::pre_execution) {
+        // The result of the pre-execution is followed by the block id of the conflict detection
+        const bool preProcessed = req.flags & HAS_PRE_PROCESSED_FLAG;
+        write(req.request, preProcessed ? req.requestSize - sizeof(uint64_t) : req.requestSize);
+      }
+      reply(req);
+    }
+  }
+
+  // The result of the pre-execution is the write itself
+  void preExecute(ExecutionRequest& req,
+                  std::optional<Timestamp>,
+                  const std::string&,
+                  concordUtils::SpanWrapper&) override {
+    if (req.maxReplySize < req.requestSize) {
+      req.outExecutionStatus = static_cast<uint32_t>(OperationResult::EXEC_DATA_TOO_LARGE);
+      return;
+    }
+    std::memcpy(req.outReply, req.request, req.requestSize);
+    req.outActualReplySize = req.requestSize;
+    req.outExecutionStatus = static_cast<uint32_t>(OperationResult::SUCCESS);
+  }
+
+ private:
+  void write(const char* request, size_t size) {
+    if (size < sizeof(uint64_t)) return;
+    uint64_t key = 0;
+    std::memcpy(&key, request, sizeof(key));
+    store_[key].assign(request + sizeof(key), size - sizeof(key));
+  }
+
+  // The reply is the sequence number the request was executed in
+  static void reply(ExecutionRequest& req) {
+    if (req.maxReplySize >= sizeof(uint64_t)) {
+      std::memcpy(req.outReply, &req.executionSequenceNum, sizeof(uint64_t));
+      req.outActualReplySize = sizeof(uint64_t);
+    }
+    req.outExecutionStatus = static_cast<uint32_t>(OperationResult::SUCCESS);
+  }
+
+  const Workload workload_;
+  std::unordered_map<uint64_t, std::string> store_;
+};
+
+// Written by a replica process and read by the parent once it exited
+struct ReplicaReport {
+  std::atomic_bool ready{false};
+  uint64_t fast_paths = 0;
+  uint64_t slow_paths = 0;
+  uint64_t fast_path_requests = 0;
+  uint64_t slow_path_requests = 0;
+};
+
+// The memory shared by the parent and the replica processes
+struct SharedState {
+  std::atomic_bool stop{false};
+  ReplicaReport replicas[kMaxReplicas];
+};
+
+SharedState* mapSharedState() {
+  auto memory = mmap(nullptr, sizeof(SharedState), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    throw std::runtime_error("failed to map the shared state: " + std::string(std::strerror(errno)));
+  }
+  return new (memory) SharedState;
+}
+
+[[noreturn]] void runReplica(uint16_t id, const Options& options, SharedMemoryNetwork& network, SharedState& shared) {
+  auto& config = ReplicaConfig::instance();
+  TestCommConfig testCommConfig(logger);
+  testCommConfig.GetReplicaConfig(id, options.keys_prefix, &config);
+  if (config.numReplicas != options.replicas) {
+    LOG_FATAL(logger, "The keys are of another cluster" << KVLOG(id, options.keys_prefix, config.numReplicas));
+    _exit(1);
+  }
+  config.replicaId = id;
+  config.numOfClientProxies = options.clients;
+  config.viewChangeProtocolEnabled = false;
+  config.preExecutionFeatureEnabled = options.workload == Workload::pre_execution;
+
+  // The state transfer isn't exercised, it only needs some state
+  static char state[4096];
+  auto st = SimpleInMemoryStateTransfer::create(state, sizeof(state), id, config.fVal, config.cVal, true);
+  auto comm = network.communicationOf(id);
+  auto aggregator = std::make_shared<concordMetrics::Aggregator>();
+  auto replica = IReplica::createNewReplica(config,
+                                            std::make_shared<BenchRequestsHandler>(options.workload),
+                                            st,
+                                            comm.get(),
+                                            nullptr,
+                                            std::make_shared<concord::performance::PerformanceManager>(),
+                                            nullptr,
+                                            nullptr);
+  replica->SetAggregator(aggregator);
+  replica->start();
+  auto& report = shared.replicas[id];
+  report.ready = true;
+
+  while (!shared.stop) {
+    std::this_thread::sleep_for(10ms);
+  }
+  report.fast_paths = aggregator->GetCounter("replica", "totalFastPaths").Get();
+  report.slow_paths = aggregator->GetCounter("replica", "totalSlowPaths").Get();
+  report.fast_path_requests = aggregator->GetCounter("replica", "totalFastPathRequests").Get();
+  report.slow_path_requests = aggregator->GetCounter("replica", "totalSlowPathRequests").Get();
+  replica->stop();
+  // Skip the destruction of the singletons, the parent only needs the report
+  _exit(0);
+}
+
+struct ClientResult {
+  std::vector<uint64_t> latencies_ns;
+  size_t failed = 0;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point end;
+};
+
+void runClient(uint16_t id, const Options& options, SharedMemoryNetwork& network, ClientResult& result) {
+  const uint16_t f = (options.replicas - 1) / 3;
+  auto comm = network.communicationOf(id);
+  std::unique_ptr<SimpleClient> client{SimpleClient::createSimpleClient(comm.get(), id, f, 0)};
+  comm->start();
+  auto seqNumGenerator = SeqNumberGeneratorForClientRequests::createSeqNumberGeneratorForClientRequests();
+  const uint8_t flags = options.workload == Workload::pre_execution ? PRE_PROCESS_REQ : EMPTY_FLAGS_REQ;
+
+  std::mt19937_64 keys{options.seed + id};
+  std::vector<char> request(sizeof(uint64_t) + options.value_size, 'v');
+  std::vector<char> reply(1024);
+  result.latencies_ns.reserve(options.requests);
+  for (size_t i = 0; i < options.warmup + options.requests; ++i) {
+    if (i == options.warmup) {
+      result.start = std::chrono::steady_clock::now();
+    }
+    const uint64_t key = keys();
+    std::memcpy(request.data(), &key, sizeof(key));
+    uint32_t replyLength = 0;
+    const auto start = std::chrono::steady_clock::now();
+    const auto res = client->sendRequest(flags,
+                                         request.data(),
+                                         request.size(),
+                                         seqNumGenerator->generateUniqueSequenceNumberForRequest(),
+                                         options.timeout_ms,
+                                         reply.size(),
+                                         reply.data(),
+                                         replyLength);
+    const auto latency = std::chrono::steady_clock::now() - start;
+    if (i < options.warmup) continue;
+    if (res != OperationResult::SUCCESS) {
+      result.failed++;
+      continue;
+    }
+    result.latencies_ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+  }
+  result.end = std::chrono::steady_clock::now();
+  comm->stop();
+}
+
+std::string toString(Workload workload) {
+  switch (workload) {
+    case Workload::noop:
+      return "noop";
+    case Workload::kv_write:
+      return "kv-write";
+    case Workload::pre_execution:
+      return "pre-execution";
+  }
+  return "unknown";
+}
+
+void report(const Options& options, const std::vector<ClientResult>& results, const SharedState& shared) {
+  if (results.empty()) {
+    std::cout << "no clients, nothing to report" << std::endl;
+    return;
+  }
+  std::vector<uint64_t> latencies;
+  size_t failed = 0;
+  auto start = results.front().start;
+  auto end = results.front().end;
+  for (const auto& result : results) {
+    latencies.insert(latencies.end(), result.latencies_ns.begin(), result.latencies_ns.end());
+    failed += result.failed;
+    start = std::min(start, result.start);
+    end = std::max(end, result.end);
+  }
+  std::sort(latencies.begin(), latencies.end());
+  const auto seconds = std::chrono::duration<double>(end - start).count();
+  const auto percentile = [&latencies](size_t per_mille) {
+    return latencies.empty() ? 0.0 : latencies[latencies.size() * per_mille / 1000] / 1e6;
+  };
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "workload: " << toString(options.workload) << ", replicas: " << options.replicas
+            << ", clients: " << options.clients << ", value size: " << options.value_size << std::endl;
+  std::cout << "requests: " << latencies.size() << ", failed: " << failed << ", seconds: " << seconds << std::endl;
+  std::cout << "throughput: " << (seconds > 0 ? latencies.size() / seconds : 0) << " requests/s" << std::endl;
+  std::cout << "latency ms: p50 " << percentile(500) << ", p99 " << percentile(990) << ", p999 " << percentile(999)
+            << std::endl;
+
+  uint64_t fast_paths = 0;
+  uint64_t slow_paths = 0;
+  for (uint16_t id = 0; id < options.replicas; ++id) {
+    const auto& replica = shared.replicas[id];
+    std::cout << "replica " << id << ": fast paths " << replica.fast_paths << " (" << replica.fast_path_requests
+              << " requests), slow paths " << replica.slow_paths << " (" << replica.slow_path_requests << " requests)"
+              << std::endl;
+    fast_paths += replica.fast_paths;
+    slow_paths += replica.slow_paths;
+  }
+  const auto paths = fast_paths + slow_paths;
+  std::cout << "fast path ratio: " << (paths > 0 ? static_cast<double>(fast_paths) / paths : 0.0) << std::endl;
+}
+
+int run(const Options& options) {
+  std::vector<NodeNum> replicas;
+  std::vector<NodeNum> clients;
+  for (uint16_t id = 0; id < options.replicas; ++id) {
+    replicas.push_back(id);
+  }
+  for (uint16_t i = 0; i < options.clients; ++i) {
+    clients.push_back(options.replicas + i);
+  }
+  SharedMemoryNetwork network{replicas, clients};
+  auto& shared = *mapSharedState();
+
+  std::vector<pid_t> children;
+  for (uint16_t id = 0; id < options.replicas; ++id) {
+    const auto child = fork();
+    if (child == -1) {
+      LOG_FATAL(logger, "fork failed: " << std::strerror(errno));
+      shared.stop = true;
+      break;
+    }
+    if (child == 0) {
+      runReplica(id, options, network, shared);
+    }
+    children.push_back(child);
+  }
+
+  bool ready = children.size() == options.replicas;
+  const auto deadline = std::chrono::steady_clock::now() + 60s;
+  while (ready && !std::all_of(shared.replicas, shared.replicas + options.replicas, [](const auto& replica) {
+    return replica.ready.load();
+  })) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      LOG_FATAL(logger, "The replicas didn't start in time");
+      ready = false;
+    }
+    std::this_thread::sleep_for(10ms);
+  }
+
+  std::vector<ClientResult> results(options.clients);
+  if (ready) {
+    std::vector<std::thread> threads;
+    for (uint16_t i = 0; i < options.clients; ++i) {
+      threads.emplace_back(
+          [&, i]() { runClient(static_cast<uint16_t>(options.replicas + i), options, network, results[i]); });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  shared.stop = true;
+  bool succeeded = ready;
+  for (auto child : children) {
+    int status = 0;
+    if (waitpid(child, &status, 0) != child || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      LOG_FATAL(logger, "A replica failed" << KVLOG(child, status));
+      succeeded = false;
+    }
+  }
+  if (!succeeded) return 1;
+  report(options, results, shared);
+  return 0;
+}
+
+}  // namespace bftEngine::bench
+
+int main(int argc, char** argv) {
+  try {
+    return bftEngine::bench::run(bftEngine::bench::parseArgs(argc, argv));
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return 1;
+  }
+}
@@ -90,6 +90,7 @@ std::unique_ptr<TestSetup> TestSetup::ParseArgs(int argc, char** argv) {
     std::string byzantineStrategies;
     bool is_separate_communication_mode = false;
     int addAllKeysAsPublic = 0;
+    int executionPipelining = 0;
 
     static struct option longOptions[] = {
         {"replica-id", required_argument, 0, 'i'},
@@ -121,6 +122,7 @@ std::unique_ptr<TestSetup> TestSetup::ParseArgs(int argc, char** argv) {
         {"enable-db-checkpoint", required_argument, 0, 'h'},
         {"publish-master-key-on-startup", no_argument, (int*)&replicaConfig.publishReplicasMasterKeyOnStartup, 1},
         {"add-all-keys-as-public", no_argument, &addAllKeysAsPublic, 1},
+        {"execution-pipelining", no_argument, &executionPipelining, 1},
         {0, 0, 0, 0}};
     int o = 0;
     int optionIndex = 0;
@@ -184,7 +186,7 @@ std::unique_ptr<TestSetup> TestSetup::ParseArgs(int argc, char** argv) {
         }
         case 'b': {
           auto policy = concord::util::to<std::uint32_t>(std::string(optarg));
-          if (policy < bftEngine::BATCH_SELF_ADJUSTED || policy > bftEngine::BATCH_ADAPTIVE)
+          if (policy < bftEngine::BATCH_SELF_ADJUSTED || policy > bftEngine::BATCH_BY_LATENCY_TARGET)
             throw std::runtime_error{"invalid argument for --consensus-batching-policy"};
           replicaConfig.batchingPolicy = policy;
           break;
@@ -260,6 +262,7 @@ std::unique_ptr<TestSetup> TestSetup::ParseArgs(int argc, char** argv) {
     }
 
     if (keysFilePrefix.empty()) throw std::runtime_error("missing --key-file-prefix");
+    replicaConfig.enableExecutionPipelining = (executionPipelining != 0);
 
     // If -p and -t are set, enable clientTransactionSigningEnabled. If only one of them is set, throw an error
     if (!principalsMapping.empty() && !txnSigningKeysPath.empty()) {
@@ -0,0 +1,180 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#ifndef CONCORD_THIN_REPLICA_ASYNC_GRPC_SERVICES_HPP_
+#define CONCORD_THIN_REPLICA_ASYNC_GRPC_SERVICES_HPP_
+
+#include <grpcpp/grpcpp.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "Logger.hpp"
+#include "thin_replica.grpc.pb.h"
+#include "thread_pool.hpp"
+
+#ifdef RUN_PERF_TRS_TRC_TOOL
+#include "thin_replica_impl_perf.hpp"
+#else
+#include "thin_replica_impl.hpp"
+#endif
+
+namespace concord {
+namespace thin_replica {
+
+using ThinReplicaAsyncServiceBase = com::vmware::concord::thin_replica::ThinReplica::WithAsyncMethod_SubscribeToUpdates<
+    com::vmware::concord::thin_replica::ThinReplica::WithAsyncMethod_SubscribeToUpdateHashes<
+        com::vmware::concord::thin_replica::ThinReplica::Service>>;
+
+// Thin replica service which serves the subscription streams (SubscribeToUpdates and SubscribeToUpdateHashes) from
+// completion queues instead of dedicating a gRPC thread to every subscriber for its whole lifetime.
+//
+// A subscription first sends the updates from storage until it caught up with the live updates. This part is run on
+// a bounded pool of sync threads. Afterwards, the live updates are sent from the completion queue threads: the next
+// update is only popped once the previous write completed, so a slow subscriber doesn't hold a thread while its
+// updates pile up in its SubUpdateBuffer (which eventually closes the stream, same as for the synchronous service).
+// Idle subscriptions don't poll: the SubUpdateBuffer puts them back on their completion queue when an update is pushed.
+//
+// The remaining RPCs are served synchronously by the gRPC server threads.
+//
+// Usage:
+//   ThinReplicaAsyncService service(std::move(impl));
+//   service.addToServer(builder);
+//   auto server = builder.BuildAndStart();
+//   service.start();
+//   ...
+//   server->Shutdown(deadline);  // Subscriptions don't end on their own, they are cancelled after the deadline
+//   service.shutdown();
+class ThinReplicaAsyncService final : public ThinReplicaAsyncServiceBase {
+ public:
+  struct Config {
+    // Number of completion queues, each served by its own thread
+    unsigned num_cq_threads{2};
+    // Number of subscriptions that can send the updates from storage concurrently, further subscriptions wait
+    unsigned num_sync_threads{16};
+  };
+
+  ThinReplicaAsyncService(std::unique_ptr<ThinReplicaImpl>&& impl, const Config& config);
+  explicit ThinReplicaAsyncService(std::unique_ptr<ThinReplicaImpl>&& impl)
+      : ThinReplicaAsyncService(std::move(impl), Config{}) {}
+  ~ThinReplicaAsyncService();
+
+  // Register the service and its completion queues. Has to be called before the server is built.
+  void addToServer(grpc::ServerBuilder& builder);
+  // Start accepting subscriptions. Has to be called after the server was started.
+  void start();
+  // Stop serving and join all threads. Has to be called after the server was shut down.
+  void shutdown();
+
+  grpc::Status ReadState(grpc::ServerContext* context,
+                         const com::vmware::concord::thin_replica::ReadStateRequest* request,
+                         grpc::ServerWriter<com::vmware::concord::thin_replica::Data>* stream) override;
+
+  grpc::Status ReadStateHash(grpc::ServerContext* context,
+                             const com::vmware::concord::thin_replica::ReadStateHashRequest* request,
+                             com::vmware::concord::thin_replica::Hash* hash) override;
+
+  grpc::Status AckUpdate(grpc::ServerContext* context,
+                         const com::vmware::concord::thin_replica::BlockId* block_id,
+                         google::protobuf::Empty* empty) override;
+
+  grpc::Status Unsubscribe(grpc::ServerContext* context,
+                           const google::protobuf::Empty* request,
+                           google::protobuf::Empty* response) override;
+
+  // An outstanding operation on a completion queue, the completion queue tag
+  class CallData {
+   public:
+    virtual ~CallData() = default;
+    // Called by the completion queue thread once the operation completed
+    virtual void proceed(bool ok) = 0;
+    // Register to be put back on the completion queue once there is a live update, see waitForLiveUpdate(). Return
+    // false if there already is one or the call is done.
+    virtual bool notifyOnLiveUpdate() { return false; }
+    // Put the call back on the completion queue if it still waits for a live update
+    virtual void cancelWait() {}
+  };
+
+ private:
+  template <typename DataT>
+  friend class SubscriptionCallData;
+
+  void handleRpcs(unsigned cq_idx);
+
+  // Issue an operation on a completion queue unless the service is shutting down.
+  // Return whether the operation was issued.
+  template <typename OperationT>
+  bool issue(OperationT&& operation) {
+    std::shared_lock<std::shared_mutex> lock(shutdown_mutex_);
+    if (shutting_down_) {
+      return false;
+    }
+    operation();
+    return true;
+  }
+
+  bool isShuttingDown() const { return shutting_down_; }
+
+  // Let the call wait for a live update without an operation on its completion queue. Return false if there already
+  // is one or the call is done. Has to be issued (see issue()), so that the call is woken up on shutdown. The call
+  // stops waiting once it's back on the completion queue, see stopWaiting().
+  bool waitForLiveUpdate(CallData* call);
+  void stopWaiting(CallData* call);
+  // Put the call back on the completion queue if it waits for a live update, e.g. once the client went away
+  void wakeUpIfWaiting(CallData* call);
+
+  // Run the given job on the sync threads
+  template <typename JobT>
+  void startSync(JobT&& job) {
+    {
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      ++pending_syncs_;
+    }
+    sync_pool_->async([this, job = std::forward<JobT>(job)]() mutable {
+      job();
+      std::lock_guard<std::mutex> lock(sync_mutex_);
+      if (--pending_syncs_ == 0) {
+        sync_cv_.notify_all();
+      }
+    });
+  }
+
+  logging::Logger logger_;
+  std::unique_ptr<ThinReplicaImpl> impl_;
+  const Config config_;
+  std::unique_ptr<concord::util::ThreadPool> sync_pool_;
+  // Jobs given to the sync pool which didn't finish yet, including the queued ones
+  std::mutex sync_mutex_;
+  std::condition_variable sync_cv_;
+  size_t pending_syncs_{0};
+  std::vector<std::unique_ptr<grpc::ServerCompletionQueue>> cqs_;
+  std::vector<std::thread> cq_threads_;
+  // No operations are issued once shutting down, see issue()
+  std::shared_mutex shutdown_mutex_;
+  std::atomic_bool shutting_down_{false};
+  // Calls waiting for a live update, see waitForLiveUpdate()
+  std::mutex waiting_mutex_;
+  std::unordered_set<CallData*> waiting_calls_;
+};
+
+}  // namespace thin_replica
+}  // namespace concord
+
+#endif  // CONCORD_THIN_REPLICA_ASYNC_GRPC_SERVICES_HPP_
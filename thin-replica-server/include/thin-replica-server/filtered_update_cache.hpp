@@ -0,0 +1,105 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#ifndef CONCORD_THIN_REPLICA_FILTERED_UPDATE_CACHE_HPP_
+#define CONCORD_THIN_REPLICA_FILTERED_UPDATE_CACHE_HPP_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "assertUtils.hpp"
+#include "kvbc_app_filter/kvbc_app_filter.h"
+#include "subscription_buffer.hpp"
+
+namespace concord {
+namespace thin_replica {
+
+// Memoizes the filtered live updates and their hashes per (block id, client
+// id). All subscribers of the same client see the same filtered update, hence
+// it is computed by whichever subscriber gets to it first and shared with the
+// others. Only the newest max_blocks block ids are kept - subscribers that fall
+// further behind are disconnected by their SubUpdateBuffer anyway.
+class FilteredUpdateCache {
+ public:
+  typedef std::shared_ptr<const kvbc::KvbFilteredUpdate> FilteredUpdatePtr;
+
+  explicit FilteredUpdateCache(size_t max_blocks) : max_blocks_(max_blocks) { ConcordAssertGT(max_blocks_, 0); }
+
+  FilteredUpdateCache(const FilteredUpdateCache&) = delete;
+  FilteredUpdateCache& operator=(const FilteredUpdateCache&) = delete;
+
+  // Return the update filtered for the filter's client
+  FilteredUpdatePtr filteredUpdate(const SubUpdate& update, kvbc::KvbAppFilter& filter) {
+    auto entry = getEntry(update.block_id, filter.getClientId());
+    return filteredUpdate(*entry, update, filter);
+  }
+
+  // Return the hash of the update filtered for the filter's client
+  std::string hash(const SubUpdate& update, kvbc::KvbAppFilter& filter) {
+    auto entry = getEntry(update.block_id, filter.getClientId());
+    std::call_once(entry->hash_once,
+                   [&] { entry->hash = filter.hashUpdate(*filteredUpdate(*entry, update, filter)); });
+    return entry->hash;
+  }
+
+  // Number of (block id, client id) pairs currently cached
+  size_t size() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t size = 0;
+    for (const auto& [block_id, entries] : blocks_) {
+      (void)block_id;
+      size += entries.size();
+    }
+    return size;
+  }
+
+ private:
+  struct Entry {
+    std::once_flag filtered_once;
+    FilteredUpdatePtr filtered;
+    std::once_flag hash_once;
+    std::string hash;
+  };
+
+  // Entries are handed out as shared pointers so that an eviction doesn't pull
+  // the result from under a subscriber that is still computing or using it.
+  std::shared_ptr<Entry> getEntry(kvbc::BlockId block_id, const std::string& client_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = blocks_[block_id][client_id];
+    if (!entry) entry = std::make_shared<Entry>();
+    auto result = entry;
+    while (blocks_.size() > max_blocks_) {
+      blocks_.erase(blocks_.begin());
+    }
+    return result;
+  }
+
+  static FilteredUpdatePtr filteredUpdate(Entry& entry, const SubUpdate& update, kvbc::KvbAppFilter& filter) {
+    std::call_once(entry.filtered_once, [&] {
+      entry.filtered = std::make_shared<const kvbc::KvbFilteredUpdate>(filter.filterUpdate(update));
+    });
+    return entry.filtered;
+  }
+
+  const size_t max_blocks_;
+  std::mutex mutex_;
+  std::map<kvbc::BlockId, std::unordered_map<std::string, std::shared_ptr<Entry>>> blocks_;
+};
+
+}  // namespace thin_replica
+}  // namespace concord
+
+#endif  // CONCORD_THIN_REPLICA_FILTERED_UPDATE_CACHE_HPP_
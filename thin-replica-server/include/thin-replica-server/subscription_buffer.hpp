@@ -19,6 +19,8 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <tuple>
 #include <unordered_set>
 #include "Logger.hpp"
@@ -37,12 +39,18 @@ class ConsumerTooSlow : public std::runtime_error {
 
 typedef kvbc::BlockUpdate SubUpdate;
 typedef kvbc::EventGroupUpdate SubEventGroupUpdate;
+// Updates are immutable once published and shared by all subscribers
+typedef std::shared_ptr<const SubUpdate> SubUpdatePtr;
+typedef std::shared_ptr<const SubEventGroupUpdate> SubEventGroupUpdatePtr;
 
 // Each subscriber creates its own spsc queue and puts it into the shared list
 // of subscriber buffers. This is a thread-safe implementation around boost's
 // spsc queue in order to use an additional wake-up mechanism. We expect a
 // single producer (the commands handler) and a single consumer (the subscriber
 // thread in the thin replica gRPC service).
+// The queue holds references to updates shared with the other subscribers. It
+// acts as the subscriber's cursor into the stream of updates: pushing is a
+// reference count increment, no matter how big the update is.
 class SubUpdateBuffer {
  public:
   explicit SubUpdateBuffer(size_t size)
@@ -59,10 +67,14 @@ class SubUpdateBuffer {
   SubUpdateBuffer& operator=(const SubUpdateBuffer&) = delete;
 
   // Add an update to the queue and notify waiting subscribers
-  void Push(const SubUpdate& update) {
+  void Push(const SubUpdate& update) { Push(std::make_shared<const SubUpdate>(update)); }
+
+  void Push(SubUpdatePtr update) {
+    ConcordAssertNE(update, nullptr);
+    const auto block_id = update->block_id;
     {
       std::unique_lock<std::mutex> lock(mutex_);
-      if (!too_slow_ && !queue_.push(update)) {
+      if (!too_slow_ && !queue_.push(std::move(update))) {
         // If we fail to push a new update (because the queue is full) we
         // indicate that this queue is unusable and the reader should clean-up.
         // Not stopping the subscription will lead to a failure on the consumer
@@ -70,17 +82,24 @@ class SubUpdateBuffer {
         too_slow_ = true;
         LOG_WARN(logger_, "Failed to add update. Consumer too slow.");
       } else {
-        newest_block_id_ = update.block_id;
+        newest_block_id_ = block_id;
       }
+      notifyNonEmpty(notify_);
     }
     cv_.notify_one();
   }
 
   // Add an update to the queue and notify waiting subscribers
   void PushEventGroup(const SubEventGroupUpdate& update) {
+    PushEventGroup(std::make_shared<const SubEventGroupUpdate>(update));
+  }
+
+  void PushEventGroup(SubEventGroupUpdatePtr update) {
+    ConcordAssertNE(update, nullptr);
+    const auto event_group_id = update->event_group_id;
     {
       std::unique_lock<std::mutex> lock(eg_mutex_);
-      if (!eg_too_slow_ && !eg_queue_.push(update)) {
+      if (!eg_too_slow_ && !eg_queue_.push(std::move(update))) {
         // If we fail to push a new update (because the queue is full) we
         // indicate that this queue is unusable and the reader should clean-up.
         // Not stopping the subscription will lead to a failure on the consumer
@@ -88,14 +107,22 @@ class SubUpdateBuffer {
         eg_too_slow_ = true;
         LOG_WARN(logger_, "Failed to add update. Consumer too slow.");
       } else {
-        newest_event_group_id_ = update.event_group_id;
+        newest_event_group_id_ = event_group_id;
       }
+      notifyNonEmpty(eg_notify_);
     }
     eg_cv_.notify_one();
   }
 
-  // Return the oldest update (block if queue is empty)
+  // Return a copy of the oldest update (block if queue is empty)
   void Pop(SubUpdate& out) {
+    SubUpdatePtr update;
+    Pop(update);
+    out = *update;
+  }
+
+  // Return the oldest update (block if queue is empty)
+  void Pop(SubUpdatePtr& out) {
     std::unique_lock<std::mutex> lock(mutex_);
     // Boost's spsc queue is wait-free but we want to block here
     cv_.wait(lock, [this] { return too_slow_ || queue_.read_available(); });
@@ -111,6 +138,14 @@ class SubUpdateBuffer {
 
   template <typename RepT, typename PeriodT>
   bool TryPop(SubUpdate& out, const std::chrono::duration<RepT, PeriodT>& timeout) {
+    SubUpdatePtr update;
+    if (!TryPop(update, timeout)) return false;
+    out = *update;
+    return true;
+  }
+
+  template <typename RepT, typename PeriodT>
+  bool TryPop(SubUpdatePtr& out, const std::chrono::duration<RepT, PeriodT>& timeout) {
     std::unique_lock<std::mutex> lock(mutex_);
     // Boost's spsc queue is wait-free but we want to block here
     cv_.wait_for(lock, timeout, [this] { return too_slow_ || queue_.read_available(); });
@@ -128,8 +163,15 @@ class SubUpdateBuffer {
     return false;
   }
 
-  // Return the oldest update (event group if queue is empty)
+  // Return a copy of the oldest update (event group if queue is empty)
   void PopEventGroup(SubEventGroupUpdate& out) {
+    SubEventGroupUpdatePtr update;
+    PopEventGroup(update);
+    out = *update;
+  }
+
+  // Return the oldest update (event group if queue is empty)
+  void PopEventGroup(SubEventGroupUpdatePtr& out) {
     std::unique_lock<std::mutex> lock(eg_mutex_);
     // Boost's spsc queue is wait-free but we want to block here
     eg_cv_.wait(lock, [this] { return eg_too_slow_ || eg_queue_.read_available(); });
@@ -145,6 +187,14 @@ class SubUpdateBuffer {
 
   template <typename RepT, typename PeriodT>
   bool TryPopEventGroup(SubEventGroupUpdate& out, const std::chrono::duration<RepT, PeriodT>& timeout) {
+    SubEventGroupUpdatePtr update;
+    if (!TryPopEventGroup(update, timeout)) return false;
+    out = *update;
+    return true;
+  }
+
+  template <typename RepT, typename PeriodT>
+  bool TryPopEventGroup(SubEventGroupUpdatePtr& out, const std::chrono::duration<RepT, PeriodT>& timeout) {
     std::unique_lock<std::mutex> lock(eg_mutex_);
     // Boost's spsc queue is wait-free but we want to block here
     eg_cv_.wait_for(lock, timeout, [this] { return eg_too_slow_ || eg_queue_.read_available(); });
@@ -184,6 +234,37 @@ class SubUpdateBuffer {
     return eg_cv_.wait_for(lock, duration, [this] { return eg_queue_.read_available(); });
   }
 
+  // Instead of blocking until there is an update to pop, register `notify` to
+  // be called by the next push (also if the consumer turns out to be too
+  // slow). Return false without registering if there already is an update to
+  // pop. At most one notification can be registered. It is called with the
+  // buffer locked, hence it has to be quick and must not use the buffer.
+  bool notifyWhenNonEmpty(std::function<void()> notify) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (too_slow_ || queue_.read_available()) return false;
+    ConcordAssert(!notify_);
+    notify_ = std::move(notify);
+    return true;
+  }
+
+  bool notifyWhenEventGroupNonEmpty(std::function<void()> notify) {
+    std::unique_lock<std::mutex> lock(eg_mutex_);
+    if (eg_too_slow_ || eg_queue_.read_available()) return false;
+    ConcordAssert(!eg_notify_);
+    eg_notify_ = std::move(notify);
+    return true;
+  }
+
+  // Drop the registered notification. Return whether it was still registered,
+  // i.e. it won't be called anymore. Otherwise, it was called already.
+  bool cancelNotification() {
+    std::scoped_lock lock(mutex_, eg_mutex_);
+    const bool registered = notify_ || eg_notify_;
+    notify_ = nullptr;
+    eg_notify_ = nullptr;
+    return registered;
+  }
+
   // This is not thread-safe and the caller has to make sure that there is no
   // writer or reader active. This is a trade-off in order to stay lock-free.
   void removeAllUpdates() {
@@ -223,7 +304,7 @@ class SubUpdateBuffer {
     std::unique_lock<std::mutex> lock(mutex_);
     // Undefined behavior if the queue is empty
     ConcordAssertGT(queue_.read_available(), 0);
-    return queue_.front().block_id;
+    return queue_.front()->block_id;
   }
 
   // The caller needs to make sure that the queue is not empty when calling
@@ -231,7 +312,7 @@ class SubUpdateBuffer {
     std::unique_lock<std::mutex> lock(eg_mutex_);
     // Undefined behavior if the queue is empty
     ConcordAssertGT(eg_queue_.read_available(), 0);
-    return eg_queue_.front().event_group_id;
+    return eg_queue_.front()->event_group_id;
   }
 
   bool Empty() {
@@ -267,9 +348,17 @@ class SubUpdateBuffer {
   }
 
  private:
+  // Call and drop the given notification, if registered
+  static void notifyNonEmpty(std::function<void()>& notify) {
+    if (notify) {
+      notify();
+      notify = nullptr;
+    }
+  }
+
   logging::Logger logger_;
-  boost::lockfree::spsc_queue<SubUpdate> queue_;
-  boost::lockfree::spsc_queue<SubEventGroupUpdate> eg_queue_;
+  boost::lockfree::spsc_queue<SubUpdatePtr> queue_;
+  boost::lockfree::spsc_queue<SubEventGroupUpdatePtr> eg_queue_;
   // lock used for updating the queue as well as the variables below
   std::mutex mutex_;
   std::condition_variable cv_;
@@ -281,6 +370,9 @@ class SubUpdateBuffer {
   bool eg_too_slow_;
   uint64_t newest_block_id_;
   uint64_t newest_event_group_id_;
+  // See notifyWhenNonEmpty(), guarded by mutex_ and eg_mutex_ respectively
+  std::function<void()> notify_;
+  std::function<void()> eg_notify_;
 };
 
 // Thread-safe list implementation which manages subscriber queues. You can
@@ -310,10 +402,10 @@ class SubBufferList {
   }
 
   // Populate updates to all subscribers
-  // Note: This is potentially expensive depending on the update size and the
-  // number of subscribers. If TRC/TRS stays then we might want to think about
-  // an optimization.
-  virtual void updateSubBuffers(SubUpdate& update) {
+  // Note: The update is copied once and the copy is shared by all subscribers.
+  virtual void updateSubBuffers(SubUpdate& update) { updateSubBuffers(std::make_shared<const SubUpdate>(update)); }
+
+  virtual void updateSubBuffers(const SubUpdatePtr& update) {
     std::lock_guard<std::mutex> lock(mutex_);
     for (const auto& it : subscriber_) {
       it->Push(update);
@@ -321,6 +413,10 @@ class SubBufferList {
   }
 
   virtual void updateEventGroupSubBuffers(SubEventGroupUpdate& update) {
+    updateEventGroupSubBuffers(std::make_shared<const SubEventGroupUpdate>(update));
+  }
+
+  virtual void updateEventGroupSubBuffers(const SubEventGroupUpdatePtr& update) {
     std::lock_guard<std::mutex> lock(mutex_);
     for (const auto& it : subscriber_) {
       it->PushEventGroup(update);
@@ -24,7 +24,12 @@
 #include <opentracing/tracer.h>
 #endif
 #include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <string>
@@ -35,10 +40,13 @@
 #include "kv_types.hpp"
 #include "kvbc_app_filter/kvbc_app_filter.h"
 #include "kvbc_app_filter/kvbc_key_types.h"
+#include "lru_cache.hpp"
 
 #include "thin_replica.grpc.pb.h"
+#include "filtered_update_cache.hpp"
 #include "subscription_buffer.hpp"
 #include "trs_metrics.hpp"
+#include "thread_pool.hpp"
 
 using google::protobuf::util::TimeUtil;
 using namespace std::chrono_literals;
@@ -70,6 +78,12 @@ struct ThinReplicaServerConfig {
   // the time duration the TRS waits before printing warning logs when
   // subscription status for live updates is not ok
   std::chrono::seconds no_live_subscription_warn_duration;
+  // the number of blocks read and filtered ahead of the stream while a
+  // subscriber catches up with the blockchain
+  const size_t sync_read_ahead;
+  // the number of threads, shared by all subscribers, reading and filtering
+  // the blocks a subscriber has to catch up with
+  const unsigned num_sync_readers;
 
   ThinReplicaServerConfig(const bool is_insecure_trs_,
                           const std::string& tls_trs_cert_path_,
@@ -77,17 +91,23 @@ struct ThinReplicaServerConfig {
                           SubBufferList& subscriber_list_,
                           std::unordered_set<std::string>& client_id_set_,
                           const uint16_t update_metrics_aggregator_thresh_ = 100,
-                          std::chrono::seconds no_live_subscription_warn_duration_ = kNoLiveSubscriptionWarnDuration)
+                          std::chrono::seconds no_live_subscription_warn_duration_ = kNoLiveSubscriptionWarnDuration,
+                          const size_t sync_read_ahead_ = kSyncReadAhead,
+                          const unsigned num_sync_readers_ = kNumSyncReaders)
       : is_insecure_trs(is_insecure_trs_),
         tls_trs_cert_path(tls_trs_cert_path_),
         rostorage(rostorage_),
         subscriber_list(subscriber_list_),
         client_id_set(client_id_set_),
         update_metrics_aggregator_thresh(update_metrics_aggregator_thresh_),
-        no_live_subscription_warn_duration(no_live_subscription_warn_duration_) {}
+        no_live_subscription_warn_duration(no_live_subscription_warn_duration_),
+        sync_read_ahead(sync_read_ahead_),
+        num_sync_readers(num_sync_readers_) {}
 
  private:
   static constexpr std::chrono::seconds kNoLiveSubscriptionWarnDuration = 60s;
+  static constexpr size_t kSyncReadAhead = 64;
+  static constexpr unsigned kNumSyncReaders = 4;
 };
 
 class ThinReplicaImpl {
@@ -109,6 +129,10 @@ class ThinReplicaImpl {
   using KvbAppFilterPtr = std::shared_ptr<kvbc::KvbAppFilter>;
   static constexpr size_t kSubUpdateBufferSize{1000u};
   const std::chrono::milliseconds kWaitForUpdateTimeout{100};
+  // How often, in blocks sent, the catch-up rate metric is updated
+  static constexpr kvbc::BlockId kCatchupRateInterval{1000};
+  // Number of client ids whose block hash index is kept, see getBlockHashIndex()
+  static constexpr size_t kMaxBlockHashIndexes{64u};
   const std::string kCorrelationIdTag = "cid";
   // last timestamp when subscription status for live updates was not ok
   std::optional<std::chrono::steady_clock::time_point> last_failed_subscribe_status_time;
@@ -116,7 +140,12 @@ class ThinReplicaImpl {
  public:
   ThinReplicaImpl(std::unique_ptr<ThinReplicaServerConfig> config,
                   std::shared_ptr<concordMetrics::Aggregator> aggregator)
-      : logger_(logging::getLogger("concord.thin_replica")), config_(std::move(config)), aggregator_(aggregator) {}
+      : logger_(logging::getLogger("concord.thin_replica")),
+        config_(std::move(config)),
+        aggregator_(aggregator),
+        sync_readers_(config_->num_sync_readers) {
+    ConcordAssertGT(config_->sync_read_ahead, 0);
+  }
 
   ThinReplicaImpl(const ThinReplicaImpl&) = delete;
   ThinReplicaImpl(ThinReplicaImpl&&) = delete;
@@ -231,10 +260,52 @@ class ThinReplicaImpl {
     return grpc::Status(grpc::StatusCode::UNIMPLEMENTED, "AckUpdate");
   }
 
+  // State of a subscription that caught up with the live updates
+  struct LiveSubscription {
+    KvbAppFilterPtr kvb_filter;
+    std::shared_ptr<SubUpdateBuffer> live_updates;
+    std::shared_ptr<kvbc::FilteredBlockHashIndex> block_hash_index;
+    std::unique_ptr<ThinReplicaServerMetrics> metrics;
+    // Whether event groups or legacy events are streamed
+    bool event_groups{false};
+    uint16_t update_aggregator_counter{0};
+  };
+
   template <typename ServerContextT, typename ServerWriterT, typename DataT>
   grpc::Status SubscribeToUpdates(ServerContextT* context,
                                   const com::vmware::concord::thin_replica::SubscriptionRequest* request,
                                   ServerWriterT* stream) {
+    LiveSubscription subscription;
+    auto status = startSubscription<ServerContextT, ServerWriterT, DataT>(context, request, stream, subscription);
+    if (!status.ok()) {
+      return status;
+    }
+
+    // Read, filter, and send live updates
+    DataT data;
+    try {
+      while (!context->IsCancelled()) {
+        if (!nextLiveUpdate(subscription, data, kWaitForUpdateTimeout)) {
+          continue;
+        }
+        if (!stream->Write(data)) {
+          throw StreamClosed("Subscription stream closed");
+        }
+      }
+    } catch (std::exception& error) {
+      LOG_INFO(logger_, "Subscription stream closed: " << error.what());
+    }
+    return finishSubscription(subscription, context->IsCancelled());
+  }
+
+  // Set up the subscription and send the updates from storage until the subscription caught up with the live updates.
+  // On success, the live updates are to be read with nextLiveUpdate() and the subscription is to be closed with
+  // finishSubscription(). The caller is expected to send the updates read with nextLiveUpdate().
+  template <typename ServerContextT, typename ServerWriterT, typename DataT>
+  grpc::Status startSubscription(ServerContextT* context,
+                                 const com::vmware::concord::thin_replica::SubscriptionRequest* request,
+                                 ServerWriterT* stream,
+                                 LiveSubscription& subscription) {
     std::string stream_type;
     if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
       stream_type = "data";
@@ -275,10 +346,9 @@ class ThinReplicaImpl {
     }
 
     // TRS metrics
-    ThinReplicaServerMetrics metrics_(stream_type, getClientId(context));
-    metrics_.setAggregator(aggregator_);
-    uint16_t update_aggregator_counter = 0;
-    metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+    auto metrics = std::make_unique<ThinReplicaServerMetrics>(stream_type, getClientId(context));
+    metrics->setAggregator(aggregator_);
+    metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
 
     // If legacy event request then mark whether we need to transition into event groups
     bool is_event_group_transition = false;
@@ -295,89 +365,39 @@ class ThinReplicaImpl {
 
     if (request->has_events() && !is_event_group_transition) {
       try {
-        syncAndSend<ServerContextT, ServerWriterT, DataT>(context, start_block_id, live_updates, stream, kvb_filter);
+        syncAndSend<ServerContextT, ServerWriterT, DataT>(
+            context, start_block_id, live_updates, stream, kvb_filter, *metrics);
       } catch (concord::kvbc::NoLegacyEvents& error) {
         LOG_WARN(logger_, error.what());
         is_event_group_transition = true;
       } catch (StreamCancelled& error) {
         config_->subscriber_list.removeBuffer(live_updates);
         live_updates->removeAllUpdates();
-        metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-        metrics_.updateAggregator();
+        metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+        metrics->updateAggregator();
         return grpc::Status(grpc::StatusCode::CANCELLED, error.what());
       } catch (UpdatePruned& error) {
         LOG_WARN(logger_, "Requested update pruned in syncAndSend: " << error.what());
         config_->subscriber_list.removeBuffer(live_updates);
         live_updates->removeAllEventGroupUpdates();
-        metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-        metrics_.updateAggregator();
+        metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+        metrics->updateAggregator();
         return grpc::Status(grpc::StatusCode::NOT_FOUND, error.what());
       } catch (std::exception& error) {
         LOG_ERROR(logger_, error.what());
         config_->subscriber_list.removeBuffer(live_updates);
         live_updates->removeAllUpdates();
 
-        metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-        metrics_.updateAggregator();
+        metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+        metrics->updateAggregator();
 
         std::stringstream msg;
         msg << "Couldn't transition from block id " << start_block_id << " to new blocks";
         return grpc::Status(grpc::StatusCode::UNKNOWN, msg.str());
       }
-      // Read, filter, and send live updates
-      SubUpdate update;
-      try {
-        while (!context->IsCancelled() && !is_event_group_transition) {
-          metrics_.queue_size.Get().Set(live_updates->Size());
-          bool is_update_available = false;
-          is_update_available = live_updates->TryPop(update, kWaitForUpdateTimeout);
-          if (not is_update_available) {
-            continue;
-          }
-          auto kvb_update =
-              kvbc::KvbUpdate{update.block_id, update.correlation_id, std::move(update.immutable_kv_pairs)};
-          const auto& filtered_update = kvb_filter->filterUpdate(kvb_update);
-          if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
-            LOG_DEBUG(logger_, "Live updates send data");
-            auto correlation_id = filtered_update.correlation_id;
-            if (update.parent_span) {
-              sendData(stream, filtered_update, {*update.parent_span});
-            } else {
-              std::string propagated_span_context;
-#ifdef USE_OPENTRACING
-              auto span = opentracing::Tracer::Global()->StartSpan(
-                  "trs_stream_update", {opentracing::SetTag{kCorrelationIdTag, correlation_id}});
-              std::ostringstream context;
-              const opentracing::Span& span_to_serialize = *span;
-              span_to_serialize.tracer().Inject(span_to_serialize.context(), context);
-              propagated_span_context = context.str();
-#endif
-              sendData(stream, filtered_update, {propagated_span_context});
-            }
-          } else if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Hash>()) {
-            LOG_DEBUG(logger_, "Live updates send hash");
-            sendHash(stream, update.block_id, kvb_filter->hashUpdate(filtered_update));
-          }
-          metrics_.last_sent_block_id.Get().Set(update.block_id);
-          if (++update_aggregator_counter == config_->update_metrics_aggregator_thresh) {
-            metrics_.updateAggregator();
-            update_aggregator_counter = 0;
-          }
-        }
-      } catch (std::exception& error) {
-        LOG_INFO(logger_, "Subscription stream closed: " << error.what());
-      }
-
-      // Clean up if we need to return
-      if (not is_event_group_transition || context->IsCancelled()) {
-        config_->subscriber_list.removeBuffer(live_updates);
-        live_updates->removeAllUpdates();
-        metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-        metrics_.updateAggregator();
-        if (context->IsCancelled()) {
-          LOG_INFO(logger_, "Subscription cancelled");
-          return grpc::Status::CANCELLED;
-        }
+      if (not is_event_group_transition) {
+        subscription = LiveSubscription{kvb_filter, live_updates, getBlockHashIndex(kvb_filter->getClientId())};
+        subscription.metrics = std::move(metrics);
         return grpc::Status::OK;
       }
     }
@@ -404,64 +424,125 @@ class ThinReplicaImpl {
       LOG_WARN(logger_, "StreamCancelled in syncAndSendEventGroups: " << error.what());
       config_->subscriber_list.removeBuffer(live_updates);
       live_updates->removeAllEventGroupUpdates();
-      metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-      metrics_.updateAggregator();
+      metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+      metrics->updateAggregator();
       return grpc::Status(grpc::StatusCode::CANCELLED, error.what());
     } catch (UpdatePruned& error) {
       LOG_WARN(logger_, "Requested update pruned in syncAndSendEventGroups: " << error.what());
       config_->subscriber_list.removeBuffer(live_updates);
       live_updates->removeAllEventGroupUpdates();
-      metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-      metrics_.updateAggregator();
+      metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+      metrics->updateAggregator();
       return grpc::Status(grpc::StatusCode::NOT_FOUND, error.what());
     } catch (std::exception& error) {
       LOG_ERROR(logger_, "Exception in syncAndSendEventGroups: " << error.what());
       config_->subscriber_list.removeBuffer(live_updates);
       live_updates->removeAllEventGroupUpdates();
 
-      metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-      metrics_.updateAggregator();
+      metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+      metrics->updateAggregator();
 
       std::stringstream msg;
       msg << "Couldn't transition from event_group_id " << event_group_id << " to new event groups";
       return grpc::Status(grpc::StatusCode::UNKNOWN, msg.str());
     }
 
-    // Read, filter, and send live updates
-    SubEventGroupUpdate sub_eg_update;
-    try {
-      while (not context->IsCancelled()) {
-        metrics_.queue_size.Get().Set(live_updates->SizeEventGroupQueue());
-        bool is_update_available = false;
-        is_update_available = live_updates->TryPopEventGroup(sub_eg_update, kWaitForUpdateTimeout);
-        if (not is_update_available) {
-          continue;
-        }
-        auto eg_update = kvbc::EgUpdate{sub_eg_update.event_group_id, std::move(sub_eg_update.event_group)};
-        const auto& filtered_eg_update = kvb_filter->filterEventGroupUpdate(eg_update);
-        if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
-          //  auto correlation_id = filtered_update.correlation_id; (TODO (Shruti) - Get correlation ID)
-          sendEventGroupData(stream, filtered_eg_update, sub_eg_update.parent_span);
-        } else if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Hash>()) {
-          sendEventGroupHash(
-              stream, sub_eg_update.event_group_id, kvb_filter->hashEventGroupUpdate(filtered_eg_update));
+    subscription = LiveSubscription{kvb_filter, live_updates, getBlockHashIndex(kvb_filter->getClientId())};
+    subscription.metrics = std::move(metrics);
+    subscription.event_groups = true;
+    return grpc::Status::OK;
+  }
+
+  // Read and filter the next live update of the subscription into the message to send. Return false if no update
+  // arrived within the given timeout. Throws ConsumerTooSlow if the subscriber fell too far behind.
+  // The updates are shared with the other subscribers and the filtered
+  // results are shared with the other subscribers of the same client.
+  template <typename DataT, typename RepT, typename PeriodT>
+  bool nextLiveUpdate(LiveSubscription& subscription, DataT& out, const std::chrono::duration<RepT, PeriodT>& timeout) {
+    auto& live_updates = subscription.live_updates;
+    auto& kvb_filter = subscription.kvb_filter;
+    auto& metrics = *subscription.metrics;
+    if (not subscription.event_groups) {
+      metrics.queue_size.Get().Set(live_updates->Size());
+      SubUpdatePtr update;
+      if (not live_updates->TryPop(update, timeout)) {
+        return false;
+      }
+      if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
+        LOG_DEBUG(logger_, "Live updates send data");
+        const auto filtered_update = filtered_update_cache_.filteredUpdate(*update, *kvb_filter);
+        auto correlation_id = filtered_update->correlation_id;
+        if (update->parent_span) {
+          out = makeData(*filtered_update, {*update->parent_span});
+        } else {
+          std::string propagated_span_context;
+#ifdef USE_OPENTRACING
+          auto span = opentracing::Tracer::Global()->StartSpan(
+              "trs_stream_update", {opentracing::SetTag{kCorrelationIdTag, correlation_id}});
+          std::ostringstream context;
+          const opentracing::Span& span_to_serialize = *span;
+          span_to_serialize.tracer().Inject(span_to_serialize.context(), context);
+          propagated_span_context = context.str();
+#endif
+          out = makeData(*filtered_update, {propagated_span_context});
         }
-        metrics_.last_sent_event_group_id.Get().Set(sub_eg_update.event_group_id);
-        if (++update_aggregator_counter == config_->update_metrics_aggregator_thresh) {
-          metrics_.updateAggregator();
-          update_aggregator_counter = 0;
+      } else if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Hash>()) {
+        LOG_DEBUG(logger_, "Live updates send hash");
+        const auto hash = filtered_update_cache_.hash(*update, *kvb_filter);
+        if (!subscription.block_hash_index->empty()) {
+          subscription.block_hash_index->append(update->block_id, hash);
         }
+        out = makeHash(update->block_id, hash);
       }
-    } catch (std::exception& error) {
-      LOG_INFO(logger_, "Subscription stream closed: " << error.what());
+      metrics.last_sent_block_id.Get().Set(update->block_id);
+    } else {
+      metrics.queue_size.Get().Set(live_updates->SizeEventGroupQueue());
+      SubEventGroupUpdatePtr sub_eg_update;
+      if (not live_updates->TryPopEventGroup(sub_eg_update, timeout)) {
+        return false;
+      }
+      const auto& filtered_eg_update = kvb_filter->filterEventGroupUpdate(*sub_eg_update);
+      if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
+        //  auto correlation_id = filtered_update.correlation_id; (TODO (Shruti) - Get correlation ID)
+        out = makeEventGroupData(filtered_eg_update, sub_eg_update->parent_span);
+      } else if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Hash>()) {
+        out = makeEventGroupHash(sub_eg_update->event_group_id, kvb_filter->hashEventGroupUpdate(filtered_eg_update));
+      }
+      metrics.last_sent_event_group_id.Get().Set(sub_eg_update->event_group_id);
     }
+    if (++subscription.update_aggregator_counter == config_->update_metrics_aggregator_thresh) {
+      metrics.updateAggregator();
+      subscription.update_aggregator_counter = 0;
+    }
+    return true;
+  }
+
+  // Instead of waiting in nextLiveUpdate(), register `notify` to be called once there is a live update to read, see
+  // SubUpdateBuffer::notifyWhenNonEmpty(). Return false without registering if there already is one.
+  bool notifyOnLiveUpdate(LiveSubscription& subscription, std::function<void()> notify) {
+    if (subscription.event_groups) {
+      return subscription.live_updates->notifyWhenEventGroupNonEmpty(std::move(notify));
+    }
+    return subscription.live_updates->notifyWhenNonEmpty(std::move(notify));
+  }
+
+  // Drop the notification registered with notifyOnLiveUpdate(). Return whether it wasn't called yet.
+  bool cancelLiveUpdateNotification(LiveSubscription& subscription) {
+    return subscription.live_updates->cancelNotification();
+  }
 
-    config_->subscriber_list.removeBuffer(live_updates);
-    live_updates->removeAllEventGroupUpdates();
-    metrics_.subscriber_list_size.Get().Set(config_->subscriber_list.Size());
-    metrics_.updateAggregator();
+  // Unsubscribe from the live updates once the subscription stream is done
+  grpc::Status finishSubscription(LiveSubscription& subscription, bool cancelled) {
+    config_->subscriber_list.removeBuffer(subscription.live_updates);
+    if (subscription.event_groups) {
+      subscription.live_updates->removeAllEventGroupUpdates();
+    } else {
+      subscription.live_updates->removeAllUpdates();
+    }
+    subscription.metrics->subscriber_list_size.Get().Set(config_->subscriber_list.Size());
+    subscription.metrics->updateAggregator();
 
-    if (context->IsCancelled()) {
+    if (cancelled) {
       LOG_INFO(logger_, "Subscription cancelled");
       return grpc::Status::CANCELLED;
     }
@@ -620,46 +701,26 @@ class ThinReplicaImpl {
                               ServerWriterT* stream,
                               kvbc::BlockId start,
                               kvbc::BlockId end,
-                              std::shared_ptr<kvbc::KvbAppFilter> kvb_filter) {
-    boost::lockfree::spsc_queue<kvbc::KvbFilteredUpdate> queue{10};
-    std::atomic_bool close_stream = false;
-
-    auto kvb_reader = std::async(std::launch::async,
-                                 &kvbc::KvbAppFilter::readBlockRange,
-                                 kvb_filter,
-                                 start,
-                                 end,
-                                 std::ref(queue),
-                                 std::ref(close_stream));
-
-    kvbc::KvbFilteredUpdate kvb_update;
-    while (kvb_reader.wait_for(0s) != std::future_status::ready || !queue.empty()) {
-      if (context->IsCancelled()) {
-        close_stream = true;
-        while (!queue.empty()) {
-          queue.pop(kvb_update);
-        }
-        throw StreamCancelled("Kvb data stream cancelled");
-      }
-      while (queue.pop(kvb_update)) {
-        try {
-          sendData(stream, kvb_update);
-        } catch (StreamClosed& error) {
-          LOG_WARN(logger, "Data stream closed at block " << kvb_update.block_id);
-
-          // Stop kvb_reader and empty queue
-          close_stream = true;
-          while (!queue.empty()) {
-            queue.pop(kvb_update);
-          }
-          throw;
-        }
-      }
+                              std::shared_ptr<kvbc::KvbAppFilter> kvb_filter,
+                              ThinReplicaServerMetrics* metrics = nullptr) {
+    if (start > end || end > (config_->rostorage)->getLastBlockId()) {
+      throw kvbc::InvalidBlockRange(start, end);
     }
-    ConcordAssert(queue.empty());
-
-    // Throws exception if something goes wrong
-    kvb_reader.get();
+    readAheadAndSend(
+        context,
+        start,
+        end,
+        metrics,
+        [kvb_filter](kvbc::BlockId block_id) { return kvb_filter->readFilteredBlock(block_id); },
+        [&](const kvbc::KvbFilteredUpdate& kvb_update) {
+          try {
+            sendData(stream, kvb_update);
+          } catch (StreamClosed& error) {
+            LOG_WARN(logger, "Data stream closed at block " << kvb_update.block_id);
+            throw;
+          }
+        },
+        "Kvb data stream cancelled");
   }
 
   template <typename ServerContextT, typename ServerWriterT>
@@ -714,13 +775,60 @@ class ThinReplicaImpl {
                                 ServerWriterT* stream,
                                 kvbc::BlockId start,
                                 kvbc::BlockId end,
-                                std::shared_ptr<kvbc::KvbAppFilter> kvb_filter) {
+                                std::shared_ptr<kvbc::KvbAppFilter> kvb_filter,
+                                ThinReplicaServerMetrics* metrics = nullptr) {
+    // The hashes are computed out of order, hence extend the client's hash index here
+    auto block_hash_index = getBlockHashIndex(kvb_filter->getClientId());
+    readAheadAndSend(
+        context,
+        start,
+        end,
+        metrics,
+        [kvb_filter](kvbc::BlockId block_id) { return std::make_pair(block_id, kvb_filter->readBlockHash(block_id)); },
+        [&](const std::pair<kvbc::BlockId, std::string>& block_hash) {
+          if (!block_hash_index->empty()) {
+            block_hash_index->append(block_hash.first, block_hash.second);
+          }
+          sendHash(stream, block_hash.first, block_hash.second);
+        },
+        "Kvb hash stream cancelled");
+  }
+
+  // Read the blocks [start, end] on the sync readers, up to sync_read_ahead
+  // blocks ahead of the stream, and send them in order from the calling thread.
+  // The reads still in flight when sending fails are left to finish on their
+  // own and their results are dropped.
+  template <typename ServerContextT, typename ReadT, typename SendT>
+  void readAheadAndSend(ServerContextT* context,
+                        kvbc::BlockId start,
+                        kvbc::BlockId end,
+                        ThinReplicaServerMetrics* metrics,
+                        const ReadT& read,
+                        const SendT& send,
+                        const char* cancelled_msg) {
+    std::deque<std::future<std::invoke_result_t<ReadT, kvbc::BlockId>>> read_ahead;
+    auto next_block_to_read = start;
+    const auto sync_start = std::chrono::steady_clock::now();
     for (auto block_id = start; block_id <= end; ++block_id) {
+      while (next_block_to_read <= end && read_ahead.size() < config_->sync_read_ahead) {
+        read_ahead.push_back(sync_readers_.async(read, next_block_to_read++));
+      }
       if (context->IsCancelled()) {
-        throw StreamCancelled("Kvb hash stream cancelled");
+        throw StreamCancelled(cancelled_msg);
+      }
+      // Throws if the read failed
+      auto result = read_ahead.front().get();
+      read_ahead.pop_front();
+      send(result);
+
+      const auto blocks_sent = block_id - start + 1;
+      if (metrics && (blocks_sent % kCatchupRateInterval == 0 || block_id == end)) {
+        const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - sync_start).count();
+        if (elapsed > 0) {
+          metrics->catchup_blocks_per_sec.Get().Set(static_cast<uint64_t>(blocks_sent / elapsed));
+          metrics->updateAggregator();
+        }
       }
-      std::string hash = kvb_filter->readBlockHash(block_id);
-      sendHash(stream, block_id, hash);
     }
   }
 
@@ -747,14 +855,15 @@ class ThinReplicaImpl {
                           ServerWriterT* stream,
                           kvbc::BlockId start,
                           kvbc::BlockId end,
-                          std::shared_ptr<kvbc::KvbAppFilter> kvb_filter) {
+                          std::shared_ptr<kvbc::KvbAppFilter> kvb_filter,
+                          ThinReplicaServerMetrics* metrics = nullptr) {
     static_assert(std::is_same<DataT, com::vmware::concord::thin_replica::Data>() ||
                       std::is_same<DataT, com::vmware::concord::thin_replica::Hash>(),
                   "We expect either a Data or Hash type");
     if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Data>()) {
-      readFromKvbAndSendData(logger, context, stream, start, end, kvb_filter);
+      readFromKvbAndSendData(logger, context, stream, start, end, kvb_filter, metrics);
     } else if constexpr (std::is_same<DataT, com::vmware::concord::thin_replica::Hash>()) {
-      readFromKvbAndSendHashes(logger, context, stream, start, end, kvb_filter);
+      readFromKvbAndSendHashes(logger, context, stream, start, end, kvb_filter, metrics);
     }
   }
 
@@ -786,7 +895,8 @@ class ThinReplicaImpl {
                    kvbc::BlockId start,
                    std::shared_ptr<SubUpdateBuffer>& live_updates,
                    ServerWriterT* stream,
-                   std::shared_ptr<kvbc::KvbAppFilter>& kvb_filter) {
+                   std::shared_ptr<kvbc::KvbAppFilter>& kvb_filter,
+                   ThinReplicaServerMetrics& metrics) {
     kvbc::BlockId first_block_id = (config_->rostorage)->getGenesisBlockId();
     if (start < first_block_id) {
       std::stringstream msg;
@@ -800,7 +910,7 @@ class ThinReplicaImpl {
     // Let's not wait for a live update yet due to there might be lots of
     // history we have to catch up with first
     LOG_INFO(logger_, "Sync reading from KVB [" << start << ", " << end << "]");
-    readAndSend<ServerContextT, ServerWriterT, DataT>(logger_, context, stream, start, end, kvb_filter);
+    readAndSend<ServerContextT, ServerWriterT, DataT>(logger_, context, stream, start, end, kvb_filter, &metrics);
 
     // Let's wait until we have at least one live update
     bool is_update_available = false;
@@ -832,18 +942,18 @@ class ThinReplicaImpl {
       end = live_updates->newestBlockId();
 
       LOG_INFO(logger_, "Sync filling gap [" << start << ", " << end << "]");
-      readAndSend<ServerContextT, ServerWriterT, DataT>(logger_, context, stream, start, end, kvb_filter);
+      readAndSend<ServerContextT, ServerWriterT, DataT>(logger_, context, stream, start, end, kvb_filter, &metrics);
     }
 
     // Overlap:
     // If we read updates from KVB that were added to the live updates already
     // then we just need to drop the overlap and return
     ConcordAssert(live_updates->oldestBlockId() <= end);
-    SubUpdate update;
+    SubUpdatePtr update;
     do {
       live_updates->Pop(update);
-      LOG_INFO(logger_, "Sync dropping " << update.block_id);
-    } while (update.block_id < end);
+      LOG_INFO(logger_, "Sync dropping " << update->block_id);
+    } while (update->block_id < end);
   }
 
   // Read from KVB until we are in sync with the live updates. This function
@@ -911,18 +1021,16 @@ class ThinReplicaImpl {
     // If we read updates from KVB that were added to the live updates already
     // then we just need to drop the overlap and return
     ConcordAssert(live_updates->oldestEventGroupId() <= end);
-    SubEventGroupUpdate update;
+    SubEventGroupUpdatePtr update;
     do {
       live_updates->PopEventGroup(update);
-      LOG_INFO(logger_, "Sync dropping " << update.event_group_id);
-    } while (update.event_group_id < end);
+      LOG_INFO(logger_, "Sync dropping " << update->event_group_id);
+    } while (update->event_group_id < end);
   }
 
-  // Send* prepares the response object and puts it on the stream
-  template <typename ServerWriterT>
-  void sendData(ServerWriterT* stream,
-                const kvbc::KvbFilteredUpdate& update,
-                const std::optional<std::string>& span = std::nullopt) {
+  // make* prepares the response object
+  com::vmware::concord::thin_replica::Data makeData(const kvbc::KvbFilteredUpdate& update,
+                                                    const std::optional<std::string>& span = std::nullopt) {
     com::vmware::concord::thin_replica::Data data;
     LOG_DEBUG(logger_, "sendData for block " << update.block_id);
     data.mutable_events()->set_block_id(update.block_id);
@@ -937,16 +1045,11 @@ class ThinReplicaImpl {
     if (span) {
       data.mutable_events()->set_span_context(*span);
     }
-    if (!stream->Write(data)) {
-      throw StreamClosed("Data stream closed");
-    }
+    return data;
   }
 
-  // Send* prepares the response object and puts it on the stream
-  template <typename ServerWriterT>
-  void sendEventGroupData(ServerWriterT* stream,
-                          const kvbc::KvbFilteredEventGroupUpdate& eg_update,
-                          const std::optional<std::string>& span = std::nullopt) {
+  com::vmware::concord::thin_replica::Data makeEventGroupData(const kvbc::KvbFilteredEventGroupUpdate& eg_update,
+                                                              const std::optional<std::string>& span = std::nullopt) {
     com::vmware::concord::thin_replica::Data data;
     LOG_DEBUG(logger_, "sendEventGroupData for id " << eg_update.event_group_id);
     data.mutable_event_group()->set_id(eg_update.event_group_id);
@@ -961,6 +1064,43 @@ class ThinReplicaImpl {
     if (span) {
       data.mutable_event_group()->set_trace_context(*span);
     }
+    return data;
+  }
+
+  com::vmware::concord::thin_replica::Hash makeHash(kvbc::BlockId block_id, const std::string& update_hash) {
+    com::vmware::concord::thin_replica::Hash hash;
+    hash.mutable_events()->set_block_id(block_id);
+    hash.mutable_events()->set_hash(update_hash);
+    LOG_DEBUG(logger_, "COMPARE SendHash block_id " << block_id << " update_hash " << update_hash);
+    return hash;
+  }
+
+  com::vmware::concord::thin_replica::Hash makeEventGroupHash(kvbc::EventGroupId event_group_id,
+                                                              const std::string& update_hash) {
+    com::vmware::concord::thin_replica::Hash hash;
+    hash.mutable_event_group()->set_event_group_id(event_group_id);
+    hash.mutable_event_group()->set_hash(update_hash);
+    LOG_DEBUG(logger_, "COMPARE SendHash event group id " << event_group_id << " update_hash " << update_hash);
+    return hash;
+  }
+
+  // Send* prepares the response object and puts it on the stream
+  template <typename ServerWriterT>
+  void sendData(ServerWriterT* stream,
+                const kvbc::KvbFilteredUpdate& update,
+                const std::optional<std::string>& span = std::nullopt) {
+    auto data = makeData(update, span);
+    if (!stream->Write(data)) {
+      throw StreamClosed("Data stream closed");
+    }
+  }
+
+  // Send* prepares the response object and puts it on the stream
+  template <typename ServerWriterT>
+  void sendEventGroupData(ServerWriterT* stream,
+                          const kvbc::KvbFilteredEventGroupUpdate& eg_update,
+                          const std::optional<std::string>& span = std::nullopt) {
+    auto data = makeEventGroupData(eg_update, span);
     if (!stream->Write(data)) {
       throw StreamClosed("Data event group stream closed");
     }
@@ -968,10 +1108,7 @@ class ThinReplicaImpl {
 
   template <typename ServerWriterT>
   void sendHash(ServerWriterT* stream, kvbc::BlockId block_id, const std::string& update_hash) {
-    com::vmware::concord::thin_replica::Hash hash;
-    hash.mutable_events()->set_block_id(block_id);
-    hash.mutable_events()->set_hash(update_hash);
-    LOG_DEBUG(logger_, "COMPARE SendHash block_id " << block_id << " update_hash " << update_hash);
+    auto hash = makeHash(block_id, update_hash);
     if (!stream->Write(hash)) {
       throw StreamClosed("Hash stream closed");
     }
@@ -979,10 +1116,7 @@ class ThinReplicaImpl {
 
   template <typename ServerWriterT>
   void sendEventGroupHash(ServerWriterT* stream, kvbc::EventGroupId event_group_id, const std::string& update_hash) {
-    com::vmware::concord::thin_replica::Hash hash;
-    hash.mutable_event_group()->set_event_group_id(event_group_id);
-    hash.mutable_event_group()->set_hash(update_hash);
-    LOG_DEBUG(logger_, "COMPARE SendHash event group id " << event_group_id << " update_hash " << update_hash);
+    auto hash = makeEventGroupHash(event_group_id, update_hash);
     if (!stream->Write(hash)) {
       throw StreamClosed("Hash event group stream closed");
     }
@@ -1029,7 +1163,9 @@ class ThinReplicaImpl {
   std::tuple<grpc::Status, KvbAppFilterPtr> createKvbFilter(ServerContextT* context, const RequestT* request) {
     KvbAppFilterPtr kvb_filter;
     try {
-      kvb_filter = std::make_shared<kvbc::KvbAppFilter>(config_->rostorage, getClientId(context));
+      const auto client_id = getClientId(context);
+      kvb_filter = std::make_shared<kvbc::KvbAppFilter>(config_->rostorage, client_id);
+      kvb_filter->setBlockHashIndex(getBlockHashIndex(client_id));
     } catch (std::exception& error) {
       std::stringstream msg;
       msg << "Failed to set up filter: " << error.what();
@@ -1039,6 +1175,18 @@ class ThinReplicaImpl {
     return {grpc::Status::OK, kvb_filter};
   }
 
+  // The block hash index is shared by all the filters of the same client id.
+  // Filters keep using an evicted index, it's rebuilt for the next ones.
+  std::shared_ptr<kvbc::FilteredBlockHashIndex> getBlockHashIndex(const std::string& client_id) {
+    std::lock_guard<std::mutex> lock(block_hash_indexes_mutex_);
+    if (auto index = block_hash_indexes_.get(client_id)) {
+      return *index;
+    }
+    auto index = std::make_shared<kvbc::FilteredBlockHashIndex>();
+    block_hash_indexes_.put(client_id, index);
+    return index;
+  }
+
   template <typename RequestT>
   std::tuple<grpc::Status, std::shared_ptr<SubUpdateBuffer>> subscribeToLiveUpdates(
       RequestT* request, const std::string& client_id, std::shared_ptr<kvbc::KvbAppFilter>& kvb_filter) {
@@ -1057,6 +1205,17 @@ class ThinReplicaImpl {
   logging::Logger logger_;
   std::unique_ptr<ThinReplicaServerConfig> config_;
   std::shared_ptr<concordMetrics::Aggregator> aggregator_;
+  // Shared by all the subscription streams served by this TRS
+  FilteredUpdateCache filtered_update_cache_{kSubUpdateBufferSize};
+  // Client id -> filtered block hashes read so far, for the
+  // kMaxBlockHashIndexes most recently served client ids. This makes
+  // ReadStateHash proportional to the blocks added since the client's previous
+  // request instead of to the whole blockchain.
+  std::mutex block_hash_indexes_mutex_;
+  concord::util::LruCache<std::string, std::shared_ptr<kvbc::FilteredBlockHashIndex>> block_hash_indexes_{
+      kMaxBlockHashIndexes};
+  // Read and filter the blocks subscribers catch up with, see readAheadAndSend()
+  concord::util::ThreadPool sync_readers_;
 };
 }  // namespace thin_replica
 }  // namespace concord
@@ -0,0 +1,392 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "thin-replica-server/async_grpc_services.hpp"
+
+#include <grpcpp/alarm.h>
+
+#include <algorithm>
+
+#include "assertUtils.hpp"
+
+using grpc::ServerContext;
+using grpc::ServerWriter;
+
+using com::vmware::concord::thin_replica::BlockId;
+using com::vmware::concord::thin_replica::Data;
+using com::vmware::concord::thin_replica::Hash;
+using com::vmware::concord::thin_replica::ReadStateHashRequest;
+using com::vmware::concord::thin_replica::ReadStateRequest;
+using com::vmware::concord::thin_replica::SubscriptionRequest;
+
+// NOTE: Make sure that all the logic is located in the implementation
+
+namespace concord {
+namespace thin_replica {
+
+// A single subscription stream. There is at most one outstanding operation per subscription, hence the subscription
+// itself is the tag of all its operations and its state tells which operation completed:
+//   kWaitingForSubscription - Waiting for a new subscription request
+//   kSync                   - The sync threads send the updates from storage, the operation is one of their writes
+//   kLive                   - Sending the live updates, the operation is a write or the alarm which the live updates
+//                             buffer sets off once the next update is pushed (see waitForLiveUpdate)
+//   kFinishing              - The subscription stream is being closed
+// Besides, gRPC tells through the done tag once the call is done, e.g. cancelled by the client. The call is deleted
+// once both its last operation and the done tag completed.
+template <typename DataT>
+class SubscriptionCallData final : public ThinReplicaAsyncService::CallData {
+ public:
+  // Wait for the next subscription on the given completion queue. Memory is freed in `proceed`.
+  static void waitForSubscription(ThinReplicaAsyncService& service, grpc::ServerCompletionQueue* cq) {
+    auto call = new SubscriptionCallData(service, cq);
+    // Only delivered if the call starts
+    call->context_.AsyncNotifyWhenDone(&call->done_tag_);
+    const auto issued = service.issue([&] {
+      if constexpr (std::is_same_v<DataT, Data>) {
+        service.RequestSubscribeToUpdates(&call->context_, &call->request_, &call->writer_, cq, cq, call);
+      } else {
+        service.RequestSubscribeToUpdateHashes(&call->context_, &call->request_, &call->writer_, cq, cq, call);
+      }
+    });
+    if (!issued) {
+      delete call;
+    }
+  }
+
+  void proceed(bool ok) override {
+    switch (state_) {
+      case State::kWaitingForSubscription:
+        if (!ok) {
+          // The server is shutting down
+          delete this;
+          return;
+        }
+        waitForSubscription(service_, cq_);
+        state_ = State::kSync;
+        service_.startSync([this] { sync(); });
+        return;
+      case State::kSync:
+        onSyncWriteDone(ok);
+        return;
+      case State::kLive:
+        service_.stopWaiting(this);
+        // Alarms aren't cancelled, hence a failure means that the write failed
+        if (!ok) {
+          finish(true);
+          return;
+        }
+        sendNextLiveUpdate();
+        return;
+      case State::kFinishing:
+        unref();
+        return;
+    }
+  }
+
+ private:
+  enum class State { kWaitingForSubscription, kSync, kLive, kFinishing };
+
+  class DoneTag final : public ThinReplicaAsyncService::CallData {
+   public:
+    explicit DoneTag(SubscriptionCallData& call) : call_(call) {}
+    void proceed(bool) override { call_.onDone(); }
+
+   private:
+    SubscriptionCallData& call_;
+  };
+
+  // The server context as seen by the sync threads
+  class SyncContext {
+   public:
+    explicit SyncContext(SubscriptionCallData& call) : call_(call) {}
+    bool IsCancelled() const { return call_.sync_cancelled_ || call_.done_ || call_.service_.isShuttingDown(); }
+    const std::multimap<grpc::string_ref, grpc::string_ref>& client_metadata() const {
+      return call_.context_.client_metadata();
+    }
+    std::shared_ptr<const grpc::AuthContext> auth_context() const { return call_.context_.auth_context(); }
+
+   private:
+    SubscriptionCallData& call_;
+  };
+
+  // The server writer as seen by the sync threads, each write blocks until it completed
+  class SyncWriter {
+   public:
+    explicit SyncWriter(SubscriptionCallData& call) : call_(call) {}
+    bool Write(const DataT& msg) { return call_.writeAndWait(msg); }
+
+   private:
+    SubscriptionCallData& call_;
+  };
+
+  SubscriptionCallData(ThinReplicaAsyncService& service, grpc::ServerCompletionQueue* cq)
+      : service_(service), cq_(cq), writer_(&context_), done_tag_(*this) {}
+
+  // Runs on a sync thread
+  void sync() {
+    SyncContext context(*this);
+    SyncWriter writer(*this);
+    grpc::Status status;
+    try {
+      status = service_.impl_->template startSubscription<SyncContext, SyncWriter, DataT>(
+          &context, &request_, &writer, subscription_);
+    } catch (std::exception& error) {
+      LOG_ERROR(service_.logger_, "Subscription failed: " << error.what());
+      status = grpc::Status(grpc::StatusCode::UNKNOWN, error.what());
+    }
+    if (!status.ok()) {
+      finishCall(status);
+      return;
+    }
+    state_ = State::kLive;
+    sendNextLiveUpdate();
+  }
+
+  bool writeAndWait(const DataT& msg) {
+    std::unique_lock<std::mutex> lock(sync_write_mutex_);
+    sync_write_done_ = false;
+    // The write of a cancelled call fails right away, don't format and send the rest of the sync
+    if (done_ || !service_.issue([&] { writer_.Write(msg, this); })) {
+      sync_cancelled_ = true;
+      return false;
+    }
+    sync_write_cv_.wait(lock, [this] { return sync_write_done_; });
+    if (!sync_write_ok_) {
+      sync_cancelled_ = true;
+    }
+    return sync_write_ok_;
+  }
+
+  void onSyncWriteDone(bool ok) {
+    // Notify while locked, the sync thread may finish and delete the call once it sees the write done
+    std::lock_guard<std::mutex> lock(sync_write_mutex_);
+    sync_write_ok_ = ok;
+    sync_write_done_ = true;
+    sync_write_cv_.notify_one();
+  }
+
+  // The call is done, by now an outstanding write fails. A subscription waiting for a live update is finished.
+  void onDone() {
+    done_ = true;
+    service_.wakeUpIfWaiting(this);
+    unref();
+  }
+
+  void unref() {
+    if (--refs_ == 0) {
+      delete this;
+    }
+  }
+
+  // Write the next live update if there is one or wait for it otherwise
+  void sendNextLiveUpdate() {
+    while (true) {
+      if (service_.isShuttingDown() || done_) {
+        finish(true);
+        return;
+      }
+      bool has_update = false;
+      try {
+        has_update = service_.impl_->nextLiveUpdate(subscription_, message_, std::chrono::milliseconds::zero());
+      } catch (std::exception& error) {
+        LOG_INFO(service_.logger_, "Subscription stream closed: " << error.what());
+        finish(false);
+        return;
+      }
+      bool waiting = false;
+      const auto issued = has_update ? service_.issue([&] { writer_.Write(message_, this); })
+                                     : service_.issue([&] { waiting = service_.waitForLiveUpdate(this); });
+      if (!issued) {
+        finish(true);
+        return;
+      }
+      if (has_update || waiting) {
+        return;
+      }
+      // An update was pushed in the meantime or the call is done
+    }
+  }
+
+  // Called by the service under the lock of the waiting calls, which orders it with onDone(). See
+  // ThinReplicaAsyncService::waitForLiveUpdate().
+  bool notifyOnLiveUpdate() override {
+    return !done_ && service_.impl_->notifyOnLiveUpdate(subscription_, [this] { wakeUp(); });
+  }
+
+  void cancelWait() override {
+    if (service_.impl_->cancelLiveUpdateNotification(subscription_)) {
+      wakeUp();
+    }
+  }
+
+  // Put the subscription back on its completion queue right away
+  void wakeUp() { alarm_.Set(cq_, std::chrono::system_clock::now(), this); }
+
+  void finish(bool cancelled) { finishCall(service_.impl_->finishSubscription(subscription_, cancelled)); }
+
+  void finishCall(const grpc::Status& status) {
+    state_ = State::kFinishing;
+    if (!service_.issue([&] { writer_.Finish(status, this); })) {
+      // The server is shut down, which cancels the call and completes the done tag
+      unref();
+    }
+  }
+
+  ThinReplicaAsyncService& service_;
+  grpc::ServerCompletionQueue* cq_;
+  State state_{State::kWaitingForSubscription};
+
+  grpc::ServerContext context_;
+  SubscriptionRequest request_;
+  grpc::ServerAsyncWriter<DataT> writer_;
+  ThinReplicaImpl::LiveSubscription subscription_;
+  DataT message_;
+  grpc::Alarm alarm_;
+  DoneTag done_tag_;
+  std::atomic_bool done_{false};
+  // Held by the operations of the call and by the done tag
+  std::atomic_int refs_{2};
+
+  // Only used while in kSync
+  std::mutex sync_write_mutex_;
+  std::condition_variable sync_write_cv_;
+  bool sync_write_done_{false};
+  bool sync_write_ok_{false};
+  bool sync_cancelled_{false};
+};
+
+ThinReplicaAsyncService::ThinReplicaAsyncService(std::unique_ptr<ThinReplicaImpl>&& impl, const Config& config)
+    : logger_(logging::getLogger("concord.thin_replica.async")), impl_(std::move(impl)), config_(config) {
+  ConcordAssertGT(config_.num_cq_threads, 0);
+  ConcordAssertGT(config_.num_sync_threads, 0);
+}
+
+ThinReplicaAsyncService::~ThinReplicaAsyncService() { shutdown(); }
+
+void ThinReplicaAsyncService::addToServer(grpc::ServerBuilder& builder) {
+  builder.RegisterService(this);
+  for (unsigned i = 0; i < config_.num_cq_threads; ++i) {
+    cqs_.emplace_back(builder.AddCompletionQueue());
+  }
+}
+
+void ThinReplicaAsyncService::start() {
+  ConcordAssertEQ(cqs_.size(), config_.num_cq_threads);
+  sync_pool_ = std::make_unique<concord::util::ThreadPool>(config_.num_sync_threads);
+  for (unsigned i = 0; i < config_.num_cq_threads; ++i) {
+    cq_threads_.emplace_back([this, i] { handleRpcs(i); });
+  }
+}
+
+void ThinReplicaAsyncService::shutdown() {
+  {
+    std::unique_lock<std::shared_mutex> lock(shutdown_mutex_);
+    if (shutting_down_) {
+      return;
+    }
+    shutting_down_ = true;
+  }
+
+  // The sync jobs notice the shutdown on their next write or while waiting for live updates. They still need the
+  // completion queues to complete their outstanding writes.
+  LOG_INFO(logger_, "Waiting for the subscriptions to finish syncing");
+  {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    sync_cv_.wait(lock, [this] { return pending_syncs_ == 0; });
+  }
+  sync_pool_.reset();
+
+  // Subscriptions waiting for a live update have no operation on the completion queues, wake them up to finish
+  {
+    std::lock_guard<std::mutex> lock(waiting_mutex_);
+    for (auto call : waiting_calls_) {
+      call->cancelWait();
+    }
+  }
+
+  LOG_INFO(logger_, "Shutting down and emptying completion queues");
+  std::for_each(cqs_.begin(), cqs_.end(), [](auto& cq) { cq->Shutdown(); });
+  if (cq_threads_.empty()) {
+    // Never started
+    for (auto& cq : cqs_) {
+      void* tag;
+      bool ok;
+      while (cq->Next(&tag, &ok))
+        ;
+    }
+  }
+  std::for_each(cq_threads_.begin(), cq_threads_.end(), [](auto& t) { t.join(); });
+  cq_threads_.clear();
+}
+
+bool ThinReplicaAsyncService::waitForLiveUpdate(CallData* call) {
+  std::lock_guard<std::mutex> lock(waiting_mutex_);
+  if (!call->notifyOnLiveUpdate()) {
+    return false;
+  }
+  waiting_calls_.insert(call);
+  return true;
+}
+
+void ThinReplicaAsyncService::stopWaiting(CallData* call) {
+  std::lock_guard<std::mutex> lock(waiting_mutex_);
+  waiting_calls_.erase(call);
+}
+
+void ThinReplicaAsyncService::wakeUpIfWaiting(CallData* call) {
+  std::lock_guard<std::mutex> lock(waiting_mutex_);
+  if (waiting_calls_.count(call)) {
+    call->cancelWait();
+  }
+}
+
+void ThinReplicaAsyncService::handleRpcs(unsigned cq_idx) {
+  auto cq = cqs_[cq_idx].get();
+  SubscriptionCallData<Data>::waitForSubscription(*this, cq);
+  SubscriptionCallData<Hash>::waitForSubscription(*this, cq);
+
+  void* tag;
+  bool ok = false;
+  // Every tag is a CallData, see `proceed`. Next() returns false once the queue is drained and shutdown.
+  while (cq->Next(&tag, &ok)) {
+    static_cast<CallData*>(tag)->proceed(ok);
+  }
+  LOG_INFO(logger_, "Completion queue drained and shutdown, stop processing.");
+}
+
+grpc::Status ThinReplicaAsyncService::ReadState(ServerContext* context,
+                                                const ReadStateRequest* request,
+                                                ServerWriter<Data>* stream) {
+  return impl_->ReadState(context, request, stream);
+}
+
+grpc::Status ThinReplicaAsyncService::ReadStateHash(ServerContext* context,
+                                                    const ReadStateHashRequest* request,
+                                                    Hash* hash) {
+  return impl_->ReadStateHash(context, request, hash);
+}
+
+grpc::Status ThinReplicaAsyncService::AckUpdate(ServerContext* context,
+                                                const BlockId* block_id,
+                                                google::protobuf::Empty* empty) {
+  return impl_->AckUpdate(context, block_id, empty);
+}
+
+grpc::Status ThinReplicaAsyncService::Unsubscribe(ServerContext* context,
+                                                  const google::protobuf::Empty* request,
+                                                  google::protobuf::Empty* response) {
+  return impl_->Unsubscribe(context, request, response);
+}
+
+}  // namespace thin_replica
+}  // namespace concord
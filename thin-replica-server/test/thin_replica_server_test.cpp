@@ -993,6 +993,51 @@ TEST(thin_replica_server_test, SubscribeToUpdateHashesWithGap) {
   EXPECT_EQ(status.error_code(), grpc::StatusCode::OK);
 }
 
+template <typename DataT>
+void subscribeWithReadAhead(size_t sync_read_ahead, unsigned num_sync_readers) {
+  // More blocks to catch up with than read in parallel
+  const BlockId last_block_id = 200;
+  FakeStorage storage{generate_kvp(1, last_block_id)};
+  storage.genesis_block_id = 1;
+  auto live_update_blocks = generate_kvp(last_block_id + 2, last_block_id + 5);
+  TestStateMachine<DataT> state_machine{storage, live_update_blocks, 1};
+  TestSubBufferList<DataT> buffer{state_machine};
+  TestServerWriter<DataT> stream{state_machine};
+
+  bool is_insecure_trs = true;
+  std::string tls_trs_cert_path;
+  std::unordered_set<std::string> client_id_set;
+  uint16_t update_metrics_aggregator_thresh = 100;
+
+  auto trs_config = std::make_unique<concord::thin_replica::ThinReplicaServerConfig>(is_insecure_trs,
+                                                                                     tls_trs_cert_path,
+                                                                                     &storage,
+                                                                                     buffer,
+                                                                                     client_id_set,
+                                                                                     update_metrics_aggregator_thresh,
+                                                                                     std::chrono::seconds{60},
+                                                                                     sync_read_ahead,
+                                                                                     num_sync_readers);
+  concord::thin_replica::ThinReplicaImpl replica(std::move(trs_config), std::make_shared<concordMetrics::Aggregator>());
+  TestServerContext context;
+  SubscriptionRequest request;
+  request.mutable_events()->set_block_id(1u);
+  auto status =
+      replica.SubscribeToUpdates<TestServerContext, TestServerWriter<DataT>, DataT>(&context, &request, &stream);
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::OK);
+}
+
+// The blocks read ahead in parallel are sent in order
+TEST(thin_replica_server_test, SubscribeToUpdatesWithReadAhead) {
+  subscribeWithReadAhead<Data>(1, 1);
+  subscribeWithReadAhead<Data>(16, 4);
+}
+
+TEST(thin_replica_server_test, SubscribeToUpdateHashesWithReadAhead) {
+  subscribeWithReadAhead<Hash>(1, 1);
+  subscribeWithReadAhead<Hash>(16, 4);
+}
+
 TEST(thin_replica_server_test, SubscribeToPrivateEventGroupUpdateHashesWithGap) {
   FakeStorage storage(generateEventGroupMap(1, kLastEventGroupId, EventGroupType::PrivateEventGroupsOnly));
   EXPECT_EQ(storage.getLastEventGroupId(), kLastEventGroupId);
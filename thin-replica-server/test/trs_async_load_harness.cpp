@@ -0,0 +1,306 @@
+// Concord
+//
+// Copyright (c) 2021 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Load harness for the thin replica server's subscription streams. Serves an in-memory blockchain on localhost, opens
+// many subscriptions from a single client thread, keeps adding blocks and reports how fast the blocks were delivered,
+// the delivery latency of the live blocks and the number of threads used by the process.
+//
+// Usage: trs_async_load_harness <async|sync> [subscribers] [blocks] [value size]
+// Exits with a failure if not all subscribers received all blocks in time.
+
+#include <grpcpp/grpcpp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "concord_kvbc.pb.h"
+#include "endianness.hpp"
+#include "kv_types.hpp"
+#include "thin-replica-server/async_grpc_services.hpp"
+#include "thin-replica-server/grpc_services.hpp"
+
+namespace {
+
+using concord::kvbc::BlockId;
+using concord::kvbc::categorization::ImmutableInput;
+using com::vmware::concord::kvbc::ValueWithTrids;
+using com::vmware::concord::thin_replica::Data;
+using com::vmware::concord::thin_replica::SubscriptionRequest;
+using com::vmware::concord::thin_replica::ThinReplica;
+
+using namespace std::chrono_literals;
+
+const std::string kClientId{"LOAD_TEST_ID"};
+constexpr BlockId kInitialBlocks{100};
+constexpr auto kBlockInterval = 1ms;
+constexpr auto kTimeout = 120s;
+
+// Legacy events only, without event groups
+class InMemoryStorage : public concord::kvbc::IReader {
+ public:
+  void add(BlockId block_id, const ImmutableInput& block) {
+    std::scoped_lock lock(mutex_);
+    blocks_.emplace(block_id, block);
+  }
+
+  std::optional<concord::kvbc::categorization::Value> get(const std::string&,
+                                                          const std::string&,
+                                                          BlockId) const override {
+    return std::nullopt;
+  }
+
+  std::optional<concord::kvbc::categorization::Value> getLatest(const std::string& category_id,
+                                                                const std::string&) const override {
+    if (category_id == concord::kvbc::categorization::kExecutionEventGroupLatestCategory) {
+      // `0` is an invalid event group id, i.e. there are no event groups
+      return concord::kvbc::categorization::VersionedValue{
+          {getLastBlockId(), concordUtils::toBigEndianStringBuffer<uint64_t>(0)}};
+    }
+    return std::nullopt;
+  }
+
+  void multiGet(const std::string&,
+                const std::vector<std::string>& keys,
+                const std::vector<BlockId>&,
+                std::vector<std::optional<concord::kvbc::categorization::Value>>& values) const override {
+    values.assign(keys.size(), std::nullopt);
+  }
+
+  void multiGetLatest(const std::string&,
+                      const std::vector<std::string>& keys,
+                      std::vector<std::optional<concord::kvbc::categorization::Value>>& values) const override {
+    values.assign(keys.size(), std::nullopt);
+  }
+
+  std::optional<concord::kvbc::categorization::TaggedVersion> getLatestVersion(const std::string&,
+                                                                               const std::string&) const override {
+    return std::nullopt;
+  }
+
+  void multiGetLatestVersion(
+      const std::string&,
+      const std::vector<std::string>& keys,
+      std::vector<std::optional<concord::kvbc::categorization::TaggedVersion>>& versions) const override {
+    versions.assign(keys.size(), std::nullopt);
+  }
+
+  std::optional<concord::kvbc::categorization::Updates> getBlockUpdates(BlockId block_id) const override {
+    std::scoped_lock lock(mutex_);
+    auto it = blocks_.find(block_id);
+    if (it == blocks_.end()) {
+      return std::nullopt;
+    }
+    concord::kvbc::categorization::ImmutableUpdates immutable;
+    for (const auto& [key, value] : it->second.kv) {
+      std::set<std::string> tags(value.tags.begin(), value.tags.end());
+      concord::kvbc::categorization::ImmutableUpdates::ImmutableValue immutable_value{std::string{value.data},
+                                                                                      std::move(tags)};
+      immutable.addUpdate(std::string{key}, std::move(immutable_value));
+    }
+    concord::kvbc::categorization::Updates updates;
+    updates.add(concord::kvbc::categorization::kExecutionEventsCategory, std::move(immutable));
+    return updates;
+  }
+
+  BlockId getGenesisBlockId() const override { return 1; }
+
+  BlockId getLastBlockId() const override {
+    std::scoped_lock lock(mutex_);
+    return blocks_.empty() ? 0 : blocks_.rbegin()->first;
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::map<BlockId, ImmutableInput> blocks_;
+};
+
+ImmutableInput makeBlock(BlockId block_id, size_t value_size) {
+  ValueWithTrids proto;
+  proto.set_value(std::string(value_size, 'v'));
+  concord::kvbc::categorization::ImmutableValueUpdate value;
+  value.data = proto.SerializeAsString();
+  ImmutableInput block;
+  // Keys are prefixed with the block id
+  block.kv.insert({concordUtils::toBigEndianStringBuffer(block_id) + "key", value});
+  return block;
+}
+
+size_t numThreads() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("Threads:", 0) == 0) {
+      return std::stoul(line.substr(8));
+    }
+  }
+  return 0;
+}
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct Subscriber {
+  grpc::ClientContext context;
+  std::unique_ptr<grpc::ClientAsyncReader<Data>> reader;
+  Data data;
+  grpc::Status status;
+  bool started{false};
+  bool finishing{false};
+  BlockId last_block_id{0};
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2 || (std::string{argv[1]} != "async" && std::string{argv[1]} != "sync")) {
+    std::cerr << "Usage: " << argv[0] << " <async|sync> [subscribers] [blocks] [value size]" << std::endl;
+    return 1;
+  }
+  const bool async = std::string{argv[1]} == "async";
+  const size_t num_subscribers = argc > 2 ? std::stoul(argv[2]) : 200;
+  const BlockId num_blocks = argc > 3 ? std::stoull(argv[3]) : 1000;
+  const size_t value_size = argc > 4 ? std::stoul(argv[4]) : 256;
+  const BlockId last_block_id = kInitialBlocks + num_blocks;
+
+  InMemoryStorage storage;
+  for (BlockId block_id = 1; block_id <= kInitialBlocks; ++block_id) {
+    storage.add(block_id, makeBlock(block_id, value_size));
+  }
+
+  // Server
+  concord::thin_replica::SubBufferList subscriber_list;
+  std::unordered_set<std::string> client_ids{kClientId};
+  auto trs_config = std::make_unique<concord::thin_replica::ThinReplicaServerConfig>(
+      true, "", &storage, subscriber_list, client_ids);
+  auto impl = std::make_unique<concord::thin_replica::ThinReplicaImpl>(std::move(trs_config),
+                                                                      std::make_shared<concordMetrics::Aggregator>());
+  grpc::ServerBuilder builder;
+  int port = 0;
+  builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+  std::unique_ptr<concord::thin_replica::ThinReplicaAsyncService> async_service;
+  std::unique_ptr<concord::thin_replica::ThinReplicaService> sync_service;
+  if (async) {
+    async_service = std::make_unique<concord::thin_replica::ThinReplicaAsyncService>(std::move(impl));
+    async_service->addToServer(builder);
+  } else {
+    sync_service = std::make_unique<concord::thin_replica::ThinReplicaService>(std::move(impl));
+    builder.RegisterService(sync_service.get());
+  }
+  auto server = builder.BuildAndStart();
+  if (async_service) async_service->start();
+
+  // Publishing time of each live block, 0 for the blocks added before the subscriptions
+  std::vector<std::atomic<int64_t>> published_ns(last_block_id + 1);
+
+  // Keep adding blocks until all subscribers received the last one - subscriptions only complete their catch-up once
+  // they see a live block.
+  std::atomic_bool stop{false};
+  std::atomic<size_t> max_threads{0};
+  std::thread producer([&] {
+    for (BlockId block_id = kInitialBlocks + 1; !stop; ++block_id) {
+      auto block = makeBlock(block_id, value_size);
+      storage.add(block_id, block);
+      if (block_id <= last_block_id) {
+        published_ns[block_id] = nowNs();
+      }
+      using concord::thin_replica::SubUpdate;
+      subscriber_list.updateSubBuffers(std::make_shared<const SubUpdate>(SubUpdate{block_id, "", std::move(block)}));
+      max_threads = std::max(max_threads.load(), numThreads());
+      std::this_thread::sleep_for(kBlockInterval);
+    }
+  });
+
+  // Subscribers
+  auto channel = grpc::CreateChannel("127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials());
+  auto stub = ThinReplica::NewStub(channel);
+  grpc::CompletionQueue cq;
+  SubscriptionRequest request;
+  request.mutable_events()->set_block_id(1);
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::unique_ptr<Subscriber>> subscribers;
+  for (size_t i = 0; i < num_subscribers; ++i) {
+    auto& subscriber = subscribers.emplace_back(std::make_unique<Subscriber>());
+    subscriber->context.AddMetadata("client_id", kClientId);
+    subscriber->reader = stub->PrepareAsyncSubscribeToUpdates(&subscriber->context, request, &cq);
+    subscriber->reader->StartCall(subscriber.get());
+  }
+
+  size_t num_finished = 0;
+  size_t num_completed = 0;
+  uint64_t num_received = 0;
+  std::vector<int64_t> latencies_ns;
+  latencies_ns.reserve(num_subscribers * num_blocks);
+  const auto deadline = std::chrono::system_clock::now() + kTimeout;
+  void* tag;
+  bool ok;
+  while (num_finished < num_subscribers && cq.AsyncNext(&tag, &ok, deadline) == grpc::CompletionQueue::GOT_EVENT) {
+    auto subscriber = static_cast<Subscriber*>(tag);
+    if (subscriber->finishing) {
+      ++num_finished;
+      continue;
+    }
+    if (ok && subscriber->started) {
+      ++num_received;
+      const auto block_id = subscriber->data.events().block_id();
+      if (block_id <= last_block_id && published_ns[block_id] > 0) {
+        latencies_ns.push_back(nowNs() - published_ns[block_id]);
+      }
+      subscriber->last_block_id = block_id;
+    }
+    subscriber->started = true;
+    if (!ok || subscriber->last_block_id >= last_block_id) {
+      if (ok) ++num_completed;
+      subscriber->finishing = true;
+      subscriber->context.TryCancel();
+      subscriber->reader->Finish(&subscriber->status, subscriber);
+      continue;
+    }
+    subscriber->reader->Read(&subscriber->data, subscriber);
+  }
+  const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  stop = true;
+  producer.join();
+  for (auto& subscriber : subscribers) {
+    subscriber->context.TryCancel();
+  }
+  server->Shutdown(std::chrono::system_clock::now() + 1s);
+  if (async_service) async_service->shutdown();
+  cq.Shutdown();
+  while (cq.Next(&tag, &ok))
+    ;
+
+  std::sort(latencies_ns.begin(), latencies_ns.end());
+  auto percentile_us = [&](double p) {
+    return latencies_ns.empty() ? 0 : latencies_ns[static_cast<size_t>(p * (latencies_ns.size() - 1))] / 1000;
+  };
+  std::cout << argv[1] << ": subscribers=" << num_subscribers << " completed=" << num_completed
+            << " blocks=" << last_block_id << " delivered=" << num_received
+            << " updates/s=" << static_cast<uint64_t>(num_received / elapsed) << " p50=" << percentile_us(0.5)
+            << "us p99=" << percentile_us(0.99) << "us max_threads=" << max_threads << std::endl;
+  return num_completed == num_subscribers ? 0 : 1;
+}
@@ -18,6 +18,8 @@
 #include <future>
 #include <list>
 #include "Logger.hpp"
+#include "kvbc_app_filter/kvbc_app_filter.h"
+#include "thin-replica-server/filtered_update_cache.hpp"
 #include "thin-replica-server/subscription_buffer.hpp"
 
 using namespace std::chrono_literals;
@@ -28,10 +30,14 @@ using concord::kvbc::categorization::ImmutableInput;
 using concord::kvbc::categorization::ImmutableValueUpdate;
 using concord::kvbc::categorization::EventGroup;
 using concord::kvbc::categorization::Event;
+using concord::kvbc::KvbAppFilter;
 using concord::thin_replica::ConsumerTooSlow;
+using concord::thin_replica::FilteredUpdateCache;
 using concord::thin_replica::SubBufferList;
 using concord::thin_replica::SubUpdate;
+using concord::thin_replica::SubUpdatePtr;
 using concord::thin_replica::SubEventGroupUpdate;
+using concord::thin_replica::SubEventGroupUpdatePtr;
 using concord::thin_replica::SubUpdateBuffer;
 
 // A producer should be able to "add" updates whether there are consumers or
@@ -236,6 +242,75 @@ TEST(trs_sub_buffer_test, happy_path_w_two_consumers_eg) {
   }
 }
 
+// All consumers should get the very same (immutable) update instead of a copy
+TEST(trs_sub_buffer_test, consumers_share_updates) {
+  SubBufferList sub_list;
+  auto updates1 = std::make_shared<SubUpdateBuffer>(10);
+  auto updates2 = std::make_shared<SubUpdateBuffer>(10);
+  sub_list.addBuffer(updates1);
+  sub_list.addBuffer(updates2);
+
+  ImmutableInput input;
+  ImmutableValueUpdate val;
+  val.data = "value";
+  input.kv = {{"key", val}};
+  SubUpdate update{1337, "CID", input};
+  sub_list.updateSubBuffers(update);
+
+  EventGroup event_group;
+  Event event;
+  event.data = "value";
+  event_group.events.emplace_back(event);
+  SubEventGroupUpdate update_eg{1337, event_group};
+  sub_list.updateEventGroupSubBuffers(update_eg);
+
+  SubUpdatePtr out1, out2;
+  ASSERT_TRUE(updates1->TryPop(out1, 10ms));
+  ASSERT_TRUE(updates2->TryPop(out2, 10ms));
+  ASSERT_EQ(out1, out2);
+  ASSERT_EQ(out1->block_id, 1337);
+  ASSERT_EQ(out1->correlation_id, "CID");
+
+  SubEventGroupUpdatePtr out_eg1, out_eg2;
+  ASSERT_TRUE(updates1->TryPopEventGroup(out_eg1, 10ms));
+  ASSERT_TRUE(updates2->TryPopEventGroup(out_eg2, 10ms));
+  ASSERT_EQ(out_eg1, out_eg2);
+  ASSERT_EQ(out_eg1->event_group_id, 1337);
+
+  // A consumer falling behind doesn't affect the others
+  sub_list.updateSubBuffers(update);
+  ASSERT_TRUE(updates1->TryPop(out1, 10ms));
+  ASSERT_EQ(updates2->Size(), 1);
+}
+
+// Filters with the same client id should share the filtered update and hash
+TEST(trs_sub_buffer_test, filtered_update_cache) {
+  FilteredUpdateCache cache(2);
+  KvbAppFilter filter1(nullptr, "client1");
+  KvbAppFilter filter2(nullptr, "client1");
+  KvbAppFilter other_filter(nullptr, "client2");
+  SubUpdate update{1, "CID", {}};
+
+  auto filtered1 = cache.filteredUpdate(update, filter1);
+  auto filtered2 = cache.filteredUpdate(update, filter2);
+  auto other_filtered = cache.filteredUpdate(update, other_filter);
+  ASSERT_EQ(filtered1, filtered2);
+  ASSERT_NE(filtered1, other_filtered);
+  ASSERT_EQ(filtered1->block_id, 1);
+  ASSERT_EQ(filtered1->correlation_id, "CID");
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(cache.hash(update, filter2), filter1.hashUpdate(*filtered1));
+
+  // Only the newest blocks are kept
+  for (concord::kvbc::BlockId block_id = 2; block_id <= 4; ++block_id) {
+    update.block_id = block_id;
+    cache.hash(update, filter1);
+  }
+  ASSERT_EQ(cache.size(), 2);
+  update.block_id = 1;
+  ASSERT_NE(cache.filteredUpdate(update, filter2), filtered1);
+}
+
 TEST(trs_sub_buffer_test, waiting_for_updates) {
   auto updates = std::make_shared<SubUpdateBuffer>(10);
   auto updates_eg = std::make_shared<SubUpdateBuffer>(10);
@@ -284,6 +359,39 @@ TEST(trs_sub_buffer_test, waiting_for_updates) {
   sub_list.updateEventGroupSubBuffers(update_eg);
 }
 
+TEST(trs_sub_buffer_test, notified_when_non_empty) {
+  SubUpdateBuffer updates(10);
+  int notified = 0;
+
+  ASSERT_TRUE(updates.notifyWhenNonEmpty([&] { ++notified; }));
+  updates.Push(SubUpdate{});
+  ASSERT_EQ(notified, 1);
+  // Only the first push notifies
+  updates.Push(SubUpdate{});
+  ASSERT_EQ(notified, 1);
+  ASSERT_FALSE(updates.cancelNotification());
+
+  // There already is an update
+  ASSERT_FALSE(updates.notifyWhenNonEmpty([&] { ++notified; }));
+  updates.removeAllUpdates();
+
+  // Event groups are notified separately
+  ASSERT_TRUE(updates.notifyWhenEventGroupNonEmpty([&] { ++notified; }));
+  updates.Push(SubUpdate{});
+  ASSERT_EQ(notified, 1);
+  updates.PushEventGroup(SubEventGroupUpdate{});
+  ASSERT_EQ(notified, 2);
+  updates.removeAllUpdates();
+  updates.removeAllEventGroupUpdates();
+
+  // A cancelled notification isn't called
+  ASSERT_TRUE(updates.notifyWhenNonEmpty([&] { ++notified; }));
+  ASSERT_TRUE(updates.cancelNotification());
+  ASSERT_FALSE(updates.cancelNotification());
+  updates.Push(SubUpdate{});
+  ASSERT_EQ(notified, 2);
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
@@ -0,0 +1,160 @@
+// Concord
+//
+// Copyright (c) 2018 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "bls/relic/LagrangeCoeffCache.h"
+#include "threshsign/bls/relic/BlsThresholdScheme.h"
+
+#include "Utils.h"
+#include "Timer.h"
+#include "Logger.hpp"
+#include "XAssert.h"
+#include "app/RelicMain.h"
+
+#include "lib/Benchmark.h"
+
+extern "C" {
+#include <relic/relic.h>
+#include <relic/relic_err.h>
+}
+
+using namespace BLS::Relic;
+using std::endl;
+
+/**
+ * Measures the latency of combining k signature shares into a threshold signature (i.e., what the replica pays once
+ * the last share arrives), with and without the verifier's Lagrange coefficient cache.
+ *
+ * "Stable" rounds always combine the same subset of signers (the common case in a healthy cluster), while "random"
+ * rounds pick a fresh subset every time and thus mostly miss the cache.
+ */
+class CombineLatencyBenchmark {
+ private:
+  const int k, n;
+  const int numIters;
+  std::vector<IThresholdSigner*> sks;
+  std::unique_ptr<BlsThresholdVerifier> cachedVerifier;
+  std::unique_ptr<BlsThresholdVerifier> uncachedVerifier;
+  std::vector<std::vector<char>> shares;
+  std::vector<char> threshSig;
+  const std::string msg = "combine latency benchmark";
+
+ public:
+  CombineLatencyBenchmark(const BlsPublicParameters& params, int k, int n, int numIters)
+      : k(k), n(n), numIters(numIters), shares(static_cast<size_t>(n + 1)) {
+    BlsThresholdFactory factory(params, false);
+    IThresholdVerifier* verifTmp;
+    std::tie(sks, verifTmp) = factory.newRandomSigners(k, n);
+    cachedVerifier.reset(dynamic_cast<BlsThresholdVerifier*>(verifTmp));
+    uncachedVerifier.reset(new BlsThresholdVerifier(cachedVerifier->getParams(),
+                                                    cachedVerifier->getKey().getPoint(),
+                                                    k,
+                                                    n,
+                                                    cachedVerifier->getPublicKeysVector(),
+                                                    0));
+    threshSig.resize(static_cast<size_t>(cachedVerifier->requiredLengthForSignedData()));
+
+    for (ShareID i = 1; i <= n; i++) {
+      size_t idx = static_cast<size_t>(i);
+      shares[idx].resize(static_cast<size_t>(sks[idx]->requiredLengthForSignedData()));
+      sks[idx]->signData(
+          msg.data(), static_cast<int>(msg.size()), shares[idx].data(), static_cast<int>(shares[idx].size()));
+    }
+  }
+
+  ~CombineLatencyBenchmark() {
+    for (auto& sk : sks) {
+      delete sk;
+    }
+  }
+
+ protected:
+  void combine(const BlsThresholdVerifier& verifier, const VectorOfShares& signers, AveragingTimer& t) {
+    std::unique_ptr<IThresholdAccumulator> accum(verifier.newAccumulator(false));
+    for (ShareID id = signers.first(); signers.isEnd(id) == false; id = signers.next(id)) {
+      const auto& share = shares[static_cast<size_t>(id)];
+      accum->add(share.data(), static_cast<int>(share.size()));
+    }
+
+    t.startLap();
+    accum->getFullSignedData(threshSig.data(), static_cast<int>(threshSig.size()));
+    t.endLap();
+
+    if (!verifier.verify(
+            msg.data(), static_cast<int>(msg.size()), threshSig.data(), static_cast<int>(threshSig.size())))
+      throw std::logic_error("Combined threshold signature does not verify");
+  }
+
+  void run(const BlsThresholdVerifier& verifier, bool stable, const std::string& name) {
+    AveragingTimer t(name);
+    VectorOfShares signers;
+    VectorOfShares::randomSubset(signers, n, k);
+    for (int i = 0; i < numIters; i++) {
+      if (!stable) {
+        signers.clear();
+        VectorOfShares::randomSubset(signers, n, k);
+      }
+      combine(verifier, signers, t);
+    }
+    std::cout << "  " << t.getName() << " (" << numIters << " iters avg): " << t.averageLapTime() << " microsecs"
+              << endl;
+  }
+
+ public:
+  void start() {
+    std::cout << "k = " << k << " out of n = " << n << endl;
+    run(*uncachedVerifier, true, "No cache,   stable signers");
+    run(*cachedVerifier, true, "With cache, stable signers");
+    run(*uncachedVerifier, false, "No cache,   random signers");
+    run(*cachedVerifier, false, "With cache, random signers");
+
+    auto stats = cachedVerifier->getLagrangeCoeffCache()->getStats();
+    std::cout << "  Cache hits: " << stats.hits << ", misses: " << stats.misses << ", pinned subsets: " << stats.pinned
+              << endl
+              << endl;
+  }
+};
+
+int RelicAppMain(const Library& lib, const std::vector<std::string>& args) {
+  (void)args;
+  lib.getPrecomputedInverses();
+
+  unsigned int seed = static_cast<unsigned int>(time(NULL));
+  LOG_INFO(THRESHSIGN_LOG, "Randomness seed passed to srand(): " << seed);
+  // NOTE: srand is not and should not be used for any cryptographic randomness.
+  srand(seed);
+
+#ifdef NDEBUG
+  const int numIters = 50;
+#else
+  const int numIters = 5;
+#endif
+
+  BlsPublicParameters params(PublicParametersFactory::getWhatever());
+
+  // 2f+c+1 out of n (slow path prepare/commit) and n out of n (optimistic fast path). The 3f+c+1 = n-1 case is
+  // served by BlsAlmostMultisigAccumulator's own precomputed coefficients and does not use the cache.
+  std::vector<std::pair<int, int>> nk = Benchmark::getThresholdTestCases(151, false, true, false);
+  for (const auto& c : Benchmark::getThresholdTestCases(151, false, true, false)) {
+    nk.push_back(std::pair<int, int>(c.first, c.first));
+  }
+
+  for (auto [n, k] : nk) {
+    CombineLatencyBenchmark b(params, k, n, numIters);
+    b.start();
+  }
+
+  return 0;
+}
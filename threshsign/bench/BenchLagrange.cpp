@@ -14,6 +14,7 @@
 #include <fstream>
 #include <vector>
 
+#include "bls/relic/LagrangeCoeffCache.h"
 #include "bls/relic/LagrangeInterpolation.h"
 #include "threshsign/bls/relic/BlsPublicParameters.h"
 #include "threshsign/bls/relic/PublicParametersFactory.h"
@@ -133,11 +134,39 @@ int RelicAppMain(const Library& lib, const std::vector<std::string>& args) {
       printTime(t, subset.count(), numIters);
     }
 
+    // Cached coefficients: the first lookup interpolates, the following ones should only pay for hashing the subset
+    LagrangeCoeffCache cache(n, 4);
+    LagrangeCoeffCache::CoeffsPtr cachedCoeffs = cache.get(subset);
+    AveragingTimer tc("LRU cache hit       ");
+    for (int i = 0; i < numIters; i++) {
+      tc.startLap();
+      cachedCoeffs = cache.get(subset);
+      tc.endLap();
+    }
+    printTime(tc, subset.count(), numIters);
+
+    // Precomputing the "all but one" subsets costs n interpolations, so only time it for smaller n
+    if (n < 512) {
+      LagrangeCoeffCache pinnedCache(n, 4);
+      AveragingTimer tp("Precompute n-1 of n ");
+      tp.startLap();
+      pinnedCache.precomputeCommonSubsets(n - 1);
+      tp.endLap();
+      std::cout << "      \\-> Time used to precompute " << n << " 'all but one' subsets: " << tp.averageLapTime()
+                << " microsecs" << endl;
+    }
+
     std::cout << endl;
 
     // Make sure naive and reduced implementations agree!
     for (ShareID i = subset.first(); subset.isEnd(i) == false; i = subset.next(i)) {
       size_t idx = static_cast<size_t>(i);
+      if (redCoeffs[idx] != (*cachedCoeffs)[idx]) {
+        LOG_ERROR(THRESHSIGN_LOG, "ReducedAccumCoeff[" << idx << "] != CachedCoeff [" << idx << "]");
+        LOG_ERROR(THRESHSIGN_LOG, redCoeffs[idx] << " != " << (*cachedCoeffs)[idx]);
+        throw std::runtime_error("Bad coeff");
+      }
+
       if (n < 512) {
         if (redCoeffs[idx] != rnCoeffs[idx]) {
           LOG_ERROR(THRESHSIGN_LOG, "ReducedAccumCoeff[" << idx << "] != ReducedNaiveCoeff [" << idx << "]");
@@ -13,6 +13,7 @@
 #pragma once
 
 #include <bitset>
+#include <functional>
 
 #include "ThresholdSignaturesTypes.h"
 
@@ -74,6 +75,11 @@ class VectorOfShares {
 
   bool operator!=(const VectorOfShares& v) const { return data != v.data; }
 
+  /**
+   * Hashes the underlying bit vector, so that a set of signers can be used as a key in unordered containers.
+   */
+  size_t hash() const { return std::hash<std::bitset<MAX_NUM_OF_SHARES>>{}(data); }
+
   /**
    * Serializes this vector of share IDs as a byte sequence.
    *
@@ -103,3 +109,10 @@ class VectorOfShares {
 };
 
 std::ostream& operator<<(std::ostream& out, const VectorOfShares& v);
+
+namespace std {
+template <>
+struct hash<VectorOfShares> {
+  size_t operator()(const VectorOfShares& v) const { return v.hash(); }
+};
+}  // namespace std
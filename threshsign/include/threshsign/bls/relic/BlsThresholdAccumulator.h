@@ -22,11 +22,14 @@
 #include "BlsAccumulatorBase.h"
 #include "BlsPublicKey.h"
 
+#include <memory>
 #include <vector>
 
 namespace BLS {
 namespace Relic {
 
+class LagrangeCoeffCache;
+
 class BlsThresholdAccumulator : public BlsAccumulatorBase {
  protected:
   /**
@@ -35,11 +38,19 @@ class BlsThresholdAccumulator : public BlsAccumulatorBase {
    */
   std::vector<BNT> coeffs;
 
+  /**
+   * Optional cache of Lagrange coefficients shared with the other accumulators of the same verifier. When set,
+   * computeLagrangeCoeff() fetches the coefficients for validSharesBits into cachedCoeffs instead of filling coeffs.
+   */
+  std::shared_ptr<LagrangeCoeffCache> coeffCache;
+  std::shared_ptr<const std::vector<BNT>> cachedCoeffs;
+
  public:
   BlsThresholdAccumulator(const std::vector<BlsPublicKey>& vks,
                           NumSharesType reqSigners,
                           NumSharesType totalSigners,
-                          bool withShareVerification);
+                          bool withShareVerification,
+                          std::shared_ptr<LagrangeCoeffCache> coeffCache = nullptr);
   virtual ~BlsThresholdAccumulator() {}
 
   // IThresholdAccumulator overloads.
@@ -24,6 +24,8 @@
 
 namespace BLS::Relic {
 
+class LagrangeCoeffCache;
+
 class BlsThresholdVerifier : public IThresholdVerifier {
  protected:
   BlsPublicParameters params_;
@@ -33,13 +35,22 @@ class BlsThresholdVerifier : public IThresholdVerifier {
   G2T generator2_;
   NumSharesType reqSigners_;
   const NumSharesType numSigners_;
+  // Lagrange coefficients memoized per set of signers, shared by all the accumulators created by this verifier
+  std::shared_ptr<LagrangeCoeffCache> lagrangeCoeffCache_;
 
  public:
+  static constexpr size_t kDefaultLagrangeCoeffCacheSize = 32;
+
+  /**
+   * @param lagrangeCoeffCacheSize  max number of signer subsets whose Lagrange coefficients are memoized (0 disables
+   *                                the cache and makes every accumulator interpolate from scratch)
+   */
   BlsThresholdVerifier(const BlsPublicParameters &params,
                        const G2T &pk,
                        NumSharesType reqSigners,
                        NumSharesType numSigners,
-                       const std::vector<BlsPublicKey> &verificationKeys);
+                       const std::vector<BlsPublicKey> &verificationKeys,
+                       size_t lagrangeCoeffCacheSize = kDefaultLagrangeCoeffCacheSize);
 
   BlsThresholdVerifier() = delete;
 
@@ -54,6 +65,7 @@ class BlsThresholdVerifier : public IThresholdVerifier {
   std::vector<BlsPublicKey> getPublicKeysVector() const { return publicKeysVector_; }
   const BlsPublicParameters &getParams() const { return params_; }
   const BlsPublicKey getKey() const { return publicKey_; }
+  const std::shared_ptr<LagrangeCoeffCache> &getLagrangeCoeffCache() const { return lagrangeCoeffCache_; }
   /**
    * NOTE: Used by BlsBatchVerifier to verify shares
    */
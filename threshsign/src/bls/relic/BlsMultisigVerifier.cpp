@@ -28,7 +28,7 @@ BlsMultisigVerifier::BlsMultisigVerifier(const BlsPublicParameters &params,
                                          NumSharesType reqSigners,
                                          NumSharesType numSigners,
                                          const vector<BlsPublicKey> &verificationKeys)
-    : BlsThresholdVerifier(params, G2T::Identity(), reqSigners, numSigners, verificationKeys) {
+    : BlsThresholdVerifier(params, G2T::Identity(), reqSigners, numSigners, verificationKeys, 0) {
   if (reqSigners == numSigners) {
     // the PK is the aggregate PK of all numSigners and is needed to verify
     // n-out-of-n threshold
@@ -45,7 +45,8 @@ BlsMultisigVerifier::BlsMultisigVerifier(const BlsThresholdVerifier &base)
                            base.getKey().y,
                            base.getNumRequiredShares(),
                            base.getNumTotalShares(),
-                           base.getPublicKeysVector()) {}
+                           base.getPublicKeysVector(),
+                           0) {}
 
 IThresholdAccumulator *BlsMultisigVerifier::newAccumulator(bool withShareVerification) const {
   if (reqSigners_ == numSigners_ && withShareVerification) {
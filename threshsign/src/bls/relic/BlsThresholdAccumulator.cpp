@@ -19,6 +19,7 @@
 #include "threshsign/bls/relic/FastMultExp.h"
 
 #include "BlsAlmostMultisigCoefficients.h"
+#include "LagrangeCoeffCache.h"
 #include "LagrangeInterpolation.h"
 
 #include <vector>
@@ -33,13 +34,18 @@ namespace Relic {
 BlsThresholdAccumulator::BlsThresholdAccumulator(const std::vector<BlsPublicKey>& vks,
                                                  NumSharesType reqSigners,
                                                  NumSharesType totalSigners,
-                                                 bool withShareVerification)
-    : BlsAccumulatorBase(vks, reqSigners, totalSigners, withShareVerification) {
+                                                 bool withShareVerification,
+                                                 std::shared_ptr<LagrangeCoeffCache> coeffCache)
+    : BlsAccumulatorBase(vks, reqSigners, totalSigners, withShareVerification), coeffCache(std::move(coeffCache)) {
   coeffs.resize(static_cast<size_t>(totalSigners + 1));
   assertEqual(threshSig, G1T::Identity());
 }
 
 void BlsThresholdAccumulator::computeLagrangeCoeff() {
+  if (coeffCache) {
+    cachedCoeffs = coeffCache->get(validSharesBits);
+    return;
+  }
   lagrangeCoeffAccumReduced(validSharesBits, coeffs, BLS::Relic::Library::Get().getG2Order());
 }
 
@@ -51,7 +57,7 @@ void BlsThresholdAccumulator::exponentiateLagrangeCoeff() {
   //}
 
   int maxBits = Library::Get().getG2OrderNumBits();
-  threshSig = fastMultExp<G1T>(validSharesBits, validShares, coeffs, maxBits);
+  threshSig = fastMultExp<G1T>(validSharesBits, validShares, cachedCoeffs ? *cachedCoeffs : coeffs, maxBits);
 }
 
 } /* namespace Relic */
@@ -20,6 +20,7 @@
 #include "threshsign/bls/relic/BlsPublicParameters.h"
 
 #include "BlsAlmostMultisigAccumulator.h"
+#include "LagrangeCoeffCache.h"
 
 #include <algorithm>
 #include <iterator>
@@ -37,7 +38,8 @@ BlsThresholdVerifier::BlsThresholdVerifier(const BlsPublicParameters &params,
                                            const G2T &pk,
                                            NumSharesType reqSigners,
                                            NumSharesType numSigners,
-                                           const vector<BlsPublicKey> &verificationKeys)
+                                           const vector<BlsPublicKey> &verificationKeys,
+                                           size_t lagrangeCoeffCacheSize)
     : params_(params),
       publicKey_(pk),
       publicKeysVector_(verificationKeys.begin(), verificationKeys.end()),
@@ -48,6 +50,13 @@ BlsThresholdVerifier::BlsThresholdVerifier(const BlsPublicParameters &params,
   // verifKeys[0] was copied as well, but it's set to a dummy PK so it does not matter
   assertEqual(publicKeysVector_.size(), static_cast<vector<BlsPublicKey>::size_type>(numSigners + 1));
 
+  // The (n-1)-out-of-n case is served by BlsAlmostMultisigAccumulator's own precomputed coefficients, so a cache would
+  // never be consulted there.
+  if (lagrangeCoeffCacheSize > 0 && reqSigners_ != numSigners_ - 1) {
+    lagrangeCoeffCache_ = std::make_shared<LagrangeCoeffCache>(numSigners_, lagrangeCoeffCacheSize);
+    lagrangeCoeffCache_->precomputeCommonSubsets(reqSigners_);
+  }
+
 #ifdef TRACE
   LOG_TRACE(BLS_LOG, "VKs (array has size " << vks.size() << ")");
   copy(vks.begin(), vks.end(), ostream_iterator<BlsPublicKey>(cout, "\n"));
@@ -62,7 +71,8 @@ IThresholdAccumulator *BlsThresholdVerifier::newAccumulator(bool withShareVerifi
   if (reqSigners_ == numSigners_ - 1) {
     return new BlsAlmostMultisigAccumulator(publicKeysVector_, numSigners_);
   } else {
-    return new BlsThresholdAccumulator(publicKeysVector_, reqSigners_, numSigners_, withShareVerification);
+    return new BlsThresholdAccumulator(
+        publicKeysVector_, reqSigners_, numSigners_, withShareVerification, lagrangeCoeffCache_);
   }
 }
 
@@ -0,0 +1,98 @@
+// Concord
+//
+// Copyright (c) 2018 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#ifdef ERROR  // TODO(GG): should be fixed by encapsulating relic (or windows) definitions in cpp files
+#undef ERROR
+#endif
+
+#include "LagrangeCoeffCache.h"
+#include "LagrangeInterpolation.h"
+
+#include "threshsign/bls/relic/Library.h"
+
+#include "Logger.hpp"
+#include "XAssert.h"
+
+namespace BLS {
+namespace Relic {
+
+LagrangeCoeffCache::LagrangeCoeffCache(NumSharesType numSigners, size_t capacity)
+    : numSigners_(numSigners), fieldOrder_(Library::Get().getG2Order()), lru_(capacity) {
+  assertStrictlyPositive(numSigners);
+  assertStrictlyPositive(capacity);
+}
+
+LagrangeCoeffCache::CoeffsPtr LagrangeCoeffCache::compute(const VectorOfShares& signers) const {
+  auto coeffs = std::make_shared<std::vector<BNT>>(static_cast<size_t>(numSigners_ + 1));
+  lagrangeCoeffAccumReduced(signers, *coeffs, fieldOrder_);
+  return coeffs;
+}
+
+LagrangeCoeffCache::CoeffsPtr LagrangeCoeffCache::get(const VectorOfShares& signers) {
+  {
+    std::lock_guard<std::mutex> g(lock_);
+    auto it = pinned_.find(signers);
+    if (it != pinned_.end()) {
+      hits_++;
+      return it->second;
+    }
+    auto cached = lru_.get(signers);
+    if (cached) {
+      hits_++;
+      return *cached;
+    }
+    misses_++;
+  }
+
+  // Interpolate outside of the lock so that concurrent misses on different subsets do not serialize. Two accumulators
+  // missing on the same subset at the same time will both compute it, which is harmless.
+  auto coeffs = compute(signers);
+  std::lock_guard<std::mutex> g(lock_);
+  lru_.put(signers, coeffs);
+  return coeffs;
+}
+
+void LagrangeCoeffCache::precomputeCommonSubsets(NumSharesType reqSigners) {
+  VectorOfShares all;
+  for (ShareID i = 1; i <= numSigners_; i++) {
+    all.add(i);
+  }
+
+  std::unordered_map<VectorOfShares, CoeffsPtr> subsets;
+  if (reqSigners == numSigners_) {
+    subsets.emplace(all, compute(all));
+  } else if (reqSigners == numSigners_ - 1) {
+    for (ShareID missing = 1; missing <= numSigners_; missing++) {
+      VectorOfShares allButOne = all;
+      allButOne.remove(missing);
+      subsets.emplace(allButOne, compute(allButOne));
+    }
+  }
+
+  LOG_DEBUG(BLS_LOG,
+            "Precomputed Lagrange coefficients for " << subsets.size() << " subsets (reqSigners = " << reqSigners
+                                                     << ", numSigners = " << numSigners_ << ")");
+  std::lock_guard<std::mutex> g(lock_);
+  pinned_.insert(subsets.begin(), subsets.end());
+}
+
+LagrangeCoeffCache::Stats LagrangeCoeffCache::getStats() const {
+  std::lock_guard<std::mutex> g(lock_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.pinned = pinned_.size();
+  return stats;
+}
+
+}  // namespace Relic
+}  // namespace BLS
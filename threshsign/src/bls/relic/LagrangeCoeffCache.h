@@ -0,0 +1,85 @@
+// Concord
+//
+// Copyright (c) 2018 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "threshsign/bls/relic/BlsNumTypes.h"
+#include "threshsign/ThresholdSignaturesTypes.h"
+#include "threshsign/VectorOfShares.h"
+
+#include "lru_cache.hpp"
+
+namespace BLS {
+namespace Relic {
+
+/**
+ * Memoizes Lagrange coefficient vectors l_i^S(0) keyed by the set of signers S.
+ *
+ * In a stable cluster, the first reqSigners shares to arrive usually come from the same few subsets of signers, so
+ * BlsThresholdAccumulator can skip the interpolation entirely for them. Entries are kept in a bounded LRU, except for
+ * the precomputed common subsets (see precomputeCommonSubsets()), which are pinned for the lifetime of the cache.
+ *
+ * Thread-safe: a single cache is owned by a BlsThresholdVerifier and shared by all the accumulators it creates, which
+ * may combine signatures concurrently.
+ */
+class LagrangeCoeffCache {
+ public:
+  using CoeffsPtr = std::shared_ptr<const std::vector<BNT>>;
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t pinned = 0;
+  };
+
+ public:
+  LagrangeCoeffCache(NumSharesType numSigners, size_t capacity);
+
+ public:
+  /**
+   * Returns the Lagrange coefficients for 'signers', computing and caching them on a miss.
+   * The returned vector has numSigners + 1 entries and is indexed by signer ID.
+   */
+  CoeffsPtr get(const VectorOfShares& signers);
+
+  /**
+   * Precomputes and pins the coefficients of the "all signers" and "all but one signer" subsets that have exactly
+   * reqSigners members (i.e., only the ones an accumulator with this threshold can ever ask for).
+   * Meant to be called once, when the verification keys are installed.
+   */
+  void precomputeCommonSubsets(NumSharesType reqSigners);
+
+  Stats getStats() const;
+
+  size_t capacity() const { return lru_.capacity(); }
+
+ protected:
+  CoeffsPtr compute(const VectorOfShares& signers) const;
+
+ protected:
+  const NumSharesType numSigners_;
+  const BNT fieldOrder_;
+
+  mutable std::mutex lock_;
+  std::unordered_map<VectorOfShares, CoeffsPtr> pinned_;
+  concord::util::LruCache<VectorOfShares, CoeffsPtr> lru_;
+  size_t hits_ = 0;
+  size_t misses_ = 0;
+};
+
+}  // namespace Relic
+}  // namespace BLS
@@ -30,6 +30,7 @@
 #include "threshsign/bls/relic/BlsPublicParameters.h"
 #include "threshsign/bls/relic/PublicParametersFactory.h"
 
+#include "bls/relic/LagrangeCoeffCache.h"
 #include "bls/relic/LagrangeInterpolation.h"
 
 using namespace std;
@@ -127,6 +128,38 @@ int RelicAppMain(const Library& lib, const std::vector<std::string>& args) {
       LOG_ERROR(THRESHSIGN_LOG, "  lagrCoeffs[" << pos << "] = " << *result.second);
       throw std::runtime_error("Bad coeffs");
     }
+
+    // The cache must return the same coefficients on a miss and on the following hit
+    LagrangeCoeffCache cache(numSigners, 2);
+    for (int i = 0; i < 2; i++) {
+      LagrangeCoeffCache::CoeffsPtr cachedCoeffs = cache.get(signers);
+      testAssertEqual(cachedCoeffs->size(), lagrCoeffs.size());
+      for (ShareID id = signers.first(); signers.isEnd(id) == false; id = signers.next(id)) {
+        size_t idx = static_cast<size_t>(id);
+        testAssertEqual((*cachedCoeffs)[idx], lagrCoeffs[idx]);
+      }
+    }
+    testAssertEqual(cache.getStats().misses, 1u);
+    testAssertEqual(cache.getStats().hits, 1u);
+  }
+
+  // Precomputed "all" and "all but one" subsets are pinned and served as hits
+  NumSharesType n = 7;
+  for (NumSharesType reqSigners : {n, n - 1}) {
+    LagrangeCoeffCache cache(n, 1);
+    cache.precomputeCommonSubsets(reqSigners);
+    testAssertEqual(cache.getStats().pinned, static_cast<size_t>(reqSigners == n ? 1 : n));
+
+    VectorOfShares subset;
+    VectorOfShares::randomSubset(subset, n, reqSigners);
+    std::vector<BNT> lagrCoeffs(static_cast<size_t>(n + 1), BNT(0));
+    lagrangeCoeffAccumReduced(subset, lagrCoeffs, lib.getG2Order());
+    LagrangeCoeffCache::CoeffsPtr cachedCoeffs = cache.get(subset);
+    for (ShareID id = subset.first(); subset.isEnd(id) == false; id = subset.next(id)) {
+      size_t idx = static_cast<size_t>(id);
+      testAssertEqual((*cachedCoeffs)[idx], lagrCoeffs[idx]);
+    }
+    testAssertEqual(cache.getStats().misses, 0u);
   }
   return 0;
 }
@@ -18,7 +18,9 @@
 #include <condition_variable>
 #include <functional>
 #include <exception>
+#include <optional>
 #include "Logger.hpp"
+#include "ThreadPlacement.hpp"
 
 namespace concord::util {
 /**
@@ -31,11 +33,12 @@ class Handoff {
   typedef std::function<void()> func_type;
 
  public:
-  Handoff(std::uint16_t replicaId) {
-    thread_ = std::thread([this, replicaId] {
+  Handoff(std::uint16_t replicaId, std::optional<ThreadPlacement::Role> role = std::nullopt) {
+    thread_ = std::thread([this, replicaId, role] {
       try {
         MDC_PUT(MDC_REPLICA_ID_KEY, std::to_string(replicaId));
         MDC_PUT(MDC_THREAD_KEY, "handoff");
+        if (role) ThreadPlacement::instance().place(*role);
         for (;;) pop()();
       } catch (ThreadCanceledException& e) {
         LOG_INFO(getLogger(), "thread cancelled " << std::this_thread::get_id());
@@ -13,11 +13,13 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
 #include <stdint.h>
 #include <map>
 #include <vector>
 #include <mutex>
+#include <shared_mutex>
 #include <memory>
 #include <list>
 #include <variant>
@@ -38,6 +40,9 @@ using AtomicGauge = BasicGauge<std::atomic_uint64_t>;
 using AtomicCounter = BasicCounter<std::atomic_uint64_t>;
 using Status = BasicStatus<std::string>;
 
+class ShardedCounter;
+class ShardedGauge;
+
 // Forward declarations since Aggregator requires these types.
 class Component;
 class Values;
@@ -53,6 +58,10 @@ typedef struct metric_ Metric;
 // The Aggregator is the type responsible for reporting metrics for the entire
 // system. A process should have a single aggregator, and any service
 // responsible for reporting system metrics should read it from the aggregator.
+//
+// Components publish their values by swapping in a new immutable copy, and
+// readers work on the copies they loaded. Publishing and reading only share
+// a reader lock, which is taken exclusively just to register a component.
 class Aggregator {
  public:
   Aggregator(bool metricsEnabled = true) : metricsEnabled_(metricsEnabled) {}
@@ -64,16 +73,22 @@ class Aggregator {
   std::list<Metric> CollectCounters();
   std::list<Metric> CollectStatuses();
   std::list<Metric> CollectSummaries();
+  // All gauges, counters and statuses of all components
+  std::list<Metric> Snapshot();
   // Generate a JSON formatted string
   std::string ToJson();
 
  private:
+  // A registered component and the values it published last
+  struct PublishedComponent;
+
   const bool metricsEnabled_ = true;
   void RegisterComponent(Component& component);
   void UpdateValues(const std::string& name, Values&& values);
+  const PublishedComponent& FindComponent(const std::string& component_name) const;
 
-  std::map<std::string, Component> components_;
-  std::mutex lock_;
+  std::map<std::string, PublishedComponent> components_;
+  std::shared_mutex lock_;
 
   friend class Component;
 };
@@ -98,6 +113,7 @@ class BasicGauge {
   BasicGauge operator--(int) { return BasicGauge(val_--); }
   void Set(const uint64_t val) { val_ = val; }
   T& Get() { return val_; }
+  const T& Get() const { return val_; }
 
  private:
   T val_;
@@ -123,6 +139,7 @@ class BasicCounter {
   }
 
   T& Get() { return val_; }
+  const T& Get() const { return val_; }
 
  private:
   T val_;
@@ -141,11 +158,74 @@ class BasicStatus {
 
   void Set(const T& val) { val_ = val; }
   T& Get() { return val_; }
+  const T& Get() const { return val_; }
 
  private:
   T val_;
 };
 
+/******************************** Class ShardedValue ********************************/
+
+// A value updated by many threads at once. Every thread adds to its own
+// cache line sized shard, and the shards are only summed up when the value is
+// read. Updates therefore never lock and rarely share a cache line.
+class ShardedValue {
+ public:
+  static constexpr size_t kShards = 64;
+
+  explicit ShardedValue(const uint64_t val) { shards_[0].val.store(val, std::memory_order_relaxed); }
+  ShardedValue(const ShardedValue&) = delete;
+  ShardedValue& operator=(const ShardedValue&) = delete;
+
+  uint64_t Get() const {
+    uint64_t sum = 0;
+    for (const auto& shard : shards_) {
+      sum += shard.val.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ protected:
+  // Negative deltas wrap around, and so does the sum of the shards.
+  void Add(const uint64_t delta) { shards_[ShardIndex()].val.fetch_add(delta, std::memory_order_relaxed); }
+
+ private:
+  struct alignas(64) Shard {
+    std::atomic_uint64_t val{0};
+  };
+
+  // Threads are assigned shards round robin on their first update
+  static size_t ShardIndex() {
+    static std::atomic_size_t next_shard{0};
+    thread_local const size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+  }
+
+  std::array<Shard, kShards> shards_;
+};
+
+class ShardedCounter : public ShardedValue {
+ public:
+  explicit ShardedCounter(const uint64_t val) : ShardedValue(val) {}
+  // postfix
+  void operator++(int) { Add(1); }
+  void operator+=(const uint64_t rhs) { Add(rhs); }
+};
+
+class ShardedGauge : public ShardedValue {
+ public:
+  explicit ShardedGauge(const uint64_t val) : ShardedValue(val) {}
+  // postfix
+  void operator++(int) { Add(1); }
+  // postfix
+  void operator--(int) { Add(-1); }
+  void operator+=(const uint64_t rhs) { Add(rhs); }
+  void operator-=(const uint64_t rhs) { Add(-rhs); }
+  // Updates by other threads between reading the current value and adding
+  // the difference are kept on top of the new value.
+  void Set(const uint64_t val) { Add(val - Get()); }
+};
+
 // A generic struct that may represent a counter or a gauge
 // the motivation is to eliminate that need to know the exact
 // metric name before getting it from the aggregator
@@ -165,6 +245,9 @@ class Values {
   std::vector<Counter> counters_;
   std::vector<AtomicCounter> atomic_counters_;
   std::vector<AtomicGauge> atomic_gauges_;
+  // Live values shared with the component, they are read when collected
+  std::vector<std::shared_ptr<ShardedCounter>> sharded_counters_;
+  std::vector<std::shared_ptr<ShardedGauge>> sharded_gauges_;
 
   friend class Component;
   friend class Aggregator;
@@ -183,6 +266,8 @@ class Names {
   std::vector<std::string> counter_names_;
   std::vector<std::string> atomic_counter_names_;
   std::vector<std::string> atomic_gauge_names_;
+  std::vector<std::string> sharded_counter_names_;
+  std::vector<std::string> sharded_gauge_names_;
 
   friend class Component;
   friend class Aggregator;
@@ -250,6 +335,36 @@ class Component {
     const bool metricsEnabled_;
   };
 
+  // A ShardedHandle shares ownership of a sharded value. Unlike a Handle, it
+  // may be copied to and used from any thread, and the aggregator always
+  // reports the current value without the component being updated.
+  template <typename T>
+  class ShardedHandle {
+   public:
+    ShardedHandle(std::shared_ptr<T> value, bool metricsEnabled)
+        : value_(std::move(value)), metricsEnabled_(metricsEnabled) {}
+    T& Get() { return *value_; }
+    const T& Get() const { return *value_; }
+    // postfix
+    void operator++(int) {
+      if (metricsEnabled_) (*value_)++;
+    }
+    // postfix
+    void operator--(int) {
+      if (metricsEnabled_) (*value_)--;
+    }
+    void operator+=(const uint64_t rhs) {
+      if (metricsEnabled_) *value_ += rhs;
+    }
+    void operator-=(const uint64_t rhs) {
+      if (metricsEnabled_) *value_ -= rhs;
+    }
+
+   private:
+    std::shared_ptr<T> value_;
+    bool metricsEnabled_;
+  };
+
   Component(const std::string& name, std::shared_ptr<Aggregator> aggregator)
       : aggregator_(aggregator), name_(name), metricsEnabled_(aggregator->metricsEnabled_) {}
   std::string Name() { return name_; }
@@ -266,10 +381,15 @@ class Component {
   Handle<AtomicCounter> RegisterAtomicCounter(const std::string& name, const uint64_t val);
   Handle<AtomicCounter> RegisterAtomicCounter(const std::string& name) { return RegisterAtomicCounter(name, 0); }
   Handle<AtomicGauge> RegisterAtomicGauge(const std::string& name, const uint64_t val);
+  ShardedHandle<ShardedCounter> RegisterShardedCounter(const std::string& name, const uint64_t val);
+  ShardedHandle<ShardedCounter> RegisterShardedCounter(const std::string& name) {
+    return RegisterShardedCounter(name, 0);
+  }
+  ShardedHandle<ShardedGauge> RegisterShardedGauge(const std::string& name, const uint64_t val);
 
-  std::list<Metric> CollectGauges();
-  std::list<Metric> CollectCounters();
-  std::list<Metric> CollectStatuses();
+  std::list<Metric> CollectGauges() const { return CollectGauges(values_); }
+  std::list<Metric> CollectCounters() const { return CollectCounters(values_); }
+  std::list<Metric> CollectStatuses() const { return CollectStatuses(values_); }
   // Register the component with the aggregator.
   // This *must* be done after all values are registered in this component.
   // If registration happens before all registration of the values, then the
@@ -293,12 +413,17 @@ class Component {
   }
 
   // Generate a JSON formatted string
-  std::string ToJson();
+  std::string ToJson() const { return ToJson(values_); }
 
  private:
   friend class Aggregator;
 
-  void SetValues(Values&& values) { values_ = values; }
+  // The names and tags are those of this component, the values may be a copy
+  // published to the aggregator.
+  std::list<Metric> CollectGauges(const Values& values) const;
+  std::list<Metric> CollectCounters(const Values& values) const;
+  std::list<Metric> CollectStatuses(const Values& values) const;
+  std::string ToJson(const Values& values) const;
 
   std::weak_ptr<Aggregator> aggregator_;
   std::string name_;
@@ -314,5 +439,13 @@ typedef concordMetrics::Component::Handle<concordMetrics::Status> StatusHandle;
 typedef concordMetrics::Component::Handle<concordMetrics::Counter> CounterHandle;
 typedef concordMetrics::Component::Handle<concordMetrics::AtomicCounter> AtomicCounterHandle;
 typedef concordMetrics::Component::Handle<concordMetrics::AtomicGauge> AtomicGaugeHandle;
+typedef concordMetrics::Component::ShardedHandle<concordMetrics::ShardedCounter> ShardedCounterHandle;
+typedef concordMetrics::Component::ShardedHandle<concordMetrics::ShardedGauge> ShardedGaugeHandle;
+
+struct Aggregator::PublishedComponent {
+  // Only the names and tags of the registered copy are used
+  Component component;
+  std::shared_ptr<const Values> values;
+};
 
 }  // namespace concordMetrics
@@ -14,14 +14,18 @@
 #pragma once
 
 #include <stdint.h>
+#include <chrono>
+#include <list>
 #include <memory>
 #include <thread>
+#include <vector>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
 
 #include "Logger.hpp"
 #include "Metrics.hpp"
+#include "MetricsSnapshotCodec.hpp"
 
 #define MAX_MSG_SIZE (64 * 1024)  // 64k
 
@@ -30,9 +34,12 @@ namespace concordMetrics {
 const uint8_t kRequest = 0;
 const uint8_t kReply = 1;
 const uint8_t kError = 2;
+const uint8_t kBinaryRequest = 3;
+const uint8_t kBinaryReply = 4;
+const uint8_t kSubscribe = 5;
 
 #pragma pack(push, 1)
-// All requests are solely Headers with msg_type_ set to kRequest. Replies are
+// JSON requests are solely Headers with msg_type_ set to kRequest. Replies are
 // JSON strings preceded by a Header with msg_type set to kReply or kError.
 // Since we are using UDP, the entire message will always be included, so no
 // need to worry about framing. We can always change the protocol if we decide
@@ -41,36 +48,93 @@ struct Header {
   uint8_t msg_type_;
   uint64_t seq_num_;
 };
+
+// Replies to a kBinaryRequest are a snapshot encoded by SnapshotEncoder preceded by a Header with msg_type_ set to
+// kBinaryReply. The snapshot is a delta against base_snapshot_id_ if the server still keeps it, or a full one
+// otherwise, e.g. for a base_snapshot_id_ of 0.
+struct BinaryRequest {
+  Header header_;
+  uint64_t base_snapshot_id_;
+};
+
+// A kSubscribe makes the server push a kBinaryReply, with the seq_num_ of the subscription, to its sender every
+// interval_ms_. Each snapshot pushed is a delta against the previous one but for every kFullSnapshotEvery-th, so that
+// a subscriber recovers from lost datagrams. A subscription lasts kSubscriptionLease unless renewed by another
+// kSubscribe, and is cancelled by an interval_ms_ of 0. The server replies with a kError if subscriptions are disabled
+// or full, and once a push gets too large, which cancels the subscription.
+struct SubscribeRequest {
+  Header header_;
+  uint32_t interval_ms_;
+};
 #pragma pack(pop)
 
+// Anyone who can send a datagram to the server can subscribe any address to its pushes, hence subscriptions are
+// disabled by default and bounded
+struct SubscriptionConfig {
+  bool enabled = false;
+  size_t max_subscriptions = 4;
+  std::chrono::milliseconds min_interval{100};
+  size_t max_push_bytes = 16 * 1024;
+};
+
 // A UDP server that returns aggregated metrics
 class Server {
  public:
-  Server(uint16_t listenPort, bool metricsEnabled = true)
+  Server(uint16_t listenPort,
+         bool metricsEnabled = true,
+         const SubscriptionConfig& subscriptionConfig = SubscriptionConfig{})
       : listenPort_{listenPort},
         logger_{logging::getLogger("metrics-server")},
         running_{false},
-        aggregator_{std::make_shared<Aggregator>(metricsEnabled)} {}
+        aggregator_{std::make_shared<Aggregator>(metricsEnabled)},
+        subscriptionConfig_{subscriptionConfig} {}
 
   void Start();
   void Stop();
 
   std::shared_ptr<Aggregator> GetAggregator() { return aggregator_; }
 
+  static constexpr size_t kFullSnapshotEvery = 16;
+  static constexpr std::chrono::seconds kSubscriptionLease{60};
+
  private:
+  struct Subscription {
+    sockaddr_in addr;
+    socklen_t addrlen;
+    uint64_t seq_num;
+    std::chrono::milliseconds interval;
+    std::chrono::steady_clock::time_point next_push;
+    std::chrono::steady_clock::time_point expiry;
+    uint64_t last_snapshot_id = 0;
+    size_t pushes = 0;
+    // Keeps the base of the next delta, so that the subscriptions don't evict the bases of the polling clients
+    SnapshotEncoder encoder{2};
+  };
+
   uint16_t listenPort_;
   logging::Logger logger_;
   bool running_;
   std::mutex running_lock_;
 
   std::shared_ptr<Aggregator> aggregator_;
+  const SubscriptionConfig subscriptionConfig_;
   std::thread thread_;
 
   int sock_;
   uint8_t buf_[MAX_MSG_SIZE];
 
+  // Only accessed by the RecvLoop thread
+  SnapshotEncoder encoder_;
+  std::list<Subscription> subscriptions_;
+
   void RecvLoop();
+  void handleBinaryRequest(const BinaryRequest& request, sockaddr_in* cliaddr, socklen_t addrlen);
+  void handleSubscribe(const SubscribeRequest& request, sockaddr_in* cliaddr, socklen_t addrlen);
+  void pushToSubscribers();
+  // How long the RecvLoop may wait for a request before a subscription is due
+  std::chrono::microseconds timeToNextPush() const;
   void sendReply(std::string data, sockaddr_in* cliaddr, socklen_t addrlen);
+  bool sendBinaryReply(uint64_t seqNum, const std::string& data, const sockaddr_in* cliaddr, socklen_t addrlen);
   void sendError(sockaddr_in* cliaddr, socklen_t addrlen);
 };
 
@@ -0,0 +1,101 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "Metrics.hpp"
+
+namespace concordMetrics {
+
+// A compact binary encoding of the counters, gauges and statuses of an aggregator.
+//
+// The names of the components and metrics are interned in a string table that only full snapshots carry. A delta
+// snapshot carries the metrics whose values changed since a base snapshot with the same metrics, so a scrape in steady
+// state costs a few bytes per changed metric. Integers are LEB128 varints, and differences are zigzag encoded:
+//
+//   full:  kFullSnapshot, id, #strings, {length, bytes}*, #metrics, {component string, name string, type}*, and the
+//          values in metric order: counters and gauges as integers, statuses as {length, bytes}
+//   delta: kDeltaSnapshot, id, base id, #changed, {index gap from the previous changed metric, value}*, where counters
+//          and gauges are differences from their base value
+enum class MetricType : uint8_t { Counter = 0, Gauge = 1, Status = 2 };
+
+const uint8_t kFullSnapshot = 0;
+const uint8_t kDeltaSnapshot = 1;
+
+// Takes snapshots of an aggregator and encodes them. The last historySize snapshots are kept as delta bases.
+class SnapshotEncoder {
+ public:
+  explicit SnapshotEncoder(size_t historySize = 16) : historySize_{historySize} {}
+
+  // Returns the id of the new snapshot. Ids start at 1, 0 stands for no snapshot.
+  uint64_t Take(Aggregator& aggregator);
+
+  // Encodes the given snapshot as a delta against baseId if it is still kept and has the same metrics, in full
+  // otherwise. Throws std::out_of_range if the snapshot itself isn't kept anymore.
+  std::string Encode(uint64_t id, uint64_t baseId = 0) const;
+
+  uint64_t LastId() const { return lastId_; }
+
+ private:
+  struct Layout {
+    struct Entry {
+      uint32_t component;
+      uint32_t name;
+      MetricType type;
+    };
+    std::vector<std::string> strings;
+    std::vector<Entry> metrics;
+  };
+  using Value = std::variant<uint64_t, std::string>;
+  struct Snapshot {
+    uint64_t id;
+    // Shared by consecutive snapshots of the same metrics
+    std::shared_ptr<const Layout> layout;
+    std::vector<Value> values;
+  };
+
+  const Snapshot* Find(uint64_t id) const;
+  static bool SameLayout(const Layout& layout, const std::list<Metric>& metrics);
+  static std::shared_ptr<const Layout> MakeLayout(const std::list<Metric>& metrics);
+  static void EncodeFull(const Snapshot& snapshot, std::string& out);
+  static void EncodeDelta(const Snapshot& snapshot, const Snapshot& base, std::string& out);
+
+  const size_t historySize_;
+  uint64_t lastId_ = 0;
+  std::deque<Snapshot> history_;
+};
+
+// Rebuilds the metrics from encoded snapshots, applied in the order they were taken.
+class SnapshotDecoder {
+ public:
+  // Returns false, leaving the decoder unchanged, for a delta against another snapshot than the last one applied.
+  // Throws std::invalid_argument if the data is malformed.
+  bool Apply(const std::string& data);
+
+  // The id of the last snapshot applied, 0 if none
+  uint64_t LastId() const { return lastId_; }
+  const std::vector<Metric>& Metrics() const { return metrics_; }
+
+ private:
+  uint64_t lastId_ = 0;
+  std::vector<Metric> metrics_;
+};
+
+}  // namespace concordMetrics
@@ -0,0 +1,102 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace concord::util {
+
+// A bounded lock-free multi-producer multi-consumer queue, by Dmitry Vyukov. Every slot carries a sequence number
+// telling producers and consumers whether it's their turn to use it: a producer owns the slot at position pos once it
+// swaps the enqueue position when the sequence is pos, and publishes the item by setting the sequence to pos + 1. A
+// consumer frees the slot for the next lap by setting the sequence to pos + capacity.
+template <typename T>
+class MpmcBoundedQueue {
+ public:
+  // capacity: A power of two
+  explicit MpmcBoundedQueue(size_t capacity) : mask_(capacity - 1), slots_(new Slot[capacity]) {
+    if (capacity < 2 || (capacity & mask_) != 0) {
+      throw std::invalid_argument("the capacity of a queue must be a power of two");
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+      slots_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+  MpmcBoundedQueue(const MpmcBoundedQueue&) = delete;
+  MpmcBoundedQueue& operator=(const MpmcBoundedQueue&) = delete;
+
+  // Returns false if the queue is full
+  bool tryPush(const T& item) {
+    auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& slot = slots_[pos & mask_];
+      const auto diff = static_cast<int64_t>(slot.seq.load(std::memory_order_acquire) - pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          slot.item = item;
+          slot.seq.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The slot wasn't consumed since the previous lap
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false if the queue is empty
+  bool tryPop(T& item) {
+    auto pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      auto& slot = slots_[pos & mask_];
+      const auto diff = static_cast<int64_t>(slot.seq.load(std::memory_order_acquire) - (pos + 1));
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          item = slot.item;
+          slot.seq.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        // The slot wasn't published yet
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Approximate while producers or consumers are running
+  size_t size() const {
+    const auto dequeued = dequeue_pos_.load(std::memory_order_relaxed);
+    const auto enqueued = enqueue_pos_.load(std::memory_order_relaxed);
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> seq;
+    T item;
+  };
+
+  const uint64_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  alignas(64) std::atomic<uint64_t> enqueue_pos_{0};
+  alignas(64) std::atomic<uint64_t> dequeue_pos_{0};
+};
+
+}  // namespace concord::util
@@ -17,6 +17,9 @@
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
+#include <optional>
+
+#include "ThreadPlacement.hpp"
 
 namespace concord::util {
 
@@ -34,6 +37,8 @@ class SimpleThreadPool {
   };
 
   SimpleThreadPool() : stopped_(true) {}
+  // The threads of the pool are placed according to the policy of the role
+  explicit SimpleThreadPool(ThreadPlacement::Role role) : stopped_(true), role_(role) {}
 
   /**
    * starts the thread pool with desired number of threads
@@ -77,6 +82,7 @@ class SimpleThreadPool {
   std::mutex threads_startup_lock_;
   std::condition_variable threads_startup_cond_;
   std::vector<std::thread> threads_;
+  const std::optional<ThreadPlacement::Role> role_;
 };
 
 }  // namespace concord::util
@@ -0,0 +1,130 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include "Logger.hpp"
+#include "Metrics.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A thread-safe allocator of raw memory chunks of any size up to a maximum, unlike RawMemoryPool which hands out chunks
+// of a single size. A request is served from the smallest size class that fits it. The classes grow by a quarter of a
+// power of two, so a chunk wastes at most 20% of its size.
+//
+// Every thread keeps a small magazine of free chunks per class, and trades half magazines with the shared depot of the
+// class when its magazine runs empty or full, so most requests take no shared lock. Chunks are only allocated from the
+// heap when the depot is empty too: the allocator never blocks waiting for chunks. A background thread periodically
+// trims the depots, freeing half of the chunks that stayed unused since the previous trim, and publishes the number of
+// allocated and available chunks of every class.
+
+namespace concordUtil {
+
+class SlabAllocator {
+ public:
+  // Magazines are kept per slot of threads, threads beyond the number of slots share them
+  static constexpr size_t kNumOfSlots = 64;
+  static constexpr uint32_t kMinChunkSize = 64;
+  // The bytes of free chunks of a class a magazine holds, classes of larger chunks trade with the depot directly
+  static constexpr uint32_t kMagazineBytes = 1 << 20;
+  static constexpr uint32_t kMaxMagazineChunks = 32;
+
+  // With a trimPeriod of 0, the depots are only trimmed by calling trim()
+  SlabAllocator(const std::string& name,
+                uint32_t maxChunkSize,
+                std::chrono::milliseconds trimPeriod = std::chrono::seconds(1));
+  ~SlabAllocator();
+
+  SlabAllocator(const SlabAllocator&) = delete;
+  SlabAllocator& operator=(const SlabAllocator&) = delete;
+
+  // Returns a chunk of at least size bytes. Throws std::invalid_argument if size exceeds the maximum chunk size.
+  char* allocate(uint32_t size);
+  // Returns a chunk to the class it was allocated from, by any thread
+  void deallocate(char* chunk);
+
+  // Allocates numOfChunks chunks that fit size upfront, and keeps as many chunks of their class when trimming
+  void reserve(uint32_t size, uint32_t numOfChunks);
+
+  // Frees half of the chunks that stayed in the depots since the previous trim, and updates the metrics
+  void trim();
+
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator);
+
+  // The size of the chunks of the class that serves requests of size bytes
+  uint32_t chunkSize(uint32_t size) const { return classes_[classOf(size)]->size; }
+  uint32_t maxChunkSize() const { return classes_.back()->size; }
+  size_t numOfClasses() const { return classes_.size(); }
+  // The number of chunks of the class of size allocated from the heap, and not in use
+  size_t allocatedChunks(uint32_t size) const;
+  size_t availableChunks(uint32_t size) const;
+
+  static logging::Logger& logger() {
+    static logging::Logger logger_ = logging::getLogger("concord.memory.slab");
+    return logger_;
+  }
+
+ private:
+  struct SizeClass {
+    SizeClass(uint32_t size, uint32_t magazineCapacity) : size{size}, magazineCapacity{magazineCapacity} {}
+    const uint32_t size;
+    const uint32_t magazineCapacity;
+
+    // The depot, guarded by lock
+    mutable std::mutex lock;
+    std::vector<char*> free;
+    // The fewest free chunks the depot had since the previous trim
+    size_t minFree = 0;
+    size_t allocated = 0;
+    size_t reserved = 0;
+  };
+  struct alignas(64) Slot {
+    mutable std::mutex lock;
+    // A magazine of free chunks per class
+    std::vector<std::vector<char*>> magazines;
+  };
+
+  size_t classOf(uint32_t size) const;
+  Slot& slot();
+  // Moves up to numOfChunks free chunks of the class from its depot to the magazine, or allocates one if none is free
+  void refill(SizeClass& sizeClass, size_t index, std::vector<char*>& magazine, size_t numOfChunks);
+  char* newChunk(uint32_t size, size_t index);
+  static void deleteChunk(char* chunk);
+  void trimLoop();
+  void updateMetrics();
+
+ private:
+  std::vector<std::unique_ptr<SizeClass>> classes_;
+  std::vector<uint32_t> sizes_;
+  std::array<Slot, kNumOfSlots> slots_;
+
+  std::chrono::milliseconds trimPeriod_;
+  std::mutex trimLock_;
+  std::condition_variable trimCond_;
+  bool stopped_ = false;
+  std::thread trimThread_;
+
+  // Only updated when trimming
+  concordMetrics::Component metrics_;
+  std::vector<concordMetrics::GaugeHandle> allocatedChunks_;
+  std::vector<concordMetrics::GaugeHandle> availableChunks_;
+};
+
+}  // namespace concordUtil
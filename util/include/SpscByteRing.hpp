@@ -0,0 +1,115 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace concord::util {
+
+// A single producer single consumer ring of variable sized records, over a buffer and positions it doesn't own, e.g.
+// in memory shared by processes. A record is its size followed by its bytes, and never wraps around: if it doesn't fit
+// before the end of the buffer, a marker tells the reader to skip to the start.
+//
+// The writer and the reader each use a ring of their own over the same positions and buffer.
+class SpscByteRing {
+ public:
+  struct Positions {
+    // Written by the reader
+    alignas(64) std::atomic_uint64_t head{0};
+    // Written by the writer
+    alignas(64) std::atomic_uint64_t tail{0};
+  };
+
+  // capacity: The bytes of the buffer, a power of two
+  SpscByteRing(Positions& positions, char* buffer, size_t capacity)
+      : positions_(&positions), buffer_(buffer), capacity_(capacity) {
+    if (capacity < 4 * kAlignment || (capacity & (capacity - 1)) != 0) {
+      throw std::invalid_argument("the bytes of a ring must be a power of two");
+    }
+  }
+
+  // Larger records may not fit even in an empty ring
+  size_t maxRecordSize() const { return capacity_ / 4; }
+
+  // Returns false if the ring is full
+  bool tryWrite(const void* data, size_t size) {
+    const auto length = recordLength(size);
+    auto tail = positions_->tail.load(std::memory_order_relaxed);
+    const auto offset = tail & (capacity_ - 1);
+    const auto contiguous = capacity_ - offset;
+    const auto needed = contiguous < length ? contiguous + length : length;
+    if (tail + needed - cached_head_ > capacity_) {
+      cached_head_ = positions_->head.load(std::memory_order_acquire);
+      if (tail + needed - cached_head_ > capacity_) return false;
+    }
+    if (contiguous < length) {
+      writeHeader(offset, kWrapMarker);
+      tail += contiguous;
+    }
+    const auto at = tail & (capacity_ - 1);
+    writeHeader(at, static_cast<uint32_t>(size));
+    std::memcpy(&buffer_[at + kHeaderSize], data, size);
+    positions_->tail.store(tail + length, std::memory_order_release);
+    return true;
+  }
+
+  // Calls reader(data, size) for the records written so far, straight from the buffer, and returns how many
+  template <typename Reader>
+  size_t read(Reader&& reader) {
+    auto head = positions_->head.load(std::memory_order_relaxed);
+    const auto tail = positions_->tail.load(std::memory_order_acquire);
+    size_t records = 0;
+    while (head < tail) {
+      const auto offset = head & (capacity_ - 1);
+      uint32_t size = 0;
+      std::memcpy(&size, &buffer_[offset], kHeaderSize);
+      if (size == kWrapMarker) {
+        head += capacity_ - offset;
+        continue;
+      }
+      reader(static_cast<const char*>(&buffer_[offset + kHeaderSize]), static_cast<size_t>(size));
+      head += recordLength(size);
+      // Make room for a blocked writer as early as possible
+      positions_->head.store(head, std::memory_order_release);
+      ++records;
+    }
+    positions_->head.store(head, std::memory_order_release);
+    return records;
+  }
+
+  bool empty() const {
+    return positions_->head.load(std::memory_order_acquire) == positions_->tail.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t kAlignment = 8;
+  static constexpr size_t kHeaderSize = sizeof(uint32_t);
+  static constexpr uint32_t kWrapMarker = UINT32_MAX;
+
+  static size_t recordLength(size_t size) { return (kHeaderSize + size + kAlignment - 1) & ~(kAlignment - 1); }
+
+  void writeHeader(size_t offset, uint32_t size) { std::memcpy(&buffer_[offset], &size, kHeaderSize); }
+
+  Positions* positions_;
+  char* buffer_;
+  size_t capacity_;
+  // The head last read by the writer, to read the head written by the reader only when the ring looks full
+  uint64_t cached_head_ = 0;
+};
+
+static_assert(std::atomic_uint64_t::is_always_lock_free, "the positions of a ring may be in shared memory");
+
+}  // namespace concord::util
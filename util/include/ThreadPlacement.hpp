@@ -0,0 +1,113 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Metrics.hpp"
+
+namespace concord::util {
+
+// Places the long lived threads of a replica on CPUs by role.
+//
+// A policy maps roles to a list of CPUs ("0-3,8") or to a NUMA node ("node1"), e.g.
+// "dispatcher=2;post_exec=3;comm=node0". A thread placed on a node also prefers allocating memory from that node, so
+// the buffers of its pools are local to the CPUs that use them. Threads of roles the policy doesn't mention are left to
+// the OS scheduler.
+//
+// The placed threads are tracked until they exit, and the "thread_placement" metrics component reports per role the
+// number of live threads, and the migrations and involuntary context switches they went through.
+class ThreadPlacement {
+ public:
+  enum class Role : uint8_t { Dispatcher, PostExec, RequestPool, PreProcessor, Comm, StateTransfer, Count };
+  static constexpr size_t kNumOfRoles = static_cast<size_t>(Role::Count);
+  static constexpr std::array<const char*, kNumOfRoles> kRoleNames{
+      "dispatcher", "post_exec", "request_pool", "pre_processor", "comm", "state_transfer"};
+
+  struct Placement {
+    std::vector<int> cpus;
+    // The NUMA node of the CPUs, if placed on a node
+    std::optional<int> node;
+  };
+  using Policy = std::map<Role, Placement>;
+
+  static ThreadPlacement& instance() {
+    static ThreadPlacement instance_;
+    return instance_;
+  }
+
+  // Replaces the policy and moves the threads already placed accordingly. Throws std::invalid_argument if the policy is
+  // malformed, names an unknown role or a NUMA node that doesn't exist.
+  void setPolicy(const std::string& policy);
+
+  // Places the calling thread according to the policy of its role, and tracks it until it exits. Failing to place a
+  // thread, e.g. on CPUs outside of the cgroup of the process, is logged and leaves the thread where it is.
+  void place(Role role);
+
+  void setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator);
+
+  // Samples the scheduler statistics of the tracked threads and publishes the metrics. Should be called periodically.
+  void updateMetrics();
+
+  static Policy parsePolicy(const std::string& policy);
+  // Parses a list of CPUs like "0-3,8,10-11"
+  static std::vector<int> parseCpuList(const std::string& cpus);
+
+ private:
+  struct RoleMetrics {
+    concordMetrics::GaugeHandle threads;
+    concordMetrics::CounterHandle migrations;
+    concordMetrics::CounterHandle involuntaryContextSwitches;
+  };
+  struct SchedStats {
+    uint64_t migrations = 0;
+    uint64_t involuntaryContextSwitches = 0;
+    // The CPU the thread last ran on, to count migrations when the kernel doesn't report them
+    int lastCpu = -1;
+  };
+  struct Thread {
+    Role role;
+    SchedStats stats;
+  };
+
+  ThreadPlacement();
+  ThreadPlacement(const ThreadPlacement&) = delete;
+  ThreadPlacement& operator=(const ThreadPlacement&) = delete;
+
+  // Forgets the calling thread when it exits
+  struct PlacedThread;
+  void forget(pid_t tid);
+  // Places the thread on the CPUs of its role, or of the process if the policy doesn't mention the role
+  void apply(pid_t tid, Role role, bool isCallingThread);
+  // Adds the scheduler events of the thread since its last sample to the counters of its role
+  void sample(pid_t tid, Thread& thread);
+  RoleMetrics& metricsOf(Role role) { return roleMetrics_[static_cast<size_t>(role)]; }
+
+  std::mutex lock_;
+  Policy policy_;
+  // The CPUs the process was allowed to run on before any thread was placed
+  std::vector<int> defaultCpus_;
+  std::map<pid_t, Thread> threads_;
+  concordMetrics::Component metrics_;
+  std::vector<RoleMetrics> roleMetrics_;
+};
+
+}  // namespace concord::util
@@ -12,17 +12,24 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <cstdint>
 #include <chrono>
 #include <vector>
 #include <algorithm>
 #include <mutex>
+#include <utility>
 
 namespace concordUtil {
 
-// A collection of timers backed by a vector.
-class Timers {
+template <typename Queue>
+class BasicTimers;
+class TimerVector;
+class TimingWheel;
+
+// The handle and timer types shared by all the backends of BasicTimers.
+class TimersBase {
  public:
   class Handle {
    public:
@@ -38,7 +45,8 @@ class Timers {
     explicit Handle(uint64_t id) : id_(id) {}
 
     uint64_t id_;
-    friend class Timers;
+    template <typename Queue>
+    friend class BasicTimers;
   };
 
   class Timer {
@@ -49,9 +57,6 @@ class Timers {
     };
 
    private:
-    Timer(std::chrono::milliseconds duration, Type t, const std::function<void(Handle)>& callback)
-        : Timer(duration, t, callback, std::chrono::steady_clock::now()) {}
-
     Timer(std::chrono::milliseconds d,
           Type t,
           std::function<void(Handle)> cb,
@@ -62,8 +67,6 @@ class Timers {
 
     bool recurring() const { return type_ == Type::RECURRING; }
 
-    void run_callback(Handle h) { callback_(h); }
-
     void reset(std::chrono::steady_clock::time_point now) { expires_at_ = now + duration_; }
 
     void reset(std::chrono::steady_clock::time_point now, std::chrono::milliseconds d) {
@@ -77,15 +80,312 @@ class Timers {
     uint64_t id_ = 0;
     std::function<void(Handle)> callback_;
 
-    friend class Timers;
+    template <typename Queue>
+    friend class BasicTimers;
+    friend class TimerVector;
+    friend class TimingWheel;
   };
+};
 
+// Keeps the timers in a vector, sorted by id. Add is O(1), cancel and evaluate are O(n).
+class TimerVector {
  public:
-  Timers() : id_counter_(0) {}
-  Timers(const Timers& timers) = delete;
-  Timers& operator=(const Timers& timers) = delete;
-  Timers(Timers&& timers) = delete;
-  Timers&& operator=(Timers&& timers) = delete;
+  using Timer = TimersBase::Timer;
+
+  uint64_t add(Timer&& timer) {
+    timer.id_ = ++id_counter_;
+    timers_.push_back(std::move(timer));
+    return id_counter_;
+  }
+
+  Timer* find(uint64_t id) {
+    auto it = lowerBound(id);
+    return it != timers_.end() && it->id_ == id ? &*it : nullptr;
+  }
+
+  void erase(uint64_t id) {
+    auto it = lowerBound(id);
+    if (it != timers_.end() && it->id_ == id) {
+      timers_.erase(it);
+    }
+  }
+
+  // The expiry of the timer changed
+  void rescheduled(uint64_t) {}
+
+  // Append the ids of the expired timers to ids
+  void expired(std::chrono::steady_clock::time_point now, std::vector<uint64_t>& ids) const {
+    for (const auto& timer : timers_) {
+      if (timer.expired(now)) {
+        ids.push_back(timer.id_);
+      }
+    }
+  }
+
+ private:
+  std::vector<Timer>::iterator lowerBound(uint64_t id) {
+    return std::lower_bound(
+        timers_.begin(), timers_.end(), id, [](const Timer& t, uint64_t id) { return t.id_ < id; });
+  }
+
+  std::vector<Timer> timers_;
+  uint64_t id_counter_ = 0;
+};
+
+// Hierarchical timing wheel with a resolution of 1ms. Level 0 has a slot per tick for the next 256 ticks, every higher
+// level has a slot per 256 slots of the level below it, so the 4 levels reach 2^32 ticks (~49 days) ahead. Timers
+// further out are parked in the level 3 slot that is cascaded last. A slot of a higher level is cascaded into the
+// lower levels once the current tick reaches the block it covers.
+//
+// Add, cancel and reset are O(1). evaluate() returns right away until the earliest time a timer may expire at, and
+// otherwise only visits the occupied level 0 slots and the block boundaries up to now.
+class TimingWheel {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Timer = TimersBase::Timer;
+
+  TimingWheel() : origin_(Clock::now()) {
+    for (auto& level : slots_) {
+      level.fill(kNil);
+    }
+  }
+
+  uint64_t add(Timer&& timer) {
+    uint32_t index = 0;
+    if (free_.empty()) {
+      index = static_cast<uint32_t>(entries_.size());
+      entries_.emplace_back(std::move(timer));
+    } else {
+      index = free_.back();
+      free_.pop_back();
+      entries_[index].timer = std::move(timer);
+    }
+    auto& entry = entries_[index];
+    entry.in_use = true;
+    // The generation tells a stale handle apart from the handle of a later timer in the same entry
+    entry.timer.id_ = (static_cast<uint64_t>(entry.generation) << 32) | index;
+    link(index);
+    return entry.timer.id_;
+  }
+
+  Timer* find(uint64_t id) {
+    const auto index = static_cast<uint32_t>(id);
+    if (index >= entries_.size() || !entries_[index].in_use || entries_[index].timer.id_ != id) {
+      return nullptr;
+    }
+    return &entries_[index].timer;
+  }
+
+  void erase(uint64_t id) {
+    if (!find(id)) {
+      return;
+    }
+    const auto index = static_cast<uint32_t>(id);
+    auto& entry = entries_[index];
+    unlink(index);
+    entry.in_use = false;
+    entry.timer.callback_ = nullptr;
+    if (++entry.generation == 0) {
+      entry.generation = 1;
+    }
+    free_.push_back(index);
+  }
+
+  // The expiry of the timer changed
+  void rescheduled(uint64_t id) {
+    if (!find(id)) {
+      return;
+    }
+    const auto index = static_cast<uint32_t>(id);
+    unlink(index);
+    link(index);
+  }
+
+  // Append the ids of the expired timers to ids. They stay in the wheel but are no longer linked to a slot, they must
+  // be either erased or rescheduled.
+  void expired(Clock::time_point now, std::vector<uint64_t>& ids) {
+    if (now < earliest_) {
+      return;
+    }
+    const auto target = tick(now);
+    while (true) {
+      for (auto index = slots_[0][current_ & kSlotMask]; index != kNil;) {
+        auto& entry = entries_[index];
+        const auto next = entry.next;
+        if (entry.timer.expired(now)) {
+          unlink(index);
+          ids.push_back(entry.timer.id_);
+        }
+        index = next;
+      }
+      if (current_ >= target) {
+        break;
+      }
+      // Nothing is due or has to be cascaded in between
+      current_ = std::min(nextEventTick(), target);
+      if ((current_ & kSlotMask) == 0) {
+        cascade();
+      }
+    }
+    earliest_ = linked_ > 0 ? origin_ + std::chrono::milliseconds(firstOccupiedTick()) : Clock::time_point::max();
+  }
+
+ private:
+  static constexpr uint32_t kNil = UINT32_MAX;
+  static constexpr size_t kLevels = 4;
+  static constexpr size_t kSlotBits = 8;
+  static constexpr size_t kSlots = size_t{1} << kSlotBits;
+  static constexpr uint64_t kSlotMask = kSlots - 1;
+  static constexpr uint16_t kUnlinked = UINT16_MAX;
+
+  struct Entry {
+    explicit Entry(Timer&& t) : timer(std::move(t)) {}
+    Timer timer;
+    uint32_t generation = 1;
+    bool in_use = false;
+    // Level * kSlots + slot, or kUnlinked
+    uint16_t slot = kUnlinked;
+    uint32_t prev = kNil;
+    uint32_t next = kNil;
+  };
+
+  uint64_t tick(Clock::time_point t) const {
+    return t > origin_ ? std::chrono::duration_cast<std::chrono::milliseconds>(t - origin_).count() : 0;
+  }
+
+  void link(uint32_t index) {
+    auto& entry = entries_[index];
+    // Timers that are already due go to the current slot
+    const auto expiry = std::max(tick(entry.timer.expires_at_), current_);
+    const auto distance = expiry - current_;
+    size_t level = 0;
+    while (level < kLevels && (distance >> (kSlotBits * (level + 1))) != 0) {
+      ++level;
+    }
+    size_t slot = 0;
+    if (level == kLevels) {
+      level = kLevels - 1;
+      slot = ((current_ >> (kSlotBits * level)) - 1) & kSlotMask;
+    } else {
+      slot = (expiry >> (kSlotBits * level)) & kSlotMask;
+    }
+
+    auto& head = slots_[level][slot];
+    entry.slot = static_cast<uint16_t>(level * kSlots + slot);
+    entry.prev = kNil;
+    entry.next = head;
+    if (head != kNil) {
+      entries_[head].prev = index;
+    }
+    head = index;
+    occupied_[level][slot / 64] |= uint64_t{1} << (slot % 64);
+    ++linked_;
+    earliest_ = std::min(earliest_, entry.timer.expires_at_);
+  }
+
+  void unlink(uint32_t index) {
+    auto& entry = entries_[index];
+    if (entry.slot == kUnlinked) {
+      return;
+    }
+    const size_t level = entry.slot / kSlots;
+    const size_t slot = entry.slot % kSlots;
+    if (entry.prev != kNil) {
+      entries_[entry.prev].next = entry.next;
+    } else {
+      slots_[level][slot] = entry.next;
+    }
+    if (entry.next != kNil) {
+      entries_[entry.next].prev = entry.prev;
+    }
+    if (slots_[level][slot] == kNil) {
+      occupied_[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+    }
+    entry.slot = kUnlinked;
+    --linked_;
+  }
+
+  // Move the timers of the higher level slots the current tick entered into the lower levels
+  void cascade() {
+    for (size_t level = 1; level < kLevels; ++level) {
+      const auto slot = (current_ >> (kSlotBits * level)) & kSlotMask;
+      auto index = std::exchange(slots_[level][slot], kNil);
+      occupied_[level][slot / 64] &= ~(uint64_t{1} << (slot % 64));
+      while (index != kNil) {
+        const auto next = entries_[index].next;
+        entries_[index].slot = kUnlinked;
+        --linked_;
+        link(index);
+        index = next;
+      }
+      if (slot != 0) {
+        break;
+      }
+    }
+  }
+
+  // The first occupied slot of the level in [first, last), or kSlots
+  size_t findSlot(size_t level, size_t first, size_t last) const {
+    for (auto slot = first; slot < last; slot = (slot / 64 + 1) * 64) {
+      const auto bits = occupied_[level][slot / 64] >> (slot % 64);
+      if (bits != 0) {
+        const auto found = slot + __builtin_ctzll(bits);
+        return found < last ? found : kSlots;
+      }
+    }
+    return kSlots;
+  }
+
+  // The first tick after the current one at which a slot has to be collected or cascaded
+  uint64_t nextEventTick() const {
+    // The timers of the higher levels are cascaded at the end of the block at the earliest
+    const auto current_slot = current_ & kSlotMask;
+    if (auto slot = findSlot(0, current_slot + 1, kSlots); slot != kSlots) {
+      return current_ - current_slot + slot;
+    }
+    auto next = UINT64_MAX;
+    for (size_t level = 0; level < kLevels; ++level) {
+      const auto shift = kSlotBits * level;
+      const auto current_slot = (current_ >> shift) & kSlotMask;
+      const auto block = current_ >> (shift + kSlotBits);
+      // The slots up to the current one belong to the next block; the current slot of level 0 holds only the current
+      // tick, the ones of the higher levels were cascaded already
+      auto slot = findSlot(level, current_slot + 1, kSlots);
+      if (slot != kSlots) {
+        next = std::min(next, ((block << kSlotBits) | slot) << shift);
+      } else if ((slot = findSlot(level, 0, level == 0 ? current_slot : current_slot + 1)) != kSlots) {
+        next = std::min(next, (((block + 1) << kSlotBits) | slot) << shift);
+      }
+    }
+    return next;
+  }
+
+  // No timer expires before this tick
+  uint64_t firstOccupiedTick() const {
+    return slots_[0][current_ & kSlotMask] != kNil ? current_ : nextEventTick();
+  }
+
+  const Clock::time_point origin_;
+  // The timers expiring before this tick have been collected
+  uint64_t current_ = 0;
+  // No timer expires before this time
+  Clock::time_point earliest_ = Clock::time_point::max();
+  std::vector<Entry> entries_;
+  std::vector<uint32_t> free_;
+  size_t linked_ = 0;
+  std::array<std::array<uint32_t, kSlots>, kLevels> slots_;
+  std::array<std::array<uint64_t, kSlots / 64>, kLevels> occupied_{};
+};
+
+// A collection of timers. Callbacks run from evaluate() and may add, reset and cancel timers, including their own.
+template <typename Queue>
+class BasicTimers : public TimersBase {
+ public:
+  BasicTimers() = default;
+  BasicTimers(const BasicTimers& timers) = delete;
+  BasicTimers& operator=(const BasicTimers& timers) = delete;
+  BasicTimers(BasicTimers&& timers) = delete;
+  BasicTimers&& operator=(BasicTimers&& timers) = delete;
 
   Handle add(std::chrono::milliseconds d, Timer::Type t, const std::function<void(Handle)>& cb) {
     return add(d, t, cb, std::chrono::steady_clock::now());
@@ -96,29 +396,22 @@ class Timers {
              const std::function<void(Handle)>& cb,
              std::chrono::steady_clock::time_point now) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    timers_.emplace_back(Timer(d, t, cb, now));
-    id_counter_ += 1;
-    Handle h{id_counter_};
-    timers_.back().id_ = h.id_;
-    return h;
+    return Handle{queue_.add(Timer(d, t, cb, now))};
   }
 
   void reset(const Handle& handle, std::chrono::milliseconds d) { reset(handle, d, std::chrono::steady_clock::now()); }
 
   void reset(const Handle& handle, std::chrono::milliseconds d, std::chrono::steady_clock::time_point now) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    auto it = find(handle);
-    if (it != timers_.end()) {
-      it->reset(now, d);
+    if (auto timer = queue_.find(handle.id_)) {
+      timer->reset(now, d);
+      queue_.rescheduled(handle.id_);
     }
   }
 
   void cancel(const Handle& handle) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    auto it = find(handle);
-    if (it != timers_.end()) {
-      timers_.erase(it);
-    }
+    queue_.erase(handle.id_);
   }
 
   // Run the callbacks for all expired timers, and reschedule them if they are recurring.
@@ -126,35 +419,37 @@ class Timers {
 
   void evaluate(std::chrono::steady_clock::time_point now) {
     std::unique_lock<std::recursive_mutex> mlock(lock_);
-    if (timers_.empty()) return;
-
-    // Expired ids must be stored separately since erasing causes iterator invalidation.
-    std::vector<Handle> to_cancel;
-    for (auto& timer : timers_) {
-      if (timer.expired(now)) {
-        timer.run_callback(Handle(timer.id_));
-        if (timer.recurring()) {
-          timer.reset(now);
-        } else {
-          to_cancel.push_back(Handle(timer.id_));
-        }
+    std::vector<uint64_t> expired;
+    queue_.expired(now, expired);
+    for (auto id : expired) {
+      auto timer = queue_.find(id);
+      // An earlier callback may have cancelled or reset the timer
+      if (!timer) continue;
+      if (!timer->expired(now)) {
+        queue_.rescheduled(id);
+        continue;
       }
-    }
 
-    for (auto& handle : to_cancel) {
-      cancel(handle);
+      // The callback runs from a local since it may cancel its timer or add timers, which may move the timer
+      auto callback = std::move(timer->callback_);
+      callback(Handle(id));
+      timer = queue_.find(id);
+      if (!timer) continue;
+      timer->callback_ = std::move(callback);
+      if (timer->recurring()) {
+        timer->reset(now);
+        queue_.rescheduled(id);
+      } else {
+        queue_.erase(id);
+      }
     }
   }
 
  private:
-  std::vector<Timer>::iterator find(const Handle& handle) {
-    std::unique_lock<std::recursive_mutex> mlock(lock_);
-    return std::find_if(timers_.begin(), timers_.end(), [&handle](const Timer& t) { return t.id_ == handle.id_; });
-  }
-
   std::recursive_mutex lock_;
-  std::vector<Timer> timers_;
-  uint64_t id_counter_;
+  Queue queue_;
 };
 
+using Timers = BasicTimers<TimingWheel>;
+
 }  // namespace concordUtil
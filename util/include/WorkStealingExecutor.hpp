@@ -0,0 +1,233 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "assertUtils.hpp"
+#include "MpmcBoundedQueue.hpp"
+#include "SimpleThreadPool.hpp"
+
+namespace concord::util {
+
+// An executor of fire-and-forget tasks on a fixed set of worker threads.
+//
+// Every worker has its own deque. Tasks submitted from a worker go to the bottom of its deque, and the worker pops
+// them from there, so tasks spawned by a task run while its data is still in the cache. Tasks submitted from other
+// threads go to a lock-free injection queue shared by the workers. A worker out of tasks steals from the top of the
+// deques of the others, so no single lock is taken on either submission or dequeue. Idle workers spin briefly and
+// then sleep until a task is submitted.
+class WorkStealingExecutor {
+ public:
+  WorkStealingExecutor();
+  // Starts the executor right away
+  explicit WorkStealingExecutor(size_t num_of_threads, bool pin_threads = false);
+  // Stops the executor and discards the remaining tasks
+  ~WorkStealingExecutor();
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  /**
+   * starts the executor with the desired number of threads
+   * @param pin_threads - whether to pin worker i to CPU i modulo the number of CPUs
+   */
+  void start(size_t num_of_threads, bool pin_threads = false);
+  /**
+   * stops the executor, tasks executing when it is called run to completion
+   * @param executeAllTasks - whether to execute the remaining tasks on the calling thread, otherwise they are discarded
+   */
+  void stop(bool executeAllTasks = false);
+  /**
+   * submit a callable for execution. It's moved into the executor and destroyed without being called if the executor
+   * is stopped or discards it. Tasks must not throw.
+   * @return whether the task was accepted
+   */
+  template <class F>
+  bool submit(F&& func) {
+    return schedule(new CallableTask<std::decay_t<F>>(std::forward<F>(func)));
+  }
+  size_t getNumOfThreads() const { return workers_.size(); }
+  /**
+   * get the approximate number of tasks waiting for execution
+   */
+  size_t getNumOfTasks() const;
+
+ private:
+  class Task {
+   public:
+    virtual ~Task() = default;
+    virtual void run() = 0;
+  };
+
+  template <class F>
+  class CallableTask : public Task {
+   public:
+    explicit CallableTask(F&& func) : func_(std::move(func)) {}
+    explicit CallableTask(const F& func) : func_(func) {}
+    void run() override { func_(); }
+
+   private:
+    F func_;
+  };
+
+  // A Chase-Lev deque. Only the owning worker pushes and pops at the bottom, other workers steal from the top.
+  class WorkDeque {
+   public:
+    WorkDeque();
+    ~WorkDeque();
+    void push(Task* task);
+    Task* pop();
+    Task* steal();
+    size_t size() const;
+
+   private:
+    struct Array {
+      explicit Array(int64_t capacity) : capacity(capacity), slots(new std::atomic<Task*>[capacity]) {}
+      Task* get(int64_t i) const { return slots[i & (capacity - 1)].load(std::memory_order_relaxed); }
+      void put(int64_t i, Task* task) { slots[i & (capacity - 1)].store(task, std::memory_order_relaxed); }
+      const int64_t capacity;
+      std::unique_ptr<std::atomic<Task*>[]> slots;
+    };
+
+    alignas(64) std::atomic<int64_t> top_{0};
+    alignas(64) std::atomic<int64_t> bottom_{0};
+    std::atomic<Array*> array_;
+    // Thieves may still read an array after the owner grew the deque, so arrays live as long as the deque
+    std::vector<std::unique_ptr<Array>> arrays_;
+  };
+
+  struct Worker {
+    WorkDeque deque;
+    std::thread thread;
+  };
+
+  bool schedule(Task* task);
+  void loop(size_t index);
+  Task* findTask(size_t index);
+  bool hasTasks() const;
+  void execute(Task* task);
+  void wakeOne();
+  void discardAll(bool execute);
+
+  static constexpr size_t kInjectionQueueCapacity = 8192;
+
+  MpmcBoundedQueue<Task*> injection_queue_{kInjectionQueueCapacity};
+  // Takes the tasks submitted while the injection queue is full
+  std::deque<Task*> overflow_;
+  std::mutex overflow_lock_;
+  std::atomic_size_t overflow_size_{0};
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic_bool stopped_{true};
+
+  // Idle workers sleep on the condition variable. Submitters only take the lock if a worker sleeps.
+  std::mutex park_lock_;
+  std::condition_variable park_cond_;
+  std::atomic_size_t sleepers_{0};
+};
+
+// Exposes the interface of SimpleThreadPool on top of a WorkStealingExecutor.
+//
+// Unlike SimpleThreadPool, jobs added while the pool is stopped are released.
+class WorkStealingSimpleThreadPool {
+ public:
+  using Job = SimpleThreadPool::Job;
+
+  /**
+   * starts the thread pool with desired number of threads
+   */
+  void start(uint8_t num_of_threads = 1, bool pin_threads = false) { executor_.start(num_of_threads, pin_threads); }
+  /**
+   * stops the thread pool
+   * @param executeAllJobs - whether to execute remaining jobs
+   */
+  void stop(bool executeAllJobs = false) { executor_.stop(executeAllJobs); }
+  /**
+   * add a job for execution
+   * @param j - subclass of Job for execution
+   */
+  void add(Job* j) { executor_.submit(JobTask{j}); }
+  /**
+   * get the number of currently allocated threads in pool
+   */
+  size_t getNumOfThreads() const { return executor_.getNumOfThreads(); }
+  /**
+   * get the approximate number of jobs in queue
+   */
+  size_t getNumOfJobs() const { return executor_.getNumOfTasks(); }
+
+ private:
+  // Releases the job after executing it, or when it's discarded
+  class JobTask {
+   public:
+    explicit JobTask(Job* job) : job_(job) {}
+    JobTask(JobTask&& other) : job_(std::exchange(other.job_, nullptr)) {}
+    JobTask(const JobTask&) = delete;
+    ~JobTask() {
+      if (job_) job_->release();
+    }
+    void operator()() {
+      job_->execute();
+      std::exchange(job_, nullptr)->release();
+    }
+
+   private:
+    Job* job_;
+  };
+
+  WorkStealingExecutor executor_;
+};
+
+// Exposes the interface of ThreadPool on top of a WorkStealingExecutor.
+class WorkStealingThreadPool {
+ public:
+  // Starts the thread pool with thread_count > 0 threads.
+  explicit WorkStealingThreadPool(unsigned int thread_count, bool pin_threads = false) noexcept {
+    ConcordAssert(thread_count > 0);
+    executor_.start(thread_count, pin_threads);
+  }
+
+  // Starts the thread pool with the maximum number of concurrent threads supported by the implementation.
+  WorkStealingThreadPool() noexcept
+      : WorkStealingThreadPool{std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1} {}
+
+  // Stops the thread pool. Waits for the currently executing tasks only, the futures of the others are broken.
+  ~WorkStealingThreadPool() noexcept { executor_.stop(); }
+
+  // Same as ThreadPool::async().
+  template <class F, class... Args>
+  auto async(F&& func, Args&&... args) {
+    using ResultType = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+    auto ptask = std::packaged_task<ResultType(std::decay_t<Args>...)>{std::forward<F>(func)};
+    auto future = ptask.get_future();
+    executor_.submit([ptask = std::move(ptask), tup = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+      std::apply(ptask, std::move(tup));
+    });
+    return future;
+  }
+
+ private:
+  WorkStealingExecutor executor_;
+};
+
+}  // namespace concord::util
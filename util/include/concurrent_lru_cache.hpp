@@ -0,0 +1,294 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the
+// "License").  You may not use this product except in compliance with the
+// Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "assertUtils.hpp"
+#include "Metrics.hpp"
+
+namespace concord::util {
+
+// The number of bytes an entry is charged, in addition to the bookkeeping of the cache.
+template <typename Key, typename Value>
+struct DefaultCacheCharge {
+  size_t operator()(const Key&, const Value&) const { return sizeof(Key) + sizeof(Value); }
+};
+
+// A thread safe cache, bounded by the number of bytes of its entries, evicting approximately the least recently used.
+//
+// Keys are spread over shards, each with its own lock. A shard evicts with the CLOCK policy: a hit only marks the
+// entry as referenced, and the hand sweeping the entries on eviction skips over and clears the marked ones. Unlike
+// LruCache, a hit therefore doesn't reorder anything and only takes the lock of its shard in shared mode, so readers
+// never wait for each other.
+//
+// Every shard reports its hits and misses as metrics of the component with the given name. The cache also reports its
+// puts, evictions and size in bytes.
+template <typename Key,
+          typename Value,
+          typename Charge = DefaultCacheCharge<Key, Value>,
+          typename Hash = std::hash<Key>>
+class ConcurrentLruCache {
+ public:
+  // The number of shards is rounded up to a power of two, every shard gets an equal part of the capacity.
+  ConcurrentLruCache(size_t capacity_bytes,
+                     size_t num_shards = 16,
+                     const std::string& metrics_name = "concurrent_lru_cache",
+                     Charge charge = Charge{},
+                     Hash hash = Hash{})
+      : capacity_bytes_(capacity_bytes),
+        charge_(std::move(charge)),
+        hash_(hash),
+        shards_(roundUpToPowerOfTwo(num_shards)),
+        shard_capacity_bytes_(capacity_bytes / shards_.size()),
+        metrics_(metrics_name, std::make_shared<concordMetrics::Aggregator>()),
+        puts_(metrics_.RegisterShardedCounter("puts")),
+        evictions_(metrics_.RegisterShardedCounter("evictions")),
+        bytes_(metrics_.RegisterShardedGauge("bytes", 0)) {
+    for (size_t i = 0; i < shards_.size(); ++i) {
+      shards_[i].index = Index(0, hash_);
+      shards_[i].hits.emplace(metrics_.RegisterShardedCounter("hits_shard_" + std::to_string(i)));
+      shards_[i].misses.emplace(metrics_.RegisterShardedCounter("misses_shard_" + std::to_string(i)));
+    }
+    metrics_.Register();
+  }
+
+  ConcurrentLruCache(const ConcurrentLruCache&) = delete;
+  ConcurrentLruCache& operator=(const ConcurrentLruCache&) = delete;
+
+  // Entries charged more than the capacity of a shard are not cached.
+  template <typename K, typename V>
+  void put(K&& key, V&& value) {
+    puts_++;
+    auto& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.lock);
+    auto iter = shard.index.find(key);
+    const auto charge = chargeOf(key, value);
+    if (iter != shard.index.end()) {
+      if (charge > shard_capacity_bytes_) {
+        remove(shard, iter->second);
+        return;
+      }
+      auto& slot = shard.slots[iter->second];
+      release(shard, slot.charge);
+      evict(shard, charge, iter->second);
+      slot.value = std::forward<V>(value);
+      slot.charge = charge;
+      slot.referenced.store(true, std::memory_order_relaxed);
+      charge_bytes(shard, charge);
+      return;
+    }
+    if (charge > shard_capacity_bytes_) return;
+    evict(shard, charge, std::nullopt);
+    size_t slot_index = 0;
+    if (!shard.free_slots.empty()) {
+      slot_index = shard.free_slots.back();
+      shard.free_slots.pop_back();
+    } else {
+      slot_index = shard.slots.size();
+      shard.slots.emplace_back();
+    }
+    auto& slot = shard.slots[slot_index];
+    auto inserted = shard.index.emplace(std::forward<K>(key), slot_index).first;
+    slot.key = &inserted->first;
+    slot.value.emplace(std::forward<V>(value));
+    slot.charge = charge;
+    slot.referenced.store(false, std::memory_order_relaxed);
+    charge_bytes(shard, charge);
+  }
+
+  std::optional<Value> get(const Key& key) {
+    auto& shard = shardOf(key);
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    auto iter = shard.index.find(key);
+    if (iter == shard.index.end()) {
+      (*shard.misses)++;
+      return std::nullopt;
+    }
+    (*shard.hits)++;
+    auto& slot = shard.slots[iter->second];
+    // Don't write the cache line if the entry is marked already
+    if (!slot.referenced.load(std::memory_order_relaxed)) {
+      slot.referenced.store(true, std::memory_order_relaxed);
+    }
+    return slot.value;
+  }
+
+  bool erase(const Key& key) {
+    auto& shard = shardOf(key);
+    std::unique_lock<std::shared_mutex> lock(shard.lock);
+    auto iter = shard.index.find(key);
+    if (iter == shard.index.end()) return false;
+    remove(shard, iter->second);
+    return true;
+  }
+
+  size_t size() const {
+    size_t size = 0;
+    for (const auto& shard : shards_) {
+      std::shared_lock<std::shared_mutex> lock(shard.lock);
+      size += shard.index.size();
+    }
+    return size;
+  }
+
+  // The bytes charged for the cached entries, at most the capacity
+  size_t bytes() const {
+    size_t bytes = 0;
+    for (const auto& shard : shards_) {
+      std::shared_lock<std::shared_mutex> lock(shard.lock);
+      bytes += shard.bytes;
+    }
+    return bytes;
+  }
+
+  size_t capacity() const { return capacity_bytes_; }
+
+  size_t numShards() const { return shards_.size(); }
+
+  struct Stats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t puts = 0;
+    size_t evictions = 0;
+  };
+
+  Stats getStats() const {
+    Stats stats;
+    for (const auto& shard : shards_) {
+      stats.hits += shard.hits->Get().Get();
+      stats.misses += shard.misses->Get().Get();
+    }
+    stats.puts = puts_.Get().Get();
+    stats.evictions = evictions_.Get().Get();
+    return stats;
+  }
+
+  // Removes all entries, the stats are kept since the metrics are monotonic
+  void clear() {
+    for (auto& shard : shards_) {
+      std::unique_lock<std::shared_mutex> lock(shard.lock);
+      bytes_ -= shard.bytes;
+      shard.index.clear();
+      shard.slots.clear();
+      shard.free_slots.clear();
+      shard.hand = 0;
+      shard.bytes = 0;
+    }
+  }
+
+  void setAggregator(std::shared_ptr<concordMetrics::Aggregator> aggregator) { metrics_.SetAggregator(aggregator); }
+
+ private:
+  struct Slot {
+    // Points to the key in the index, null if the slot is free
+    const Key* key = nullptr;
+    std::optional<Value> value;
+    size_t charge = 0;
+    std::atomic_bool referenced{false};
+  };
+
+  using Index = std::unordered_map<Key, size_t, Hash>;
+
+  // The bookkeeping of an entry: its slot, and the node and bucket of the index
+  static constexpr size_t kEntryOverhead = sizeof(Slot) + sizeof(typename Index::value_type) + 3 * sizeof(void*);
+
+  struct alignas(64) Shard {
+    mutable std::shared_mutex lock;
+    Index index;
+    // A deque never moves its elements, so slots stay put as the shard grows
+    std::deque<Slot> slots;
+    std::vector<size_t> free_slots;
+    size_t hand = 0;
+    size_t bytes = 0;
+    std::optional<concordMetrics::ShardedCounterHandle> hits;
+    std::optional<concordMetrics::ShardedCounterHandle> misses;
+  };
+
+  Shard& shardOf(const Key& key) {
+    // Mix the hash, since std::hash of integers is the identity
+    const uint64_t h = static_cast<uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ULL;
+    return shards_[(h >> 32) & (shards_.size() - 1)];
+  }
+
+  static size_t roundUpToPowerOfTwo(size_t n) {
+    size_t power = 1;
+    while (power < n) power <<= 1;
+    return power;
+  }
+
+  template <typename V>
+  size_t chargeOf(const Key& key, const V& value) const {
+    return charge_(key, value) + kEntryOverhead;
+  }
+
+  void charge_bytes(Shard& shard, size_t charge) {
+    shard.bytes += charge;
+    bytes_ += charge;
+  }
+
+  void release(Shard& shard, size_t charge) {
+    shard.bytes -= charge;
+    bytes_ -= charge;
+  }
+
+  void remove(Shard& shard, size_t slot_index) {
+    auto& slot = shard.slots[slot_index];
+    release(shard, slot.charge);
+    shard.index.erase(*slot.key);
+    slot.key = nullptr;
+    slot.value.reset();
+    slot.charge = 0;
+    shard.free_slots.push_back(slot_index);
+  }
+
+  // Sweeps the hand until the shard has room for the given charge. Referenced entries get a second chance, and the
+  // given slot is never evicted.
+  void evict(Shard& shard, size_t charge, std::optional<size_t> keep) {
+    while (shard.bytes + charge > shard_capacity_bytes_ && shard.index.size() > (keep ? 1 : 0)) {
+      if (shard.hand >= shard.slots.size()) shard.hand = 0;
+      const auto slot_index = shard.hand++;
+      auto& slot = shard.slots[slot_index];
+      if (!slot.key || slot_index == keep) continue;
+      if (slot.referenced.load(std::memory_order_relaxed)) {
+        slot.referenced.store(false, std::memory_order_relaxed);
+        continue;
+      }
+      remove(shard, slot_index);
+      evictions_++;
+    }
+  }
+
+  const size_t capacity_bytes_;
+  const Charge charge_;
+  const Hash hash_;
+  std::vector<Shard> shards_;
+  const size_t shard_capacity_bytes_;
+
+  concordMetrics::Component metrics_;
+  concordMetrics::ShardedCounterHandle puts_;
+  concordMetrics::ShardedCounterHandle evictions_;
+  concordMetrics::ShardedGaugeHandle bytes_;
+};
+
+}  // namespace concord::util
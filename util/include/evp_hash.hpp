@@ -89,6 +89,16 @@ class EVPHash {
     ConcordAssert(EVP_DigestUpdate(ctx_, buf, size) == 1);
   }
 
+  // Copy a digest that is being computed piecemeal, so that the copy can be
+  // continued and finished independently of the original.
+  EVPHash clone() const noexcept {
+    ConcordAssert(updating_);
+    EVPHash copy;
+    ConcordAssert(EVP_MD_CTX_copy_ex(copy.ctx_, ctx_) == 1);
+    copy.updating_ = true;
+    return copy;
+  }
+
   Digest finish() noexcept {
     Digest digest;
     unsigned int _digest_len;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include <assertUtils.hpp>
+#include "ThreadPlacement.hpp"
 
 #include <condition_variable>
 #include <future>
@@ -40,6 +41,17 @@ class ThreadPool {
     }
   }
 
+  // Starts the thread pool with thread_count > 0 threads, placed according to the policy of the role.
+  ThreadPool(unsigned int thread_count, ThreadPlacement::Role role) noexcept {
+    ConcordAssert(thread_count > 0);
+    for (auto i = 0u; i < thread_count; ++i) {
+      threads_.emplace_back([this, role]() {
+        ThreadPlacement::instance().place(role);
+        loop();
+      });
+    }
+  }
+
   // Starts the thread pool with the maximum number of concurrent threads supported by the implementation.
   ThreadPool() noexcept
       : ThreadPool{std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1} {}
@@ -20,12 +20,123 @@ from bft_config import Replica
 REQUEST_TYPE = 0
 REPLY_TYPE = 1
 ERROR_TYPE = 2
+BINARY_REQUEST_TYPE = 3
+BINARY_REPLY_TYPE = 4
+SUBSCRIBE_TYPE = 5
 
 HEADER_FMT = "<BQ"
 HEADER_SIZE = struct.calcsize(HEADER_FMT)
+BINARY_REQUEST_FMT = "<BQQ"
+SUBSCRIBE_FMT = "<BQI"
 
 MAX_MSG_SIZE = 64*1024; # 64k
 
+# Subscriptions expire after 60 seconds on the server unless renewed
+SUBSCRIPTION_RENEWAL_SEC = 30
+
+FULL_SNAPSHOT = 0
+DELTA_SNAPSHOT = 1
+
+COUNTER = 0
+GAUGE = 1
+STATUS = 2
+
+class SnapshotDecoder:
+    """
+    Rebuild the metrics from the binary snapshots sent by the metrics server.
+    See util/include/MetricsSnapshotCodec.hpp for the format.
+    """
+    def __init__(self):
+        self.snapshot_id = 0
+        # [component, name, type, value] in the order of the snapshots
+        self.metrics = []
+
+    def apply(self, data):
+        """
+        Apply an encoded snapshot. Return False, leaving the decoder
+        unchanged, for a delta against another snapshot than the last one
+        applied. Raise ValueError if the data is malformed.
+        """
+        reader = _Reader(data)
+        kind = reader.byte()
+        snapshot_id = reader.varint()
+        if kind == FULL_SNAPSHOT:
+            strings = [reader.string() for _ in range(reader.varint())]
+            layout = []
+            for _ in range(reader.varint()):
+                component, name, metric_type = reader.varint(), reader.varint(), reader.byte()
+                if max(component, name) >= len(strings) or metric_type > STATUS:
+                    raise ValueError("Invalid metric in metrics snapshot")
+                layout.append((strings[component], strings[name], metric_type))
+            metrics = [[component, name, metric_type,
+                        reader.string() if metric_type == STATUS else reader.varint()]
+                       for component, name, metric_type in layout]
+        elif kind == DELTA_SNAPSHOT:
+            if reader.varint() != self.snapshot_id or self.snapshot_id == 0:
+                return False
+            metrics = [list(metric) for metric in self.metrics]
+            index = 0
+            for _ in range(reader.varint()):
+                index += reader.varint()
+                if index >= len(metrics):
+                    raise ValueError("Invalid metric index in metrics snapshot")
+                metric = metrics[index]
+                if metric[2] == STATUS:
+                    metric[3] = reader.string()
+                else:
+                    metric[3] = (metric[3] + _unzigzag(reader.varint())) % 2**64
+        else:
+            raise ValueError(f"Unknown metrics snapshot kind {kind}")
+        if not reader.done():
+            raise ValueError("Trailing bytes in metrics snapshot")
+        self.snapshot_id = snapshot_id
+        self.metrics = metrics
+        return True
+
+    def to_json(self):
+        """Return the metrics in the structure of the JSON replies"""
+        components = {}
+        for component, name, metric_type, value in self.metrics:
+            if component not in components:
+                components[component] = {'Name': component, 'Gauges': {},
+                                          'Statuses': {}, 'Counters': {}}
+            kind = ('Counters', 'Gauges', 'Statuses')[metric_type]
+            components[component][kind][name] = value
+        return {'Components': list(components.values())}
+
+class _Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def byte(self):
+        if self.pos >= len(self.data):
+            raise ValueError("Truncated metrics snapshot")
+        self.pos += 1
+        return self.data[self.pos - 1]
+
+    def varint(self):
+        value = 0
+        for shift in range(0, 64, 7):
+            byte = self.byte()
+            value |= (byte & 0x7f) << shift
+            if byte & 0x80 == 0:
+                return value
+        raise ValueError("Invalid varint in metrics snapshot")
+
+    def string(self):
+        size = self.varint()
+        if size > len(self.data) - self.pos:
+            raise ValueError("Truncated metrics snapshot")
+        self.pos += size
+        return bytes(self.data[self.pos - size:self.pos]).decode()
+
+    def done(self):
+        return self.pos == len(self.data)
+
+def _unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
 class MetricsClient:
     def __enter__(self):
         """context manager method for 'with' statements"""
@@ -38,6 +149,7 @@ class MetricsClient:
     def __init__(self, replica):
         self.seq_num = 0
         self.replica = replica
+        self.decoder = SnapshotDecoder()
         self.sock = trio.socket.socket(trio.socket.AF_INET,
                                        trio.socket.SOCK_DGRAM)
     def _req(self):
@@ -62,3 +174,61 @@ class MetricsClient:
             _, seq_num = struct.unpack(HEADER_FMT, reply[0:HEADER_SIZE])
             if seq_num == self.seq_num:
                 return json.loads(reply[HEADER_SIZE:])
+
+    async def get_binary(self):
+        """
+        Like get, but retrieve a binary snapshot, which is a delta against the
+        previous one retrieved by this client if the server still has it.
+        """
+        self.seq_num += 1
+        req = struct.pack(BINARY_REQUEST_FMT, BINARY_REQUEST_TYPE,
+                          self.seq_num, self.decoder.snapshot_id)
+        destination = (self.replica.ip, self.replica.metrics_port)
+        await self.sock.sendto(req, destination)
+        while True:
+            reply, _ = await self.sock.recvfrom(MAX_MSG_SIZE)
+            reply_type, seq_num = struct.unpack(HEADER_FMT, reply[0:HEADER_SIZE])
+            if seq_num == self.seq_num:
+                assert BINARY_REPLY_TYPE == reply_type
+                assert self.decoder.apply(reply[HEADER_SIZE:])
+                return self.decoder.to_json()
+
+    async def subscribe(self, interval_ms):
+        """
+        Subscribe to the metrics of the server, and yield them every time it
+        pushes a snapshot, about every interval_ms. The subscription is
+        renewed while iterating, and cancelled once the generator is closed.
+
+        A client shouldn't retrieve metrics while subscribed.
+        """
+        self.seq_num += 1
+        seq_num = self.seq_num
+        destination = (self.replica.ip, self.replica.metrics_port)
+        decoder = SnapshotDecoder()
+        try:
+            renewed = None
+            while True:
+                if renewed is None or trio.current_time() - renewed > SUBSCRIPTION_RENEWAL_SEC:
+                    req = struct.pack(SUBSCRIBE_FMT, SUBSCRIBE_TYPE, seq_num, interval_ms)
+                    await self.sock.sendto(req, destination)
+                    renewed = trio.current_time()
+                reply = None
+                with trio.move_on_after(interval_ms / 1000 + 0.1):
+                    reply, _ = await self.sock.recvfrom(MAX_MSG_SIZE)
+                if reply is None:
+                    # The server may not be up yet, or may have restarted
+                    renewed = None
+                    continue
+                reply_type, reply_seq_num = struct.unpack(HEADER_FMT, reply[0:HEADER_SIZE])
+                if reply_type == ERROR_TYPE:
+                    raise RuntimeError("The metrics server rejected or cancelled the subscription")
+                # Deltas against a lost snapshot are skipped until the next full one
+                if (reply_type == BINARY_REPLY_TYPE and reply_seq_num == seq_num
+                        and decoder.apply(reply[HEADER_SIZE:])):
+                    yield decoder.to_json()
+        finally:
+            # The subscription just expires if the client was closed first
+            if self.sock.fileno() != -1:
+                with trio.CancelScope(shield=True):
+                    req = struct.pack(SUBSCRIBE_FMT, SUBSCRIBE_TYPE, seq_num, 0)
+                    await self.sock.sendto(req, destination)
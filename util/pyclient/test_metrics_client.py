@@ -18,7 +18,7 @@ import os.path
 import trio
 
 from bft_config import Replica
-from bft_metrics_client import MetricsClient
+from bft_metrics_client import MetricsClient, SnapshotDecoder, FULL_SNAPSHOT, DELTA_SNAPSHOT, COUNTER, STATUS
 
 TIMEOUT_MILLI = 5000
 CHECK_MILLI = 100
@@ -52,5 +52,58 @@ class MetricsClientTest(unittest.TestCase):
                         self.assertEqual([], metrics['Components'])
                         return
 
+    def testGetBinary(self):
+        trio.run(self._testGetBinary)
+
+    async def _testGetBinary(self):
+        with MetricsClient(self.replica) as client:
+            with trio.fail_after(TIMEOUT_MILLI/1000):
+                while True:
+                    with trio.move_on_after(CHECK_MILLI/1000):
+                        metrics = await client.get_binary()
+                        break
+                self.assertEqual([], metrics['Components'])
+                # Later snapshots are deltas against the previous one
+                first_id = client.decoder.snapshot_id
+                metrics = await client.get_binary()
+                self.assertEqual([], metrics['Components'])
+                self.assertEqual(first_id + 1, client.decoder.snapshot_id)
+
+    def testSubscribe(self):
+        trio.run(self._testSubscribe)
+
+    async def _testSubscribe(self):
+        with MetricsClient(self.replica) as client:
+            with trio.fail_after(TIMEOUT_MILLI/1000):
+                pushes = 0
+                subscription = client.subscribe(interval_ms=100)
+                async for metrics in subscription:
+                    self.assertEqual([], metrics['Components'])
+                    pushes += 1
+                    if pushes == 20:
+                        break
+                await subscription.aclose()
+
+    def testSnapshotDecoder(self):
+        full = bytes([FULL_SNAPSHOT, 1,
+                      3, 7]) + b"replica" + bytes([4]) + b"sent" + bytes([5]) + b"state" + bytes([
+                      2, 0, 1, COUNTER, 0, 2, STATUS,
+                      0x80, 0x01, 7]) + b"primary"
+        decoder = SnapshotDecoder()
+        self.assertTrue(decoder.apply(full))
+        self.assertEqual({'Components': [{'Name': 'replica', 'Gauges': {},
+                                          'Statuses': {'state': 'primary'},
+                                          'Counters': {'sent': 128}}]},
+                         decoder.to_json())
+        # The counter goes down by one and the status changes
+        delta = bytes([DELTA_SNAPSHOT, 2, 1, 2, 0, 1, 1, 6]) + b"backup"
+        self.assertFalse(decoder.apply(bytes([DELTA_SNAPSHOT, 3, 2, 0])))
+        self.assertTrue(decoder.apply(delta))
+        self.assertEqual(2, decoder.snapshot_id)
+        self.assertEqual({'sent': 127}, decoder.to_json()['Components'][0]['Counters'])
+        self.assertEqual({'state': 'backup'}, decoder.to_json()['Components'][0]['Statuses'])
+        with self.assertRaises(ValueError):
+            decoder.apply(full[:-1])
+
 if __name__ == '__main__':
     unittest.main()
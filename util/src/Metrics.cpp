@@ -79,39 +79,58 @@ Component::Handle<AtomicGauge> Component::RegisterAtomicGauge(const std::string&
   return Component::Handle<AtomicGauge>(values_.atomic_gauges_, values_.atomic_gauges_.size() - 1, metricsEnabled_);
 }
 
-std::list<Metric> Component::CollectGauges() {
+Component::ShardedHandle<ShardedCounter> Component::RegisterShardedCounter(const std::string& name,
+                                                                           const uint64_t val) {
+  names_.sharded_counter_names_.emplace_back(name);
+  values_.sharded_counters_.emplace_back(std::make_shared<ShardedCounter>(val));
+  return Component::ShardedHandle<ShardedCounter>(values_.sharded_counters_.back(), metricsEnabled_);
+}
+
+Component::ShardedHandle<ShardedGauge> Component::RegisterShardedGauge(const std::string& name, const uint64_t val) {
+  names_.sharded_gauge_names_.emplace_back(name);
+  values_.sharded_gauges_.emplace_back(std::make_shared<ShardedGauge>(val));
+  return Component::ShardedHandle<ShardedGauge>(values_.sharded_gauges_.back(), metricsEnabled_);
+}
+
+std::list<Metric> Component::CollectGauges(const Values& values) const {
   if (!metricsEnabled_) return list<Metric>();
   std::list<Metric> ret;
   for (size_t i = 0; i < names_.gauge_names_.size(); i++) {
     if (tags_.gauge_tags_.size() > i) {
-      ret.emplace_back(Metric{name_, names_.gauge_names_[i], values_.gauges_[i], tags_.gauge_tags_[i]});
+      ret.emplace_back(Metric{name_, names_.gauge_names_[i], values.gauges_[i], tags_.gauge_tags_[i]});
     } else {
-      ret.emplace_back(Metric{name_, names_.gauge_names_[i], values_.gauges_[i]});
+      ret.emplace_back(Metric{name_, names_.gauge_names_[i], values.gauges_[i]});
     }
   }
   for (std::size_t i = 0; i < names_.atomic_gauge_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.atomic_gauge_names_[i], Gauge(values_.atomic_gauges_[i].Get())});
+    ret.emplace_back(Metric{name_, names_.atomic_gauge_names_[i], Gauge(values.atomic_gauges_[i].Get())});
+  }
+  for (std::size_t i = 0; i < names_.sharded_gauge_names_.size(); i++) {
+    ret.emplace_back(Metric{name_, names_.sharded_gauge_names_[i], Gauge(values.sharded_gauges_[i]->Get())});
   }
   return ret;
 }
 
-std::list<Metric> Component::CollectCounters() {
+std::list<Metric> Component::CollectCounters(const Values& values) const {
   if (!metricsEnabled_) return list<Metric>();
   std::list<Metric> ret;
   for (size_t i = 0; i < names_.counter_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.counter_names_[i], values_.counters_[i]});
+    ret.emplace_back(Metric{name_, names_.counter_names_[i], values.counters_[i]});
   }
   for (std::size_t i = 0; i < names_.atomic_counter_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.atomic_counter_names_[i], Counter(values_.atomic_counters_[i].Get())});
+    ret.emplace_back(Metric{name_, names_.atomic_counter_names_[i], Counter(values.atomic_counters_[i].Get())});
+  }
+  for (std::size_t i = 0; i < names_.sharded_counter_names_.size(); i++) {
+    ret.emplace_back(Metric{name_, names_.sharded_counter_names_[i], Counter(values.sharded_counters_[i]->Get())});
   }
   return ret;
 }
 
-std::list<Metric> Component::CollectStatuses() {
+std::list<Metric> Component::CollectStatuses(const Values& values) const {
   if (!metricsEnabled_) return list<Metric>();
   std::list<Metric> ret;
   for (size_t i = 0; i < names_.status_names_.size(); i++) {
-    ret.emplace_back(Metric{name_, names_.status_names_[i], values_.statuses_[i]});
+    ret.emplace_back(Metric{name_, names_.status_names_[i], values.statuses_[i]});
   }
   return ret;
 }
@@ -123,7 +142,7 @@ void Component::UpdateAggregator() {
 }
 
 // Generate a JSON string of the component. To save space we don't add any newline characters.
-std::string Component::ToJson() {
+std::string Component::ToJson(const Values& values) const {
   if (!metricsEnabled_) return "";
   ostringstream oss;
 
@@ -137,7 +156,14 @@ std::string Component::ToJson() {
     if (i != 0) {
       oss << ",";
     }
-    oss << "\"" << names_.gauge_names_[i] << "\":" << values_.gauges_[i].Get() << "";
+    oss << "\"" << names_.gauge_names_[i] << "\":" << values.gauges_[i].Get() << "";
+  }
+
+  for (size_t i = 0; i < names_.sharded_gauge_names_.size(); i++) {
+    if (i != 0 || names_.gauge_names_.size() > 0) {
+      oss << ",";
+    }
+    oss << "\"" << names_.sharded_gauge_names_[i] << "\":" << values.sharded_gauges_[i]->Get() << "";
   }
 
   // End gauges
@@ -151,7 +177,7 @@ std::string Component::ToJson() {
       oss << ",";
     }
     oss << "\"" << names_.status_names_[i] << "\":"
-        << "\"" << values_.statuses_[i].Get() << "\"";
+        << "\"" << values.statuses_[i].Get() << "\"";
   }
 
   // End status
@@ -164,14 +190,21 @@ std::string Component::ToJson() {
     if (i != 0) {
       oss << ",";
     }
-    oss << "\"" << names_.counter_names_[i] << "\":" << values_.counters_[i].Get() << "";
+    oss << "\"" << names_.counter_names_[i] << "\":" << values.counters_[i].Get() << "";
   }
 
   for (size_t i = 0; i < names_.atomic_counter_names_.size(); i++) {
     if (i != 0 || names_.counter_names_.size() > 0) {
       oss << ",";
     }
-    oss << "\"" << names_.atomic_counter_names_[i] << "\":" << values_.atomic_counters_[i].Get() << "";
+    oss << "\"" << names_.atomic_counter_names_[i] << "\":" << values.atomic_counters_[i].Get() << "";
+  }
+
+  for (size_t i = 0; i < names_.sharded_counter_names_.size(); i++) {
+    if (i != 0 || names_.counter_names_.size() + names_.atomic_counter_names_.size() > 0) {
+      oss << ",";
+    }
+    oss << "\"" << names_.sharded_counter_names_[i] << "\":" << values.sharded_counters_[i]->Get() << "";
   }
 
   // End counters
@@ -186,62 +219,69 @@ std::string Component::ToJson() {
 /******************************** Class Aggregator ********************************/
 
 void Aggregator::RegisterComponent(Component& component) {
-  std::lock_guard<std::mutex> lock(lock_);
-  components_.insert(make_pair(component.Name(), component));
+  auto values = std::make_shared<const Values>(component.values_);
+  std::unique_lock<std::shared_mutex> lock(lock_);
+  components_.insert(make_pair(component.Name(), PublishedComponent{component, std::move(values)}));
 }
 
 // Throws if the component doesn't exist.
 // This is only called from the component itself, so it will never actually throw.
 void Aggregator::UpdateValues(const string& name, Values&& values) {
   if (!metricsEnabled_) return;
-  std::lock_guard<std::mutex> lock(lock_);
-  try {
-    components_.at(name).SetValues(std::move(values));
-  } catch (const std::out_of_range& e) {
+  auto published = std::make_shared<const Values>(std::move(values));
+  std::shared_lock<std::shared_mutex> lock(lock_);
+  auto it = components_.find(name);
+  if (it == components_.end()) {
     throw std::out_of_range("components_.at() failed for name = " + name);
   }
+  std::atomic_store(&it->second.values, std::move(published));
 }
 
-Gauge Aggregator::GetGauge(const string& component_name, const string& val_name) {
-  std::lock_guard<std::mutex> lock(lock_);
-  try {
-    auto& component = components_.at(component_name);
-    auto& gauges = component.names_.gauge_names_;
-    if (std::find(gauges.begin(), gauges.end(), val_name) != gauges.end()) {
-      return FindValue(kGaugeName, val_name, component.names_.gauge_names_, component.values_.gauges_);
-    }
-    auto atomic_gauge =
-        FindValue(kCounterName, val_name, component.names_.atomic_gauge_names_, component.values_.atomic_gauges_);
-    return Gauge(atomic_gauge.Get());
-  } catch (const std::out_of_range& e) {
+const Aggregator::PublishedComponent& Aggregator::FindComponent(const string& component_name) const {
+  auto it = components_.find(component_name);
+  if (it == components_.end()) {
     throw std::out_of_range("components_.at() failed for component_name = " + component_name);
   }
+  return it->second;
 }
 
-Status Aggregator::GetStatus(const string& component_name, const string& val_name) {
-  std::lock_guard<std::mutex> lock(lock_);
-  try {
-    auto& component = components_.at(component_name);
-    return FindValue(kStatusName, val_name, component.names_.status_names_, component.values_.statuses_);
-  } catch (const std::out_of_range& e) {
-    throw std::out_of_range("components_.at() failed for component_name = " + component_name);
+Gauge Aggregator::GetGauge(const string& component_name, const string& val_name) {
+  std::shared_lock<std::shared_mutex> lock(lock_);
+  auto& published = FindComponent(component_name);
+  auto& names = published.component.names_;
+  auto values = std::atomic_load(&published.values);
+  if (std::find(names.gauge_names_.begin(), names.gauge_names_.end(), val_name) != names.gauge_names_.end()) {
+    return FindValue(kGaugeName, val_name, names.gauge_names_, values->gauges_);
   }
+  auto& sharded = names.sharded_gauge_names_;
+  if (std::find(sharded.begin(), sharded.end(), val_name) != sharded.end()) {
+    return Gauge(FindValue(kGaugeName, val_name, sharded, values->sharded_gauges_)->Get());
+  }
+  auto atomic_gauge = FindValue(kGaugeName, val_name, names.atomic_gauge_names_, values->atomic_gauges_);
+  return Gauge(atomic_gauge.Get());
+}
+
+Status Aggregator::GetStatus(const string& component_name, const string& val_name) {
+  std::shared_lock<std::shared_mutex> lock(lock_);
+  auto& published = FindComponent(component_name);
+  auto values = std::atomic_load(&published.values);
+  return FindValue(kStatusName, val_name, published.component.names_.status_names_, values->statuses_);
 }
 
 Counter Aggregator::GetCounter(const string& component_name, const string& val_name) {
-  std::lock_guard<std::mutex> lock(lock_);
-  try {
-    auto& component = components_.at(component_name);
-    auto& counters = component.names_.counter_names_;
-    if (std::find(counters.begin(), counters.end(), val_name) != counters.end()) {
-      return FindValue(kCounterName, val_name, component.names_.counter_names_, component.values_.counters_);
-    }
-    auto atomic_counter =
-        FindValue(kCounterName, val_name, component.names_.atomic_counter_names_, component.values_.atomic_counters_);
-    return Counter(atomic_counter.Get());
-  } catch (const std::out_of_range& e) {
-    throw std::out_of_range("components_.at() failed for component_name = " + component_name);
+  std::shared_lock<std::shared_mutex> lock(lock_);
+  auto& published = FindComponent(component_name);
+  auto& names = published.component.names_;
+  auto values = std::atomic_load(&published.values);
+  if (std::find(names.counter_names_.begin(), names.counter_names_.end(), val_name) != names.counter_names_.end()) {
+    return FindValue(kCounterName, val_name, names.counter_names_, values->counters_);
   }
+  auto& sharded = names.sharded_counter_names_;
+  if (std::find(sharded.begin(), sharded.end(), val_name) != sharded.end()) {
+    return Counter(FindValue(kCounterName, val_name, sharded, values->sharded_counters_)->Get());
+  }
+  auto atomic_counter = FindValue(kCounterName, val_name, names.atomic_counter_names_, values->atomic_counters_);
+  return Counter(atomic_counter.Get());
 }
 
 // Generate a JSON string of all aggregated components. To save space we don't
@@ -249,7 +289,7 @@ Counter Aggregator::GetCounter(const string& component_name, const string& val_n
 std::string Aggregator::ToJson() {
   if (!metricsEnabled_) return "";
   ostringstream oss;
-  std::lock_guard<std::mutex> lock(lock_);
+  std::shared_lock<std::shared_mutex> lock(lock_);
 
   // Add the object opening
   oss << "{\"Components\":[";
@@ -260,7 +300,7 @@ std::string Aggregator::ToJson() {
     if (it != components_.begin()) {
       oss << ",";
     }
-    oss << it->second.ToJson();
+    oss << it->second.component.ToJson(*std::atomic_load(&it->second.values));
   }
 
   // Add the object end
@@ -270,32 +310,44 @@ std::string Aggregator::ToJson() {
 }
 std::list<Metric> Aggregator::CollectGauges() {
   if (!metricsEnabled_) return std::list<Metric>();
-  std::lock_guard<std::mutex> lock(lock_);
+  std::shared_lock<std::shared_mutex> lock(lock_);
   std::list<Metric> ret;
   for (auto& comp : components_) {
-    const auto& gauges = comp.second.CollectGauges();
-    ret.insert(ret.end(), gauges.begin(), gauges.end());
+    ret.splice(ret.end(), comp.second.component.CollectGauges(*std::atomic_load(&comp.second.values)));
   }
   return ret;
 }
 std::list<Metric> Aggregator::CollectCounters() {
   if (!metricsEnabled_) return std::list<Metric>();
-  std::lock_guard<std::mutex> lock(lock_);
+  std::shared_lock<std::shared_mutex> lock(lock_);
   std::list<Metric> ret;
   for (auto& comp : components_) {
-    const auto& counters = comp.second.CollectCounters();
-    ret.insert(ret.end(), counters.begin(), counters.end());
+    ret.splice(ret.end(), comp.second.component.CollectCounters(*std::atomic_load(&comp.second.values)));
   }
   return ret;
 }
 
 std::list<Metric> Aggregator::CollectStatuses() {
   if (!metricsEnabled_) return std::list<Metric>();
-  std::lock_guard<std::mutex> lock(lock_);
+  std::shared_lock<std::shared_mutex> lock(lock_);
+  std::list<Metric> ret;
+  for (auto& comp : components_) {
+    ret.splice(ret.end(), comp.second.component.CollectStatuses(*std::atomic_load(&comp.second.values)));
+  }
+  return ret;
+}
+
+// Every component is read from a single published copy of its values, so the
+// values of a component are consistent with each other.
+std::list<Metric> Aggregator::Snapshot() {
+  if (!metricsEnabled_) return std::list<Metric>();
+  std::shared_lock<std::shared_mutex> lock(lock_);
   std::list<Metric> ret;
   for (auto& comp : components_) {
-    const auto& statuses = comp.second.CollectStatuses();
-    ret.insert(ret.end(), statuses.begin(), statuses.end());
+    const auto values = std::atomic_load(&comp.second.values);
+    ret.splice(ret.end(), comp.second.component.CollectGauges(*values));
+    ret.splice(ret.end(), comp.second.component.CollectCounters(*values));
+    ret.splice(ret.end(), comp.second.component.CollectStatuses(*values));
   }
   return ret;
 }
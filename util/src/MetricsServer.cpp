@@ -13,12 +13,16 @@
 
 #include <string.h>
 #include <unistd.h>
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <arpa/inet.h>
 
 #include "MetricsServer.hpp"
 #include "errnoString.hpp"
+#include "kvstream.h"
+
+using namespace std::chrono;
 
 namespace concordMetrics {
 
@@ -84,9 +88,11 @@ void Server::RecvLoop() {
     }
     running_lock_.unlock();
 
+    pushToSubscribers();
+    const auto wait = timeToNextPush();
     struct timeval timeout;
-    timeout.tv_sec = 1;
-    timeout.tv_usec = 0;
+    timeout.tv_sec = wait.count() / 1000000;
+    timeout.tv_usec = wait.count() % 1000000;
 
     if (setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout)) < 0) {
       LOG_ERROR(logger_, "Failed to set socket timeout!" << concordUtils::errnoString(errno));
@@ -103,6 +109,19 @@ void Server::RecvLoop() {
       continue;
     }
 
+    if (buf_[0] == kBinaryRequest && len == sizeof(BinaryRequest)) {
+      BinaryRequest request;
+      memcpy(&request, buf_, sizeof(request));
+      handleBinaryRequest(request, &cliaddr, addrlen);
+      continue;
+    }
+    if (buf_[0] == kSubscribe && len == sizeof(SubscribeRequest)) {
+      SubscribeRequest request;
+      memcpy(&request, buf_, sizeof(request));
+      handleSubscribe(request, &cliaddr, addrlen);
+      continue;
+    }
+
     if (buf_[0] != kRequest || len != sizeof(Header)) {
       LOG_WARN(logger_, "Received invalid request");
       sendError(&cliaddr, addrlen);
@@ -129,6 +148,104 @@ void Server::sendReply(std::string data, sockaddr_in* cliaddr, socklen_t addrlen
   }
 }
 
+void Server::handleBinaryRequest(const BinaryRequest& request, sockaddr_in* cliaddr, socklen_t addrlen) {
+  const auto id = encoder_.Take(*aggregator_);
+  if (!sendBinaryReply(request.header_.seq_num_, encoder_.Encode(id, request.base_snapshot_id_), cliaddr, addrlen)) {
+    sendError(cliaddr, addrlen);
+  }
+}
+
+void Server::handleSubscribe(const SubscribeRequest& request, sockaddr_in* cliaddr, socklen_t addrlen) {
+  if (!subscriptionConfig_.enabled) {
+    sendError(cliaddr, addrlen);
+    return;
+  }
+  auto it = std::find_if(subscriptions_.begin(), subscriptions_.end(), [cliaddr](const Subscription& s) {
+    return s.addr.sin_addr.s_addr == cliaddr->sin_addr.s_addr && s.addr.sin_port == cliaddr->sin_port;
+  });
+  if (request.interval_ms_ == 0) {
+    if (it != subscriptions_.end()) subscriptions_.erase(it);
+    return;
+  }
+  if (it == subscriptions_.end()) {
+    if (subscriptions_.size() >= subscriptionConfig_.max_subscriptions) {
+      LOG_WARN(logger_, "Too many metrics subscriptions, rejecting a new one");
+      sendError(cliaddr, addrlen);
+      return;
+    }
+    it = subscriptions_.emplace(subscriptions_.end());
+    it->addr = *cliaddr;
+    it->addrlen = addrlen;
+  }
+  // A renewal restarts the subscription with a full snapshot, in case the subscriber lost track
+  const auto now = steady_clock::now();
+  it->seq_num = request.header_.seq_num_;
+  it->interval = std::max(milliseconds(request.interval_ms_), subscriptionConfig_.min_interval);
+  it->next_push = now;
+  it->expiry = now + kSubscriptionLease;
+  it->last_snapshot_id = 0;
+  it->pushes = 0;
+  pushToSubscribers();
+}
+
+void Server::pushToSubscribers() {
+  const auto now = steady_clock::now();
+  subscriptions_.remove_if([now](const Subscription& s) { return s.expiry <= now; });
+  for (auto it = subscriptions_.begin(); it != subscriptions_.end();) {
+    auto& subscription = *it;
+    if (subscription.next_push > now) {
+      ++it;
+      continue;
+    }
+    const auto id = subscription.encoder.Take(*aggregator_);
+    const auto base = subscription.pushes % kFullSnapshotEvery == 0 ? 0 : subscription.last_snapshot_id;
+    const auto snapshot = subscription.encoder.Encode(id, base);
+    if (snapshot.size() > subscriptionConfig_.max_push_bytes) {
+      LOG_WARN(logger_,
+               "Metrics snapshot too large to be pushed, cancelling a subscription: "
+                   << KVLOG(snapshot.size(), subscriptionConfig_.max_push_bytes));
+      sendError(&subscription.addr, subscription.addrlen);
+      it = subscriptions_.erase(it);
+      continue;
+    }
+    if (!sendBinaryReply(subscription.seq_num, snapshot, &subscription.addr, subscription.addrlen)) {
+      it = subscriptions_.erase(it);
+      continue;
+    }
+    subscription.last_snapshot_id = id;
+    subscription.pushes++;
+    // Skip the pushes missed, rather than bursting them
+    subscription.next_push = std::max(subscription.next_push + subscription.interval, now);
+    ++it;
+  }
+}
+
+microseconds Server::timeToNextPush() const {
+  microseconds wait = seconds(1);
+  const auto now = steady_clock::now();
+  for (const auto& subscription : subscriptions_) {
+    wait = std::min(wait, duration_cast<microseconds>(subscription.next_push - now));
+  }
+  // A timeout of 0 would block forever
+  return std::max(wait, microseconds(1));
+}
+
+bool Server::sendBinaryReply(uint64_t seqNum, const std::string& data, const sockaddr_in* cliaddr, socklen_t addrlen) {
+  if (data.size() > MAX_MSG_SIZE - sizeof(Header)) {
+    LOG_ERROR(logger_, "Binary metrics snapshot too large to be transmitted: " << data.size() << " bytes");
+    return false;
+  }
+  Header header{kBinaryReply, seqNum};
+  memcpy(buf_, &header, sizeof(header));
+  memcpy(buf_ + sizeof(Header), data.data(), data.size());
+  auto len = sendto(sock_, buf_, data.size() + sizeof(Header), 0, (const struct sockaddr*)cliaddr, addrlen);
+  if (len < 0) {
+    LOG_ERROR(logger_, "Failed to send binary reply msg: " << concordUtils::errnoString(errno));
+    return false;
+  }
+  return true;
+}
+
 void Server::sendError(sockaddr_in* cliaddr, socklen_t addrlen) {
   const char* msg = "Invalid Request";
   auto msglen = strlen(msg);
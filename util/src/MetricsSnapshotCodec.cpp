@@ -0,0 +1,278 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "MetricsSnapshotCodec.hpp"
+
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace concordMetrics {
+
+namespace {
+
+void PutVarint(uint64_t value, string& out) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void PutString(const string& value, string& out) {
+  PutVarint(value.size(), out);
+  out.append(value);
+}
+
+// Counters and gauges may go down between snapshots, e.g. after a restart
+uint64_t ZigZag(uint64_t from, uint64_t to) {
+  const auto diff = static_cast<int64_t>(to - from);
+  return (static_cast<uint64_t>(diff) << 1) ^ static_cast<uint64_t>(diff >> 63);
+}
+
+uint64_t UnZigZag(uint64_t from, uint64_t zigzag) {
+  const auto diff = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+  return from + static_cast<uint64_t>(diff);
+}
+
+class Reader {
+ public:
+  explicit Reader(const string& data) : data_{data} {}
+
+  uint8_t Byte() {
+    if (pos_ >= data_.size()) throw invalid_argument("Truncated metrics snapshot");
+    return static_cast<uint8_t>(data_[pos_++]);
+  }
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      const auto byte = Byte();
+      value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    throw invalid_argument("Invalid varint in metrics snapshot");
+  }
+
+  // A count of items taking at least a byte each, bounded by the data left to avoid huge allocations
+  size_t Count() {
+    const auto count = Varint();
+    if (count > data_.size() - pos_) throw invalid_argument("Invalid count in metrics snapshot");
+    return count;
+  }
+
+  string String() {
+    const auto size = Count();
+    string value = data_.substr(pos_, size);
+    pos_ += size;
+    return value;
+  }
+
+  bool Done() const { return pos_ == data_.size(); }
+
+ private:
+  const string& data_;
+  size_t pos_ = 0;
+};
+
+MetricType TypeOf(const Metric& metric) {
+  if (holds_alternative<Counter>(metric.value)) return MetricType::Counter;
+  if (holds_alternative<Gauge>(metric.value)) return MetricType::Gauge;
+  return MetricType::Status;
+}
+
+}  // namespace
+
+uint64_t SnapshotEncoder::Take(Aggregator& aggregator) {
+  const auto metrics = aggregator.Snapshot();
+  auto layout = history_.empty() ? nullptr : history_.back().layout;
+  if (!layout || !SameLayout(*layout, metrics)) layout = MakeLayout(metrics);
+
+  Snapshot snapshot{++lastId_, layout, {}};
+  snapshot.values.reserve(metrics.size());
+  for (const auto& metric : metrics) {
+    switch (TypeOf(metric)) {
+      case MetricType::Counter:
+        snapshot.values.emplace_back(get<Counter>(metric.value).Get());
+        break;
+      case MetricType::Gauge:
+        snapshot.values.emplace_back(get<Gauge>(metric.value).Get());
+        break;
+      case MetricType::Status:
+        snapshot.values.emplace_back(get<Status>(metric.value).Get());
+        break;
+    }
+  }
+  history_.push_back(std::move(snapshot));
+  if (history_.size() > historySize_) history_.pop_front();
+  return lastId_;
+}
+
+string SnapshotEncoder::Encode(uint64_t id, uint64_t baseId) const {
+  const auto* snapshot = Find(id);
+  if (snapshot == nullptr) throw out_of_range("Metrics snapshot " + to_string(id) + " isn't kept anymore");
+  const auto* base = Find(baseId);
+  string out;
+  if (base != nullptr && base->layout == snapshot->layout) {
+    EncodeDelta(*snapshot, *base, out);
+  } else {
+    EncodeFull(*snapshot, out);
+  }
+  return out;
+}
+
+const SnapshotEncoder::Snapshot* SnapshotEncoder::Find(uint64_t id) const {
+  if (id == 0 || history_.empty() || id < history_.front().id || id > history_.back().id) return nullptr;
+  return &history_[id - history_.front().id];
+}
+
+bool SnapshotEncoder::SameLayout(const Layout& layout, const list<Metric>& metrics) {
+  if (layout.metrics.size() != metrics.size()) return false;
+  auto entry = layout.metrics.begin();
+  for (const auto& metric : metrics) {
+    if (entry->type != TypeOf(metric) || layout.strings[entry->name] != metric.name ||
+        layout.strings[entry->component] != metric.component) {
+      return false;
+    }
+    ++entry;
+  }
+  return true;
+}
+
+shared_ptr<const SnapshotEncoder::Layout> SnapshotEncoder::MakeLayout(const list<Metric>& metrics) {
+  auto layout = make_shared<Layout>();
+  unordered_map<string, uint32_t> indexes;
+  auto intern = [&layout, &indexes](const string& s) {
+    auto [it, inserted] = indexes.emplace(s, layout->strings.size());
+    if (inserted) layout->strings.push_back(s);
+    return it->second;
+  };
+  layout->metrics.reserve(metrics.size());
+  for (const auto& metric : metrics) {
+    layout->metrics.push_back(Layout::Entry{intern(metric.component), intern(metric.name), TypeOf(metric)});
+  }
+  return layout;
+}
+
+void SnapshotEncoder::EncodeFull(const Snapshot& snapshot, string& out) {
+  const auto& layout = *snapshot.layout;
+  out.push_back(static_cast<char>(kFullSnapshot));
+  PutVarint(snapshot.id, out);
+  PutVarint(layout.strings.size(), out);
+  for (const auto& s : layout.strings) {
+    PutString(s, out);
+  }
+  PutVarint(layout.metrics.size(), out);
+  for (const auto& entry : layout.metrics) {
+    PutVarint(entry.component, out);
+    PutVarint(entry.name, out);
+    out.push_back(static_cast<char>(entry.type));
+  }
+  for (const auto& value : snapshot.values) {
+    if (holds_alternative<uint64_t>(value)) {
+      PutVarint(get<uint64_t>(value), out);
+    } else {
+      PutString(get<string>(value), out);
+    }
+  }
+}
+
+void SnapshotEncoder::EncodeDelta(const Snapshot& snapshot, const Snapshot& base, string& out) {
+  string changes;
+  size_t numOfChanges = 0;
+  size_t previous = 0;
+  for (size_t i = 0; i < snapshot.values.size(); ++i) {
+    const auto& value = snapshot.values[i];
+    const auto& baseValue = base.values[i];
+    if (value == baseValue) continue;
+    PutVarint(i - previous, changes);
+    if (holds_alternative<uint64_t>(value)) {
+      PutVarint(ZigZag(get<uint64_t>(baseValue), get<uint64_t>(value)), changes);
+    } else {
+      PutString(get<string>(value), changes);
+    }
+    previous = i;
+    ++numOfChanges;
+  }
+  out.push_back(static_cast<char>(kDeltaSnapshot));
+  PutVarint(snapshot.id, out);
+  PutVarint(base.id, out);
+  PutVarint(numOfChanges, out);
+  out.append(changes);
+}
+
+bool SnapshotDecoder::Apply(const string& data) {
+  Reader reader{data};
+  const auto kind = reader.Byte();
+  const auto id = reader.Varint();
+  vector<Metric> metrics;
+  if (kind == kFullSnapshot) {
+    vector<string> strings(reader.Count());
+    for (auto& s : strings) {
+      s = reader.String();
+    }
+    const auto numOfMetrics = reader.Count();
+    vector<MetricType> types;
+    metrics.reserve(numOfMetrics);
+    types.reserve(numOfMetrics);
+    for (size_t i = 0; i < numOfMetrics; ++i) {
+      const auto component = reader.Varint();
+      const auto name = reader.Varint();
+      const auto type = reader.Byte();
+      if (component >= strings.size() || name >= strings.size() || type > static_cast<uint8_t>(MetricType::Status)) {
+        throw invalid_argument("Invalid metric in metrics snapshot");
+      }
+      metrics.push_back(Metric{strings[component], strings[name], Counter(0)});
+      types.push_back(static_cast<MetricType>(type));
+    }
+    for (size_t i = 0; i < numOfMetrics; ++i) {
+      switch (types[i]) {
+        case MetricType::Counter:
+          metrics[i].value = Counter(reader.Varint());
+          break;
+        case MetricType::Gauge:
+          metrics[i].value = Gauge(reader.Varint());
+          break;
+        case MetricType::Status:
+          metrics[i].value = Status(reader.String());
+          break;
+      }
+    }
+  } else if (kind == kDeltaSnapshot) {
+    if (reader.Varint() != lastId_ || lastId_ == 0) return false;
+    metrics = metrics_;
+    const auto numOfChanges = reader.Count();
+    size_t index = 0;
+    for (size_t i = 0; i < numOfChanges; ++i) {
+      index += reader.Varint();
+      if (index >= metrics.size()) throw invalid_argument("Invalid metric index in metrics snapshot");
+      auto& value = metrics[index].value;
+      if (auto* counter = get_if<Counter>(&value)) {
+        counter->Get() = UnZigZag(counter->Get(), reader.Varint());
+      } else if (auto* gauge = get_if<Gauge>(&value)) {
+        gauge->Set(UnZigZag(gauge->Get(), reader.Varint()));
+      } else {
+        get<Status>(value).Set(reader.String());
+      }
+    }
+  } else {
+    throw invalid_argument("Unknown metrics snapshot kind " + to_string(kind));
+  }
+  if (!reader.Done()) throw invalid_argument("Trailing bytes in metrics snapshot");
+  lastId_ = id;
+  metrics_ = std::move(metrics);
+  return true;
+}
+
+}  // namespace concordMetrics
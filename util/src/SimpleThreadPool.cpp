@@ -24,6 +24,7 @@ void SimpleThreadPool::start(uint8_t num_of_threads) {
   for (auto i = 0; i < num_of_threads; ++i) {
     threads_.emplace_back(std::thread([this, num_of_threads] {
       LOG_DEBUG(SP, "thread start " << std::this_thread::get_id());
+      if (role_) ThreadPlacement::instance().place(*role_);
       {
         std::unique_lock<std::mutex> ul(threads_startup_lock_);
         num_of_free_threads_++;
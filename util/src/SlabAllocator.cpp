@@ -0,0 +1,250 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "SlabAllocator.hpp"
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include "assertUtils.hpp"
+#include "kvstream.h"
+
+namespace concordUtil {
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr uint32_t kChunkMagic = 0x51ab0c8d;
+constexpr uint32_t kChunkAlignment = 16;
+
+// Precedes every chunk, keeping it aligned as memory returned by new
+struct ChunkHeader {
+  uint32_t sizeClass;
+  uint32_t magic;
+  uint64_t reserved;
+};
+static_assert(sizeof(ChunkHeader) == kChunkAlignment);
+
+atomic_size_t nextThreadIndex{0};
+
+ChunkHeader* headerOf(char* chunk) { return reinterpret_cast<ChunkHeader*>(chunk - sizeof(ChunkHeader)); }
+
+}  // namespace
+
+SlabAllocator::SlabAllocator(const string& name, uint32_t maxChunkSize, milliseconds trimPeriod)
+    : trimPeriod_{trimPeriod}, metrics_{name, make_shared<concordMetrics::Aggregator>()} {
+  if (maxChunkSize == 0) throw invalid_argument(__PRETTY_FUNCTION__ + string(": maxChunkSize must be positive"));
+  // Four classes per power of two: base, 1.25 * base, 1.5 * base and 1.75 * base
+  const uint64_t lastSize = (uint64_t{maxChunkSize} + kChunkAlignment - 1) / kChunkAlignment * kChunkAlignment;
+  uint64_t base = kMinChunkSize;
+  for (uint64_t size = base;; size += base / 4) {
+    if (size == 2 * base) base *= 2;
+    sizes_.push_back(static_cast<uint32_t>(min(size, lastSize)));
+    if (size >= lastSize) break;
+  }
+  for (const auto size : sizes_) {
+    classes_.push_back(make_unique<SizeClass>(size, min(kMaxMagazineChunks, kMagazineBytes / size)));
+    allocatedChunks_.push_back(metrics_.RegisterGauge("allocatedChunks_" + to_string(size), 0));
+    availableChunks_.push_back(metrics_.RegisterGauge("availableChunks_" + to_string(size), 0));
+  }
+  metrics_.Register();
+  for (auto& slot : slots_) {
+    slot.magazines.resize(classes_.size());
+  }
+  if (trimPeriod_.count() > 0) trimThread_ = thread([this] { trimLoop(); });
+  LOG_INFO(logger(), "Slab allocator created" << KVLOG(name, maxChunkSize, classes_.size(), trimPeriod_.count()));
+}
+
+SlabAllocator::~SlabAllocator() {
+  {
+    lock_guard<mutex> lock(trimLock_);
+    stopped_ = true;
+  }
+  trimCond_.notify_one();
+  if (trimThread_.joinable()) trimThread_.join();
+
+  size_t inUse = 0;
+  for (auto& sizeClass : classes_) {
+    inUse += sizeClass->allocated - sizeClass->free.size();
+    for (auto* chunk : sizeClass->free) deleteChunk(chunk);
+  }
+  for (auto& slot : slots_) {
+    for (auto& magazine : slot.magazines) {
+      inUse -= magazine.size();
+      for (auto* chunk : magazine) deleteChunk(chunk);
+    }
+  }
+  if (inUse != 0) LOG_WARN(logger(), "Slab allocator destroyed with chunks in use" << KVLOG(inUse));
+}
+
+size_t SlabAllocator::classOf(uint32_t size) const {
+  return lower_bound(sizes_.begin(), sizes_.end(), size) - sizes_.begin();
+}
+
+SlabAllocator::Slot& SlabAllocator::slot() {
+  static thread_local const size_t threadIndex = nextThreadIndex++;
+  return slots_[threadIndex % kNumOfSlots];
+}
+
+char* SlabAllocator::newChunk(uint32_t size, size_t index) {
+  auto* raw = static_cast<char*>(::operator new(sizeof(ChunkHeader) + size));
+  new (raw) ChunkHeader{static_cast<uint32_t>(index), kChunkMagic, 0};
+  return raw + sizeof(ChunkHeader);
+}
+
+void SlabAllocator::deleteChunk(char* chunk) { ::operator delete(headerOf(chunk)); }
+
+void SlabAllocator::refill(SizeClass& sizeClass, size_t index, vector<char*>& magazine, size_t numOfChunks) {
+  {
+    lock_guard<mutex> lock(sizeClass.lock);
+    auto& free = sizeClass.free;
+    const auto moved = min(numOfChunks, free.size());
+    if (moved > 0) {
+      magazine.insert(magazine.end(), free.end() - moved, free.end());
+      free.resize(free.size() - moved);
+      sizeClass.minFree = min(sizeClass.minFree, free.size());
+      return;
+    }
+    sizeClass.allocated++;
+  }
+  // No free chunk anywhere, allocate outside of the depot lock
+  magazine.push_back(newChunk(sizeClass.size, index));
+}
+
+char* SlabAllocator::allocate(uint32_t size) {
+  if (size > maxChunkSize()) {
+    throw invalid_argument(__PRETTY_FUNCTION__ + string(": size ") + to_string(size) +
+                           " exceeds the maximum chunk size " + to_string(maxChunkSize()));
+  }
+  const auto index = classOf(size);
+  auto& sizeClass = *classes_[index];
+  auto& threadSlot = slot();
+  lock_guard<mutex> lock(threadSlot.lock);
+  auto& magazine = threadSlot.magazines[index];
+  if (magazine.empty()) refill(sizeClass, index, magazine, max<size_t>(1, (sizeClass.magazineCapacity + 1) / 2));
+  auto* chunk = magazine.back();
+  magazine.pop_back();
+  return chunk;
+}
+
+void SlabAllocator::deallocate(char* chunk) {
+  if (chunk == nullptr) return;
+  const auto* header = headerOf(chunk);
+  ConcordAssertEQ(header->magic, kChunkMagic);
+  const auto index = header->sizeClass;
+  ConcordAssertLT(index, classes_.size());
+  auto& sizeClass = *classes_[index];
+  auto& threadSlot = slot();
+  lock_guard<mutex> lock(threadSlot.lock);
+  auto& magazine = threadSlot.magazines[index];
+  if (magazine.size() < sizeClass.magazineCapacity) {
+    magazine.push_back(chunk);
+    return;
+  }
+  // The magazine is full: keep half of it and hand the rest to the depot
+  const auto kept = sizeClass.magazineCapacity / 2;
+  lock_guard<mutex> depotLock(sizeClass.lock);
+  sizeClass.free.insert(sizeClass.free.end(), magazine.begin() + kept, magazine.end());
+  sizeClass.free.push_back(chunk);
+  magazine.resize(kept);
+}
+
+void SlabAllocator::reserve(uint32_t size, uint32_t numOfChunks) {
+  if (size > maxChunkSize()) {
+    throw invalid_argument(__PRETTY_FUNCTION__ + string(": size ") + to_string(size) +
+                           " exceeds the maximum chunk size " + to_string(maxChunkSize()));
+  }
+  const auto index = classOf(size);
+  auto& sizeClass = *classes_[index];
+  vector<char*> chunks;
+  chunks.reserve(numOfChunks);
+  for (uint32_t i = 0; i < numOfChunks; ++i) {
+    chunks.push_back(newChunk(sizeClass.size, index));
+  }
+  lock_guard<mutex> lock(sizeClass.lock);
+  sizeClass.free.insert(sizeClass.free.end(), chunks.begin(), chunks.end());
+  sizeClass.allocated += numOfChunks;
+  sizeClass.reserved += numOfChunks;
+  LOG_INFO(logger(), "Chunks reserved" << KVLOG(sizeClass.size, numOfChunks, sizeClass.allocated));
+}
+
+void SlabAllocator::trim() {
+  lock_guard<mutex> trimLock(trimLock_);
+  vector<char*> chunks;
+  for (auto& sizeClass : classes_) {
+    {
+      lock_guard<mutex> lock(sizeClass->lock);
+      auto& free = sizeClass->free;
+      // Chunks that stayed in the depot since the previous trim, beyond the reserved ones
+      const auto unreserved = free.size() > sizeClass->reserved ? free.size() - sizeClass->reserved : 0;
+      const auto unused = min(sizeClass->minFree, unreserved);
+      const auto trimmed = (unused + 1) / 2;
+      chunks.assign(free.end() - trimmed, free.end());
+      free.resize(free.size() - trimmed);
+      sizeClass->allocated -= trimmed;
+      sizeClass->minFree = free.size();
+    }
+    if (!chunks.empty()) LOG_DEBUG(logger(), "Chunks trimmed" << KVLOG(sizeClass->size, chunks.size()));
+    for (auto* chunk : chunks) deleteChunk(chunk);
+  }
+  updateMetrics();
+}
+
+void SlabAllocator::trimLoop() {
+  unique_lock<mutex> lock(trimLock_);
+  while (!stopped_) {
+    trimCond_.wait_for(lock, trimPeriod_, [this] { return stopped_; });
+    if (stopped_) break;
+    lock.unlock();
+    trim();
+    lock.lock();
+  }
+}
+
+void SlabAllocator::updateMetrics() {
+  vector<size_t> available(classes_.size(), 0);
+  for (auto& slot : slots_) {
+    lock_guard<mutex> lock(slot.lock);
+    for (size_t i = 0; i < classes_.size(); ++i) available[i] += slot.magazines[i].size();
+  }
+  for (size_t i = 0; i < classes_.size(); ++i) {
+    lock_guard<mutex> lock(classes_[i]->lock);
+    allocatedChunks_[i].Get().Set(classes_[i]->allocated);
+    availableChunks_[i].Get().Set(available[i] + classes_[i]->free.size());
+  }
+  metrics_.UpdateAggregator();
+}
+
+void SlabAllocator::setAggregator(const shared_ptr<concordMetrics::Aggregator>& aggregator) {
+  lock_guard<mutex> lock(trimLock_);
+  metrics_.SetAggregator(aggregator);
+}
+
+size_t SlabAllocator::allocatedChunks(uint32_t size) const {
+  const auto& sizeClass = *classes_[classOf(size)];
+  lock_guard<mutex> lock(sizeClass.lock);
+  return sizeClass.allocated;
+}
+
+size_t SlabAllocator::availableChunks(uint32_t size) const {
+  const auto index = classOf(size);
+  size_t available = 0;
+  for (const auto& slot : slots_) {
+    lock_guard<mutex> lock(slot.lock);
+    available += slot.magazines[index].size();
+  }
+  lock_guard<mutex> lock(classes_[index]->lock);
+  return available + classes_[index]->free.size();
+}
+
+}  // namespace concordUtil
@@ -0,0 +1,263 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "ThreadPlacement.hpp"
+#include "Logger.hpp"
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace concord::util {
+
+namespace {
+
+logging::Logger TP = logging::getLogger("concord.util.thread-placement");
+
+// MPOL_PREFERRED and MPOL_DEFAULT of <numaif.h>, which comes with libnuma
+constexpr int kMpolDefault = 0;
+constexpr int kMpolPreferred = 1;
+constexpr const char* kNodePrefix = "node";
+
+pid_t currentTid() { return static_cast<pid_t>(syscall(SYS_gettid)); }
+
+std::string trim(const std::string& s) {
+  const auto first = s.find_first_not_of(" \t");
+  if (first == std::string::npos) return "";
+  return s.substr(first, s.find_last_not_of(" \t") - first + 1);
+}
+
+std::vector<std::string> split(const std::string& s, char delimiter) {
+  std::vector<std::string> parts;
+  std::istringstream stream(s);
+  std::string part;
+  while (std::getline(stream, part, delimiter)) parts.push_back(trim(part));
+  return parts;
+}
+
+int parseNumber(const std::string& s, const std::string& context) {
+  if (s.empty() || s.size() > 6 || !std::all_of(s.begin(), s.end(), ::isdigit)) {
+    throw std::invalid_argument("Invalid number '" + s + "' in " + context);
+  }
+  return std::stoi(s);
+}
+
+std::vector<int> nodeCpus(int node) {
+  const auto path = "/sys/devices/system/node/node" + std::to_string(node) + "/cpulist";
+  std::ifstream file(path);
+  std::string cpus;
+  if (!std::getline(file, cpus)) throw std::invalid_argument("Unknown NUMA node " + std::to_string(node));
+  return ThreadPlacement::parseCpuList(trim(cpus));
+}
+
+// Returns the value following the key in the /proc file of the thread, e.g. "se.nr_migrations : 12"
+std::optional<uint64_t> readProcValue(pid_t tid, const std::string& file, const std::string& key) {
+  std::ifstream stream("/proc/self/task/" + std::to_string(tid) + "/" + file);
+  std::string line;
+  while (std::getline(stream, line)) {
+    if (line.compare(0, key.size(), key) != 0) continue;
+    const auto pos = line.find_first_of("0123456789", key.size());
+    if (pos == std::string::npos) return std::nullopt;
+    return std::stoull(line.substr(pos));
+  }
+  return std::nullopt;
+}
+
+// The CPU the thread last ran on, field 39 of /proc/<tid>/stat
+std::optional<int> readLastCpu(pid_t tid) {
+  std::ifstream stream("/proc/self/task/" + std::to_string(tid) + "/stat");
+  std::string stat;
+  if (!std::getline(stream, stat)) return std::nullopt;
+  // The fields following the command name, which may contain spaces, start at field 3
+  const auto pos = stat.rfind(')');
+  if (pos == std::string::npos) return std::nullopt;
+  const auto fields = split(stat.substr(pos + 2), ' ');
+  if (fields.size() <= 39 - 3) return std::nullopt;
+  return std::stoi(fields[39 - 3]);
+}
+
+}  // namespace
+
+struct ThreadPlacement::PlacedThread {
+  ~PlacedThread() {
+    if (tid != 0) ThreadPlacement::instance().forget(tid);
+  }
+  pid_t tid = 0;
+};
+
+ThreadPlacement::ThreadPlacement() : metrics_{"thread_placement", std::make_shared<concordMetrics::Aggregator>()} {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpus)) defaultCpus_.push_back(cpu);
+    }
+  }
+  for (const auto* name : kRoleNames) {
+    const std::string role{name};
+    roleMetrics_.push_back(RoleMetrics{metrics_.RegisterGauge(role + "_threads", 0),
+                                       metrics_.RegisterCounter(role + "_migrations"),
+                                       metrics_.RegisterCounter(role + "_involuntary_context_switches")});
+  }
+  metrics_.Register();
+}
+
+std::vector<int> ThreadPlacement::parseCpuList(const std::string& cpus) {
+  std::vector<int> list;
+  for (const auto& range : split(cpus, ',')) {
+    const auto dash = range.find('-');
+    const auto context = "CPU list '" + cpus + "'";
+    const auto first = parseNumber(range.substr(0, dash), context);
+    const auto last = dash == std::string::npos ? first : parseNumber(range.substr(dash + 1), context);
+    if (last < first) throw std::invalid_argument("Invalid CPU range '" + range + "'");
+    for (int cpu = first; cpu <= last; ++cpu) list.push_back(cpu);
+  }
+  if (list.empty()) throw std::invalid_argument("Empty CPU list");
+  std::sort(list.begin(), list.end());
+  list.erase(std::unique(list.begin(), list.end()), list.end());
+  return list;
+}
+
+ThreadPlacement::Policy ThreadPlacement::parsePolicy(const std::string& policy) {
+  Policy parsed;
+  for (const auto& entry : split(policy, ';')) {
+    if (entry.empty()) continue;
+    const auto eq = entry.find('=');
+    if (eq == std::string::npos) throw std::invalid_argument("Expected role=cpus, got '" + entry + "'");
+    const auto name = trim(entry.substr(0, eq));
+    const auto value = trim(entry.substr(eq + 1));
+    const auto it = std::find_if(kRoleNames.begin(), kRoleNames.end(), [&name](auto n) { return name == n; });
+    if (it == kRoleNames.end()) throw std::invalid_argument("Unknown thread role '" + name + "'");
+    const auto role = static_cast<Role>(it - kRoleNames.begin());
+
+    Placement placement;
+    if (value.compare(0, std::char_traits<char>::length(kNodePrefix), kNodePrefix) == 0) {
+      const auto node = parseNumber(value.substr(std::char_traits<char>::length(kNodePrefix)), "'" + entry + "'");
+      placement.cpus = nodeCpus(node);
+      placement.node = node;
+    } else {
+      placement.cpus = parseCpuList(value);
+    }
+    if (!parsed.emplace(role, std::move(placement)).second) {
+      throw std::invalid_argument("Thread role '" + name + "' is placed more than once");
+    }
+  }
+  return parsed;
+}
+
+void ThreadPlacement::setPolicy(const std::string& policy) {
+  auto parsed = parsePolicy(policy);
+  std::lock_guard<std::mutex> lock(lock_);
+  policy_ = std::move(parsed);
+  LOG_INFO(TP, "Thread placement policy: '" << policy << "'");
+  // The memory policy of other threads can't be changed, but the kernel allocates from the node a thread runs on
+  const auto tid = currentTid();
+  for (const auto& [threadId, thread] : threads_) {
+    apply(threadId, thread.role, threadId == tid);
+  }
+}
+
+void ThreadPlacement::place(Role role) {
+  static thread_local PlacedThread placedThread;
+  const auto tid = currentTid();
+  std::lock_guard<std::mutex> lock(lock_);
+  auto [it, inserted] = threads_.emplace(tid, Thread{role, {}});
+  if (inserted) {
+    sample(tid, it->second);
+    metricsOf(role).threads++;
+  } else if (it->second.role != role) {
+    // The thread changed its role, its scheduler events so far belong to the previous one
+    sample(tid, it->second);
+    metricsOf(it->second.role).threads--;
+    it->second.role = role;
+    metricsOf(role).threads++;
+  }
+  placedThread.tid = tid;
+  // Threads inherit the placement of the thread that created them, so roles without a policy get the default one
+  if (!policy_.empty()) apply(tid, role, true);
+}
+
+void ThreadPlacement::apply(pid_t tid, Role role, bool isCallingThread) {
+  const auto it = policy_.find(role);
+  const auto& cpus = it != policy_.end() ? it->second.cpus : defaultCpus_;
+  if (cpus.empty()) return;
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (const auto cpu : cpus) {
+    if (cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuSet);
+  }
+  const auto* roleName = kRoleNames[static_cast<size_t>(role)];
+  if (sched_setaffinity(tid, sizeof(cpuSet), &cpuSet) != 0) {
+    LOG_WARN(TP, "Failed to place thread " << tid << " of role " << roleName << ": " << strerror(errno));
+    return;
+  }
+  if (isCallingThread) {
+    const auto node = it != policy_.end() ? it->second.node : std::nullopt;
+    constexpr auto kBitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+    std::vector<unsigned long> nodes(node ? *node / kBitsPerWord + 1 : 1);
+    if (node) nodes[*node / kBitsPerWord] |= 1UL << (*node % kBitsPerWord);
+    const auto mode = node ? kMpolPreferred : kMpolDefault;
+    if (syscall(SYS_set_mempolicy, mode, node ? nodes.data() : nullptr, nodes.size() * kBitsPerWord + 1) != 0) {
+      LOG_WARN(TP, "Failed to set the memory policy of thread " << tid << " of role " << roleName);
+    }
+  }
+  LOG_DEBUG(TP, "Placed thread " << tid << " of role " << roleName << " on " << cpus.size() << " CPUs");
+}
+
+void ThreadPlacement::forget(pid_t tid) {
+  std::lock_guard<std::mutex> lock(lock_);
+  auto it = threads_.find(tid);
+  if (it == threads_.end()) return;
+  sample(tid, it->second);
+  metricsOf(it->second.role).threads--;
+  threads_.erase(it);
+}
+
+void ThreadPlacement::sample(pid_t tid, Thread& thread) {
+  auto& metrics = metricsOf(thread.role);
+  auto& stats = thread.stats;
+  if (const auto switches = readProcValue(tid, "status", "nonvoluntary_ctxt_switches")) {
+    if (*switches > stats.involuntaryContextSwitches) {
+      metrics.involuntaryContextSwitches += *switches - stats.involuntaryContextSwitches;
+    }
+    stats.involuntaryContextSwitches = *switches;
+  }
+  // The sched file exists with CONFIG_SCHED_DEBUG only, otherwise count the migrations seen between samples
+  if (const auto migrations = readProcValue(tid, "sched", "se.nr_migrations")) {
+    if (*migrations > stats.migrations) metrics.migrations += *migrations - stats.migrations;
+    stats.migrations = *migrations;
+  } else if (const auto cpu = readLastCpu(tid)) {
+    if (stats.lastCpu != -1 && *cpu != stats.lastCpu) metrics.migrations++;
+    stats.lastCpu = *cpu;
+  }
+}
+
+void ThreadPlacement::setAggregator(const std::shared_ptr<concordMetrics::Aggregator>& aggregator) {
+  std::lock_guard<std::mutex> lock(lock_);
+  metrics_.SetAggregator(aggregator);
+}
+
+void ThreadPlacement::updateMetrics() {
+  std::lock_guard<std::mutex> lock(lock_);
+  for (auto& [tid, thread] : threads_) {
+    sample(tid, thread);
+  }
+  metrics_.UpdateAggregator();
+}
+
+}  // namespace concord::util
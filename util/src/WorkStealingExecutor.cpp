@@ -0,0 +1,279 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").  You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+#include "WorkStealingExecutor.hpp"
+#include "Logger.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+#include <exception>
+#include <typeinfo>
+
+namespace concord::util {
+
+namespace {
+
+logging::Logger WSE = logging::getLogger("concord.util.work-stealing-executor");
+
+// The rounds of looking for a task, yielding in between, before an idle worker sleeps
+constexpr size_t kSpinRounds = 64;
+constexpr int64_t kInitialDequeCapacity = 1024;
+
+// The executor and index of the worker running on this thread, if any
+thread_local const void* current_executor = nullptr;
+thread_local size_t current_worker = 0;
+
+}  // namespace
+
+/******************************** Class WorkDeque ********************************/
+
+WorkStealingExecutor::WorkDeque::WorkDeque() {
+  arrays_.push_back(std::make_unique<Array>(kInitialDequeCapacity));
+  array_.store(arrays_.back().get(), std::memory_order_relaxed);
+}
+
+WorkStealingExecutor::WorkDeque::~WorkDeque() {
+  while (auto task = pop()) {
+    delete task;
+  }
+}
+
+void WorkStealingExecutor::WorkDeque::push(Task* task) {
+  const auto b = bottom_.load(std::memory_order_relaxed);
+  const auto t = top_.load(std::memory_order_acquire);
+  auto array = array_.load(std::memory_order_relaxed);
+  if (b - t > array->capacity - 1) {
+    auto grown = std::make_unique<Array>(array->capacity * 2);
+    for (auto i = t; i < b; ++i) {
+      grown->put(i, array->get(i));
+    }
+    array = grown.get();
+    arrays_.push_back(std::move(grown));
+    array_.store(array, std::memory_order_release);
+  }
+  array->put(b, task);
+  bottom_.store(b + 1, std::memory_order_release);
+}
+
+WorkStealingExecutor::Task* WorkStealingExecutor::WorkDeque::pop() {
+  const auto b = bottom_.load(std::memory_order_relaxed) - 1;
+  auto array = array_.load(std::memory_order_relaxed);
+  // The store of bottom must be ordered before the load of top, a thief orders them the other way around
+  bottom_.store(b, std::memory_order_seq_cst);
+  auto t = top_.load(std::memory_order_seq_cst);
+  if (t > b) {
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  auto task = array->get(b);
+  if (t == b) {
+    // The last task, race the thieves for it
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      task = nullptr;
+    }
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+  return task;
+}
+
+WorkStealingExecutor::Task* WorkStealingExecutor::WorkDeque::steal() {
+  auto t = top_.load(std::memory_order_seq_cst);
+  const auto b = bottom_.load(std::memory_order_seq_cst);
+  if (t >= b) {
+    return nullptr;
+  }
+  auto task = array_.load(std::memory_order_acquire)->get(t);
+  if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return task;
+}
+
+size_t WorkStealingExecutor::WorkDeque::size() const {
+  const auto b = bottom_.load(std::memory_order_relaxed);
+  const auto t = top_.load(std::memory_order_relaxed);
+  return b > t ? b - t : 0;
+}
+
+/******************************** Class WorkStealingExecutor ********************************/
+
+WorkStealingExecutor::WorkStealingExecutor() = default;
+
+WorkStealingExecutor::WorkStealingExecutor(size_t num_of_threads, bool pin_threads) {
+  start(num_of_threads, pin_threads);
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  stop();
+  discardAll(false);
+}
+
+void WorkStealingExecutor::start(size_t num_of_threads, bool pin_threads) {
+  ConcordAssert(stopped_);
+  ConcordAssert(num_of_threads > 0);
+  for (size_t i = 0; i < num_of_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  stopped_ = false;
+  const auto num_of_cpus = std::thread::hardware_concurrency();
+  for (size_t i = 0; i < num_of_threads; ++i) {
+    auto& thread = workers_[i]->thread;
+    thread = std::thread(&WorkStealingExecutor::loop, this, i);
+    if (pin_threads && num_of_cpus > 0) {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(i % num_of_cpus, &cpus);
+      if (pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) != 0) {
+        LOG_WARN(WSE, "Failed to pin worker " << i << " to CPU " << i % num_of_cpus);
+      }
+    }
+  }
+  LOG_DEBUG(WSE, "started " << num_of_threads << " workers" << (pin_threads ? " pinned to CPUs" : ""));
+}
+
+void WorkStealingExecutor::stop(bool executeAllTasks) {
+  {
+    std::lock_guard<std::mutex> lock(park_lock_);
+    if (stopped_) return;
+    stopped_ = true;
+  }
+  park_cond_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+  // no more concurrent workers, can cleanup their deques
+  LOG_DEBUG(WSE, "will " << (executeAllTasks ? "execute " : "discard ") << getNumOfTasks() << " tasks");
+  discardAll(executeAllTasks);
+  workers_.clear();
+}
+
+size_t WorkStealingExecutor::getNumOfTasks() const {
+  auto tasks = injection_queue_.size() + overflow_size_.load(std::memory_order_relaxed);
+  for (const auto& worker : workers_) {
+    tasks += worker->deque.size();
+  }
+  return tasks;
+}
+
+bool WorkStealingExecutor::schedule(Task* task) {
+  if (stopped_.load(std::memory_order_acquire)) {
+    delete task;
+    return false;
+  }
+  if (current_executor == this) {
+    workers_[current_worker]->deque.push(task);
+  } else if (!injection_queue_.tryPush(task)) {
+    std::lock_guard<std::mutex> lock(overflow_lock_);
+    overflow_.push_back(task);
+    overflow_size_.fetch_add(1, std::memory_order_relaxed);
+  }
+  wakeOne();
+  return true;
+}
+
+void WorkStealingExecutor::wakeOne() {
+  // Both the submitter and a worker about to sleep read-modify-write sleepers_, so one of them comes second and reads
+  // what the other did: either the submitter sees the sleeper, or the worker acquires the task published before.
+  if (sleepers_.fetch_add(0, std::memory_order_acq_rel) > 0) {
+    std::lock_guard<std::mutex> lock(park_lock_);
+    park_cond_.notify_one();
+  }
+}
+
+void WorkStealingExecutor::loop(size_t index) {
+  current_executor = this;
+  current_worker = index;
+  LOG_DEBUG(WSE, "worker " << index << " start " << std::this_thread::get_id());
+  while (!stopped_.load(std::memory_order_acquire)) {
+    auto task = findTask(index);
+    for (size_t round = 0; !task && round < kSpinRounds; ++round) {
+      std::this_thread::yield();
+      task = findTask(index);
+    }
+    if (task) {
+      execute(task);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(park_lock_);
+    sleepers_.fetch_add(1, std::memory_order_acq_rel);
+    if (!stopped_ && !hasTasks()) {
+      park_cond_.wait(lock);
+    }
+    sleepers_.fetch_sub(1, std::memory_order_relaxed);
+  }
+  current_executor = nullptr;
+}
+
+WorkStealingExecutor::Task* WorkStealingExecutor::findTask(size_t index) {
+  if (auto task = workers_[index]->deque.pop()) {
+    return task;
+  }
+  Task* task = nullptr;
+  if (injection_queue_.tryPop(task)) {
+    return task;
+  }
+  if (overflow_size_.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(overflow_lock_);
+    if (!overflow_.empty()) {
+      task = overflow_.front();
+      overflow_.pop_front();
+      overflow_size_.fetch_sub(1, std::memory_order_relaxed);
+      return task;
+    }
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    if (auto task = workers_[(index + i) % workers_.size()]->deque.steal()) {
+      return task;
+    }
+  }
+  return nullptr;
+}
+
+bool WorkStealingExecutor::hasTasks() const { return getNumOfTasks() > 0; }
+
+void WorkStealingExecutor::execute(Task* task) {
+  try {
+    task->run();
+  } catch (std::exception& e) {
+    LOG_FATAL(WSE, "exception during execution of " << typeid(*task).name() << " Reason: " << e.what());
+    std::terminate();
+  } catch (...) {
+    LOG_FATAL(WSE, "unknown exception during execution of " << typeid(*task).name());
+    std::terminate();
+  }
+  delete task;
+}
+
+void WorkStealingExecutor::discardAll(bool execute) {
+  auto next = [this]() -> Task* {
+    for (auto& worker : workers_) {
+      if (auto task = worker->deque.pop()) return task;
+    }
+    Task* task = nullptr;
+    if (injection_queue_.tryPop(task)) return task;
+    std::lock_guard<std::mutex> lock(overflow_lock_);
+    if (overflow_.empty()) return nullptr;
+    task = overflow_.front();
+    overflow_.pop_front();
+    overflow_size_.fetch_sub(1, std::memory_order_relaxed);
+    return task;
+  };
+  while (auto task = next()) {
+    if (execute) {
+      this->execute(task);
+    } else {
+      delete task;
+    }
+  }
+}
+
+}  // namespace concord::util
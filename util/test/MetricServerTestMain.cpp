@@ -22,7 +22,9 @@ using namespace concordMetrics;
 
 int main() {
   cout << "Starting MetricsServer" << endl;
-  concordMetrics::Server server(6161);
+  SubscriptionConfig subscriptions;
+  subscriptions.enabled = true;
+  concordMetrics::Server server(6161, true, subscriptions);
   server.Start();
 
   // We don't join the thread until server.Stop(), so keep the main thread
@@ -0,0 +1,238 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "AsyncSink.hpp"
+#include "Logger.hpp"
+
+#include <future>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace logging;
+using namespace std::chrono_literals;
+
+bool push(AsyncSink& sink, const std::string& record) { return sink.push(record.data(), record.size()); }
+
+AsyncSinkConfig config(size_t ring_bytes, OverflowPolicy policy) {
+  AsyncSinkConfig config;
+  config.ring_bytes = ring_bytes;
+  config.overflow_policy = policy;
+  config.drain_interval = 1ms;
+  return config;
+}
+
+TEST(async_sink, records_of_a_thread_are_written_in_order) {
+  std::vector<std::string> written;
+  const size_t num_threads = 4;
+  const size_t records_per_thread = 20000;
+  {
+    AsyncSink sink{config(4096, OverflowPolicy::block),
+                   [&written](const char* data, size_t size) { written.emplace_back(data, size); }};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&sink, t]() {
+        for (size_t i = 0; i < records_per_thread; ++i) {
+          ASSERT_TRUE(push(sink, std::to_string(t) + ":" + std::to_string(i)));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    sink.stop();
+    ASSERT_EQ(num_threads * records_per_thread, sink.getStats().written);
+    ASSERT_EQ(0, sink.getStats().dropped);
+  }
+  std::map<size_t, size_t> next;
+  for (const auto& record : written) {
+    const auto separator = record.find(':');
+    const auto thread = std::stoul(record.substr(0, separator));
+    ASSERT_EQ(next[thread]++, std::stoul(record.substr(separator + 1)));
+  }
+  ASSERT_EQ(num_threads, next.size());
+}
+
+TEST(async_sink, records_wrap_around_the_ring) {
+  std::vector<std::string> pushed;
+  std::vector<std::string> written;
+  AsyncSink sink{config(1024, OverflowPolicy::block),
+                 [&written](const char* data, size_t size) { written.emplace_back(data, size); }};
+  for (size_t i = 0; i < 5000; ++i) {
+    pushed.emplace_back((i * 37) % 257, static_cast<char>('a' + i % 26));
+    ASSERT_TRUE(push(sink, pushed.back()));
+  }
+  sink.stop();
+  ASSERT_EQ(pushed, written);
+}
+
+TEST(async_sink, drop_policy_counts_the_dropped_records) {
+  std::promise<void> unblock;
+  auto unblocked = unblock.get_future().share();
+  size_t written = 0;
+  AsyncSink sink{config(1024, OverflowPolicy::drop), [&written, unblocked](const char*, size_t) {
+                   unblocked.wait();
+                   written++;
+                 }};
+  const size_t num_records = 1000;
+  size_t accepted = 0;
+  for (size_t i = 0; i < num_records; ++i) {
+    if (push(sink, "a record of 32 bytes, more or less")) accepted++;
+  }
+  ASSERT_LT(accepted, num_records);
+  unblock.set_value();
+  sink.stop();
+  ASSERT_EQ(accepted, written);
+  ASSERT_EQ(accepted, sink.getStats().written);
+  ASSERT_EQ(num_records - accepted, sink.getStats().dropped);
+}
+
+TEST(async_sink, block_policy_waits_for_room) {
+  size_t written = 0;
+  AsyncSink sink{config(1024, OverflowPolicy::block), [&written](const char*, size_t) {
+                   std::this_thread::sleep_for(10us);
+                   written++;
+                 }};
+  const size_t num_records = 1000;
+  for (size_t i = 0; i < num_records; ++i) {
+    ASSERT_TRUE(push(sink, "a record of 32 bytes, more or less"));
+  }
+  sink.stop();
+  ASSERT_EQ(num_records, written);
+  ASSERT_EQ(0, sink.getStats().dropped);
+}
+
+TEST(async_sink, flush_and_stop) {
+  std::vector<std::string> written;
+  size_t flushes = 0;
+  AsyncSink sink{config(4096, OverflowPolicy::drop),
+                 [&written](const char* data, size_t size) { written.emplace_back(data, size); },
+                 [&flushes]() { flushes++; }};
+  // Larger than a quarter of the ring
+  ASSERT_FALSE(push(sink, std::string(1025, 'x')));
+  ASSERT_TRUE(push(sink, "first"));
+  sink.flush();
+  ASSERT_EQ(std::vector<std::string>{"first"}, written);
+  ASSERT_LE(1, flushes);
+
+  sink.stop();
+  ASSERT_FALSE(push(sink, "dropped"));
+  ASSERT_EQ(2, sink.getStats().dropped);
+  // Doesn't wait for a stopped sink
+  sink.flush();
+
+  sink.start();
+  ASSERT_TRUE(push(sink, "second"));
+  sink.stop();
+  ASSERT_EQ((std::vector<std::string>{"first", "second"}), written);
+}
+
+TEST(async_sink, rings_of_exited_threads_are_released) {
+  size_t written = 0;
+  AsyncSink sink{config(1024, OverflowPolicy::drop), [&written](const char*, size_t) { written++; }};
+  const size_t num_threads = 8;
+  for (size_t round = 0; round < 3; ++round) {
+    std::promise<void> exit;
+    auto exited = exit.get_future().share();
+    std::vector<std::promise<void>> pushed(num_threads);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&sink, &pushed, exited, t]() {
+        EXPECT_TRUE(push(sink, "a record"));
+        pushed[t].set_value();
+        exited.wait();
+      });
+    }
+    for (auto& promise : pushed) {
+      promise.get_future().wait();
+    }
+    sink.flush();
+    ASSERT_EQ(num_threads, sink.getStats().rings);
+    exit.set_value();
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    // The rings are forgotten by the drains that follow the one that wrote their records
+    for (size_t i = 0; i < 3; ++i) {
+      sink.flush();
+    }
+    ASSERT_EQ(0, sink.getStats().rings);
+  }
+  ASSERT_TRUE(push(sink, "from the main thread"));
+  ASSERT_EQ(1, sink.getStats().rings);
+  sink.stop();
+  ASSERT_EQ(3 * num_threads + 1, written);
+}
+
+TEST(async_sink, ring_bytes_must_be_a_power_of_two) {
+  ASSERT_THROW(AsyncSink(config(1000, OverflowPolicy::drop), [](const char*, size_t) {}), std::invalid_argument);
+}
+
+TEST(async_logging, log_macros) {
+  auto logger = getLogger("concord.util.async-logging-test");
+  std::ostringstream out;
+  auto cout_buffer = std::cout.rdbuf(out.rdbuf());
+
+  startAsyncLogging();
+  ASSERT_TRUE(isAsyncLogging());
+  LOG_INFO(logger, "async " << 42 << std::hex << " " << 255);
+  LOG_INFO(logger, "formatting is reset " << 255);
+  LOG_DEBUG(logger, "filtered by level");
+  flushAsyncLogging();
+  const auto logged = out.str();
+  stopAsyncLogging();
+  ASSERT_FALSE(isAsyncLogging());
+  LOG_INFO(logger, "sync");
+
+  std::cout.rdbuf(cout_buffer);
+  ASSERT_NE(std::string::npos, logged.find("|concord.util.async-logging-test|"));
+  ASSERT_NE(std::string::npos, logged.find("|async 42 ff\n"));
+  ASSERT_NE(std::string::npos, logged.find("|formatting is reset 255\n"));
+  ASSERT_EQ(std::string::npos, logged.find("filtered by level"));
+  ASSERT_NE(std::string::npos, out.str().find("|sync\n"));
+  ASSERT_EQ(2, getAsyncLoggingStats().written);
+}
+
+std::string logged(const logging::Logger& logger, int value) {
+  LOG_INFO(logger, "inner " << value);
+  return std::to_string(value);
+}
+
+TEST(async_logging, nested_log_macros) {
+  auto logger = getLogger("concord.util.async-logging-test");
+  std::ostringstream out;
+  auto cout_buffer = std::cout.rdbuf(out.rdbuf());
+
+  startAsyncLogging();
+  LOG_INFO(logger, "outer " << 1 << " " << logged(logger, 2) << " " << 3);
+  flushAsyncLogging();
+  stopAsyncLogging();
+
+  std::cout.rdbuf(cout_buffer);
+  ASSERT_NE(std::string::npos, out.str().find("|inner 2\n"));
+  ASSERT_NE(std::string::npos, out.str().find("|outer 1 2 3\n"));
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,172 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+//
+
+#include "gtest/gtest.h"
+#include "concurrent_lru_cache.hpp"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace concord::util;
+
+namespace {
+
+// Charges the size of the string values only
+struct StringCharge {
+  size_t operator()(const int&, const std::string& value) const { return value.size(); }
+};
+
+using StringCache = ConcurrentLruCache<int, std::string, StringCharge>;
+
+// The bytes an entry with a value of the given size is charged in a StringCache
+size_t charged(size_t value_size) {
+  StringCache cache(1 << 20, 1);
+  cache.put(0, std::string(value_size, 'v'));
+  return cache.bytes();
+}
+
+TEST(concurrent_lru_cache_test, basic) {
+  auto cache = ConcurrentLruCache<int, int>(1 << 20, 4);
+  ASSERT_EQ(4, cache.numShards());
+  ASSERT_EQ(1 << 20, cache.capacity());
+  ASSERT_FALSE(cache.get(1).has_value());
+  cache.put(1, 10);
+  cache.put(2, 20);
+  ASSERT_EQ(10, cache.get(1));
+  ASSERT_EQ(20, cache.get(2));
+  ASSERT_EQ(2, cache.size());
+
+  // Update
+  cache.put(1, 11);
+  ASSERT_EQ(11, cache.get(1));
+  ASSERT_EQ(2, cache.size());
+
+  ASSERT_TRUE(cache.erase(1));
+  ASSERT_FALSE(cache.erase(1));
+  ASSERT_FALSE(cache.get(1).has_value());
+  ASSERT_EQ(1, cache.size());
+
+  auto stats = cache.getStats();
+  ASSERT_EQ(3, stats.hits);
+  ASSERT_EQ(2, stats.misses);
+  ASSERT_EQ(3, stats.puts);
+  ASSERT_EQ(0, stats.evictions);
+
+  cache.clear();
+  ASSERT_EQ(0, cache.size());
+  ASSERT_EQ(0, cache.bytes());
+  ASSERT_EQ(3, cache.getStats().hits);
+}
+
+TEST(concurrent_lru_cache_test, bounded_by_bytes) {
+  const auto entry = charged(100);
+  StringCache cache(10 * entry, 1);
+  for (int i = 0; i < 100; ++i) {
+    cache.put(i, std::string(100, 'v'));
+    ASSERT_LE(cache.bytes(), cache.capacity());
+  }
+  ASSERT_EQ(10, cache.size());
+  ASSERT_EQ(90, cache.getStats().evictions);
+
+  // A larger value takes the room of several entries
+  cache.put(1000, std::string(100 + 3 * entry, 'v'));
+  ASSERT_EQ(7, cache.size());
+  ASSERT_LE(cache.bytes(), cache.capacity());
+
+  // Growing an existing value evicts the others, not the value itself
+  cache.put(1000, std::string(100 + 8 * entry, 'v'));
+  ASSERT_EQ(2, cache.size());
+  ASSERT_TRUE(cache.get(1000).has_value());
+
+  // Values larger than the capacity are not cached
+  cache.put(2000, std::string(cache.capacity(), 'v'));
+  ASSERT_FALSE(cache.get(2000).has_value());
+  cache.put(1000, std::string(cache.capacity(), 'v'));
+  ASSERT_FALSE(cache.get(1000).has_value());
+  ASSERT_EQ(1, cache.size());
+}
+
+TEST(concurrent_lru_cache_test, referenced_entries_get_a_second_chance) {
+  const auto entry = charged(1);
+  StringCache cache(3 * entry, 1);
+  cache.put(1, "1");
+  cache.put(2, "2");
+  cache.put(3, "3");
+  ASSERT_EQ("1", cache.get(1));
+
+  // 2 is the oldest entry not used since inserted
+  cache.put(4, "4");
+  ASSERT_FALSE(cache.get(2).has_value());
+  ASSERT_EQ("1", cache.get(1));
+  ASSERT_EQ("3", cache.get(3));
+  ASSERT_EQ("4", cache.get(4));
+
+  // All are referenced, the hand clears them and evicts the first one it reaches again
+  cache.put(5, "5");
+  ASSERT_EQ(3, cache.size());
+  ASSERT_EQ("5", cache.get(5));
+}
+
+TEST(concurrent_lru_cache_test, shard_metrics) {
+  auto aggregator = std::make_shared<concordMetrics::Aggregator>();
+  auto cache = ConcurrentLruCache<int, int>(1 << 20, 2, "test_cache");
+  cache.setAggregator(aggregator);
+  for (int i = 0; i < 100; ++i) {
+    cache.put(i, i);
+  }
+  for (int i = 0; i < 200; ++i) {
+    cache.get(i);
+  }
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  for (int shard = 0; shard < 2; ++shard) {
+    const auto shard_hits = aggregator->GetCounter("test_cache", "hits_shard_" + std::to_string(shard)).Get();
+    ASSERT_GT(shard_hits, 0);
+    hits += shard_hits;
+    misses += aggregator->GetCounter("test_cache", "misses_shard_" + std::to_string(shard)).Get();
+  }
+  ASSERT_EQ(100, hits);
+  ASSERT_EQ(100, misses);
+  ASSERT_EQ(100, aggregator->GetCounter("test_cache", "puts").Get());
+  ASSERT_EQ(cache.bytes(), aggregator->GetGauge("test_cache", "bytes").Get());
+}
+
+TEST(concurrent_lru_cache_test, concurrent_readers_and_writers) {
+  const auto entry = charged(8);
+  StringCache cache(256 * entry, 8);
+  const int num_keys = 1024;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cache, t]() {
+      for (int i = 0; i < 20000; ++i) {
+        const int key = (i * 7 + t) % num_keys;
+        if (i % 4 == 0) {
+          cache.put(key, std::to_string(key));
+        } else if (auto value = cache.get(key)) {
+          ASSERT_EQ(std::to_string(key), *value);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_LE(cache.bytes(), cache.capacity());
+  auto stats = cache.getStats();
+  ASSERT_EQ(4 * 15000, stats.hits + stats.misses);
+  ASSERT_EQ(4 * 5000, stats.puts);
+}
+
+}  // namespace
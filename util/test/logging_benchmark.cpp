@@ -0,0 +1,98 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+// The latency of a LOG_* call on the calling thread, logging synchronously and through the async sink with either
+// overflow policy. The output goes to a file, and every call is timed to report the tail latency:
+//   p50_ns, p99_ns, max_ns - percentiles of the calls of a thread, averaged over the threads
+//   dropped                - records dropped by the sink
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include "Logger.hpp"
+
+namespace {
+
+using namespace logging;
+
+enum class Mode { sync, async_drop, async_block };
+
+auto logger = getLogger("concord.util.logging-benchmark");
+
+std::ofstream output;
+std::streambuf* cout_buffer = nullptr;
+// The sink of a configuration is kept between runs
+uint64_t dropped_before = 0;
+
+void setUp(Mode mode) {
+  output.open("/tmp/concord_logging_benchmark.log", std::ios::trunc);
+  cout_buffer = std::cout.rdbuf(output.rdbuf());
+  if (mode != Mode::sync) {
+    AsyncSinkConfig config;
+    config.overflow_policy = mode == Mode::async_drop ? OverflowPolicy::drop : OverflowPolicy::block;
+    startAsyncLogging(config);
+  }
+  dropped_before = getAsyncLoggingStats().dropped;
+}
+
+void tearDown() {
+  stopAsyncLogging();
+  std::cout.rdbuf(cout_buffer);
+  output.close();
+  std::remove("/tmp/concord_logging_benchmark.log");
+}
+
+template <Mode mode>
+void BM_Log(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    setUp(mode);
+  }
+  std::vector<uint64_t> latencies;
+  latencies.reserve(1 << 20);
+  uint64_t seq_num = 0;
+  SCOPED_MDC_SEQ_NUM(std::to_string(state.thread_index()));
+  for (auto _ : state) {
+    const auto start = std::chrono::steady_clock::now();
+    LOG_INFO(logger, "Processing request " << seq_num++ << " of client " << state.thread_index() << " in view 7");
+    const auto latency = std::chrono::steady_clock::now() - start;
+    if (latencies.size() < latencies.capacity()) {
+      latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+    }
+  }
+  std::sort(latencies.begin(), latencies.end());
+  if (!latencies.empty()) {
+    state.counters["p50_ns"] = benchmark::Counter(latencies[latencies.size() / 2], benchmark::Counter::kAvgThreads);
+    state.counters["p99_ns"] =
+        benchmark::Counter(latencies[latencies.size() * 99 / 100], benchmark::Counter::kAvgThreads);
+    state.counters["max_ns"] = benchmark::Counter(latencies.back(), benchmark::Counter::kAvgThreads);
+  }
+  // All threads are done logging once out of the loop
+  if (state.thread_index() == 0) {
+    state.counters["dropped"] = getAsyncLoggingStats().dropped - dropped_before;
+    tearDown();
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Log, Mode::sync)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Log, Mode::async_drop)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Log, Mode::async_block)->ThreadRange(1, 8)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
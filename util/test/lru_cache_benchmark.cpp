@@ -0,0 +1,85 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Scaling of cache reads from 1 to 32 threads, for LruCache behind a mutex, which is how it has to be shared, and for
+// ConcurrentLruCache. The caches hold kEntries entries and 90% of the reads hit.
+
+#include <benchmark/benchmark.h>
+
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include "lru_cache.hpp"
+#include "concurrent_lru_cache.hpp"
+
+namespace {
+
+using namespace concord::util;
+
+constexpr int kEntries = 100000;
+constexpr int kKeys = kEntries * 10 / 9;
+constexpr size_t kReadsPerIteration = 1000;
+
+std::vector<int> randomKeys(int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<int> dist(0, kKeys - 1);
+  std::vector<int> keys(kReadsPerIteration);
+  for (auto& key : keys) {
+    key = dist(gen);
+  }
+  return keys;
+}
+
+struct LockedLruCache {
+  LockedLruCache() : cache(kEntries) {
+    for (int i = 0; i < kEntries; ++i) {
+      cache.put(i, i);
+    }
+  }
+  std::optional<int> get(int key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return cache.get(key);
+  }
+  std::mutex mutex;
+  LruCache<int, int> cache;
+};
+
+struct ShardedLruCache {
+  ShardedLruCache() : cache(kEntries * 128, 64) {
+    for (int i = 0; i < kEntries; ++i) {
+      cache.put(i, i);
+    }
+  }
+  std::optional<int> get(int key) { return cache.get(key); }
+  ConcurrentLruCache<int, int> cache;
+};
+
+template <class Cache>
+void BM_Get(benchmark::State& state) {
+  static Cache cache;
+  const auto keys = randomKeys(state.thread_index());
+  for (auto _ : state) {
+    for (auto key : keys) {
+      benchmark::DoNotOptimize(cache.get(key));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * kReadsPerIteration);
+}
+
+BENCHMARK_TEMPLATE(BM_Get, LockedLruCache)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Get, ShardedLruCache)->ThreadRange(1, 32)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
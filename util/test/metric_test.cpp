@@ -15,7 +15,10 @@
 #include <cstdlib>
 #include "gtest/gtest.h"
 #include "Metrics.hpp"
+#include "MetricsSnapshotCodec.hpp"
 #include <cmath>
+#include <thread>
+#include <vector>
 
 using namespace std;
 
@@ -200,4 +203,190 @@ TEST(MetricTest, CollectStatuses) {
   ASSERT_EQ(numOfGaugesInStateTransfer, 1);
 }
 
+TEST(MetricTest, ShardedValues) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  auto h_counter = c.RegisterShardedCounter("messages_sent");
+  auto h_gauge = c.RegisterShardedGauge("pending_requests", 10);
+  c.Register();
+
+  const size_t num_threads = 8;
+  const uint64_t num_updates = 10000;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([=]() mutable {
+      for (uint64_t i = 0; i < num_updates; i++) {
+        h_counter++;
+        h_gauge++;
+        h_gauge -= 2;
+      }
+      h_counter += 5;
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  // Sharded values are read live, without updating the aggregator
+  ASSERT_EQ(num_threads * (num_updates + 5), aggregator->GetCounter(c.Name(), "messages_sent").Get());
+  ASSERT_EQ(h_counter.Get().Get(), aggregator->GetCounter(c.Name(), "messages_sent").Get());
+  h_gauge.Get().Set(num_threads * num_updates);
+  h_gauge += 3;
+  ASSERT_EQ(num_threads * num_updates + 3, aggregator->GetGauge(c.Name(), "pending_requests").Get());
+
+  auto counters = aggregator->CollectCounters();
+  ASSERT_EQ(1, counters.size());
+  ASSERT_EQ("messages_sent", counters.front().name);
+  ASSERT_EQ(num_threads * (num_updates + 5), std::get<Counter>(counters.front().value).Get());
+  auto gauges = aggregator->CollectGauges();
+  ASSERT_EQ(1, gauges.size());
+  ASSERT_EQ(num_threads * num_updates + 3, std::get<Gauge>(gauges.front().value).Get());
+}
+
+TEST(MetricTest, ShardedValuesToJson) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  c.RegisterGauge("connected_peers", 3);
+  c.RegisterShardedGauge("pending_requests", 4);
+  c.RegisterCounter("messages_sent", 0);
+  c.RegisterAtomicCounter("messages_received", 1);
+  c.RegisterShardedCounter("requests_received", 2);
+  c.Register();
+
+  Component c2("state-transfer", aggregator);
+  c2.RegisterShardedCounter("blocks-fetched");
+  c2.Register();
+
+  ostringstream oss;
+  oss << "python3 -c '" << aggregator->ToJson() << "'" << endl;
+  ASSERT_EQ(0, system(oss.str().c_str()));
+}
+
+TEST(MetricTest, SnapshotWhilePublishing) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  auto h_gauge = c.RegisterGauge("view", 0);
+  auto h_counter = c.RegisterCounter("messages_sent", 0);
+  auto h_status = c.RegisterStatus("state", "0");
+  c.Register();
+
+  // Every published copy has all values equal, so a snapshot never mixes copies
+  const uint64_t num_updates = 10000;
+  std::thread publisher([&]() {
+    for (uint64_t i = 1; i <= num_updates; i++) {
+      h_gauge.Get().Set(i);
+      h_counter++;
+      h_status.Get().Set(std::to_string(i));
+      c.UpdateAggregator();
+    }
+  });
+  uint64_t last = 0;
+  while (last < num_updates) {
+    auto metrics = aggregator->Snapshot();
+    ASSERT_EQ(3, metrics.size());
+    const auto gauge = std::get<Gauge>(metrics.front().value).Get();
+    ASSERT_EQ(gauge, std::get<Counter>(std::next(metrics.begin())->value).Get());
+    ASSERT_EQ(std::to_string(gauge), std::get<Status>(metrics.back().value).Get());
+    ASSERT_GE(gauge, last);
+    last = gauge;
+  }
+  publisher.join();
+}
+
+void AssertSameMetrics(const std::list<Metric>& expected, const std::vector<Metric>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  auto metric = actual.begin();
+  for (const auto& e : expected) {
+    ASSERT_EQ(e.component, metric->component);
+    ASSERT_EQ(e.name, metric->name);
+    ASSERT_EQ(e.value.index(), metric->value.index());
+    if (auto* counter = std::get_if<Counter>(&e.value)) {
+      ASSERT_EQ(counter->Get(), std::get<Counter>(metric->value).Get());
+    } else if (auto* gauge = std::get_if<Gauge>(&e.value)) {
+      ASSERT_EQ(gauge->Get(), std::get<Gauge>(metric->value).Get());
+    } else {
+      ASSERT_EQ(std::get<Status>(e.value).Get(), std::get<Status>(metric->value).Get());
+    }
+    ++metric;
+  }
+}
+
+TEST(MetricTest, BinarySnapshots) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component replica("replica", aggregator);
+  auto h_gauge = replica.RegisterGauge("connected_peers", 3);
+  auto h_status = replica.RegisterStatus("state", "primary");
+  auto h_counter = replica.RegisterCounter("messages_sent", 0);
+  auto h_sharded = replica.RegisterShardedCounter("messages_received", 0);
+  replica.Register();
+  Component client("client", aggregator);
+  client.RegisterGauge("connected_peers", 4);
+  client.Register();
+
+  SnapshotEncoder encoder{4};
+  SnapshotDecoder decoder;
+  const auto full = encoder.Encode(encoder.Take(*aggregator));
+  ASSERT_EQ(kFullSnapshot, full[0]);
+  ASSERT_TRUE(decoder.Apply(full));
+  ASSERT_EQ(1, decoder.LastId());
+  AssertSameMetrics(aggregator->Snapshot(), decoder.Metrics());
+
+  // Only the changed values are sent, counters and gauges may go down
+  h_gauge.Get().Set(1);
+  h_status.Get().Set("backup");
+  h_counter += 1000000;
+  h_sharded += 7;
+  replica.UpdateAggregator();
+  const auto delta = encoder.Encode(encoder.Take(*aggregator), decoder.LastId());
+  ASSERT_EQ(kDeltaSnapshot, delta[0]);
+  ASSERT_LT(delta.size(), full.size());
+  ASSERT_TRUE(decoder.Apply(delta));
+  AssertSameMetrics(aggregator->Snapshot(), decoder.Metrics());
+
+  // Nothing changed
+  const auto empty = encoder.Encode(encoder.Take(*aggregator), decoder.LastId());
+  ASSERT_EQ(4, empty.size());
+  ASSERT_TRUE(decoder.Apply(empty));
+  AssertSameMetrics(aggregator->Snapshot(), decoder.Metrics());
+
+  // A delta against another base than the last snapshot applied is rejected
+  h_counter += 1;
+  replica.UpdateAggregator();
+  const auto id = encoder.Take(*aggregator);
+  ASSERT_FALSE(decoder.Apply(encoder.Encode(id, 1)));
+  ASSERT_EQ(3, decoder.LastId());
+  ASSERT_TRUE(decoder.Apply(encoder.Encode(id, decoder.LastId())));
+  AssertSameMetrics(aggregator->Snapshot(), decoder.Metrics());
+
+  // Bases that fell out of the history and bases with other metrics get a full snapshot
+  for (int i = 0; i < 4; ++i) encoder.Take(*aggregator);
+  ASSERT_EQ(kFullSnapshot, encoder.Encode(encoder.LastId(), 1)[0]);
+  ASSERT_THROW(encoder.Encode(1), std::out_of_range);
+  Component other("other", aggregator);
+  other.RegisterStatus("name", "other");
+  other.Register();
+  const auto layout_changed = encoder.Encode(encoder.Take(*aggregator), decoder.LastId());
+  ASSERT_EQ(kFullSnapshot, layout_changed[0]);
+  ASSERT_TRUE(decoder.Apply(layout_changed));
+  AssertSameMetrics(aggregator->Snapshot(), decoder.Metrics());
+}
+
+TEST(MetricTest, MalformedBinarySnapshots) {
+  auto aggregator = std::make_shared<Aggregator>();
+  Component c("replica", aggregator);
+  c.RegisterStatus("state", "primary");
+  c.Register();
+  SnapshotEncoder encoder;
+  const auto full = encoder.Encode(encoder.Take(*aggregator));
+
+  SnapshotDecoder decoder;
+  for (size_t size = 0; size < full.size(); ++size) {
+    ASSERT_THROW(decoder.Apply(full.substr(0, size)), std::invalid_argument);
+  }
+  ASSERT_THROW(decoder.Apply(full + "x"), std::invalid_argument);
+  ASSERT_THROW(decoder.Apply(std::string("\x07\x01", 2)), std::invalid_argument);
+  ASSERT_EQ(0, decoder.LastId());
+  ASSERT_TRUE(decoder.Apply(full));
+}
+
 }  // namespace concordMetrics
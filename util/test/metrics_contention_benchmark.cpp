@@ -0,0 +1,185 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License"). You may not use this product except in
+// compliance with the Apache 2.0 License.
+//
+// This product may include a number of subcomponents with separate copyright notices and license terms. Your use of
+// these subcomponents is subject to the terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Contention benchmark of the metrics. Writer threads update a counter and a gauge for the given duration while a
+// scraper thread takes snapshots of the aggregator and serializes it to JSON. Reports the updates/s of the writers and
+// the scrapes/s of the scraper for:
+//   component - every writer has its own component and publishes its values every [publish every] updates
+//   atomic    - all writers share an atomic counter and gauge
+//   sharded   - all writers share a sharded counter and gauge
+//
+// Usage: metrics_contention_benchmark [writers] [duration ms] [publish every]
+// Exits with a failure if the aggregator doesn't report all updates.
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Metrics.hpp"
+
+using namespace concordMetrics;
+
+namespace {
+
+struct Result {
+  uint64_t updates = 0;
+  uint64_t scrapes = 0;
+  bool correct = false;
+};
+
+// Runs the writers until the duration ends while scraping, and returns the number of updates and scrapes.
+// update(writer index) performs a single update, reported() scrapes and returns the total of the counters.
+template <typename Update, typename Reported>
+Result run(size_t num_writers, std::chrono::milliseconds duration, Update update, Reported reported) {
+  std::atomic_bool stop{false};
+  std::atomic_uint64_t scrapes{0};
+  std::vector<uint64_t> updates(num_writers, 0);
+  std::vector<std::thread> writers;
+  for (size_t w = 0; w < num_writers; w++) {
+    writers.emplace_back([&, w]() {
+      uint64_t done = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        update(w);
+        done++;
+      }
+      updates[w] = done;
+    });
+  }
+  std::thread scraper([&]() {
+    while (!stop.load(std::memory_order_relaxed)) {
+      reported();
+      scrapes++;
+    }
+  });
+  std::this_thread::sleep_for(duration);
+  stop = true;
+  for (auto& writer : writers) {
+    writer.join();
+  }
+  scraper.join();
+
+  Result result;
+  for (auto u : updates) {
+    result.updates += u;
+  }
+  result.scrapes = scrapes;
+  result.correct = reported() == result.updates;
+  return result;
+}
+
+void print(const std::string& name, const Result& result, std::chrono::milliseconds duration) {
+  const double seconds = std::chrono::duration<double>(duration).count();
+  std::cout << name << ": updates/s=" << static_cast<uint64_t>(result.updates / seconds)
+            << " scrapes/s=" << static_cast<uint64_t>(result.scrapes / seconds)
+            << (result.correct ? "" : " INCORRECT TOTAL") << std::endl;
+}
+
+// The total of the counters reported by the aggregator. Also serializes it, as a scraper would.
+uint64_t scrape(Aggregator& aggregator) {
+  uint64_t total = 0;
+  for (const auto& metric : aggregator.Snapshot()) {
+    if (auto counter = std::get_if<Counter>(&metric.value)) {
+      total += counter->Get();
+    }
+  }
+  aggregator.ToJson();
+  return total;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t num_writers = argc > 1 ? std::stoul(argv[1]) : 32;
+  const std::chrono::milliseconds duration(argc > 2 ? std::stoul(argv[2]) : 1000);
+  const uint64_t publish_every = argc > 3 ? std::stoull(argv[3]) : 64;
+  std::cout << "writers=" << num_writers << " duration=" << duration.count() << "ms publish every=" << publish_every
+            << std::endl;
+  bool correct = true;
+
+  {
+    auto aggregator = std::make_shared<Aggregator>();
+    std::vector<std::unique_ptr<Component>> components;
+    std::vector<CounterHandle> counters;
+    std::vector<GaugeHandle> gauges;
+    for (size_t w = 0; w < num_writers; w++) {
+      components.push_back(std::make_unique<Component>("writer" + std::to_string(w), aggregator));
+      counters.push_back(components.back()->RegisterCounter("updates"));
+      gauges.push_back(components.back()->RegisterGauge("last_update", 0));
+      components.back()->Register();
+    }
+    auto result = run(
+        num_writers,
+        duration,
+        [&](size_t w) {
+          counters[w]++;
+          const auto done = counters[w].Get().Get();
+          gauges[w].Get().Set(done);
+          if (done % publish_every == 0) {
+            components[w]->UpdateAggregator();
+          }
+        },
+        [&]() { return scrape(*aggregator); });
+    // Publish the updates since the last publication before checking the total
+    for (auto& component : components) {
+      component->UpdateAggregator();
+    }
+    result.correct = scrape(*aggregator) == result.updates;
+    correct = correct && result.correct;
+    print("component", result, duration);
+  }
+
+  {
+    auto aggregator = std::make_shared<Aggregator>();
+    Component component("writers", aggregator);
+    auto counter = component.RegisterAtomicCounter("updates");
+    auto gauge = component.RegisterAtomicGauge("in_flight", 0);
+    component.Register();
+    auto result = run(
+        num_writers,
+        duration,
+        [&](size_t) {
+          gauge++;
+          counter++;
+          gauge--;
+        },
+        // Atomic values are only published on UpdateAggregator, which reads the live component
+        [&]() {
+          component.UpdateAggregator();
+          return scrape(*aggregator);
+        });
+    correct = correct && result.correct;
+    print("atomic", result, duration);
+  }
+
+  {
+    auto aggregator = std::make_shared<Aggregator>();
+    Component component("writers", aggregator);
+    auto counter = component.RegisterShardedCounter("updates");
+    auto gauge = component.RegisterShardedGauge("in_flight", 0);
+    component.Register();
+    auto result = run(
+        num_writers,
+        duration,
+        [&](size_t) {
+          gauge++;
+          counter++;
+          gauge--;
+        },
+        [&]() { return scrape(*aggregator); });
+    correct = correct && result.correct;
+    print("sharded", result, duration);
+  }
+
+  return correct ? 0 : 1;
+}
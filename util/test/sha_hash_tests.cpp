@@ -135,6 +135,27 @@ TYPED_TEST(SHATest, update) {
   ASSERT_EQ(expected, sha.finish());
 }
 
+TYPED_TEST(SHATest, clone) {
+  using Test = typename TestFixture::Type;
+  using Hash = typename Test::Hash;
+
+  auto sha = Hash{};
+  sha.init();
+  sha.update("art", 3);
+  auto copy = sha.clone();
+  sha.update("ist", 3);
+  copy.update("ist", 3);
+  ASSERT_EQ(string_to_array<Hash>(Test::ARTIST_DIGEST), sha.finish());
+  ASSERT_EQ(string_to_array<Hash>(Test::ARTIST_DIGEST), copy.finish());
+
+  // The copy continues independently of the original
+  sha.init();
+  auto other_copy = sha.clone();
+  other_copy.update("REM", 3);
+  ASSERT_EQ(string_to_array<Hash>(Test::REM_DIGEST), other_copy.finish());
+  ASSERT_EQ(string_to_array<Hash>(Test::EMPTY_DIGEST), sha.finish());
+}
+
 }  // namespace
 
 int main(int argc, char** argv) {
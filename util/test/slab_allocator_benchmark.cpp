@@ -0,0 +1,96 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Allocation and release of buffers for requests of mixed sizes from 1 to 32 threads, for RawMemoryPool, which hands
+// out chunks of the maximum size, SlabAllocator and plain new. Most requests are small and a few are close to the
+// maximum, like client requests. Each thread keeps kBuffersInFlight buffers and replaces the oldest one per request.
+
+#include <benchmark/benchmark.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "RawMemoryPool.hpp"
+#include "SlabAllocator.hpp"
+
+namespace {
+
+using namespace concordUtil;
+
+constexpr uint32_t kMaxSize = 64 * 1024;
+constexpr size_t kBuffersInFlight = 16;
+constexpr size_t kRequestsPerIteration = 1000;
+
+std::vector<uint32_t> randomSizes(int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<uint32_t> small(16, 1024);
+  std::uniform_int_distribution<uint32_t> large(1024, kMaxSize);
+  std::bernoulli_distribution isLarge(0.1);
+  std::vector<uint32_t> sizes(kRequestsPerIteration);
+  for (auto& size : sizes) {
+    size = isLarge(gen) ? large(gen) : small(gen);
+  }
+  return sizes;
+}
+
+struct RawPool {
+  RawPool() : pool(kMaxSize, timers) { pool.allocatePool(256, 4096); }
+  char* allocate(uint32_t) { return pool.getChunk(); }
+  void deallocate(char* chunk) { pool.returnChunk(chunk); }
+  Timers timers;
+  RawMemoryPool pool;
+};
+
+struct Slab {
+  Slab() : allocator("slab_benchmark", kMaxSize) {}
+  char* allocate(uint32_t size) { return allocator.allocate(size); }
+  void deallocate(char* chunk) { allocator.deallocate(chunk); }
+  SlabAllocator allocator;
+};
+
+struct Heap {
+  char* allocate(uint32_t size) { return new char[size]; }
+  void deallocate(char* chunk) { delete[] chunk; }
+};
+
+template <class Allocator>
+void BM_AllocateRelease(benchmark::State& state) {
+  static Allocator allocator;
+  const auto sizes = randomSizes(state.thread_index());
+  std::vector<char*> inFlight(kBuffersInFlight, nullptr);
+  size_t next = 0;
+  for (auto _ : state) {
+    for (auto size : sizes) {
+      auto*& buffer = inFlight[next++ % kBuffersInFlight];
+      if (buffer != nullptr) allocator.deallocate(buffer);
+      buffer = allocator.allocate(size);
+      // Touch the buffer like a request being copied in
+      memset(buffer, 0, std::min<uint32_t>(size, 256));
+    }
+  }
+  for (auto*& buffer : inFlight) {
+    if (buffer != nullptr) allocator.deallocate(buffer);
+    buffer = nullptr;
+  }
+  state.SetItemsProcessed(state.iterations() * kRequestsPerIteration);
+}
+
+BENCHMARK_TEMPLATE(BM_AllocateRelease, RawPool)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AllocateRelease, Slab)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_AllocateRelease, Heap)->ThreadRange(1, 32)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,192 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "SlabAllocator.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace concordUtil;
+using namespace std::chrono_literals;
+
+constexpr uint32_t kMaxChunkSize = 1 << 20;
+
+TEST(SlabAllocatorTest, sizeClasses) {
+  SlabAllocator allocator("slab", kMaxChunkSize, 0ms);
+  ASSERT_EQ(SlabAllocator::kMinChunkSize, allocator.chunkSize(0));
+  ASSERT_EQ(SlabAllocator::kMinChunkSize, allocator.chunkSize(1));
+  ASSERT_EQ(80, allocator.chunkSize(65));
+  ASSERT_EQ(128, allocator.chunkSize(128));
+  ASSERT_EQ(160, allocator.chunkSize(129));
+  ASSERT_EQ(kMaxChunkSize, allocator.chunkSize(kMaxChunkSize));
+  ASSERT_EQ(kMaxChunkSize, allocator.maxChunkSize());
+  for (uint32_t size = SlabAllocator::kMinChunkSize; size <= kMaxChunkSize; size = size * 9 / 8) {
+    ASSERT_GE(allocator.chunkSize(size), size);
+    // At most 20% of a chunk is wasted
+    ASSERT_LE(allocator.chunkSize(size) - size, allocator.chunkSize(size) / 5) << size;
+  }
+
+  // The largest class is the maximum chunk size, rounded up to keep chunks aligned
+  SlabAllocator unaligned("unaligned", 1000, 0ms);
+  ASSERT_EQ(1008, unaligned.maxChunkSize());
+  ASSERT_EQ(1008, unaligned.chunkSize(1000));
+}
+
+TEST(SlabAllocatorTest, checkInput) {
+  ASSERT_THROW(SlabAllocator("slab", 0, 0ms), std::invalid_argument);
+  SlabAllocator allocator("slab", kMaxChunkSize, 0ms);
+  ASSERT_THROW(allocator.allocate(kMaxChunkSize + 1), std::invalid_argument);
+  ASSERT_THROW(allocator.reserve(kMaxChunkSize + 1, 1), std::invalid_argument);
+  ASSERT_NO_THROW(allocator.deallocate(nullptr));
+}
+
+TEST(SlabAllocatorTest, chunksAreReused) {
+  SlabAllocator allocator("slab", kMaxChunkSize, 0ms);
+  for (uint32_t size : {1u, 100u, 4000u, kMaxChunkSize}) {
+    auto* chunk = allocator.allocate(size);
+    ASSERT_EQ(0, reinterpret_cast<uintptr_t>(chunk) % 16);
+    memset(chunk, 0xab, allocator.chunkSize(size));
+    allocator.deallocate(chunk);
+    ASSERT_EQ(chunk, allocator.allocate(size));
+    allocator.deallocate(chunk);
+    ASSERT_EQ(1, allocator.allocatedChunks(size));
+    ASSERT_EQ(1, allocator.availableChunks(size));
+  }
+}
+
+TEST(SlabAllocatorTest, reservedChunks) {
+  // Chunks this large skip the magazines
+  const uint32_t size = 2 * SlabAllocator::kMagazineBytes;
+  SlabAllocator allocator("slab", size, 0ms);
+  allocator.reserve(size, 3);
+  ASSERT_EQ(3, allocator.allocatedChunks(size));
+  ASSERT_EQ(3, allocator.availableChunks(size));
+
+  std::vector<char*> chunks;
+  for (int i = 0; i < 5; ++i) chunks.push_back(allocator.allocate(size - i));
+  ASSERT_EQ(5, allocator.allocatedChunks(size));
+  ASSERT_EQ(0, allocator.availableChunks(size));
+  for (auto* chunk : chunks) allocator.deallocate(chunk);
+  ASSERT_EQ(5, allocator.availableChunks(size));
+
+  // Trimming never goes below the reserved chunks
+  for (int i = 0; i < 10; ++i) allocator.trim();
+  ASSERT_EQ(3, allocator.allocatedChunks(size));
+  ASSERT_EQ(3, allocator.availableChunks(size));
+}
+
+TEST(SlabAllocatorTest, trimFreesUnusedChunks) {
+  SlabAllocator allocator("slab", kMaxChunkSize, 0ms);
+  auto aggregator = std::make_shared<concordMetrics::Aggregator>();
+  allocator.setAggregator(aggregator);
+  const uint32_t size = 4096;
+  const auto chunkSize = std::to_string(allocator.chunkSize(size));
+
+  std::vector<char*> chunks;
+  for (int i = 0; i < 1000; ++i) chunks.push_back(allocator.allocate(size));
+  for (auto* chunk : chunks) allocator.deallocate(chunk);
+  const auto allocated = allocator.allocatedChunks(size);
+  ASSERT_EQ(1000, allocated);
+  ASSERT_EQ(1000, allocator.availableChunks(size));
+
+  // The first trim only starts tracking the depot, the next ones free half of what stayed unused
+  allocator.trim();
+  ASSERT_EQ(allocated, aggregator->GetGauge("slab", "allocatedChunks_" + chunkSize).Get());
+  allocator.trim();
+  ASSERT_LT(allocator.allocatedChunks(size), allocated);
+  ASSERT_GT(allocator.allocatedChunks(size), allocated / 3);
+  for (int i = 0; i < 20; ++i) allocator.trim();
+  // Only the magazine of this thread is left
+  ASSERT_LE(allocator.allocatedChunks(size), SlabAllocator::kMaxMagazineChunks);
+  ASSERT_EQ(allocator.allocatedChunks(size), allocator.availableChunks(size));
+  ASSERT_EQ(allocator.allocatedChunks(size), aggregator->GetGauge("slab", "allocatedChunks_" + chunkSize).Get());
+  ASSERT_EQ(allocator.availableChunks(size), aggregator->GetGauge("slab", "availableChunks_" + chunkSize).Get());
+
+  // Chunks in use are kept
+  chunks.clear();
+  for (int i = 0; i < 100; ++i) chunks.push_back(allocator.allocate(size));
+  for (int i = 0; i < 20; ++i) allocator.trim();
+  ASSERT_GE(allocator.allocatedChunks(size), 100);
+  for (auto* chunk : chunks) allocator.deallocate(chunk);
+}
+
+TEST(SlabAllocatorTest, backgroundTrimming) {
+  SlabAllocator allocator("slab", kMaxChunkSize, 1ms);
+  std::vector<char*> chunks;
+  for (int i = 0; i < 1000; ++i) chunks.push_back(allocator.allocate(100));
+  for (auto* chunk : chunks) allocator.deallocate(chunk);
+  const auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (allocator.allocatedChunks(100) > SlabAllocator::kMaxMagazineChunks) {
+    ASSERT_LT(std::chrono::steady_clock::now(), deadline);
+    std::this_thread::sleep_for(1ms);
+  }
+}
+
+// Chunks of random sizes are allocated by producers and freed by consumers, or by the producers themselves once
+// kMaxInFlight chunks are outstanding
+TEST(SlabAllocatorTest, concurrentAllocFree) {
+  constexpr size_t kMaxInFlight = 256;
+  constexpr uint32_t kMaxSize = 16 * 1024;
+  SlabAllocator allocator("slab", kMaxChunkSize, 1ms);
+  std::mutex lock;
+  std::vector<std::pair<char*, uint32_t>> inFlight;
+  auto check = [](const std::pair<char*, uint32_t>& chunk) {
+    if (chunk.second > 0) {
+      ASSERT_EQ(chunk.first[chunk.second - 1], chunk.first[0]);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t]() {
+      std::mt19937 gen(t);
+      std::uniform_int_distribution<uint32_t> sizes(0, kMaxSize);
+      for (int i = 0; i < 5000; ++i) {
+        std::pair<char*, uint32_t> chunk{nullptr, 0};
+        if (t % 2 == 0) {
+          const auto size = sizes(gen);
+          auto* allocated = allocator.allocate(size);
+          memset(allocated, t, size);
+          std::lock_guard<std::mutex> guard(lock);
+          inFlight.emplace_back(allocated, size);
+          if (inFlight.size() <= kMaxInFlight) continue;
+          chunk = inFlight.front();
+          inFlight.erase(inFlight.begin());
+        } else {
+          std::lock_guard<std::mutex> guard(lock);
+          if (inFlight.empty()) continue;
+          chunk = inFlight.back();
+          inFlight.pop_back();
+        }
+        check(chunk);
+        allocator.deallocate(chunk.first);
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  for (auto& [chunk, size] : inFlight) allocator.deallocate(chunk);
+  for (uint32_t size = 0; size <= kMaxSize; size = allocator.chunkSize(size) + 1) {
+    ASSERT_EQ(allocator.allocatedChunks(size), allocator.availableChunks(size)) << size;
+  }
+}
+
+}  // namespace
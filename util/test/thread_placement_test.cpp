@@ -0,0 +1,173 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "ThreadPlacement.hpp"
+
+#include <sched.h>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace concord::util;
+using Role = ThreadPlacement::Role;
+
+std::vector<int> allowedCpus() {
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  std::vector<int> allowed;
+  if (sched_getaffinity(0, sizeof(cpus), &cpus) != 0) return allowed;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpus)) allowed.push_back(cpu);
+  }
+  return allowed;
+}
+
+// A thread placed with a role that waits to be released
+class PlacedThread {
+ public:
+  explicit PlacedThread(Role role) {
+    thread_ = std::thread([this, role]() {
+      ThreadPlacement::instance().place(role);
+      std::unique_lock<std::mutex> lock(lock_);
+      placed_ = true;
+      cond_.notify_all();
+      cond_.wait(lock, [this]() { return released_; });
+    });
+    std::unique_lock<std::mutex> lock(lock_);
+    cond_.wait(lock, [this]() { return placed_; });
+  }
+
+  ~PlacedThread() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      released_ = true;
+    }
+    cond_.notify_all();
+    thread_.join();
+  }
+
+  std::vector<int> cpus() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    std::vector<int> list;
+    EXPECT_EQ(0, pthread_getaffinity_np(thread_.native_handle(), sizeof(cpus), &cpus));
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &cpus)) list.push_back(cpu);
+    }
+    return list;
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable cond_;
+  bool placed_ = false;
+  bool released_ = false;
+  std::thread thread_;
+};
+
+class thread_placement_test : public ::testing::Test {
+  void SetUp() override { placement_.setAggregator(aggregator_); }
+  void TearDown() override { placement_.setPolicy(""); }
+
+ protected:
+  uint64_t threads(const std::string& role) {
+    placement_.updateMetrics();
+    return aggregator_->GetGauge("thread_placement", role + "_threads").Get();
+  }
+
+  ThreadPlacement& placement_ = ThreadPlacement::instance();
+  const std::shared_ptr<concordMetrics::Aggregator> aggregator_ = std::make_shared<concordMetrics::Aggregator>();
+  const std::vector<int> allowed_ = allowedCpus();
+};
+
+TEST(thread_placement, cpu_lists) {
+  ASSERT_EQ(std::vector<int>({3}), ThreadPlacement::parseCpuList("3"));
+  ASSERT_EQ(std::vector<int>({0, 1, 2, 3, 8}), ThreadPlacement::parseCpuList("0-3,8"));
+  ASSERT_EQ(std::vector<int>({1, 2, 5}), ThreadPlacement::parseCpuList(" 5, 1-2 ,2"));
+  for (const auto* invalid : {"", ",", "3-1", "a", "1-", "-1", "1,,2", "1-2-3"}) {
+    ASSERT_THROW(ThreadPlacement::parseCpuList(invalid), std::invalid_argument) << invalid;
+  }
+}
+
+TEST(thread_placement, policies) {
+  ASSERT_TRUE(ThreadPlacement::parsePolicy("").empty());
+  const auto policy = ThreadPlacement::parsePolicy("dispatcher=2; post_exec = 3 ;comm=4-5;");
+  ASSERT_EQ(3, policy.size());
+  ASSERT_EQ(std::vector<int>({2}), policy.at(Role::Dispatcher).cpus);
+  ASSERT_EQ(std::vector<int>({3}), policy.at(Role::PostExec).cpus);
+  ASSERT_EQ(std::vector<int>({4, 5}), policy.at(Role::Comm).cpus);
+  ASSERT_FALSE(policy.at(Role::Comm).node);
+
+  for (const auto* invalid :
+       {"dispatcher", "dispatcher=", "unknown=1", "comm=1;comm=2", "comm=node", "comm=node9999", "comm=nodex"}) {
+    ASSERT_THROW(ThreadPlacement::parsePolicy(invalid), std::invalid_argument) << invalid;
+  }
+}
+
+TEST(thread_placement, numa_nodes) {
+  std::ifstream node0("/sys/devices/system/node/node0/cpulist");
+  std::string cpus;
+  if (!std::getline(node0, cpus)) GTEST_SKIP() << "No NUMA information";
+  const auto policy = ThreadPlacement::parsePolicy("state_transfer=node0");
+  ASSERT_EQ(0, policy.at(Role::StateTransfer).node);
+  ASSERT_EQ(ThreadPlacement::parseCpuList(cpus), policy.at(Role::StateTransfer).cpus);
+}
+
+TEST_F(thread_placement_test, threads_are_placed_by_role) {
+  placement_.setPolicy("request_pool=" + std::to_string(allowed_.front()));
+  PlacedThread pinned(Role::RequestPool);
+  PlacedThread free(Role::PreProcessor);
+  ASSERT_EQ(std::vector<int>({allowed_.front()}), pinned.cpus());
+  ASSERT_EQ(allowed_, free.cpus());
+}
+
+TEST_F(thread_placement_test, placed_threads_move_with_the_policy) {
+  placement_.setPolicy("pre_processor=" + std::to_string(allowed_.front()));
+  PlacedThread thread(Role::PreProcessor);
+  ASSERT_EQ(std::vector<int>({allowed_.front()}), thread.cpus());
+
+  placement_.setPolicy("pre_processor=" + std::to_string(allowed_.back()));
+  ASSERT_EQ(std::vector<int>({allowed_.back()}), thread.cpus());
+
+  // Back to the CPUs of the process
+  placement_.setPolicy("");
+  ASSERT_EQ(allowed_, thread.cpus());
+}
+
+TEST_F(thread_placement_test, threads_are_counted_until_they_exit) {
+  const auto before = threads("comm");
+  {
+    PlacedThread first(Role::Comm);
+    PlacedThread second(Role::Comm);
+    ASSERT_EQ(before + 2, threads("comm"));
+  }
+  ASSERT_EQ(before, threads("comm"));
+}
+
+TEST_F(thread_placement_test, invalid_policy_keeps_the_previous_one) {
+  placement_.setPolicy("dispatcher=" + std::to_string(allowed_.front()));
+  ASSERT_THROW(placement_.setPolicy("dispatcher=x"), std::invalid_argument);
+  PlacedThread thread(Role::Dispatcher);
+  ASSERT_EQ(std::vector<int>({allowed_.front()}), thread.cpus());
+}
+
+}  // namespace
@@ -0,0 +1,151 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+// Throughput of fine-grained tasks on SimpleThreadPool and ThreadPool, and on the work-stealing executor through the
+// same interfaces. Every iteration submits a batch of tiny tasks and waits for all of them:
+//   Flat   - the tasks are submitted from the benchmark thread
+//   Nested - a root task spawns a binary tree of tasks from the pool threads
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "SimpleThreadPool.hpp"
+#include "thread_pool.hpp"
+#include "WorkStealingExecutor.hpp"
+
+namespace {
+
+using namespace concord::util;
+
+const auto kThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+constexpr size_t kTasks = 10000;
+constexpr size_t kDepth = 13;  // 2^14 - 1 tasks
+
+void waitFor(const std::atomic_size_t& counter, size_t value) {
+  while (counter.load(std::memory_order_acquire) < value) {
+    std::this_thread::yield();
+  }
+}
+
+// A job that counts its execution after adding two children, until the given depth
+template <class Pool>
+class CountingJob final : public SimpleThreadPool::Job {
+ public:
+  CountingJob(Pool& pool, std::atomic_size_t& executed, size_t depth)
+      : pool_(pool), executed_(executed), depth_(depth) {}
+  void execute() override {
+    if (depth_ > 0) {
+      for (int i = 0; i < 2; ++i) {
+        pool_.add(new CountingJob(pool_, executed_, depth_ - 1));
+      }
+    }
+    executed_.fetch_add(1, std::memory_order_release);
+  }
+  void release() override { delete this; }
+
+ private:
+  Pool& pool_;
+  std::atomic_size_t& executed_;
+  const size_t depth_;
+};
+
+template <class Pool>
+void BM_SimpleThreadPoolFlat(benchmark::State& state) {
+  Pool pool;
+  pool.start(kThreads);
+  std::atomic_size_t executed{0};
+  size_t expected = 0;
+  for (auto _ : state) {
+    for (size_t i = 0; i < kTasks; ++i) {
+      pool.add(new CountingJob<Pool>(pool, executed, 0));
+    }
+    expected += kTasks;
+    waitFor(executed, expected);
+  }
+  pool.stop();
+  state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+template <class Pool>
+void BM_SimpleThreadPoolNested(benchmark::State& state) {
+  Pool pool;
+  pool.start(kThreads);
+  std::atomic_size_t executed{0};
+  const size_t tasks = (1u << (kDepth + 1)) - 1;
+  size_t expected = 0;
+  for (auto _ : state) {
+    pool.add(new CountingJob<Pool>(pool, executed, kDepth));
+    expected += tasks;
+    waitFor(executed, expected);
+  }
+  pool.stop();
+  state.SetItemsProcessed(state.iterations() * tasks);
+}
+
+template <class Pool>
+void BM_ThreadPoolFlat(benchmark::State& state) {
+  Pool pool{kThreads};
+  std::vector<std::future<size_t>> futures;
+  futures.reserve(kTasks);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kTasks; ++i) {
+      futures.push_back(pool.async([i]() { return i; }));
+    }
+    for (auto& future : futures) {
+      benchmark::DoNotOptimize(future.get());
+    }
+    futures.clear();
+  }
+  state.SetItemsProcessed(state.iterations() * kTasks);
+}
+
+template <class Pool>
+void spawn(Pool& pool, std::atomic_size_t& executed, size_t depth) {
+  if (depth > 0) {
+    for (int i = 0; i < 2; ++i) {
+      pool.async([&pool, &executed, depth]() { spawn(pool, executed, depth - 1); });
+    }
+  }
+  executed.fetch_add(1, std::memory_order_release);
+}
+
+template <class Pool>
+void BM_ThreadPoolNested(benchmark::State& state) {
+  Pool pool{kThreads};
+  std::atomic_size_t executed{0};
+  const size_t tasks = (1u << (kDepth + 1)) - 1;
+  size_t expected = 0;
+  for (auto _ : state) {
+    pool.async([&pool, &executed]() { spawn(pool, executed, kDepth); });
+    expected += tasks;
+    waitFor(executed, expected);
+  }
+  state.SetItemsProcessed(state.iterations() * tasks);
+}
+
+BENCHMARK_TEMPLATE(BM_SimpleThreadPoolFlat, SimpleThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SimpleThreadPoolFlat, WorkStealingSimpleThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SimpleThreadPoolNested, SimpleThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_SimpleThreadPoolNested, WorkStealingSimpleThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ThreadPoolFlat, ThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ThreadPoolFlat, WorkStealingThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ThreadPoolNested, ThreadPool)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ThreadPoolNested, WorkStealingThreadPool)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,95 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the LICENSE
+// file.
+
+// Compares the timer backends with as many timers as a busy replica has: evaluate() from the dispatcher loop, cancel
+// and add, and reset, as done on every retransmission.
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <vector>
+
+#include "Timers.hpp"
+
+using namespace std::chrono;
+using concordUtil::BasicTimers;
+using concordUtil::TimersBase;
+using concordUtil::TimerVector;
+using concordUtil::TimingWheel;
+
+namespace {
+
+constexpr int64_t kTimers = 10000;
+
+// Recurring timers from 10ms to 10s
+template <typename Queue>
+std::vector<TimersBase::Handle> addTimers(BasicTimers<Queue>& timers, steady_clock::time_point now, int64_t count) {
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<int> duration(10, 10000);
+  std::vector<TimersBase::Handle> handles;
+  for (int64_t i = 0; i < count; ++i) {
+    handles.push_back(timers.add(
+        milliseconds(duration(gen)), TimersBase::Timer::RECURRING, [](TimersBase::Handle) {}, now));
+  }
+  return handles;
+}
+
+// The dispatcher evaluates the timers every 100us
+template <typename Queue>
+void BM_Evaluate(benchmark::State& state) {
+  BasicTimers<Queue> timers;
+  auto now = steady_clock::now();
+  addTimers(timers, now, state.range(0));
+  for (auto _ : state) {
+    now += microseconds(100);
+    timers.evaluate(now);
+  }
+}
+
+template <typename Queue>
+void BM_CancelAdd(benchmark::State& state) {
+  BasicTimers<Queue> timers;
+  const auto now = steady_clock::now();
+  auto handles = addTimers(timers, now, state.range(0));
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<size_t> index(0, handles.size() - 1);
+  for (auto _ : state) {
+    auto& handle = handles[index(gen)];
+    timers.cancel(handle);
+    handle = timers.add(
+        milliseconds(500), TimersBase::Timer::ONESHOT, [](TimersBase::Handle) {}, now);
+  }
+}
+
+template <typename Queue>
+void BM_Reset(benchmark::State& state) {
+  BasicTimers<Queue> timers;
+  const auto now = steady_clock::now();
+  auto handles = addTimers(timers, now, state.range(0));
+  std::mt19937 gen(2);
+  std::uniform_int_distribution<size_t> index(0, handles.size() - 1);
+  for (auto _ : state) {
+    timers.reset(handles[index(gen)], milliseconds(500), now);
+  }
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_Evaluate, TimerVector)->Arg(kTimers);
+BENCHMARK_TEMPLATE(BM_Evaluate, TimingWheel)->Arg(kTimers);
+BENCHMARK_TEMPLATE(BM_CancelAdd, TimerVector)->Arg(kTimers);
+BENCHMARK_TEMPLATE(BM_CancelAdd, TimingWheel)->Arg(kTimers);
+BENCHMARK_TEMPLATE(BM_Reset, TimerVector)->Arg(kTimers);
+BENCHMARK_TEMPLATE(BM_Reset, TimingWheel)->Arg(kTimers);
+
+BENCHMARK_MAIN();
@@ -13,6 +13,8 @@
 //
 
 #include <cstdlib>
+#include <map>
+#include <random>
 #include "gtest/gtest.h"
 #include "Timers.hpp"
 
@@ -106,4 +108,124 @@ TEST(TimersTest, Basic) {
   ASSERT_TRUE(third_timer_fired);
 }
 
+TEST(TimersTest, CallbacksModifyTimers) {
+  milliseconds duration(10);
+  auto timers = Timers();
+  steady_clock::time_point now = steady_clock::now();
+
+  int cancelled_counter = 0;
+  int added_counter = 0;
+  int self_cancelled_counter = 0;
+  Handle cancelled = timers.add(
+      duration * 2, Timers::Timer::RECURRING, [&cancelled_counter](Handle) { ++cancelled_counter; }, now);
+  // Cancels itself and the other timer, and adds a new one
+  timers.add(
+      duration,
+      Timers::Timer::RECURRING,
+      [&](Handle h) {
+        ++self_cancelled_counter;
+        timers.cancel(h);
+        timers.cancel(cancelled);
+        timers.add(
+            duration, Timers::Timer::ONESHOT, [&added_counter](Handle) { ++added_counter; }, now);
+      },
+      now);
+
+  now += duration * 2;
+  timers.evaluate(now);
+  ASSERT_EQ(1, self_cancelled_counter);
+  ASSERT_EQ(0, cancelled_counter);
+  ASSERT_EQ(0, added_counter);
+
+  now += duration;
+  timers.evaluate(now);
+  ASSERT_EQ(1, self_cancelled_counter);
+  ASSERT_EQ(0, cancelled_counter);
+  ASSERT_EQ(1, added_counter);
+
+  // Handles of removed timers are ignored
+  timers.reset(cancelled, duration, now);
+  timers.cancel(cancelled);
+  timers.cancel(Handle());
+  now += duration * 10;
+  timers.evaluate(now);
+  ASSERT_EQ(0, cancelled_counter);
+  ASSERT_EQ(1, added_counter);
+}
+
+TEST(TimersTest, FarTimersFireOnTime) {
+  auto timers = Timers();
+  const steady_clock::time_point start = steady_clock::now();
+  // Timers on every level of the timing wheel and beyond it
+  const std::vector<milliseconds> durations{
+      milliseconds(1), milliseconds(255), milliseconds(300), 70s, 5h, 1000h, 2000h};
+  std::vector<steady_clock::time_point> fired(durations.size());
+  for (size_t i = 0; i < durations.size(); ++i) {
+    timers.add(
+        durations[i], Timers::Timer::ONESHOT, [&fired, &start, i](Handle) { fired[i] = start; }, start);
+  }
+
+  for (size_t i = 0; i < durations.size(); ++i) {
+    const auto due = start + durations[i];
+    timers.evaluate(due - 1ms);
+    ASSERT_EQ(steady_clock::time_point{}, fired[i]) << i;
+    timers.evaluate(due);
+    ASSERT_EQ(start, fired[i]) << i;
+  }
+}
+
+// The timing wheel fires the same timers as the vector it replaced
+TEST(TimersTest, MatchesTimerVector) {
+  BasicTimers<TimerVector> vector_timers;
+  Timers wheel_timers;
+  std::mt19937 gen(42);
+  std::uniform_int_distribution<int> op(0, 9);
+  std::uniform_int_distribution<int> duration(0, 100000);
+  std::uniform_int_distribution<int> step(0, 3000);
+
+  std::vector<std::pair<Handle, Handle>> handles;
+  std::multiset<size_t> vector_fired;
+  std::multiset<size_t> wheel_fired;
+  steady_clock::time_point now = steady_clock::now();
+  for (int i = 0; i < 10000; ++i) {
+    switch (op(gen)) {
+      case 0:
+      case 1:
+      case 2: {
+        const auto index = handles.size();
+        const auto type = index % 3 == 0 ? Timers::Timer::RECURRING : Timers::Timer::ONESHOT;
+        const auto d = milliseconds(duration(gen) % (index % 2 == 0 ? 300 : 100000));
+        handles.emplace_back(
+            vector_timers.add(
+                d, type, [&vector_fired, index](Handle) { vector_fired.insert(index); }, now),
+            wheel_timers.add(
+                d, type, [&wheel_fired, index](Handle) { wheel_fired.insert(index); }, now));
+        break;
+      }
+      case 3:
+        if (!handles.empty()) {
+          const auto& [vector_handle, wheel_handle] = handles[duration(gen) % handles.size()];
+          const auto d = milliseconds(duration(gen) % 5000);
+          vector_timers.reset(vector_handle, d, now);
+          wheel_timers.reset(wheel_handle, d, now);
+        }
+        break;
+      case 4:
+        if (!handles.empty()) {
+          const auto& [vector_handle, wheel_handle] = handles[duration(gen) % handles.size()];
+          vector_timers.cancel(vector_handle);
+          wheel_timers.cancel(wheel_handle);
+        }
+        break;
+      default:
+        now += milliseconds(step(gen)) + nanoseconds(duration(gen));
+        vector_timers.evaluate(now);
+        wheel_timers.evaluate(now);
+        ASSERT_EQ(vector_fired, wheel_fired);
+        vector_fired.clear();
+        wheel_fired.clear();
+    }
+  }
+}
+
 }  // namespace concordUtil
@@ -0,0 +1,264 @@
+// Concord
+//
+// Copyright (c) 2022 VMware, Inc. All Rights Reserved.
+//
+// This product is licensed to you under the Apache 2.0 license (the "License").
+// You may not use this product except in compliance with the Apache 2.0
+// License.
+//
+// This product may include a number of subcomponents with separate copyright
+// notices and license terms. Your use of these subcomponents is subject to the
+// terms and conditions of the subcomponent's license, as noted in the
+// LICENSE file.
+
+#include "gtest/gtest.h"
+
+#include "WorkStealingExecutor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using namespace concord::util;
+using namespace std::chrono_literals;
+
+constexpr auto kWaitTimeout = 10s;
+
+bool waitFor(const std::atomic_size_t& counter, size_t value) {
+  const auto deadline = std::chrono::steady_clock::now() + kWaitTimeout;
+  while (counter < value) {
+    if (std::chrono::steady_clock::now() > deadline) return false;
+    std::this_thread::sleep_for(1ms);
+  }
+  return true;
+}
+
+// Counts the jobs executed and released
+class CountingJob final : public WorkStealingSimpleThreadPool::Job {
+ public:
+  CountingJob(std::atomic_size_t& executed, std::atomic_size_t& released) : executed_(executed), released_(released) {}
+  void execute() override { executed_++; }
+  void release() override {
+    released_++;
+    delete this;
+  }
+
+ private:
+  std::atomic_size_t& executed_;
+  std::atomic_size_t& released_;
+};
+
+// Spawns two children until the given depth
+void spawn(WorkStealingExecutor& executor, std::atomic_size_t& executed, size_t depth) {
+  executed++;
+  if (depth == 0) return;
+  for (int i = 0; i < 2; ++i) {
+    executor.submit([&executor, &executed, depth]() { spawn(executor, executed, depth - 1); });
+  }
+}
+
+TEST(work_stealing_executor, tasks_from_different_threads) {
+  WorkStealingExecutor executor{4};
+  ASSERT_EQ(4, executor.getNumOfThreads());
+  const size_t num_submitters = 4;
+  const size_t tasks_per_submitter = 20000;
+  std::atomic_size_t executed{0};
+  std::vector<std::thread> submitters;
+  for (size_t s = 0; s < num_submitters; ++s) {
+    submitters.emplace_back([&]() {
+      for (size_t i = 0; i < tasks_per_submitter; ++i) {
+        ASSERT_TRUE(executor.submit([&executed]() { executed++; }));
+      }
+    });
+  }
+  for (auto& submitter : submitters) {
+    submitter.join();
+  }
+  ASSERT_TRUE(waitFor(executed, num_submitters * tasks_per_submitter));
+}
+
+TEST(work_stealing_executor, nested_tasks) {
+  WorkStealingExecutor executor{3};
+  std::atomic_size_t executed{0};
+  const size_t depth = 14;
+  executor.submit([&]() { spawn(executor, executed, depth); });
+  ASSERT_TRUE(waitFor(executed, (1u << (depth + 1)) - 1));
+}
+
+TEST(work_stealing_executor, idle_workers_steal) {
+  WorkStealingExecutor executor{2};
+  const size_t num_children = 10;
+  std::atomic_size_t executed{0};
+  std::promise<bool> children_done;
+  // The parent blocks its worker until its children are done, which only happens if the other worker steals them
+  executor.submit([&]() {
+    for (size_t i = 0; i < num_children; ++i) {
+      executor.submit([&executed]() { executed++; });
+    }
+    children_done.set_value(waitFor(executed, num_children));
+  });
+  auto future = children_done.get_future();
+  ASSERT_EQ(std::future_status::ready, future.wait_for(kWaitTimeout));
+  ASSERT_TRUE(future.get());
+}
+
+TEST(work_stealing_executor, idle_workers_wake_up) {
+  WorkStealingExecutor executor{2};
+  std::atomic_size_t executed{0};
+  for (size_t i = 1; i <= 20; ++i) {
+    // Let the workers go to sleep
+    std::this_thread::sleep_for(2ms);
+    executor.submit([&executed]() { executed++; });
+    ASSERT_TRUE(waitFor(executed, i));
+  }
+}
+
+TEST(work_stealing_executor, overflow_of_injection_queue) {
+  WorkStealingExecutor executor{1};
+  std::atomic_size_t executed{0};
+  std::promise<void> unblock;
+  auto unblocked = unblock.get_future().share();
+  executor.submit([unblocked]() { unblocked.wait(); });
+  const size_t num_tasks = 20000;
+  for (size_t i = 0; i < num_tasks; ++i) {
+    executor.submit([&executed]() { executed++; });
+  }
+  ASSERT_LE(num_tasks, executor.getNumOfTasks());
+  unblock.set_value();
+  ASSERT_TRUE(waitFor(executed, num_tasks));
+}
+
+TEST(work_stealing_executor, stop_and_restart) {
+  WorkStealingExecutor executor;
+  std::atomic_size_t executed{0};
+  // Not started
+  ASSERT_FALSE(executor.submit([&executed]() { executed++; }));
+
+  executor.start(2, true);
+  std::promise<void> unblock;
+  auto unblocked = unblock.get_future().share();
+  for (int i = 0; i < 2; ++i) {
+    executor.submit([unblocked]() { unblocked.wait(); });
+  }
+  for (int i = 0; i < 100; ++i) {
+    executor.submit([&executed]() { executed++; });
+  }
+  std::thread stopper([&]() { executor.stop(true); });
+  std::this_thread::sleep_for(10ms);
+  unblock.set_value();
+  stopper.join();
+  ASSERT_EQ(100, executed);
+  ASSERT_EQ(0, executor.getNumOfThreads());
+  ASSERT_FALSE(executor.submit([&executed]() { executed++; }));
+
+  executor.start(1);
+  executor.submit([&executed]() { executed++; });
+  ASSERT_TRUE(waitFor(executed, 101));
+}
+
+TEST(work_stealing_simple_thread_pool, jobs_are_executed_and_released) {
+  std::atomic_size_t executed{0};
+  std::atomic_size_t released{0};
+  WorkStealingSimpleThreadPool pool;
+  // Not started, the job is released without being executed
+  pool.add(new CountingJob(executed, released));
+  ASSERT_EQ(0, executed);
+  ASSERT_EQ(1, released);
+
+  pool.start(4);
+  ASSERT_EQ(4, pool.getNumOfThreads());
+  for (int i = 0; i < 1000; ++i) {
+    pool.add(new CountingJob(executed, released));
+  }
+  ASSERT_TRUE(waitFor(released, 1001));
+  ASSERT_EQ(1000, executed);
+  pool.stop();
+  ASSERT_EQ(0, pool.getNumOfThreads());
+}
+
+TEST(work_stealing_simple_thread_pool, stop_discards_jobs) {
+  std::atomic_size_t executed{0};
+  std::atomic_size_t released{0};
+  WorkStealingSimpleThreadPool pool;
+  pool.start(1);
+
+  class BlockingJob final : public WorkStealingSimpleThreadPool::Job {
+   public:
+    BlockingJob(std::shared_future<void> unblocked) : unblocked_(unblocked) {}
+    void execute() override { unblocked_.wait(); }
+    void release() override { delete this; }
+
+   private:
+    std::shared_future<void> unblocked_;
+  };
+  std::promise<void> unblock;
+  pool.add(new BlockingJob(unblock.get_future().share()));
+  for (int i = 0; i < 10; ++i) {
+    pool.add(new CountingJob(executed, released));
+  }
+  std::thread stopper([&]() { pool.stop(false); });
+  std::this_thread::sleep_for(10ms);
+  unblock.set_value();
+  stopper.join();
+  ASSERT_EQ(0, executed);
+  ASSERT_EQ(10, released);
+  ASSERT_EQ(0, pool.getNumOfJobs());
+}
+
+TEST(work_stealing_thread_pool, async) {
+  WorkStealingThreadPool pool;
+  auto sum = pool.async([](int a, int b) { return a + b; }, 40, 2);
+  auto moved = pool.async([](std::unique_ptr<int> p) { return *p; }, std::make_unique<int>(42));
+  auto thrown = pool.async([]() { throw std::runtime_error{"error"}; });
+  ASSERT_EQ(42, sum.get());
+  ASSERT_EQ(42, moved.get());
+  ASSERT_THROW(thrown.get(), std::runtime_error);
+}
+
+TEST(work_stealing_thread_pool, tasks_from_tasks) {
+  WorkStealingThreadPool pool{2};
+  auto outer = pool.async([&pool]() {
+    std::vector<std::future<int>> inner;
+    for (int i = 0; i < 100; ++i) {
+      inner.push_back(pool.async([i]() { return i; }));
+    }
+    return inner;
+  });
+  auto inner = outer.get();
+  int sum = 0;
+  for (auto& future : inner) {
+    sum += future.get();
+  }
+  ASSERT_EQ(4950, sum);
+}
+
+TEST(work_stealing_thread_pool, futures_of_discarded_tasks_are_broken) {
+  std::future<void> discarded;
+  std::promise<void> unblock;
+  std::thread unblocker;
+  {
+    WorkStealingThreadPool pool{1};
+    auto unblocked = unblock.get_future().share();
+    pool.async([unblocked]() { unblocked.wait(); });
+    discarded = pool.async([]() {});
+    unblocker = std::thread([&]() {
+      std::this_thread::sleep_for(10ms);
+      unblock.set_value();
+    });
+  }
+  unblocker.join();
+  ASSERT_THROW(discarded.get(), std::future_error);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}